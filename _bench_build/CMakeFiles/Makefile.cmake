@@ -0,0 +1,69 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/repo/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "CMakeFiles/filesys.dir/DependInfo.cmake"
+  "CMakeFiles/hw3_main.dir/DependInfo.cmake"
+  "CMakeFiles/terminal.dir/DependInfo.cmake"
+  "CMakeFiles/dblock_alloc_bench.dir/DependInfo.cmake"
+  "CMakeFiles/bitmap_bench.dir/DependInfo.cmake"
+  "CMakeFiles/placement_bench.dir/DependInfo.cmake"
+  "CMakeFiles/append_bench.dir/DependInfo.cmake"
+  "CMakeFiles/inode_walk_bench.dir/DependInfo.cmake"
+  "CMakeFiles/atomic_append_bench.dir/DependInfo.cmake"
+  "CMakeFiles/extent_churn_bench.dir/DependInfo.cmake"
+  "CMakeFiles/startup_bench.dir/DependInfo.cmake"
+  "CMakeFiles/large_geometry_bench.dir/DependInfo.cmake"
+  "CMakeFiles/alloc_trace_bench.dir/DependInfo.cmake"
+  "CMakeFiles/extent_map_bench.dir/DependInfo.cmake"
+  "CMakeFiles/map_cache_bench.dir/DependInfo.cmake"
+  "CMakeFiles/read_throughput_bench.dir/DependInfo.cmake"
+  "CMakeFiles/write_throughput_bench.dir/DependInfo.cmake"
+  "CMakeFiles/tree_map_bench.dir/DependInfo.cmake"
+  "CMakeFiles/fs_convert.dir/DependInfo.cmake"
+  "CMakeFiles/part0_tests.dir/DependInfo.cmake"
+  "CMakeFiles/part1_tests.dir/DependInfo.cmake"
+  "CMakeFiles/part2_tests.dir/DependInfo.cmake"
+  "CMakeFiles/part3_tests.dir/DependInfo.cmake"
+  )
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/alloc_trace_bench.dir/bench/alloc_trace_bench.c.o"
+  "CMakeFiles/alloc_trace_bench.dir/bench/alloc_trace_bench.c.o.d"
+  "alloc_trace_bench"
+  "alloc_trace_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/alloc_trace_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/append_bench.dir/bench/append_bench.c.o"
+  "CMakeFiles/append_bench.dir/bench/append_bench.c.o.d"
+  "append_bench"
+  "append_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/append_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/atomic_append_bench.dir/bench/atomic_append_bench.c.o"
+  "CMakeFiles/atomic_append_bench.dir/bench/atomic_append_bench.c.o.d"
+  "atomic_append_bench"
+  "atomic_append_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/atomic_append_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
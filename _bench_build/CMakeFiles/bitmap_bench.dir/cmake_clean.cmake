@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bitmap_bench.dir/bench/bitmap_bench.c.o"
+  "CMakeFiles/bitmap_bench.dir/bench/bitmap_bench.c.o.d"
+  "bitmap_bench"
+  "bitmap_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/bitmap_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dblock_alloc_bench.dir/bench/dblock_alloc_bench.c.o"
+  "CMakeFiles/dblock_alloc_bench.dir/bench/dblock_alloc_bench.c.o.d"
+  "dblock_alloc_bench"
+  "dblock_alloc_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/dblock_alloc_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
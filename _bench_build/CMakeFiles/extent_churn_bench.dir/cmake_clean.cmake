@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/extent_churn_bench.dir/bench/extent_churn_bench.c.o"
+  "CMakeFiles/extent_churn_bench.dir/bench/extent_churn_bench.c.o.d"
+  "extent_churn_bench"
+  "extent_churn_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/extent_churn_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
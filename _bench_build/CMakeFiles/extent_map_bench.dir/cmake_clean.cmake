@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/extent_map_bench.dir/bench/extent_map_bench.c.o"
+  "CMakeFiles/extent_map_bench.dir/bench/extent_map_bench.c.o.d"
+  "extent_map_bench"
+  "extent_map_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/extent_map_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,25 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/bitmap.c" "CMakeFiles/filesys.dir/src/bitmap.c.o" "gcc" "CMakeFiles/filesys.dir/src/bitmap.c.o.d"
+  "/root/repo/src/block_map_cache.c" "CMakeFiles/filesys.dir/src/block_map_cache.c.o" "gcc" "CMakeFiles/filesys.dir/src/block_map_cache.c.o.d"
+  "/root/repo/src/extent_tree.c" "CMakeFiles/filesys.dir/src/extent_tree.c.o" "gcc" "CMakeFiles/filesys.dir/src/extent_tree.c.o.d"
+  "/root/repo/src/file_operations.c" "CMakeFiles/filesys.dir/src/file_operations.c.o" "gcc" "CMakeFiles/filesys.dir/src/file_operations.c.o.d"
+  "/root/repo/src/filesys.c" "CMakeFiles/filesys.dir/src/filesys.c.o" "gcc" "CMakeFiles/filesys.dir/src/filesys.c.o.d"
+  "/root/repo/src/inode_manip.c" "CMakeFiles/filesys.dir/src/inode_manip.c.o" "gcc" "CMakeFiles/filesys.dir/src/inode_manip.c.o.d"
+  "/root/repo/src/utility.c" "CMakeFiles/filesys.dir/src/utility.c.o" "gcc" "CMakeFiles/filesys.dir/src/utility.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
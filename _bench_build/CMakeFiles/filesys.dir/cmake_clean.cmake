@@ -0,0 +1,23 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/filesys.dir/src/bitmap.c.o"
+  "CMakeFiles/filesys.dir/src/bitmap.c.o.d"
+  "CMakeFiles/filesys.dir/src/block_map_cache.c.o"
+  "CMakeFiles/filesys.dir/src/block_map_cache.c.o.d"
+  "CMakeFiles/filesys.dir/src/extent_tree.c.o"
+  "CMakeFiles/filesys.dir/src/extent_tree.c.o.d"
+  "CMakeFiles/filesys.dir/src/file_operations.c.o"
+  "CMakeFiles/filesys.dir/src/file_operations.c.o.d"
+  "CMakeFiles/filesys.dir/src/filesys.c.o"
+  "CMakeFiles/filesys.dir/src/filesys.c.o.d"
+  "CMakeFiles/filesys.dir/src/inode_manip.c.o"
+  "CMakeFiles/filesys.dir/src/inode_manip.c.o.d"
+  "CMakeFiles/filesys.dir/src/utility.c.o"
+  "CMakeFiles/filesys.dir/src/utility.c.o.d"
+  "libfilesys.a"
+  "libfilesys.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/filesys.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
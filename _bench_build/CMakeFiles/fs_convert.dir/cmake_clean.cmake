@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fs_convert.dir/tools/fs_convert.c.o"
+  "CMakeFiles/fs_convert.dir/tools/fs_convert.c.o.d"
+  "fs_convert"
+  "fs_convert.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/fs_convert.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/hw3_main.dir/src/hw3.c.o"
+  "CMakeFiles/hw3_main.dir/src/hw3.c.o.d"
+  "hw3_main"
+  "hw3_main.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/hw3_main.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
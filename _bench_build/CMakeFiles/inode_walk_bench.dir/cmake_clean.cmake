@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/inode_walk_bench.dir/bench/inode_walk_bench.c.o"
+  "CMakeFiles/inode_walk_bench.dir/bench/inode_walk_bench.c.o.d"
+  "inode_walk_bench"
+  "inode_walk_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/inode_walk_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
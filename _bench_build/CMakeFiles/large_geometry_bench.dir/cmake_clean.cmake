@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/large_geometry_bench.dir/bench/large_geometry_bench.c.o"
+  "CMakeFiles/large_geometry_bench.dir/bench/large_geometry_bench.c.o.d"
+  "large_geometry_bench"
+  "large_geometry_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/large_geometry_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/map_cache_bench.dir/bench/map_cache_bench.c.o"
+  "CMakeFiles/map_cache_bench.dir/bench/map_cache_bench.c.o.d"
+  "map_cache_bench"
+  "map_cache_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/map_cache_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,49 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/src/available_dblocks_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/available_dblocks_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/available_dblocks_tests.cpp.o.d"
+  "/root/repo/tests/src/available_inodes_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/available_inodes_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/available_inodes_tests.cpp.o.d"
+  "/root/repo/tests/src/average_dblock_run_length_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/average_dblock_run_length_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/average_dblock_run_length_tests.cpp.o.d"
+  "/root/repo/tests/src/bitmap_find_first_set_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/bitmap_find_first_set_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/bitmap_find_first_set_tests.cpp.o.d"
+  "/root/repo/tests/src/bitmap_find_run_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/bitmap_find_run_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/bitmap_find_run_tests.cpp.o.d"
+  "/root/repo/tests/src/bitmap_popcount_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/bitmap_popcount_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/bitmap_popcount_tests.cpp.o.d"
+  "/root/repo/tests/src/block_map_cache_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/block_map_cache_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/block_map_cache_tests.cpp.o.d"
+  "/root/repo/tests/src/claim_available_dblock_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/claim_available_dblock_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/claim_available_dblock_tests.cpp.o.d"
+  "/root/repo/tests/src/claim_available_dblocks_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/claim_available_dblocks_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/claim_available_dblocks_tests.cpp.o.d"
+  "/root/repo/tests/src/claim_available_inode_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/claim_available_inode_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/claim_available_inode_tests.cpp.o.d"
+  "/root/repo/tests/src/claim_available_inodes_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/claim_available_inodes_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/claim_available_inodes_tests.cpp.o.d"
+  "/root/repo/tests/src/claim_dblock_near_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/claim_dblock_near_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/claim_dblock_near_tests.cpp.o.d"
+  "/root/repo/tests/src/claim_dblock_range_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/claim_dblock_range_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/claim_dblock_range_tests.cpp.o.d"
+  "/root/repo/tests/src/claim_inode_near_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/claim_inode_near_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/claim_inode_near_tests.cpp.o.d"
+  "/root/repo/tests/src/extent_tree_add_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/extent_tree_add_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/extent_tree_add_tests.cpp.o.d"
+  "/root/repo/tests/src/extent_tree_best_fit_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/extent_tree_best_fit_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/extent_tree_best_fit_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_check_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/fs_check_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/fs_check_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_drain_magazines_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/fs_drain_magazines_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/fs_drain_magazines_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_reserve_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/fs_reserve_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/fs_reserve_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_resize_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/fs_resize_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/fs_resize_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_zero_released_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/fs_zero_released_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/fs_zero_released_tests.cpp.o.d"
+  "/root/repo/tests/src/new_filesystem_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/new_filesystem_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/new_filesystem_tests.cpp.o.d"
+  "/root/repo/tests/src/new_filesystem_with_options_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/new_filesystem_with_options_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/new_filesystem_with_options_tests.cpp.o.d"
+  "/root/repo/tests/src/release_dblock_range_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/release_dblock_range_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/release_dblock_range_tests.cpp.o.d"
+  "/root/repo/tests/src/release_dblock_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/release_dblock_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/release_dblock_tests.cpp.o.d"
+  "/root/repo/tests/src/release_dblocks_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/release_dblocks_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/release_dblocks_tests.cpp.o.d"
+  "/root/repo/tests/src/release_inode_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/release_inode_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/release_inode_tests.cpp.o.d"
+  "/root/repo/tests/src/release_inodes_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/release_inodes_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/release_inodes_tests.cpp.o.d"
+  "/root/repo/tests/src/set_dblock_allocator_tests.cpp" "CMakeFiles/part0_tests.dir/tests/src/set_dblock_allocator_tests.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/set_dblock_allocator_tests.cpp.o.d"
+  "/root/repo/tests/src/test_util.cpp" "CMakeFiles/part0_tests.dir/tests/src/test_util.cpp.o" "gcc" "CMakeFiles/part0_tests.dir/tests/src/test_util.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/CMakeFiles/filesys.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,69 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/part0_tests.dir/tests/src/available_dblocks_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/available_dblocks_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/available_inodes_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/available_inodes_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/average_dblock_run_length_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/average_dblock_run_length_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/bitmap_find_first_set_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/bitmap_find_first_set_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/bitmap_find_run_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/bitmap_find_run_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/bitmap_popcount_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/bitmap_popcount_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/block_map_cache_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/block_map_cache_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_available_dblock_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_available_dblock_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_available_dblocks_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_available_dblocks_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_available_inode_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_available_inode_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_available_inodes_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_available_inodes_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_dblock_near_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_dblock_near_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_dblock_range_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_dblock_range_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_inode_near_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/claim_inode_near_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/extent_tree_add_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/extent_tree_add_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/extent_tree_best_fit_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/extent_tree_best_fit_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_check_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_check_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_drain_magazines_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_drain_magazines_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_reserve_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_reserve_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_resize_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_resize_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_zero_released_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/fs_zero_released_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/new_filesystem_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/new_filesystem_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/new_filesystem_with_options_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/new_filesystem_with_options_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/release_dblock_range_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/release_dblock_range_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/release_dblock_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/release_dblock_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/release_dblocks_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/release_dblocks_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/release_inode_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/release_inode_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/release_inodes_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/release_inodes_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/set_dblock_allocator_tests.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/set_dblock_allocator_tests.cpp.o.d"
+  "CMakeFiles/part0_tests.dir/tests/src/test_util.cpp.o"
+  "CMakeFiles/part0_tests.dir/tests/src/test_util.cpp.o.d"
+  "part0_tests"
+  "part0_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/part0_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/src/inode_modify_data_tests.cpp" "CMakeFiles/part1_tests.dir/tests/src/inode_modify_data_tests.cpp.o" "gcc" "CMakeFiles/part1_tests.dir/tests/src/inode_modify_data_tests.cpp.o.d"
+  "/root/repo/tests/src/inode_read_data_tests.cpp" "CMakeFiles/part1_tests.dir/tests/src/inode_read_data_tests.cpp.o" "gcc" "CMakeFiles/part1_tests.dir/tests/src/inode_read_data_tests.cpp.o.d"
+  "/root/repo/tests/src/inode_shrink_data_tests.cpp" "CMakeFiles/part1_tests.dir/tests/src/inode_shrink_data_tests.cpp.o" "gcc" "CMakeFiles/part1_tests.dir/tests/src/inode_shrink_data_tests.cpp.o.d"
+  "/root/repo/tests/src/inode_write_data_tests.cpp" "CMakeFiles/part1_tests.dir/tests/src/inode_write_data_tests.cpp.o" "gcc" "CMakeFiles/part1_tests.dir/tests/src/inode_write_data_tests.cpp.o.d"
+  "/root/repo/tests/src/test_util.cpp" "CMakeFiles/part1_tests.dir/tests/src/test_util.cpp.o" "gcc" "CMakeFiles/part1_tests.dir/tests/src/test_util.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/CMakeFiles/filesys.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
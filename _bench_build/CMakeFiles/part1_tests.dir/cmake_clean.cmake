@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/part1_tests.dir/tests/src/inode_modify_data_tests.cpp.o"
+  "CMakeFiles/part1_tests.dir/tests/src/inode_modify_data_tests.cpp.o.d"
+  "CMakeFiles/part1_tests.dir/tests/src/inode_read_data_tests.cpp.o"
+  "CMakeFiles/part1_tests.dir/tests/src/inode_read_data_tests.cpp.o.d"
+  "CMakeFiles/part1_tests.dir/tests/src/inode_shrink_data_tests.cpp.o"
+  "CMakeFiles/part1_tests.dir/tests/src/inode_shrink_data_tests.cpp.o.d"
+  "CMakeFiles/part1_tests.dir/tests/src/inode_write_data_tests.cpp.o"
+  "CMakeFiles/part1_tests.dir/tests/src/inode_write_data_tests.cpp.o.d"
+  "CMakeFiles/part1_tests.dir/tests/src/test_util.cpp.o"
+  "CMakeFiles/part1_tests.dir/tests/src/test_util.cpp.o.d"
+  "part1_tests"
+  "part1_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/part1_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,26 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/src/fs_flush_tests.cpp" "CMakeFiles/part2_tests.dir/tests/src/fs_flush_tests.cpp.o" "gcc" "CMakeFiles/part2_tests.dir/tests/src/fs_flush_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_open_tests.cpp" "CMakeFiles/part2_tests.dir/tests/src/fs_open_tests.cpp.o" "gcc" "CMakeFiles/part2_tests.dir/tests/src/fs_open_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_read_tests.cpp" "CMakeFiles/part2_tests.dir/tests/src/fs_read_tests.cpp.o" "gcc" "CMakeFiles/part2_tests.dir/tests/src/fs_read_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_seek_tests.cpp" "CMakeFiles/part2_tests.dir/tests/src/fs_seek_tests.cpp.o" "gcc" "CMakeFiles/part2_tests.dir/tests/src/fs_seek_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_write_tests.cpp" "CMakeFiles/part2_tests.dir/tests/src/fs_write_tests.cpp.o" "gcc" "CMakeFiles/part2_tests.dir/tests/src/fs_write_tests.cpp.o.d"
+  "/root/repo/tests/src/new_terminal_tests.cpp" "CMakeFiles/part2_tests.dir/tests/src/new_terminal_tests.cpp.o" "gcc" "CMakeFiles/part2_tests.dir/tests/src/new_terminal_tests.cpp.o.d"
+  "/root/repo/tests/src/test_util.cpp" "CMakeFiles/part2_tests.dir/tests/src/test_util.cpp.o" "gcc" "CMakeFiles/part2_tests.dir/tests/src/test_util.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/CMakeFiles/filesys.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,23 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/part2_tests.dir/tests/src/fs_flush_tests.cpp.o"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_flush_tests.cpp.o.d"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_open_tests.cpp.o"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_open_tests.cpp.o.d"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_read_tests.cpp.o"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_read_tests.cpp.o.d"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_seek_tests.cpp.o"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_seek_tests.cpp.o.d"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_write_tests.cpp.o"
+  "CMakeFiles/part2_tests.dir/tests/src/fs_write_tests.cpp.o.d"
+  "CMakeFiles/part2_tests.dir/tests/src/new_terminal_tests.cpp.o"
+  "CMakeFiles/part2_tests.dir/tests/src/new_terminal_tests.cpp.o.d"
+  "CMakeFiles/part2_tests.dir/tests/src/test_util.cpp.o"
+  "CMakeFiles/part2_tests.dir/tests/src/test_util.cpp.o.d"
+  "part2_tests"
+  "part2_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/part2_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
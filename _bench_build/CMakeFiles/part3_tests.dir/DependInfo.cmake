@@ -0,0 +1,29 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/src/change_directory_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/change_directory_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/change_directory_tests.cpp.o.d"
+  "/root/repo/tests/src/fs_convert_geometry_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/fs_convert_geometry_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/fs_convert_geometry_tests.cpp.o.d"
+  "/root/repo/tests/src/get_path_string_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/get_path_string_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/get_path_string_tests.cpp.o.d"
+  "/root/repo/tests/src/list_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/list_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/list_tests.cpp.o.d"
+  "/root/repo/tests/src/new_directory_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/new_directory_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/new_directory_tests.cpp.o.d"
+  "/root/repo/tests/src/new_file_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/new_file_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/new_file_tests.cpp.o.d"
+  "/root/repo/tests/src/remove_directory_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/remove_directory_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/remove_directory_tests.cpp.o.d"
+  "/root/repo/tests/src/remove_file_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/remove_file_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/remove_file_tests.cpp.o.d"
+  "/root/repo/tests/src/test_util.cpp" "CMakeFiles/part3_tests.dir/tests/src/test_util.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/test_util.cpp.o.d"
+  "/root/repo/tests/src/tree_tests.cpp" "CMakeFiles/part3_tests.dir/tests/src/tree_tests.cpp.o" "gcc" "CMakeFiles/part3_tests.dir/tests/src/tree_tests.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/CMakeFiles/filesys.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
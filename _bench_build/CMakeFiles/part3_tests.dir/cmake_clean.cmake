@@ -0,0 +1,29 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/part3_tests.dir/tests/src/change_directory_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/change_directory_tests.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/fs_convert_geometry_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/fs_convert_geometry_tests.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/get_path_string_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/get_path_string_tests.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/list_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/list_tests.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/new_directory_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/new_directory_tests.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/new_file_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/new_file_tests.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/remove_directory_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/remove_directory_tests.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/remove_file_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/remove_file_tests.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/test_util.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/test_util.cpp.o.d"
+  "CMakeFiles/part3_tests.dir/tests/src/tree_tests.cpp.o"
+  "CMakeFiles/part3_tests.dir/tests/src/tree_tests.cpp.o.d"
+  "part3_tests"
+  "part3_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/part3_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/placement_bench.dir/bench/placement_bench.c.o"
+  "CMakeFiles/placement_bench.dir/bench/placement_bench.c.o.d"
+  "placement_bench"
+  "placement_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/placement_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/read_throughput_bench.dir/bench/read_throughput_bench.c.o"
+  "CMakeFiles/read_throughput_bench.dir/bench/read_throughput_bench.c.o.d"
+  "read_throughput_bench"
+  "read_throughput_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/read_throughput_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/startup_bench.dir/bench/startup_bench.c.o"
+  "CMakeFiles/startup_bench.dir/bench/startup_bench.c.o.d"
+  "startup_bench"
+  "startup_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/startup_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
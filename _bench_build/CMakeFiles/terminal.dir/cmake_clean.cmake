@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/terminal.dir/src/terminal.cpp.o"
+  "CMakeFiles/terminal.dir/src/terminal.cpp.o.d"
+  "terminal"
+  "terminal.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/terminal.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
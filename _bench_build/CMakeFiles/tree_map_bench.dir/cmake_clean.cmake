@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/tree_map_bench.dir/bench/tree_map_bench.c.o"
+  "CMakeFiles/tree_map_bench.dir/bench/tree_map_bench.c.o.d"
+  "tree_map_bench"
+  "tree_map_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/tree_map_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
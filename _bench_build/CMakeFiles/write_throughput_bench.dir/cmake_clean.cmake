@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/write_throughput_bench.dir/bench/write_throughput_bench.c.o"
+  "CMakeFiles/write_throughput_bench.dir/bench/write_throughput_bench.c.o.d"
+  "write_throughput_bench"
+  "write_throughput_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/write_throughput_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
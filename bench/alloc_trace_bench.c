@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+#include "bitmap.h"
+#include "utility.h"
+
+/**
+ * replays one trace of file creates, appends, truncates and deletes against every built in
+ * dblock allocation policy, to compare them on the same workload.
+ *
+ * the trace is made up front from a fixed seed and goes through the inode functions, so
+ * every policy sees exactly the same calls. files are kept at about `FILL_PERCENT` of the
+ * dblocks, deleting and truncating more as they get close, which ages the free space the
+ * way a long running disk is. for every policy the trace speed, the bitmask words the claims
+ * and releases loaded or stored per operation, the average run length of the files as
+ * `average_dblock_run_length` measures it and the number of runs the available dblocks are
+ * split into are reported. the available dblock count has to match what the files hold
+ * once the trace is done.
+ *
+ * usage: alloc_trace_bench [dblock_total]
+ */
+
+#define DEFAULT_DBLOCK_TOTAL (1 << 16)
+#define FILE_TOTAL 512
+#define TRACE_LENGTH 200000
+#define FILL_PERCENT 80
+#define MAX_APPEND 16384
+
+typedef enum trace_op_type
+{
+    TRACE_CREATE,
+    TRACE_APPEND,
+    TRACE_TRUNCATE,
+    TRACE_DELETE
+} trace_op_type_t;
+
+typedef struct trace_op
+{
+    trace_op_type_t type;
+    size_t file;
+    size_t size; // bytes appended, or the size truncated to
+} trace_op_t;
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    // xorshift64, so the trace is the same on every run
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// makes a trace that keeps the files at about FILL_PERCENT of `dblock_total`, following
+// the size of every file as it goes. `sizes` ends up with the size of each file after it
+static void make_trace(trace_op_t *trace, size_t dblock_total, size_t *sizes)
+{
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    int live[FILE_TOTAL] = { 0 };
+    size_t held = 0;
+    size_t target = dblock_total / 100 * FILL_PERCENT;
+    for (size_t i = 0; i < TRACE_LENGTH; ++i)
+    {
+        trace_op_t *op = &trace[i];
+        op->file = next_random(&rng) % FILE_TOTAL;
+        size_t roll = next_random(&rng) % 100;
+        size_t before = calculate_necessary_dblock_amount(sizes[op->file]);
+        if (!live[op->file])
+        {
+            op->type = TRACE_CREATE;
+            op->size = 0;
+            live[op->file] = 1;
+            continue;
+        }
+
+        // small appends are the most common, as they are on real disks
+        size_t append = 1 + next_random(&rng) % ((size_t) 64 << next_random(&rng) % 9);
+        if (append > MAX_APPEND) append = MAX_APPEND;
+        int full = held + calculate_necessary_dblock_amount(sizes[op->file] + append) - before > target;
+        if (roll < 8 || (full && roll < 40))
+        {
+            op->type = TRACE_DELETE;
+            op->size = 0;
+            live[op->file] = 0;
+        }
+        else if (roll < 20 || full)
+        {
+            op->type = TRACE_TRUNCATE;
+            op->size = sizes[op->file] ? next_random(&rng) % sizes[op->file] : 0;
+        }
+        else
+        {
+            op->type = TRACE_APPEND;
+            op->size = append;
+        }
+        size_t after = op->type == TRACE_APPEND ? sizes[op->file] + op->size : op->size;
+        held = held - before + calculate_necessary_dblock_amount(after);
+        sizes[op->file] = after;
+    }
+}
+
+static void replay_trace(filesystem_t *fs, const trace_op_t *trace, inode_t **files)
+{
+    static byte data[MAX_APPEND];
+    for (size_t i = 0; i < TRACE_LENGTH; ++i)
+    {
+        const trace_op_t *op = &trace[i];
+        inode_t *inode = files[op->file];
+        inode_index_t index;
+        switch (op->type)
+        {
+        case TRACE_CREATE:
+            if (claim_available_inode(fs, &index) != SUCCESS) break;
+            inode = &fs->inodes[index];
+            memset(&inode->internal, 0, sizeof(inode->internal));
+            inode->internal.file_type = DATA_FILE;
+            inode->internal.file_perms = FS_READ | FS_WRITE;
+            snprintf(inode->internal.file_name, MAX_FILE_NAME_LEN, "f%zu", op->file);
+            files[op->file] = inode;
+            break;
+        case TRACE_APPEND:
+            inode_write_data(fs, inode, data, op->size);
+            break;
+        case TRACE_TRUNCATE:
+            inode_shrink_data(fs, inode, op->size);
+            break;
+        case TRACE_DELETE:
+            inode_release_data(fs, inode);
+            release_inode(fs, inode);
+            files[op->file] = NULL;
+            break;
+        }
+    }
+}
+
+static void bench_mode(dblock_alloc_mode_t mode, size_t dblock_total, const trace_op_t *trace, const size_t *sizes)
+{
+    filesystem_t fs;
+    fs_options_t options = { INODE_FREE_LIST, mode, FS_GEOMETRY_CLASSIC };
+    if (new_filesystem_with_options(&fs, FILE_TOTAL + 1, dblock_total, &options) != SUCCESS) return;
+
+    inode_t *files[FILE_TOTAL] = { NULL };
+    dblock_alloc_stats_t stats = { 0 };
+    fs.alloc_stats = &stats;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    replay_trace(&fs, trace, files);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fs.alloc_stats = NULL;
+
+    // only the root directory's dblock is held outside the files
+    size_t held = 1;
+    for (size_t i = 0; i < FILE_TOTAL; ++i) held += files[i] ? calculate_necessary_dblock_amount(sizes[i]) : 0;
+    int consistent = available_dblocks(&fs) == dblock_total - held;
+    for (size_t i = 0; i < FILE_TOTAL; ++i) consistent &= !files[i] || files[i]->internal.file_size == sizes[i];
+
+    printf("%-12s %12.0f %12.1f %10.2f %10zu %8s\n", fs.allocator->name, TRACE_LENGTH / (elapsed_ns(start, end) / 1e9),
+        (double) stats.bitmask_words / TRACE_LENGTH, average_dblock_run_length(&fs),
+        bitmap_count_runs(fs.dblock_bitmask, 0, fs.dblock_count, 1), consistent ? "ok" : "FAILED");
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    size_t dblock_total = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_DBLOCK_TOTAL;
+    if (dblock_total < 4096) dblock_total = DEFAULT_DBLOCK_TOTAL;
+
+    trace_op_t *trace = malloc(TRACE_LENGTH * sizeof(trace_op_t));
+    size_t *sizes = calloc(FILE_TOTAL, sizeof(size_t));
+    if (!trace || !sizes)
+    {
+        free(trace);
+        free(sizes);
+        return 1;
+    }
+    make_trace(trace, dblock_total, sizes);
+
+    static const dblock_alloc_mode_t modes[] = { DBLOCK_FIRST_FIT, DBLOCK_NEXT_FIT, DBLOCK_GOAL_DIRECTED, DBLOCK_ATOMIC, DBLOCK_EXTENT_TREE, DBLOCK_BUDDY };
+    printf("%-12s %12s %12s %10s %10s %8s\n", "policy", "ops/s", "words/op", "file run", "free runs", "count");
+    for (size_t i = 0; i < sizeof(modes) / sizeof(*modes); ++i) bench_mode(modes[i], dblock_total, trace, sizes);
+    free(trace);
+    free(sizes);
+    return 0;
+}
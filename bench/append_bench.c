@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * measures interleaved append throughput through `fs_write` and the contiguity of the
+ * files it leaves behind for several preallocation window sizes, with appends going to
+ * the inodes right away and with delayed allocation.
+ *
+ * `FILE_TOTAL` files are opened at once in a fresh file system and appended to in round
+ * robin with small records until `FILE_BYTES` bytes went to every file. the handles are
+ * then closed, which returns unused window dblocks, and `average_dblock_run_length` is taken.
+ *
+ * usage: append_bench [window ...]
+ */
+
+#define FILE_TOTAL 16
+#define RECORD_BYTES 48
+#define FILE_BYTES (1 << 18)
+#define INODE_TOTAL 64
+#define DBLOCK_TOTAL (1 << 17)
+
+static const size_t default_windows[] = { 0, 8, 32, 128 };
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static void bench_window(size_t window, int delayed)
+{
+    filesystem_t fs;
+    if (new_filesystem(&fs, INODE_TOTAL, DBLOCK_TOTAL) != SUCCESS) return;
+    fs.prealloc_window = window;
+    fs.delayed_alloc = delayed;
+
+    terminal_context_t context;
+    new_terminal(&fs, &context);
+    fs_file_t files[FILE_TOTAL];
+    for (int i = 0; i < FILE_TOTAL; ++i)
+    {
+        char path[MAX_FILE_NAME_LEN];
+        // new_file splits the path in place
+        snprintf(path, sizeof(path), "./append%d", i);
+        new_file(&context, path, FS_READ | FS_WRITE);
+        snprintf(path, sizeof(path), "./append%d", i);
+        files[i] = fs_open(&context, path);
+        if (!files[i])
+        {
+            fprintf(stderr, "cannot open %s\n", path);
+            return;
+        }
+    }
+
+    byte record[RECORD_BYTES];
+    memset(record, 'x', sizeof(record));
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t written = 0; written < FILE_BYTES; written += RECORD_BYTES)
+    {
+        for (int i = 0; i < FILE_TOTAL; ++i)
+            fs_write(files[i], record, RECORD_BYTES);
+    }
+    for (int i = 0; i < FILE_TOTAL; ++i)
+        fs_close(files[i]);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double bytes = (double)FILE_TOTAL * ((FILE_BYTES + RECORD_BYTES - 1) / RECORD_BYTES) * RECORD_BYTES;
+    printf("%-10s %8zu %10.1f %10.2f %10zu\n", delayed ? "delayed" : "immediate", window, bytes / (elapsed_ns(start, end) / 1e9) / (1 << 20),
+        average_dblock_run_length(&fs), fs.dblock_count - available_dblocks(&fs));
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    printf("%-10s %8s %10s %10s %10s\n", "mode", "window", "MB/s", "run", "used");
+    for (int delayed = 0; delayed <= 1; ++delayed)
+    {
+        if (argc > 1)
+        {
+            for (int i = 1; i < argc; ++i) bench_window(strtoul(argv[i], NULL, 10), delayed);
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(default_windows) / sizeof(*default_windows); ++i)
+            bench_window(default_windows[i], delayed);
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * measures how append throughput scales with threads in DBLOCK_ATOMIC mode.
+ *
+ * every thread appends `RECORD_BYTES` records to a file of its own with `inode_write_data`
+ * until `FILE_BYTES` bytes went to it, all threads at once. first fit runs with a single
+ * thread as the baseline, since it is not safe with more. every thread count also runs
+ * with `MAGAZINE_SIZE` dblock magazines, which are drained once the threads are done.
+ * `fs_check` then has to find every dblock referenced exactly once and nothing leaked.
+ *
+ * usage: atomic_append_bench [threads ...]
+ */
+
+#define MAX_THREADS 32
+#define MAGAZINE_SIZE 64
+#define RECORD_BYTES 4096
+#define FILE_BYTES (1 << 21)
+#define INODE_TOTAL (MAX_THREADS + 1)
+// every file also needs an index dblock per 15 data dblocks, the root directory a few more,
+// and the magazines of the other threads can hold up to four batches each
+#define DBLOCK_TOTAL (MAX_THREADS * ((FILE_BYTES / DATA_BLOCK_SIZE) * 16 / 15 + 4 * MAGAZINE_SIZE) + 64)
+
+static const size_t default_threads[] = { 1, 2, 4, 8, 16, 32 };
+
+typedef struct appender
+{
+    filesystem_t *fs;
+    inode_t *inode;
+    pthread_barrier_t *start;
+    fs_retcode_t ret;
+} appender_t;
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static void *append_file(void *arg)
+{
+    appender_t *appender = arg;
+    byte record[RECORD_BYTES];
+    memset(record, 'x', sizeof(record));
+
+    pthread_barrier_wait(appender->start);
+    appender->ret = SUCCESS;
+    for (size_t written = 0; written < FILE_BYTES && appender->ret == SUCCESS; written += RECORD_BYTES)
+        appender->ret = inode_write_data(appender->fs, appender->inode, record, RECORD_BYTES);
+    return NULL;
+}
+
+static void bench_threads(dblock_alloc_mode_t mode, size_t magazine_size, size_t thread_total)
+{
+    filesystem_t fs;
+    if (new_filesystem(&fs, INODE_TOTAL, DBLOCK_TOTAL) != SUCCESS) return;
+    if (set_dblock_allocator(&fs, dblock_allocator_for_mode(mode)) != SUCCESS)
+    {
+        free_filesystem(&fs);
+        return;
+    }
+
+    // the files are made and opened from this thread, only the appends run in parallel
+    terminal_context_t context;
+    new_terminal(&fs, &context);
+    appender_t appenders[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, thread_total + 1);
+    for (size_t i = 0; i < thread_total; ++i)
+    {
+        char path[MAX_FILE_NAME_LEN];
+        // new_file splits the path in place
+        snprintf(path, sizeof(path), "./append%zu", i);
+        new_file(&context, path, FS_READ | FS_WRITE);
+        snprintf(path, sizeof(path), "./append%zu", i);
+        fs_file_t file = fs_open(&context, path);
+        if (!file)
+        {
+            fprintf(stderr, "cannot open %s\n", path);
+            return;
+        }
+        appenders[i] = (appender_t){ &fs, file->inode, &start, SUCCESS };
+        fs_close(file);
+    }
+    fs.magazine_size = magazine_size;
+
+    for (size_t i = 0; i < thread_total; ++i) pthread_create(&threads[i], NULL, append_file, &appenders[i]);
+    struct timespec begin, end;
+    pthread_barrier_wait(&start);
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (size_t i = 0; i < thread_total; ++i) pthread_join(threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pthread_barrier_destroy(&start);
+    fs_drain_magazines(&fs);
+
+    int failed = 0;
+    for (size_t i = 0; i < thread_total; ++i) failed |= appenders[i].ret != SUCCESS;
+    fs_check_report_t report;
+    int consistent = fs_check(&fs, &report) == SUCCESS && !failed && report.leaked_dblocks == 0 &&
+        report.shared_dblocks == 0 && report.free_referenced_dblocks == 0 &&
+        report.referenced_dblocks == fs.dblock_count - fs.free_dblock_count;
+
+    double bytes = (double)thread_total * FILE_BYTES;
+    const char *mode_name = mode == DBLOCK_ATOMIC ? (magazine_size ? "atomic+mag" : "atomic") : "first-fit";
+    printf("%-10s %8zu %10.1f %10.2f %10s\n", mode_name, thread_total,
+        bytes / (elapsed_ns(begin, end) / 1e9) / (1 << 20), average_dblock_run_length(&fs), consistent ? "ok" : "FAILED");
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    printf("%-10s %8s %10s %10s %10s\n", "mode", "threads", "MB/s", "run", "fs_check");
+    bench_threads(DBLOCK_FIRST_FIT, 0, 1);
+    for (size_t magazine_size = 0; magazine_size <= MAGAZINE_SIZE; magazine_size += MAGAZINE_SIZE)
+    {
+        if (argc > 1)
+        {
+            for (int i = 1; i < argc; ++i)
+            {
+                size_t thread_total = strtoul(argv[i], NULL, 10);
+                if (thread_total >= 1 && thread_total <= MAX_THREADS) bench_threads(DBLOCK_ATOMIC, magazine_size, thread_total);
+            }
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(default_threads) / sizeof(*default_threads); ++i)
+            bench_threads(DBLOCK_ATOMIC, magazine_size, default_threads[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+#include "bitmap.h"
+
+/**
+ * measures the bitmap kernels on every instruction set the processor supports.
+ *
+ * a bitmap of `bit_total` bits is filled like an aged dblock bitmask: mostly used, with
+ * free bits and short free runs scattered through it. the benchmark then counts it, finds
+ * the single set bit at its very end, and searches it for a run of `RUN_LENGTH` set bits,
+ * which it only has at the end too, so each call walks the whole bitmap.
+ *
+ * usage: bitmap_bench [bit_total]
+ */
+
+#define DEFAULT_BIT_TOTAL ((size_t)1 << 30)
+#define RUN_LENGTH 64
+#define ROUNDS 20
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static void set_bit(uint8_t *bits, size_t n)
+{
+    bits[n / 8] |= 1 << (7 - n % 8);
+}
+
+static double gb_per_s(size_t bytes, struct timespec start, struct timespec end)
+{
+    return (double)bytes * ROUNDS / elapsed_ns(start, end);
+}
+
+static void bench_isa(bitmap_isa_t isa, const uint8_t *sparse, const uint8_t *aged, size_t bit_total)
+{
+    if (bitmap_select_isa(isa) != 0) return;
+
+    size_t bytes = bit_total / 8;
+    size_t count = 0, found = 0;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < ROUNDS; ++round) count += bitmap_popcount(aged, 0, bit_total);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double popcount_rate = gb_per_s(bytes, start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+        size_t index = 0;
+        bitmap_find_first_set(sparse, 0, bit_total, &index);
+        found += index;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double find_rate = gb_per_s(bytes, start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+        size_t index = 0;
+        bitmap_find_run(aged, 0, bit_total, RUN_LENGTH, &index);
+        found += index;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double run_rate = gb_per_s(bytes, start, end);
+
+    printf("%-10s %12.2f %12.2f %12.2f %16zu\n", bitmap_isa_string_table[isa], popcount_rate, find_rate, run_rate,
+        (count + found) % 1000000);
+}
+
+int main(int argc, char **argv)
+{
+    size_t bit_total = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_BIT_TOTAL;
+    bit_total = bit_total / 8 * 8;
+    if (bit_total < 1024) bit_total = DEFAULT_BIT_TOTAL;
+
+    uint8_t *sparse = calloc(bit_total / 8, 1);
+    uint8_t *aged = calloc(bit_total / 8, 1);
+    if (!sparse || !aged)
+    {
+        fprintf(stderr, "cannot allocate %zu bits\n", bit_total);
+        return 1;
+    }
+
+    // free runs of up to 8 dblocks spread every few hundred bits, and one long run at the end
+    srand(1);
+    for (size_t n = 0; n + 2 * RUN_LENGTH < bit_total; n += 64 + rand() % 512)
+    {
+        size_t len = 1 + rand() % 8;
+        for (size_t i = 0; i < len; ++i) set_bit(aged, n + i);
+    }
+    for (size_t n = bit_total - RUN_LENGTH; n < bit_total; ++n) set_bit(aged, n);
+    set_bit(sparse, bit_total - 1);
+
+    printf("%-10s %12s %12s %12s %16s\n", "isa", "popcount", "find-set", "find-run", "checksum");
+    printf("%-10s %12s %12s %12s\n", "", "GB/s", "GB/s", "GB/s");
+    bitmap_isa_t best = bitmap_active_isa();
+    for (int isa = BITMAP_ISA_PORTABLE; isa <= BITMAP_ISA_AVX2; ++isa)
+        bench_isa((bitmap_isa_t)isa, sparse, aged, bit_total);
+    bitmap_select_isa(best);
+
+    free(sparse);
+    free(aged);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * compares the first fit and next fit modes of `claim_available_dblock`.
+ *
+ * the fragmentation pattern of each input image is tiled across a larger file system
+ * to simulate an aged disk. the benchmark then churns the allocator: every step claims
+ * one dblock and, once `live` dblocks are held, releases the oldest one again.
+ *
+ * usage: dblock_alloc_bench [dblock_total] [image ...]
+ */
+
+#define DEFAULT_DBLOCK_TOTAL (1 << 18)
+#define CHURN_STEPS 200000
+
+static const char *default_images[] = {
+    "input/empty_random_inode_fragmented.bin",
+    "input/half_random_inode_fragmented.bin"
+};
+
+static const char *mode_names[] = { "first-fit", "next-fit" };
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static int dblock_is_available(const filesystem_t *fs, size_t n)
+{
+    return fs->dblock_bitmask[n / 8] & (1 << (7 - n % 8));
+}
+
+// builds a file system with `dblock_total` dblocks whose bitmask repeats the one of `pattern`.
+// every dblock is claimed and the ones available in the pattern are released again so the
+// allocator counters stay consistent with the bitmask
+static int build_aged_filesystem(const filesystem_t *pattern, size_t dblock_total, filesystem_t *fs)
+{
+    if (new_filesystem(fs, 2, dblock_total) != SUCCESS) return -1;
+
+    dblock_index_t idx;
+    while (claim_available_dblock(fs, &idx) == SUCCESS);
+    for (size_t i = 1; i < dblock_total; ++i)
+    {
+        if (dblock_is_available(pattern, i % pattern->dblock_count))
+            release_dblock(fs, &fs->dblocks[i * DATA_BLOCK_SIZE]);
+    }
+    fs->dblock_cursor = 0;
+    return 0;
+}
+
+static int run_churn(filesystem_t *fs, size_t live, double *ns_per_claim)
+{
+    dblock_index_t *ring = malloc(live * sizeof(dblock_index_t));
+    if (!ring) return -1;
+
+    size_t held = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t step = 0; step < CHURN_STEPS; ++step)
+    {
+        if (held == live)
+        {
+            release_dblock(fs, &fs->dblocks[ring[step % live] * DATA_BLOCK_SIZE]);
+            --held;
+        }
+        if (claim_available_dblock(fs, &ring[step % live]) != SUCCESS) break;
+        ++held;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *ns_per_claim = elapsed_ns(start, end) / CHURN_STEPS;
+    free(ring);
+    return 0;
+}
+
+static void bench_image(const char *path, size_t dblock_total)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return;
+    }
+    filesystem_t pattern;
+    fs_retcode_t ret = load_filesystem(f, &pattern);
+    fclose(f);
+    if (ret != SUCCESS)
+    {
+        fprintf(stderr, "cannot load %s: %s\n", path, fs_retcode_string_table[ret]);
+        return;
+    }
+
+    for (int mode = DBLOCK_FIRST_FIT; mode <= DBLOCK_NEXT_FIT; ++mode)
+    {
+        filesystem_t fs;
+        if (build_aged_filesystem(&pattern, dblock_total, &fs) != 0) break;
+        if (set_dblock_allocator(&fs, dblock_allocator_for_mode(mode)) != SUCCESS)
+        {
+            free_filesystem(&fs);
+            break;
+        }
+
+        // keep a quarter of the remaining free space live so the churn wraps the disk
+        size_t live = available_dblocks(&fs) / 4;
+        double ns_per_claim = 0;
+        if (live > 0 && run_churn(&fs, live, &ns_per_claim) == 0)
+            printf("%-42s %-10s %10zu %12.1f\n", path, mode_names[mode], dblock_total, ns_per_claim);
+        free_filesystem(&fs);
+    }
+    free_filesystem(&pattern);
+}
+
+int main(int argc, char **argv)
+{
+    size_t dblock_total = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_DBLOCK_TOTAL;
+    if (dblock_total < 2) dblock_total = DEFAULT_DBLOCK_TOTAL;
+
+    printf("%-42s %-10s %10s %12s\n", "image", "mode", "dblocks", "ns/claim");
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; ++i) bench_image(argv[i], dblock_total);
+    }
+    else
+    {
+        for (size_t i = 0; i < sizeof(default_images) / sizeof(*default_images); ++i)
+            bench_image(default_images[i], dblock_total);
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+#include "bitmap.h"
+
+/**
+ * compares the bitmask scan of `claim_dblock_range` in first fit mode with the extent tree
+ * of DBLOCK_EXTENT_TREE mode under create and delete churn.
+ *
+ * a file is created by claiming runs with `claim_dblock_range` until it has all of its
+ * dblocks, and deleted by releasing its runs again. creates and deletes are mixed so the
+ * file system stays about `FILL_PERCENT` full, which fragments the free space the way an
+ * old disk is. both modes see the same sequence of sizes and deletes, first `AGE_STEPS`
+ * untimed ones to fragment the file system and then `CHURN_STEPS` timed ones. the available
+ * dblock count has to match the dblocks the files do not hold at the end, and the number of
+ * runs the available dblocks are split into shows how fragmented each mode left them.
+ *
+ * usage: extent_churn_bench [dblock_total]
+ */
+
+#define DEFAULT_DBLOCK_TOTAL (1 << 20)
+#define MAX_FILE_DBLOCKS 256
+#define FILL_PERCENT 85
+#define AGE_STEPS 200000
+#define CHURN_STEPS 200000
+
+typedef struct churn_file
+{
+    size_t run_count;
+    dblock_index_t starts[MAX_FILE_DBLOCKS];
+    dblock_index_t lens[MAX_FILE_DBLOCKS];
+} churn_file_t;
+
+typedef struct churn
+{
+    filesystem_t *fs;
+    churn_file_t *files;
+    size_t file_count;
+    size_t max_files;
+    size_t held;       // dblocks the files hold
+    size_t runs;       // runs of the files created while timed
+    size_t created;
+    uint64_t rng;
+} churn_t;
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    // xorshift64, so both modes get the same sequence
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// small files are the most common, as they are on real disks
+static size_t random_file_size(uint64_t *state)
+{
+    size_t shift = next_random(state) % 9;
+    return 1 + next_random(state) % ((size_t) 1 << shift);
+}
+
+static int create_file(churn_t *churn, size_t size)
+{
+    churn_file_t *file = &churn->files[churn->file_count];
+    file->run_count = 0;
+    for (size_t claimed = 0; claimed < size;)
+    {
+        dblock_index_t start;
+        size_t len;
+        if (claim_dblock_range(churn->fs, size - claimed, 0, &start, &len) != SUCCESS)
+        {
+            for (size_t i = 0; i < file->run_count; ++i) release_dblock_range(churn->fs, file->starts[i], file->lens[i]);
+            return -1;
+        }
+        file->starts[file->run_count] = start;
+        file->lens[file->run_count++] = len;
+        claimed += len;
+    }
+    ++churn->file_count;
+    churn->held += size;
+    return 0;
+}
+
+static void delete_file(churn_t *churn, size_t n)
+{
+    churn_file_t *file = &churn->files[n];
+    for (size_t i = 0; i < file->run_count; ++i)
+    {
+        release_dblock_range(churn->fs, file->starts[i], file->lens[i]);
+        churn->held -= file->lens[i];
+    }
+    // the last file takes the place of the deleted one
+    memcpy(file, &churn->files[--churn->file_count], sizeof(churn_file_t));
+}
+
+static void run_churn(churn_t *churn, size_t steps, int timed)
+{
+    size_t target = churn->fs->dblock_count / 100 * FILL_PERCENT;
+    for (size_t step = 0; step < steps; ++step)
+    {
+        size_t size = random_file_size(&churn->rng);
+        size_t victim = next_random(&churn->rng);
+        if (churn->file_count > 0 && (churn->held + size > target || churn->file_count == churn->max_files))
+        {
+            delete_file(churn, victim % churn->file_count);
+            continue;
+        }
+        if (create_file(churn, size) != 0) continue;
+        if (!timed) continue;
+        churn->runs += churn->files[churn->file_count - 1].run_count;
+        ++churn->created;
+    }
+}
+
+static void bench_mode(dblock_alloc_mode_t mode, size_t dblock_total)
+{
+    filesystem_t fs;
+    fs_options_t options = { INODE_FREE_LIST, mode, FS_GEOMETRY_CLASSIC };
+    if (new_filesystem_with_options(&fs, 2, dblock_total, &options) != SUCCESS) return;
+
+    churn_t churn = { &fs, NULL, 0, dblock_total / 16, 0, 0, 0, 0x9E3779B97F4A7C15ULL };
+    churn.files = malloc(churn.max_files * sizeof(churn_file_t));
+    if (!churn.files)
+    {
+        free_filesystem(&fs);
+        return;
+    }
+
+    run_churn(&churn, AGE_STEPS, 0);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_churn(&churn, CHURN_STEPS, 1);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    // only the root directory's dblock is held outside the files
+    int consistent = available_dblocks(&fs) == dblock_total - 1 - churn.held;
+    printf("%-12s %10zu %10.1f %10.2f %10zu %10s\n", mode == DBLOCK_EXTENT_TREE ? "extent-tree" : "first-fit",
+        dblock_total, elapsed_ns(start, end) / CHURN_STEPS, churn.created ? (double) churn.runs / churn.created : 0.0,
+        bitmap_count_runs(fs.dblock_bitmask, 0, fs.dblock_count, 1), consistent ? "ok" : "FAILED");
+    free(churn.files);
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    size_t dblock_total = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_DBLOCK_TOTAL;
+    if (dblock_total < 1024) dblock_total = DEFAULT_DBLOCK_TOTAL;
+
+    printf("%-12s %10s %10s %10s %10s %10s\n", "mode", "dblocks", "ns/op", "runs/file", "free runs", "count");
+    bench_mode(DBLOCK_FIRST_FIT, dblock_total);
+    bench_mode(DBLOCK_EXTENT_TREE, dblock_total);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * compares inodes mapped with index dblocks to `INODE_EXTENT_MAPPED` inodes.
+ *
+ * one file is appended to `APPEND_BYTES` at a time until it holds `file_kib` KiB, read back
+ * whole `READ_BYTES` at a time, read `RANDOM_READS` times at random offsets and released
+ * again. this happens once in an empty file system, where the file gets one run of dblocks,
+ * and once in one where only runs of `FRAGMENT_RUN` dblocks are available. the entries the
+ * block map holds, the index or extent dblocks it takes and the time of every step are
+ * reported, along with whether the data read back matches what was written.
+ *
+ * usage: extent_map_bench [file_kib]
+ */
+
+#define DEFAULT_FILE_KIB 1024
+#define APPEND_BYTES 4096
+#define READ_BYTES 65536
+#define READ_ROUNDS 8
+#define RANDOM_READS 100000
+#define FRAGMENT_RUN 16
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// leaves runs of FRAGMENT_RUN available dblocks with a used one between each two
+static void fragment(filesystem_t *fs)
+{
+    dblock_index_t start;
+    size_t len;
+    while (claim_dblock_range(fs, fs->dblock_count, 0, &start, &len) == SUCCESS) {}
+    for (size_t d = 1; d + FRAGMENT_RUN <= fs->dblock_count; d += FRAGMENT_RUN + 1)
+        release_dblock_range(fs, d, FRAGMENT_RUN);
+}
+
+static void bench_map(const byte *data, size_t file_bytes, int fragmented, int extent_mapped)
+{
+    size_t data_dblocks = file_bytes / DATA_BLOCK_SIZE;
+    // room for the file, its index dblocks and the used dblocks between the fragments
+    size_t dblock_total = data_dblocks * 2 + 1024;
+    filesystem_t fs;
+    if (new_filesystem(&fs, 2, dblock_total) != SUCCESS) return;
+    if (fragmented) fragment(&fs);
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = extent_mapped ? INODE_EXTENT_MAPPED : 0;
+    size_t available = available_dblocks(&fs);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t written = 0; written < file_bytes; written += APPEND_BYTES)
+        inode_write_data(&fs, inode, (void *)(data + written), APPEND_BYTES);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double write_ns = elapsed_ns(start, end);
+    size_t map_dblocks = available - available_dblocks(&fs) - data_dblocks;
+    size_t entries = inode_map_entries(&fs, inode);
+
+    byte *buffer = malloc(READ_BYTES);
+    int matches = buffer != NULL;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < READ_ROUNDS && buffer; ++round)
+    {
+        for (size_t offset = 0; offset < file_bytes; offset += READ_BYTES)
+        {
+            size_t bytes_read = 0;
+            inode_read_data(&fs, inode, offset, buffer, READ_BYTES, &bytes_read);
+            if (round == 0) matches &= memcmp(buffer, data + offset, bytes_read) == 0;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double read_ns = elapsed_ns(start, end);
+
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < RANDOM_READS && buffer; ++i)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        size_t bytes_read = 0;
+        inode_read_data(&fs, inode, rng % (file_bytes - APPEND_BYTES), buffer, APPEND_BYTES, &bytes_read);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double random_ns = elapsed_ns(start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    inode_release_data(&fs, inode);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    matches &= available_dblocks(&fs) == available;
+
+    printf("%-10s %-7s %10zu %10zu %12.1f %12.1f %12.1f %12.1f %8s\n", fragmented ? "fragment" : "contig",
+        extent_mapped ? "extent" : "index", entries, map_dblocks, file_bytes / (write_ns / 1e9) / (1 << 20),
+        (double) file_bytes * READ_ROUNDS / (read_ns / 1e9) / (1 << 20), random_ns / RANDOM_READS,
+        elapsed_ns(start, end) / 1e3, matches ? "ok" : "FAILED");
+    free(buffer);
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    size_t file_kib = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_FILE_KIB;
+    if (file_kib < 64) file_kib = DEFAULT_FILE_KIB;
+    size_t file_bytes = file_kib * 1024;
+
+    byte *data = malloc(file_bytes);
+    if (!data) return 1;
+    for (size_t i = 0; i < file_bytes; ++i) data[i] = (byte)(i * 7 + i / 4093);
+
+    printf("%-10s %-7s %10s %10s %12s %12s %12s %12s %8s\n", "layout", "map", "entries", "map dblks",
+        "write MB/s", "read MB/s", "4K rand ns", "release us", "data");
+    for (int fragmented = 0; fragmented <= 1; ++fragmented)
+    {
+        bench_map(data, file_bytes, fragmented, 0);
+        bench_map(data, file_bytes, fragmented, 1);
+    }
+    free(data);
+    return 0;
+}
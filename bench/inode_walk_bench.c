@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * compares the free list and bitmap inode allocators on a walk over an aged tree.
+ *
+ * `DIR_TOTAL` directories are created in the root directory, each one followed by its
+ * files, for `file_total` files in all. a random `CHURN_PERCENT` of the files are then
+ * removed and as many new ones created in random directories, which is where the free
+ * list starts handing out inodes from all over the table. the tree is then walked like
+ * `tree` does, reading every directory and the inode of every entry in it.
+ *
+ * the walk reports the time per entry and the average distance in the inode table
+ * between consecutive entries of a directory.
+ *
+ * usage: inode_walk_bench [file_total]
+ */
+
+#define DIR_TOTAL 50
+#define CHURN_PERCENT 30
+#define DEFAULT_FILE_TOTAL 50000
+#define WALK_ROUNDS 20
+
+static const char *mode_names[] = { "free-list", "groups", "bitmap" };
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// path functions split their argument in place, so every call gets a fresh copy
+static void file_path(char *path, size_t size, int dir, const char *prefix, int n)
+{
+    snprintf(path, size, "./d%d/%s%d", dir, prefix, n);
+}
+
+static void build_tree(terminal_context_t *context, size_t file_total)
+{
+    char path[64];
+    size_t per_dir = file_total / DIR_TOTAL;
+    for (int d = 0; d < DIR_TOTAL; ++d)
+    {
+        snprintf(path, sizeof(path), "./d%d", d);
+        new_directory(context, path);
+        for (size_t f = 0; f < per_dir; ++f)
+        {
+            file_path(path, sizeof(path), d, "f", (int)f);
+            new_file(context, path, FS_READ);
+        }
+    }
+
+    // remove a random set of the files, then create as many in random directories
+    size_t churn = file_total * CHURN_PERCENT / 100;
+    size_t *order = malloc(file_total * sizeof(size_t));
+    for (size_t i = 0; i < file_total; ++i) order[i] = i;
+    srand(1);
+    for (size_t i = file_total - 1; i > 0; --i)
+    {
+        size_t j = rand() % (i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for (size_t i = 0; i < churn; ++i)
+    {
+        file_path(path, sizeof(path), (int)(order[i] / per_dir), "f", (int)(order[i] % per_dir));
+        remove_file(context, path);
+    }
+    for (size_t i = 0; i < churn; ++i)
+    {
+        file_path(path, sizeof(path), rand() % DIR_TOTAL, "g", (int)i);
+        new_file(context, path, FS_READ);
+    }
+    free(order);
+}
+
+// visits every entry of the directory and returns how many there were. the inode index
+// distance between consecutive entries is added to `distance`
+static size_t walk_directory(filesystem_t *fs, inode_t *dir, size_t *distance, size_t *checksum)
+{
+    size_t size = dir->internal.file_size;
+    byte *contents = malloc(size);
+    if (!contents) return 0;
+    inode_read_data(fs, dir, 0, contents, size, &size);
+
+    size_t entries = 0;
+    size_t prev = dir - fs->inodes;
+    size_t entry_size = directory_entry_size(fs);
+    for (size_t offset = 0; offset + entry_size <= size; offset += entry_size)
+    {
+        inode_index_t idx = directory_entry_inode(fs, &contents[offset]);
+        const char *name = directory_entry_name(fs, &contents[offset]);
+        if (name[0] == '\0' || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+        inode_t *inode = &fs->inodes[idx];
+        *checksum += inode->internal.file_size + (size_t)inode->internal.file_type;
+        *distance += idx > prev ? idx - prev : prev - idx;
+        prev = idx;
+        ++entries;
+        if (inode->internal.file_type == DIRECTORY) entries += walk_directory(fs, inode, distance, checksum);
+    }
+    free(contents);
+    return entries;
+}
+
+static void bench_mode(inode_alloc_mode_t mode, size_t file_total)
+{
+    filesystem_t fs;
+    fs_options_t options = { mode, DBLOCK_FIRST_FIT, FS_GEOMETRY_CLASSIC };
+    size_t inode_total = file_total + DIR_TOTAL + 1;
+    if (new_filesystem_with_options(&fs, inode_total, inode_total, &options) != SUCCESS) return;
+
+    terminal_context_t context;
+    new_terminal(&fs, &context);
+    build_tree(&context, file_total);
+
+    size_t entries = 0, distance = 0, checksum = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < WALK_ROUNDS; ++round)
+    {
+        distance = 0;
+        entries = walk_directory(&fs, &fs.inodes[0], &distance, &checksum);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("%-10s %10zu %12.1f %12.1f %12zu\n", mode_names[mode], entries,
+        elapsed_ns(start, end) / WALK_ROUNDS / (entries ? entries : 1),
+        (double)distance / (entries ? entries : 1), checksum % 1000);
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    size_t file_total = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_FILE_TOTAL;
+    if (file_total < DIR_TOTAL || file_total + DIR_TOTAL + 1 > (inode_index_t)-1) file_total = DEFAULT_FILE_TOTAL;
+
+    printf("%-10s %10s %12s %12s %12s\n", "mode", "entries", "ns/entry", "distance", "checksum");
+    bench_mode(INODE_FREE_LIST, file_total);
+    bench_mode(INODE_BITMAP, file_total);
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * checks that the cost per inode stays flat as a large geometry file system grows past the
+ * 65536 inodes of the classic one.
+ *
+ * for every inode total a tree is built where every directory holds `FANOUT` entries: inode
+ * k > 0 is entry (k - 1) % FANOUT of directory (k - 1) / FANOUT, so the depth of the tree only
+ * grows with the log of the total. every inode with children is made with `new_directory`,
+ * the others with `new_file`. each of them is then looked up with `fs_open`, and the whole
+ * file system is checked with `fs_check` and saved and loaded again. the time per inode of
+ * every step is reported; it should stay about the same from one total to the next, not
+ * grow with it. dblocks are claimed in DBLOCK_NEXT_FIT mode, since a first fit scan of a
+ * bitmask this big from dblock 0 for every claim would be what grows.
+ *
+ * usage: large_geometry_bench [inode_total ...]
+ */
+
+#define FANOUT 32
+#define MAX_PATH_LEN 256
+#define IMAGE_PATH "/tmp/large_geometry_bench.bin"
+
+static const size_t default_totals[] = { 1 << 14, 1 << 16, 1 << 18, 1 << 20 };
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// writes the path of inode k, which is ./n<i>/n<j>/... from the root down
+static void inode_path(size_t k, char *path)
+{
+    // the entries are found from the inode up to the root, so they are written in reverse
+    size_t entries[MAX_PATH_LEN / 4];
+    size_t depth = 0;
+    for (; k > 0; k = (k - 1) / FANOUT) entries[depth++] = (k - 1) % FANOUT;
+    size_t len = snprintf(path, MAX_PATH_LEN, ".");
+    while (depth > 0) len += snprintf(&path[len], MAX_PATH_LEN - len, "/n%zu", entries[--depth]);
+}
+
+static void bench_total(size_t inode_total)
+{
+    // a directory holds FANOUT entries, which with their index dblocks take a few more than
+    // FANOUT * LARGE_DIRECTORY_ENTRY_SIZE / DATA_BLOCK_SIZE dblocks
+    size_t directory_total = (inode_total - 2) / FANOUT + 1;
+    size_t dblock_total = directory_total * (FANOUT * LARGE_DIRECTORY_ENTRY_SIZE / DATA_BLOCK_SIZE + 4) + 64;
+    fs_options_t options = { INODE_FREE_LIST, DBLOCK_NEXT_FIT, FS_GEOMETRY_LARGE };
+    filesystem_t fs;
+    if (new_filesystem_with_options(&fs, inode_total, dblock_total, &options) != SUCCESS)
+    {
+        fprintf(stderr, "cannot create a file system of %zu inodes\n", inode_total);
+        return;
+    }
+    terminal_context_t context;
+    new_terminal(&fs, &context);
+
+    char path[MAX_PATH_LEN];
+    int failed = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t k = 1; k < inode_total; ++k)
+    {
+        // new_file and new_directory split the path in place
+        inode_path(k, path);
+        int is_directory = k * FANOUT + 1 < inode_total;
+        failed |= (is_directory ? new_directory(&context, path) : new_file(&context, path, FS_READ | FS_WRITE)) != 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double create_ns = elapsed_ns(start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t k = 1; k < inode_total; ++k)
+    {
+        if (k * FANOUT + 1 < inode_total) continue;
+        inode_path(k, path);
+        fs_file_t file = fs_open(&context, path);
+        failed |= file == NULL;
+        if (file) fs_close(file);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double open_ns = elapsed_ns(start, end);
+    size_t file_total = inode_total - 1 - (inode_total - 2) / FANOUT;
+
+    fs_check_report_t report;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    failed |= fs_check(&fs, &report) != SUCCESS || report.reachable_inodes != inode_total;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double check_ns = elapsed_ns(start, end);
+
+    filesystem_t loaded;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    FILE *image = fopen(IMAGE_PATH, "w+");
+    failed |= !image || save_filesystem(image, &fs) != SUCCESS;
+    if (image)
+    {
+        rewind(image);
+        failed |= load_filesystem(image, &loaded) != SUCCESS || loaded.inode_count != inode_total;
+        fclose(image);
+        free_filesystem(&loaded);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double save_load_ns = elapsed_ns(start, end);
+    remove(IMAGE_PATH);
+
+    printf("%10zu %10.1f %10.1f %10.1f %10.1f %8s\n", inode_total, create_ns / (inode_total - 1), open_ns / file_total,
+        check_ns / inode_total, save_load_ns / inode_total, failed ? "FAILED" : "ok");
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    printf("%10s %10s %10s %10s %10s %8s\n", "inodes", "create ns", "open ns", "check ns", "save ns", "result");
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            size_t inode_total = strtoul(argv[i], NULL, 10);
+            if (inode_total >= 2) bench_total(inode_total);
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(default_totals) / sizeof(*default_totals); ++i) bench_total(default_totals[i]);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+#include "block_map_cache.h"
+
+/**
+ * measures what the block map cache saves on a file mapped with index dblocks.
+ *
+ * one file is appended to `APPEND_BYTES` at a time until it holds `file_kib` KiB, then read
+ * `RANDOM_READS` times at random offsets, `APPEND_BYTES` and one byte at a time. this happens
+ * once without the cache and once with a budget of `BUDGET_KIB` KiB. the time of every step,
+ * the hits and misses of the cache and the memory it took are reported, along with whether
+ * the data read back matches what was written.
+ *
+ * usage: map_cache_bench [file_kib]
+ */
+
+#define DEFAULT_FILE_KIB 4096
+#define APPEND_BYTES 4096
+#define RANDOM_READS 100000
+#define BUDGET_KIB 1024
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// the average time of RANDOM_READS reads of `len` bytes, checking the data of every read
+static double random_reads(filesystem_t *fs, inode_t *inode, const byte *data, size_t file_bytes, byte *buffer, size_t len, int *matches)
+{
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < RANDOM_READS; ++i)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        size_t offset = rng % (file_bytes - len);
+        size_t bytes_read = 0;
+        inode_read_data(fs, inode, offset, buffer, len, &bytes_read);
+        *matches &= bytes_read == len && buffer[0] == data[offset] && buffer[len - 1] == data[offset + len - 1];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return elapsed_ns(start, end) / RANDOM_READS;
+}
+
+static void bench_cache(const byte *data, size_t file_bytes, size_t budget)
+{
+    size_t data_dblocks = file_bytes / DATA_BLOCK_SIZE;
+    filesystem_t fs;
+    if (new_filesystem(&fs, 2, data_dblocks + data_dblocks / 14 + 1024) != SUCCESS) return;
+    fs.map_cache_budget = budget;
+    inode_t *inode = &fs.inodes[1];
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t written = 0; written < file_bytes; written += APPEND_BYTES)
+        inode_write_data(&fs, inode, (void *)(data + written), APPEND_BYTES);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double write_ns = elapsed_ns(start, end);
+
+    // the cache is dropped so the reads fill it from the chain
+    if (fs.map_cache) block_map_cache_clear(fs.map_cache);
+    byte buffer[APPEND_BYTES];
+    int matches = 1;
+    double page_ns = random_reads(&fs, inode, data, file_bytes, buffer, APPEND_BYTES, &matches);
+    double byte_ns = random_reads(&fs, inode, data, file_bytes, buffer, 1, &matches);
+
+    printf("%-8s %12.1f %12.1f %12.1f %10zu %10zu %10.1f %8s\n", budget ? "cached" : "walked",
+        file_bytes / (write_ns / 1e9) / (1 << 20), page_ns, byte_ns, fs.map_cache ? fs.map_cache->hits : 0,
+        fs.map_cache ? fs.map_cache->misses : 0, fs.map_cache ? fs.map_cache->bytes / 1024.0 : 0.0, matches ? "ok" : "FAILED");
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    size_t file_kib = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_FILE_KIB;
+    if (file_kib < 64) file_kib = DEFAULT_FILE_KIB;
+    size_t file_bytes = file_kib * 1024;
+
+    byte *data = malloc(file_bytes);
+    if (!data) return 1;
+    for (size_t i = 0; i < file_bytes; ++i) data[i] = (byte)(i * 7 + i / 4093);
+
+    printf("%-8s %12s %12s %12s %10s %10s %10s %8s\n", "map", "write MB/s", "4K rand ns", "1B rand ns",
+        "hits", "misses", "cache KiB", "data");
+    bench_cache(data, file_bytes, 0);
+    bench_cache(data, file_bytes, (size_t) BUDGET_KIB * 1024);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filesys.h"
+
+/**
+ * compares first fit and goal directed dblock placement by the file fragmentation
+ * they leave behind, measured with `average_dblock_run_length`.
+ *
+ * each file system gets `FILE_TOTAL` new files in its root directory which are then grown
+ * in round robin, a few hundred bytes at a time, together with the data files already in
+ * the image, until half of the available dblocks are used. interleaved appends are what
+ * scatters the dblocks of a file under first fit.
+ * the bundled input/ images are used as is, followed by a larger freshly created one.
+ *
+ * usage: placement_bench [image ...]
+ */
+
+#define FILE_TOTAL 8
+#define APPEND_MAX 320
+#define APPEND_STEPS 4096
+#define SYNTHETIC_INODE_TOTAL 64
+#define SYNTHETIC_DBLOCK_TOTAL (1 << 14)
+
+static const char *default_images[] = {
+    "input/empty_random_inode_fragmented.bin",
+    "input/half_random_inode_fragmented.bin",
+    "input/large.bin",
+    "input/medium.bin",
+    "input/medium_text.bin",
+    "input/medium_tombstone.bin",
+    "input/small_full_inode.bin"
+};
+
+static const char *mode_names[] = { "first-fit", "next-fit", "goal" };
+
+static int load_image(const char *path, filesystem_t *fs)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return -1;
+    }
+    fs_retcode_t ret = load_filesystem(f, fs);
+    fclose(f);
+    if (ret != SUCCESS)
+    {
+        fprintf(stderr, "cannot load %s: %s\n", path, fs_retcode_string_table[ret]);
+        return -1;
+    }
+    return 0;
+}
+
+// grows the data files of `fs` in round robin until half of the available dblocks are used
+static void run_workload(filesystem_t *fs)
+{
+    size_t stop_at = available_dblocks(fs) / 2;
+    terminal_context_t context;
+    new_terminal(fs, &context);
+
+    for (int i = 0; i < FILE_TOTAL && available_inodes(fs) > 0; ++i)
+    {
+        char path[MAX_FILE_NAME_LEN];
+        snprintf(path, sizeof(path), "./bench%d", i);
+        new_file(&context, path, FS_READ | FS_WRITE);
+    }
+
+    inode_t *files[SYNTHETIC_INODE_TOTAL];
+    size_t file_total = 0;
+    for (size_t i = 1; i < fs->inode_count && file_total < SYNTHETIC_INODE_TOTAL; ++i)
+    {
+        // the free inode list has no dblocks, and directories only grow through new_file
+        inode_t *inode = &fs->inodes[i];
+        int in_use = 1;
+        for (inode_index_t iter = fs->available_inode; iter != 0; iter = fs->inodes[iter].next_free_inode)
+            if (iter == i) in_use = 0;
+        if (in_use && inode->internal.file_type == DATA_FILE) files[file_total++] = inode;
+    }
+    if (file_total == 0) return;
+
+    byte data[APPEND_MAX];
+    memset(data, 'x', sizeof(data));
+    srand(1);
+    for (size_t step = 0; step < APPEND_STEPS && available_dblocks(fs) > stop_at; ++step)
+    {
+        size_t n = 1 + rand() % APPEND_MAX;
+        if (inode_write_data(fs, files[step % file_total], data, n) != SUCCESS) break;
+    }
+}
+
+static void report(const char *name, filesystem_t *fs, dblock_alloc_mode_t mode)
+{
+    double before = average_dblock_run_length(fs);
+    if (set_dblock_allocator(fs, dblock_allocator_for_mode(mode)) != SUCCESS) return;
+    run_workload(fs);
+    printf("%-42s %-10s %8.2f %8.2f %8zu\n", name, mode_names[mode], before,
+        average_dblock_run_length(fs), fs->dblock_count - available_dblocks(fs));
+}
+
+static void bench_image(const char *path)
+{
+    dblock_alloc_mode_t modes[] = { DBLOCK_FIRST_FIT, DBLOCK_GOAL_DIRECTED };
+    for (size_t i = 0; i < sizeof(modes) / sizeof(*modes); ++i)
+    {
+        filesystem_t fs;
+        if (load_image(path, &fs) != 0) return;
+        report(path, &fs, modes[i]);
+        free_filesystem(&fs);
+    }
+}
+
+static void bench_synthetic(void)
+{
+    dblock_alloc_mode_t modes[] = { DBLOCK_FIRST_FIT, DBLOCK_GOAL_DIRECTED };
+    for (size_t i = 0; i < sizeof(modes) / sizeof(*modes); ++i)
+    {
+        filesystem_t fs;
+        if (new_filesystem(&fs, SYNTHETIC_INODE_TOTAL, SYNTHETIC_DBLOCK_TOTAL) != SUCCESS) return;
+        report("(new file system)", &fs, modes[i]);
+        free_filesystem(&fs);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    printf("%-42s %-10s %8s %8s %8s\n", "image", "mode", "before", "after", "used");
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i) bench_image(argv[i]);
+        return 0;
+    }
+
+    for (size_t i = 0; i < sizeof(default_images) / sizeof(*default_images); ++i)
+        bench_image(default_images[i]);
+    bench_synthetic();
+    return 0;
+}
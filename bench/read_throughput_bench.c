@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * measures the throughput of sequential `inode_read_data` calls.
+ *
+ * without arguments a file system is made with a `FILE_MIB` MiB file in each block map
+ * layout: mapped by the index dblock chain and written in one go, so its data dblocks are
+ * contiguous between the index dblocks, written in `INTERLEAVE_BYTES` turns with a second
+ * file so it is made of runs, mapped by an index dblock tree and mapped as extents. each file
+ * is read front to back in reads of each size in `read_sizes` until `TARGET_BYTES` have been
+ * read, and the GB/s reached for every size is reported along with whether the data matches.
+ *
+ * with arguments every data file of every image given, `input/large.bin` say, is read the
+ * same way, the whole file per call since those files are small.
+ *
+ * usage: read_throughput_bench [image ...]
+ */
+
+#define FILE_MIB 64
+#define INTERLEAVE_BYTES 4096
+#define TARGET_BYTES ((size_t) 1 << 29)
+#define CACHE_BUDGET (1 << 20)
+
+enum layout { CHAIN, INTERLEAVED, TREE, EXTENTS };
+
+static const char *layout_names[] = { "chain", "interleaved", "tree", "extents" };
+static const size_t read_sizes[] = { 4096, 65536, 1 << 20 };
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// reads the inode front to back `len` bytes at a time until `target` bytes have been read
+static double read_gbps(filesystem_t *fs, inode_t *inode, byte *buffer, size_t len, size_t target)
+{
+    size_t size = inode->internal.file_size;
+    size_t total = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (total < target)
+    {
+        for (size_t offset = 0; offset < size; offset += len)
+        {
+            size_t bytes_read = 0;
+            inode_read_data(fs, inode, offset, buffer, len, &bytes_read);
+            total += bytes_read;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return total / elapsed_ns(start, end);
+}
+
+static int matches(filesystem_t *fs, inode_t *inode, const byte *data, byte *buffer)
+{
+    size_t bytes_read = 0;
+    inode_read_data(fs, inode, 0, buffer, inode->internal.file_size, &bytes_read);
+    return bytes_read == inode->internal.file_size && memcmp(buffer, data, bytes_read) == 0;
+}
+
+static void bench_layout(const byte *data, size_t file_bytes, byte *buffer, enum layout layout)
+{
+    size_t data_dblocks = file_bytes / DATA_BLOCK_SIZE;
+    filesystem_t fs;
+    if (new_filesystem(&fs, 3, data_dblocks * 2 + data_dblocks / 7 + 64) != SUCCESS) return;
+    // the chain is cached so that reads into the middle of it do not walk it from the start
+    fs.map_cache_budget = CACHE_BUDGET;
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = layout == TREE ? INODE_TREE_MAPPED : layout == EXTENTS ? INODE_EXTENT_MAPPED : 0;
+    if (layout == INTERLEAVED)
+    {
+        for (size_t written = 0; written < file_bytes; written += INTERLEAVE_BYTES)
+        {
+            inode_write_data(&fs, inode, (void *)(data + written), INTERLEAVE_BYTES);
+            inode_write_data(&fs, &fs.inodes[2], (void *)(data + written), INTERLEAVE_BYTES);
+        }
+    }
+    else inode_write_data(&fs, inode, (void *) data, file_bytes);
+
+    printf("%-12s", layout_names[layout]);
+    for (size_t i = 0; i < sizeof(read_sizes) / sizeof(*read_sizes); ++i)
+        printf(" %12.2f", read_gbps(&fs, inode, buffer, read_sizes[i], TARGET_BYTES));
+    printf(" %8s\n", matches(&fs, inode, data, buffer) ? "ok" : "FAILED");
+    free_filesystem(&fs);
+}
+
+static void bench_image(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    filesystem_t fs;
+    if (!file || load_filesystem(file, &fs) != SUCCESS)
+    {
+        fprintf(stderr, "cannot load %s\n", path);
+        if (file) fclose(file);
+        return;
+    }
+    fclose(file);
+
+    size_t largest = 0, files = 0, bytes = 0;
+    for (size_t i = 0; i < fs.inode_count; ++i)
+    {
+        inode_t *inode = &fs.inodes[i];
+        if (inode->internal.file_type != DATA_FILE || inode->internal.file_size == 0) continue;
+        if (inode->internal.file_size > largest) largest = inode->internal.file_size;
+        bytes += inode->internal.file_size;
+        ++files;
+    }
+    byte *buffer = malloc(largest ? largest : 1);
+    if (!buffer || files == 0)
+    {
+        free(buffer);
+        free_filesystem(&fs);
+        return;
+    }
+
+    // every file is read whole, in turns, until the target is reached
+    size_t total = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (total < TARGET_BYTES / 16)
+    {
+        for (size_t i = 0; i < fs.inode_count; ++i)
+        {
+            inode_t *inode = &fs.inodes[i];
+            if (inode->internal.file_type != DATA_FILE || inode->internal.file_size == 0) continue;
+            size_t bytes_read = 0;
+            inode_read_data(&fs, inode, 0, buffer, inode->internal.file_size, &bytes_read);
+            total += bytes_read;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%-30s %8zu %12zu %12.2f\n", path, files, bytes, total / elapsed_ns(start, end));
+    free(buffer);
+    free_filesystem(&fs);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        printf("%-30s %8s %12s %12s\n", "image", "files", "bytes", "GB/s");
+        for (int i = 1; i < argc; ++i) bench_image(argv[i]);
+        return 0;
+    }
+
+    size_t file_bytes = (size_t) FILE_MIB << 20;
+    byte *data = malloc(file_bytes);
+    byte *buffer = malloc(file_bytes);
+    if (!data || !buffer) return 1;
+    for (size_t i = 0; i < file_bytes; ++i) data[i] = (byte)(i * 7 + i / 4093);
+
+    printf("%-12s %12s %12s %12s %8s\n", "layout", "4K GB/s", "64K GB/s", "1M GB/s", "data");
+    for (int layout = CHAIN; layout <= EXTENTS; ++layout) bench_layout(data, file_bytes, buffer, layout);
+    free(buffer);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "filesys.h"
+
+/**
+ * measures how the cost of `new_filesystem` grows with its capacity.
+ *
+ * for every dblock total a file system is created, `WRITE_DBLOCKS` dblocks are claimed and
+ * written, and they are released and claimed again with lazy zeroing on. the time to create
+ * the file system and the resident memory after each step are reported, next to the time
+ * an up front memset of the whole dblock arena would take, which is what allocating it
+ * zeroed on the heap costs once it has to be touched.
+ *
+ * usage: startup_bench [dblock_total ...]
+ */
+
+#define WRITE_DBLOCKS 4096
+
+static const size_t default_totals[] = { 1 << 16, 1 << 18, 1 << 20, 1 << 22, 1 << 24 };
+
+static double elapsed_ms(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+// the resident set size of the process in MiB, from /proc/self/statm
+static double resident_mib(void)
+{
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    unsigned long size = 0, resident = 0;
+    if (fscanf(statm, "%lu %lu", &size, &resident) != 2) resident = 0;
+    fclose(statm);
+    return (double) resident * sysconf(_SC_PAGESIZE) / (1 << 20);
+}
+
+static void bench_total(size_t dblock_total)
+{
+    double before = resident_mib();
+    struct timespec start, end;
+    filesystem_t fs;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fs_retcode_t ret = new_filesystem(&fs, 2, dblock_total);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (ret != SUCCESS)
+    {
+        fprintf(stderr, "cannot create a file system of %zu dblocks\n", dblock_total);
+        return;
+    }
+    double created = resident_mib();
+
+    // a small amount of data, which is what the resident memory should follow
+    static dblock_index_t indices[WRITE_DBLOCKS];
+    size_t count = dblock_total - 1 < WRITE_DBLOCKS ? dblock_total - 1 : WRITE_DBLOCKS;
+    claim_available_dblocks(&fs, count, indices);
+    for (size_t i = 0; i < count; ++i) memset(&fs.dblocks[indices[i] * DATA_BLOCK_SIZE], 'x', DATA_BLOCK_SIZE);
+    double written = resident_mib();
+
+    fs.lazy_zero = 1;
+    release_dblocks(&fs, indices, count);
+    claim_available_dblocks(&fs, count, indices);
+    int zeroed = 1;
+    for (size_t i = 0; i < count; ++i) zeroed &= fs.dblocks[indices[i] * DATA_BLOCK_SIZE] == 0;
+    free_filesystem(&fs);
+
+    // the eager alternative, touching every byte of the arena
+    struct timespec eager_start, eager_end;
+    clock_gettime(CLOCK_MONOTONIC, &eager_start);
+    byte *arena = malloc(dblock_total * DATA_BLOCK_SIZE);
+    if (arena) memset(arena, 0, dblock_total * DATA_BLOCK_SIZE);
+    clock_gettime(CLOCK_MONOTONIC, &eager_end);
+    free(arena);
+
+    printf("%10zu %10.1f %10.2f %12.1f %12.1f %10.1f %8s\n", dblock_total, (double) dblock_total * DATA_BLOCK_SIZE / (1 << 20),
+        elapsed_ms(start, end), created - before, written - before, elapsed_ms(eager_start, eager_end), zeroed ? "ok" : "FAILED");
+}
+
+int main(int argc, char **argv)
+{
+    printf("%10s %10s %10s %12s %12s %10s %8s\n", "dblocks", "arena MiB", "new ms", "rss new MiB", "rss used MiB", "memset ms", "zeroed");
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            size_t dblock_total = strtoul(argv[i], NULL, 10);
+            if (dblock_total >= 2) bench_total(dblock_total);
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(default_totals) / sizeof(*default_totals); ++i) bench_total(default_totals[i]);
+    return 0;
+}
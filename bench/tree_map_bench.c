@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * compares random access through `fs_seek` and `fs_read` on files mapped with a chain of
+ * index dblocks, the same chain with the block map cache, and `INODE_TREE_MAPPED` files.
+ *
+ * for every file size a file system is created and one file is written whole with
+ * `fs_write`, then `RANDOM_READS` reads of `READ_BYTES` bytes are made at random offsets,
+ * each after an `fs_seek` to its offset. the average time of a seek and read, the index
+ * dblocks the file takes and whether every read returned the data written are reported. the
+ * chain costs more the further into the file a read is, the tree costs one index dblock per
+ * level whatever the offset.
+ *
+ * usage: tree_map_bench [file_kib ...]
+ */
+
+#define RANDOM_READS 20000
+#define READ_BYTES 64
+#define CACHE_BUDGET (1 << 20)
+
+enum layout { CHAIN, CACHED_CHAIN, TREE };
+
+static const char *layout_names[] = { "chain", "chain+cache", "tree" };
+static const size_t default_kibs[] = { 64, 256, 1024, 4096, 16384 };
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static void bench_layout(const byte *data, size_t file_bytes, enum layout layout)
+{
+    size_t data_dblocks = file_bytes / DATA_BLOCK_SIZE;
+    filesystem_t fs;
+    if (new_filesystem(&fs, 2, data_dblocks + data_dblocks / 12 + 64) != SUCCESS) return;
+    fs.tree_map_files = layout == TREE;
+    fs.map_cache_budget = layout == CACHED_CHAIN ? CACHE_BUDGET : 0;
+
+    terminal_context_t context = { &fs, &fs.inodes[0] };
+    // new_file cuts up the path it is given
+    char new_path[] = "./file", open_path[] = "./file";
+    fs_file_t file = NULL;
+    if (new_file(&context, new_path, (permission_t)(FS_READ | FS_WRITE)) == 0) file = fs_open(&context, open_path);
+    size_t available = available_dblocks(&fs);
+    if (!file || fs_write(file, (void *) data, file_bytes) != file_bytes)
+    {
+        fprintf(stderr, "cannot write a file of %zu bytes\n", file_bytes);
+        if (file) fs_close(file);
+        free_filesystem(&fs);
+        return;
+    }
+    size_t index_dblocks = available - available_dblocks(&fs) - data_dblocks;
+
+    byte buffer[READ_BYTES];
+    int matches = 1;
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < RANDOM_READS; ++i)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        size_t offset = rng % (file_bytes - READ_BYTES);
+        fs_seek(file, FS_SEEK_START, (int) offset);
+        matches &= fs_read(file, buffer, READ_BYTES) == READ_BYTES && memcmp(buffer, data + offset, READ_BYTES) == 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("%10zu %-12s %12zu %14.1f %8s\n", file_bytes / 1024, layout_names[layout], index_dblocks,
+        elapsed_ns(start, end) / RANDOM_READS, matches ? "ok" : "FAILED");
+    fs_close(file);
+    free_filesystem(&fs);
+}
+
+static void bench_size(size_t file_kib)
+{
+    size_t file_bytes = file_kib * 1024;
+    byte *data = malloc(file_bytes);
+    if (!data) return;
+    for (size_t i = 0; i < file_bytes; ++i) data[i] = (byte)(i * 7 + i / 4093);
+    bench_layout(data, file_bytes, CHAIN);
+    bench_layout(data, file_bytes, CACHED_CHAIN);
+    bench_layout(data, file_bytes, TREE);
+    free(data);
+}
+
+int main(int argc, char **argv)
+{
+    printf("%10s %-12s %12s %14s %8s\n", "file KiB", "map", "index dblks", "seek+read ns", "data");
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            size_t file_kib = strtoul(argv[i], NULL, 10);
+            if (file_kib > 0) bench_size(file_kib);
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(default_kibs) / sizeof(*default_kibs); ++i) bench_size(default_kibs[i]);
+    return 0;
+}
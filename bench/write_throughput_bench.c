@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/**
+ * measures the throughput of appends with `inode_write_data` and of overwrites with
+ * `inode_modify_data` for write sizes from 64 B to 64 MiB.
+ *
+ * for every write size and block map layout a file system is made, and a file is appended
+ * to one write at a time until it holds `FILE_MIB` MiB. the file is then overwritten front
+ * to back with writes of the same size. this is done `ROUNDS` times, and the MB/s of the
+ * fastest append and overwrite and whether the file held the data last written every time
+ * are reported. the index dblock chain is cached so that the writes do not walk it from the
+ * start.
+ *
+ * usage: write_throughput_bench [write_bytes ...]
+ */
+
+#define FILE_MIB 64
+#define CACHE_BUDGET (1 << 20)
+#define ROUNDS 5
+
+enum layout { CHAIN, TREE, EXTENTS };
+
+static const char *layout_names[] = { "chain", "tree", "extents" };
+static const size_t default_sizes[] = { 64, 512, 4096, 65536, 1 << 20, 8 << 20, 64 << 20 };
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static size_t min_len(size_t a, size_t b)
+{
+    return a < b ? a : b;
+}
+
+// appends a file of `file_bytes` bytes `len` bytes at a time, then overwrites it, and adds
+// the time of both to `append_ns` and `overwrite_ns`. returns whether the data matches
+static int write_file(const byte *data, size_t file_bytes, byte *buffer, size_t len, enum layout layout, double *append_ns, double *overwrite_ns)
+{
+    size_t data_dblocks = file_bytes / DATA_BLOCK_SIZE;
+    filesystem_t fs;
+    // an extent mapped inode reserves an extent dblock for every few data dblocks it grows by
+    if (new_filesystem(&fs, 2, data_dblocks + data_dblocks / 4 + 64) != SUCCESS) return 0;
+    fs.map_cache_budget = CACHE_BUDGET;
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = layout == TREE ? INODE_TREE_MAPPED : layout == EXTENTS ? INODE_EXTENT_MAPPED : 0;
+
+    int matches = 1;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t written = 0; written < file_bytes; written += len)
+        matches &= inode_write_data(&fs, inode, (void *)(data + written), min_len(len, file_bytes - written)) == SUCCESS;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *append_ns = elapsed_ns(start, end);
+
+    // the data is written shifted by one byte so the overwrite changes every byte
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t offset = 0; offset < file_bytes; offset += len)
+        matches &= inode_modify_data(&fs, inode, offset, (void *)(data + offset + 1), min_len(len, file_bytes - offset)) == SUCCESS;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *overwrite_ns = elapsed_ns(start, end);
+
+    size_t bytes_read = 0;
+    inode_read_data(&fs, inode, 0, buffer, file_bytes, &bytes_read);
+    matches &= bytes_read == file_bytes && inode->internal.file_size == file_bytes && memcmp(buffer, data + 1, file_bytes) == 0;
+    free_filesystem(&fs);
+    return matches;
+}
+
+static void bench_layout(const byte *data, size_t file_bytes, byte *buffer, size_t len, enum layout layout)
+{
+    double best_append = 0, best_overwrite = 0;
+    int matches = 1;
+    for (int i = 0; i < ROUNDS; ++i)
+    {
+        double append_ns, overwrite_ns;
+        matches &= write_file(data, file_bytes, buffer, len, layout, &append_ns, &overwrite_ns);
+        if (i == 0 || append_ns < best_append) best_append = append_ns;
+        if (i == 0 || overwrite_ns < best_overwrite) best_overwrite = overwrite_ns;
+    }
+    printf("%12zu %-10s %14.1f %14.1f %8s\n", len, layout_names[layout], file_bytes / (best_append / 1e9) / (1 << 20),
+        file_bytes / (best_overwrite / 1e9) / (1 << 20), matches ? "ok" : "FAILED");
+}
+
+int main(int argc, char **argv)
+{
+    size_t file_bytes = (size_t) FILE_MIB << 20;
+    byte *data = malloc(file_bytes + 1);
+    byte *buffer = malloc(file_bytes);
+    if (!data || !buffer) return 1;
+    for (size_t i = 0; i <= file_bytes; ++i) data[i] = (byte)(i * 7 + i / 4093);
+
+    printf("%12s %-10s %14s %14s %8s\n", "write bytes", "map", "append MB/s", "overwrite MB/s", "data");
+    size_t count = argc > 1 ? (size_t) argc - 1 : sizeof(default_sizes) / sizeof(*default_sizes);
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t len = argc > 1 ? strtoul(argv[i + 1], NULL, 10) : default_sizes[i];
+        if (len == 0) continue;
+        for (int layout = CHAIN; layout <= EXTENTS; ++layout) bench_layout(data, file_bytes, buffer, len, layout);
+    }
+    free(buffer);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * kernels over bitmaps laid out like the dblock bitmask: bit n is the (7 - n % 8)th bit of
+ * byte n / 8, so the lowest index sits in the most significant bit of each byte.
+ *
+ * the bulk of every range is handed to a kernel built for the best instruction set the
+ * processor supports, picked the first time one of the functions is called.
+ */
+
+typedef enum bitmap_isa
+{
+    BITMAP_ISA_PORTABLE,
+    BITMAP_ISA_SSE42,
+    BITMAP_ISA_AVX2
+} bitmap_isa_t;
+
+extern const char *bitmap_isa_string_table[];
+
+/**
+ * returns the instruction set the kernels currently run on.
+ */
+bitmap_isa_t bitmap_active_isa(void);
+
+/**
+ * switches the kernels to another instruction set, mostly so the paths can be compared.
+ *
+ * @param isa the instruction set to run the kernels on
+ * @return 0 if the kernels switched, -1 if the processor does not support `isa`
+ */
+int bitmap_select_isa(bitmap_isa_t isa);
+
+/**
+ * counts the set bits with an index in [from, to).
+ *
+ * @param bits the bitmap to count in
+ * @param from the first bit to count
+ * @param to the bit past the last one to count
+ * @return the number of set bits in the range, 0 if it is empty
+ */
+size_t bitmap_popcount(const uint8_t *bits, size_t from, size_t to);
+
+/**
+ * finds the lowest set bit with an index in [from, to).
+ *
+ * @param bits the bitmap to search
+ * @param from the first bit to look at
+ * @param to the bit past the last one to look at
+ * @param index where the index of the bit found is stored
+ * @return 1 if a set bit was found, 0 otherwise
+ */
+int bitmap_find_first_set(const uint8_t *bits, size_t from, size_t to, size_t *index);
+
+/**
+ * finds the lowest clear bit with an index in [from, to).
+ *
+ * @param bits the bitmap to search
+ * @param from the first bit to look at
+ * @param to the bit past the last one to look at
+ * @param index where the index of the bit found is stored
+ * @return 1 if a clear bit was found, 0 otherwise
+ */
+int bitmap_find_first_clear(const uint8_t *bits, size_t from, size_t to, size_t *index);
+
+/**
+ * finds the lowest run of at least `run` consecutive set bits inside [from, to).
+ *
+ * @param bits the bitmap to search
+ * @param from the first bit to look at
+ * @param to the bit past the last one to look at
+ * @param run the number of consecutive set bits wanted, at least 1
+ * @param index where the index of the first bit of the run is stored
+ * @return 1 if a run was found, 0 otherwise or if `run` is 0
+ */
+int bitmap_find_run(const uint8_t *bits, size_t from, size_t to, size_t run, size_t *index);
+
+/**
+ * counts the maximal runs of set bits inside [from, to) that are at least `run` bits long.
+ * with `run` at 1 this is the number of runs of set bits in the range.
+ *
+ * @param bits the bitmap to count in
+ * @param from the first bit to look at
+ * @param to the bit past the last one to look at
+ * @param run the shortest run that counts, at least 1
+ * @return the number of runs, 0 if `run` is 0
+ */
+size_t bitmap_count_runs(const uint8_t *bits, size_t from, size_t to, size_t run);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef BLOCK_MAP_CACHE_H
+#define BLOCK_MAP_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * the index dblock chains of inodes, keyed by inode index. entry k of the chain of an inode
+ * is its k-th index dblock, so the index dblock listing any data dblock is found without
+ * walking the chain. chains are only ever known from their start, and grow one entry at a
+ * time as they are walked or appended to. the least recently used chains are dropped to keep
+ * the memory they take within a budget.
+ */
+
+typedef struct cached_chain cached_chain_t;
+
+typedef struct block_map_cache
+{
+    cached_chain_t **buckets;   // chains hashed by key, each bucket a singly linked list
+    size_t bucket_count;        // a power of two, 0 until the first chain is cached
+    cached_chain_t *newest;     // the most recently used chain, the head of the LRU list
+    cached_chain_t *oldest;     // the least recently used chain, dropped first
+    size_t count;               // chains cached
+    size_t bytes;               // memory the chains and buckets take
+    size_t hits;                // lookups the cached entries answered, counted by the user
+    size_t misses;              // lookups that walked past them, counted by the user
+    size_t evictions;           // chains dropped to stay within the budget
+} block_map_cache_t;
+
+/**
+ * makes `cache` empty, with zero counters.
+ *
+ * @param cache the cache to initialize
+ */
+void block_map_cache_init(block_map_cache_t *cache);
+
+/**
+ * frees every chain of `cache` and leaves it empty. the counters are kept.
+ *
+ * @param cache the cache to clear
+ */
+void block_map_cache_clear(block_map_cache_t *cache);
+
+/**
+ * finds the chain cached for `key` and makes it the most recently used one.
+ *
+ * @param cache the cache to search
+ * @param key the inode index the chain belongs to
+ * @param chain where a pointer to the entries is stored, valid until the cache changes
+ * @return the number of entries known from the start of the chain, 0 if none are
+ */
+size_t block_map_cache_find(block_map_cache_t *cache, size_t key, const uint32_t **chain);
+
+/**
+ * records entry k of the chain of `key`, which only happens when exactly k entries are known.
+ * older chains are dropped until the cache fits in `budget` bytes. a chain that would not
+ * fit on its own stops growing instead.
+ *
+ * @param cache the cache to add to
+ * @param key the inode index the chain belongs to
+ * @param k the position of the entry in the chain
+ * @param entry the index dblock at that position
+ * @param budget the most bytes the cache may take
+ */
+void block_map_cache_extend(block_map_cache_t *cache, size_t key, size_t k, uint32_t entry, size_t budget);
+
+/**
+ * forgets every entry of the chain of `key` from position `len` on, and the chain itself
+ * if no entry is left.
+ *
+ * @param cache the cache to change
+ * @param key the inode index the chain belongs to
+ * @param len the number of entries to keep
+ */
+void block_map_cache_truncate(block_map_cache_t *cache, size_t key, size_t len);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef EXTENT_TREE_H
+#define EXTENT_TREE_H
+
+#include <stddef.h>
+
+/**
+ * a set of disjoint extents [start, start + len), kept in two red-black trees: one ordered by
+ * start, to find the neighbours of an extent, and one ordered by length and then start, to
+ * find the best fit for a length. touching extents are merged as they are added, so no two
+ * extents in the set are adjacent.
+ */
+
+typedef struct extent extent_t;
+
+typedef struct extent_tree
+{
+    struct rb_node *by_start;  // root of the tree ordered by start
+    struct rb_node *by_length; // root of the tree ordered by length, then start
+    extent_t *unused;          // nodes of removed extents, kept for the next ones
+    size_t count;              // extents in the set
+    size_t total;              // sum of their lengths
+} extent_tree_t;
+
+/**
+ * makes `tree` an empty set.
+ *
+ * @param tree the set to initialize
+ */
+void extent_tree_init(extent_tree_t *tree);
+
+/**
+ * frees every node of `tree` and leaves it empty.
+ *
+ * @param tree the set to clear
+ */
+void extent_tree_clear(extent_tree_t *tree);
+
+/**
+ * adds [start, start + len) to the set, merging it with the extents it overlaps or touches.
+ *
+ * @param tree the set to add to
+ * @param start the first index of the extent
+ * @param len the length of the extent, 0 adds nothing
+ * @return 0 if it was added, -1 if a node could not be allocated
+ */
+int extent_tree_add(extent_tree_t *tree, size_t start, size_t len);
+
+/**
+ * removes [start, start + len) from the set, splitting the extents it covers part of.
+ *
+ * @param tree the set to remove from
+ * @param start the first index to remove
+ * @param len the number of indices to remove, 0 removes nothing
+ * @return 0 if it was removed, -1 if a node could not be allocated, in which case the set
+ *         holds a subset of what it should
+ */
+int extent_tree_remove(extent_tree_t *tree, size_t start, size_t len);
+
+/**
+ * finds the shortest extent holding at least `len` indices, the lowest one among those of
+ * the same length.
+ *
+ * @param tree the set to search
+ * @param len the length wanted
+ * @param start where the start of the extent found is stored
+ * @param found_len where its length is stored
+ * @return 1 if there is such an extent, 0 otherwise
+ */
+int extent_tree_best_fit(const extent_tree_t *tree, size_t len, size_t *start, size_t *found_len);
+
+/**
+ * finds the longest extent, the lowest one among those of the same length.
+ *
+ * @param tree the set to search
+ * @param start where the start of the extent found is stored
+ * @param len where its length is stored
+ * @return 1 if the set is not empty, 0 otherwise
+ */
+int extent_tree_longest(const extent_tree_t *tree, size_t *start, size_t *len);
+
+/**
+ * finds the extent holding `at`, or the first one after it.
+ *
+ * @param tree the set to search
+ * @param at the index to look from
+ * @param start where the start of the extent found is stored
+ * @param len where its length is stored
+ * @return 1 if there is such an extent, 0 otherwise
+ */
+int extent_tree_find(const extent_tree_t *tree, size_t at, size_t *start, size_t *len);
+
+#endif
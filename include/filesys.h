@@ -2,7 +2,8 @@
 #define FILESYS_H
 
 /**
- * !! DO NOT MODIFY THIS FILE !!
+ * !! the saved image format follows the types below, so change them only together with
+ * `load_filesystem` and `save_filesystem` !!
  */
 
 #include <stdint.h>
@@ -22,7 +23,11 @@ do { \
 
 typedef uint8_t byte;
 typedef uint32_t dblock_index_t;
-typedef uint16_t inode_index_t;
+// inode indices are 32 bits in memory whatever the geometry. classic images still store
+// them in 16 bits, in the header, in directory entries and in the free inode links, so a
+// classic file system holds at most `CLASSIC_MAX_INODE_COUNT` inodes. large images store
+// all 32 bits, see `fs_geometry_t`
+typedef uint32_t inode_index_t;
 
 typedef enum fs_retcode
 {
@@ -62,11 +67,35 @@ typedef enum permission
     FS_EXECUTE = 0x4
 } permission_t;
 
+// an inode with `INODE_EXTENT_MAPPED` set in `map_flags` maps its data dblocks as extents,
+// runs of consecutive dblocks, instead of one entry per data dblock. direct_data holds the
+// first `INODE_INLINE_EXTENT_COUNT` extents as (start, length) pairs, and indirect_dblock is
+// the first of a chain of extent dblocks. an extent dblock holds `EXTENT_DBLOCK_RECORD_COUNT`
+// (start, length, logical dblock) records followed by the index of the next extent dblock,
+// like an index dblock. the inline extents start the file, so their logical dblock is
+// implied. the lengths add up to the data dblocks of the file
+#define INODE_EXTENT_MAPPED 0x1
+#define INODE_INLINE_EXTENT_COUNT (INODE_DIRECT_BLOCK_COUNT / 2)
+#define EXTENT_DBLOCK_RECORD_COUNT ((DATA_BLOCK_SIZE - sizeof(dblock_index_t)) / (3 * sizeof(dblock_index_t)))
+
+// an inode with `INODE_TREE_MAPPED` set in `map_flags` keeps its first data dblocks in
+// direct_data like any other, and the rest in a tree of index dblocks rooted at
+// indirect_dblock, as the indirect blocks of the Unix file system do. every index dblock of
+// the tree holds `INODE_TREE_FANOUT` entries and no next pointer. the leaves list data
+// dblocks and the nodes above them list index dblocks one level down, so a tree of height h
+// maps `INODE_TREE_FANOUT`^h data dblocks and any of them is h index dblocks away from the
+// inode. the height is the lowest one that maps every data dblock past the direct ones, so
+// it follows from the file size. a full tree grows a level by taking a new root whose first
+// entry is the old one, and a shrinking one drops its top levels the same way
+#define INODE_TREE_MAPPED 0x2
+#define INODE_TREE_FANOUT (DATA_BLOCK_SIZE / sizeof(dblock_index_t))
+
 struct inode_internal
 {
     file_type_t file_type;
     permission_t file_perms;
     char file_name[MAX_FILE_NAME_LEN];
+    uint8_t map_flags; // `INODE_EXTENT_MAPPED`, `INODE_TREE_MAPPED` or 0, in what used to be padding so images keep their layout
     size_t file_size;
     dblock_index_t direct_data[INODE_DIRECT_BLOCK_COUNT];
     dblock_index_t indirect_dblock;
@@ -78,14 +107,204 @@ typedef union inode
     struct inode_internal internal;
 } inode_t;
 
+typedef enum dblock_alloc_mode
+{
+    DBLOCK_FIRST_FIT,   // always hand out the lowest available dblock
+    DBLOCK_NEXT_FIT,    // resume the search after the last claimed dblock
+    DBLOCK_GOAL_DIRECTED, // place dblocks of a file after its current last dblock
+    DBLOCK_ATOMIC,      // claim and release dblocks with atomic operations, safe across threads
+    DBLOCK_EXTENT_TREE, // hand out the shortest run of available dblocks that fits, from an extent tree
+    DBLOCK_BUDDY        // hand out runs from the smallest aligned power of two block that fits
+} dblock_alloc_mode_t;
+
+// in `DBLOCK_ATOMIC` mode the dblock claim and release functions, `fs_reserve` and friends,
+// `available_dblocks` and `inode_write_data` on different inodes may be called from several
+// threads at once. inode claims, the directory functions and changing the mode still need
+// to be done from one thread at a time
+
+// in `DBLOCK_EXTENT_TREE` mode the runs of available dblocks are also kept in a tree indexed
+// by start and by length, so a claim finds the best fit without scanning the bitmask. the
+// bitmask stays what is saved, the tree is rebuilt from it when needed
+
+// while `map_cache_budget` is set, the inode functions remember the index dblock chain of
+// every inode they walk, so the index dblock listing any data dblock of a file is found
+// without following the chain from its start. the chains are kept in step with appends and
+// shrinks, and the least recently used ones are dropped to stay within the budget. the
+// cache is not used in `DBLOCK_ATOMIC` mode, where writes to several inodes may race
+
+// in `DBLOCK_BUDDY` mode the available dblocks are also kept as blocks of 2^k dblocks that
+// start at a multiple of 2^k, with a free list per k. a claim of n dblocks takes them from the
+// start of a block of the lowest k with 2^k >= n, so it is found in O(log n) and the
+// dblocks are contiguous and aligned, and released dblocks merge back with their buddies.
+// the lists are not saved, images of this mode are the same as any other and load in
+// `DBLOCK_FIRST_FIT` mode
+
+typedef enum inode_alloc_mode
+{
+    INODE_FREE_LIST,    // always hand out the head of the free inode list
+    INODE_BLOCK_GROUPS, // spread directories across block groups, keep files in their parent's group
+    INODE_BITMAP        // hand out the lowest available inode, or the first one after the parent
+} inode_alloc_mode_t;
+
+// how wide inode indices are where a file system stores them, in the image header and in
+// directory entries. classic images store them in 2 bytes and so hold at most
+// `CLASSIC_MAX_INODE_COUNT` inodes. large geometry images store them in 4 bytes and set
+// `FS_LARGE_GEOMETRY_FLAG` in the inode count they start with, which code that only knows
+// classic images reads as a count no image can have
+typedef enum fs_geometry
+{
+    FS_GEOMETRY_CLASSIC,
+    FS_GEOMETRY_LARGE
+} fs_geometry_t;
+
+#define CLASSIC_MAX_INODE_COUNT ((size_t) 1 << 16)
+#define LARGE_MAX_INODE_COUNT ((size_t) 1 << 32)
+#define FS_LARGE_GEOMETRY_FLAG ((size_t) 1 << 63)
+
+// a directory entry is an inode index followed by a name of up to MAX_FILE_NAME_LEN - 1
+// bytes and a null byte. large geometry entries are padded to 32 bytes so an entry never
+// straddles two dblocks
+#define CLASSIC_DIRECTORY_ENTRY_SIZE (sizeof(uint16_t) + MAX_FILE_NAME_LEN)
+#define LARGE_DIRECTORY_ENTRY_SIZE 32
+
+// options `new_filesystem_with_options` creates a file system with
+typedef struct fs_options
+{
+    inode_alloc_mode_t inode_alloc_mode;
+    dblock_alloc_mode_t dblock_alloc_mode;
+    fs_geometry_t geometry;
+} fs_options_t;
+
+// images of file systems using any of these features end with a trailer listing them
+// after the dblocks. images without a trailer load with every feature off
+typedef enum fs_feature
+{
+    FS_FEATURE_INODE_BITMAP = 0x1,  // inodes are claimed in `INODE_BITMAP` mode
+    FS_FEATURE_EXTENT_TREE = 0x2,   // dblocks are claimed in `DBLOCK_EXTENT_TREE` mode
+    FS_FEATURE_EXTENT_MAP = 0x4,    // some inodes are `INODE_EXTENT_MAPPED`
+    FS_FEATURE_INDIRECT_TREE = 0x8  // some inodes are `INODE_TREE_MAPPED`
+} fs_feature_t;
+
+// dblocks per block group unless `set_block_group_size` picks another size. one dblock
+// worth of bitmask covers this many dblocks, as in ext2
+#define DEFAULT_BLOCK_GROUP_DBLOCK_COUNT (DATA_BLOCK_SIZE * 8)
+
+// block group g owns inodes [g * group_inode_count, (g + 1) * group_inode_count) and
+// dblocks [g * group_dblock_count, (g + 1) * group_dblock_count) along with the slice of
+// `dblock_bitmask` that covers them. only its free counters are stored separately
+typedef struct block_group
+{
+    size_t free_inode_count;
+    size_t free_dblock_count;
+} block_group_t;
+
+// a run of dblocks claimed ahead of time for the appends of one open file
+typedef struct dblock_window
+{
+    dblock_index_t start;
+    size_t len;
+} dblock_window_t;
+
+// appends `fs_write` holds on to until `fs_flush` gives them data blocks
+typedef struct fs_write_buffer
+{
+    byte *data;
+    size_t len;
+    size_t cap;
+} fs_write_buffer_t;
+
+// capacity set aside by `fs_reserve` for one multi step operation, see `fs_reserve`
+typedef struct fs_reservation
+{
+    size_t dblocks;
+    size_t inodes;
+} fs_reservation_t;
+
+// the dblocks and inodes one thread caches, see `fs_drain_magazines`
+typedef struct fs_magazine fs_magazine_t;
+
+// what the dblock claim and release functions did while `alloc_stats` points here. the
+// counters are added to without atomic operations, so they are only exact while one thread
+// at a time claims and releases
+typedef struct dblock_alloc_stats
+{
+    size_t dblocks_claimed;
+    size_t dblocks_released;
+    size_t bitmask_words; // 64 bit words of `dblock_bitmask` loaded or stored on the way
+} dblock_alloc_stats_t;
+
+struct filesystem;
+
+// a dblock allocation policy, see `set_dblock_allocator`. the claim and release functions
+// check their arguments, serve the magazines and zero lazily released dblocks themselves, and
+// leave picking the dblocks and marking them in the bitmask to the policy of the file system.
+// whatever a policy keeps next to the bitmask, it keeps in step with the bitmask
+typedef struct dblock_allocator
+{
+    const char *name;
+    dblock_alloc_mode_t mode; // what `dblock_alloc_mode` reads while the policy is in use
+    int concurrent; // set if claims and releases can run on several threads without the magazine lock
+    // builds what the policy keeps next to the bitmask from it, NULL if it keeps nothing
+    fs_retcode_t (*attach)(struct filesystem *fs);
+    // claims one dblock for `claim_available_dblock`
+    fs_retcode_t (*claim)(struct filesystem *fs, dblock_index_t *index);
+    // claims one dblock close to `goal` for `claim_dblock_near`, NULL if the policy has no use for goals
+    fs_retcode_t (*claim_near)(struct filesystem *fs, dblock_index_t goal, dblock_index_t *index);
+    // takes `n` dblocks out of the bitmask whose units the caller already took out of the
+    // unreserved count, so there are always enough
+    void (*take)(struct filesystem *fs, size_t n, dblock_index_t *out);
+    // claims a run of up to `want` dblocks for `claim_dblock_range`
+    fs_retcode_t (*claim_range)(struct filesystem *fs, size_t want, dblock_index_t goal, dblock_index_t *start, size_t *len);
+    // marks dblocks [start, start + len) as available
+    void (*release_range)(struct filesystem *fs, size_t start, size_t len);
+    // marks the `n` dblocks in `indices` as available
+    void (*release_list)(struct filesystem *fs, const dblock_index_t *indices, size_t n);
+} dblock_allocator_t;
+
 typedef struct filesystem
 {   
     inode_index_t available_inode; 
     inode_t *inodes;
     size_t inode_count;
+    size_t inode_arena_cap; // inodes the address space after `inodes` is reserved for, see `fs_resize`
     byte *dblock_bitmask;
     byte *dblocks;
     size_t dblock_count;
+    dblock_alloc_mode_t dblock_alloc_mode; // the mode of `allocator`, changed with `set_dblock_allocator`
+    const dblock_allocator_t *allocator; // the policy dblocks are claimed with, see `set_dblock_allocator`
+    dblock_alloc_stats_t *alloc_stats; // NULL unless the claims and releases are counted
+    size_t dblock_cursor; // dblock index following the last claimed dblock
+    dblock_index_t *dblock_hints; // where empty inode n places its first dblock, NULL until a hint is set, see `set_dblock_hint`
+    size_t free_inode_count; // kept up to date by the claim and release functions
+    size_t free_dblock_count;
+    uint64_t *dblock_summary; // bit n is set if dblocks [64n, 64n + 64) have an available one
+    uint64_t *dblock_summary_top; // bit n is set if `dblock_summary` word n is not zero
+    inode_alloc_mode_t inode_alloc_mode;
+    block_group_t *groups;
+    size_t group_count;
+    size_t group_inode_count;
+    size_t group_dblock_count; // always a multiple of 64
+    uint64_t *inode_free_bits; // bit n % 64 of word n / 64 is set if inode n is available
+    inode_index_t *inode_free_prev; // the inode before inode n in the free list, 0 for the head
+    size_t prealloc_window; // dblocks `fs_write` reserves ahead of an open file, 0 disables it
+    int delayed_alloc; // `fs_write` buffers appends until `fs_flush` or `fs_close` if set
+    size_t unreserved_inode_count; // `free_inode_count` less what `fs_reserve` holds
+    size_t unreserved_dblock_count;
+    size_t magazine_size; // dblocks and inodes a thread's magazine trades with `fs` at once, 0 disables them
+    fs_magazine_t *magazines; // the magazine of every thread that used `fs`
+    size_t magazine_stamp; // tells `fs` apart from an earlier file system at the same address
+    int magazine_lock;
+    struct extent_tree *extents; // the available dblocks as extents, NULL until `DBLOCK_EXTENT_TREE` mode needs them
+    int extents_stale; // set when `extents` missed a change and has to be rebuilt from the bitmask
+    struct dblock_buddy *buddy; // the free lists of `DBLOCK_BUDDY` mode, NULL until it needs them
+    int buddy_stale; // set when `buddy` missed a change and has to be rebuilt from the bitmask
+    int extent_map_files; // `new_file` makes extent mapped data files if set, see `INODE_EXTENT_MAPPED`
+    int tree_map_files; // `new_file` makes tree mapped data files if set and `extent_map_files` is not, see `INODE_TREE_MAPPED`
+    size_t map_cache_budget; // bytes the index dblock chains of inodes may be cached in, 0 disables the cache
+    struct block_map_cache *map_cache; // the cached chains, NULL until an inode function needs them
+    int lazy_zero; // dblocks released while set are zeroed when they are claimed again, see `fs_zero_released`
+    uint64_t *dblock_needs_zero; // bit n % 64 of word n / 64 is set if dblock n was released and not zeroed yet
+    fs_geometry_t geometry;
 } filesystem_t;
 
 /*----------------------------------------------------*
@@ -127,15 +346,36 @@ typedef struct filesystem
  * the first dblock should contain one directory entry. the first directory entry
  * should have an inode index of 0 and have the entry name be '.'
  * 
+ * the file system has classic geometry, so `inode_total` can be at most
+ * `CLASSIC_MAX_INODE_COUNT`.
+ * 
  * @param fs the file system to initialize
  * @param inode_total the total number of inodes in the file system
  * @param dblock_total the total number of data blocks in the file system
  * @return SUCCESS if file system is correctly initilaized.
  *         INVALID_INPUT if `inode_total` or `dblock_total` is equal to 0.
+ *         INVALID_INPUT if `inode_total` is more than the geometry can index.
  *         INVALID_INPUT if fs is null 
  */
 fs_retcode_t new_filesystem(filesystem_t *fs, size_t inode_total, size_t dblock_total);
 
+/**
+ * creates a new filesystem like `new_filesystem` with the allocators and geometry picked by
+ * `options`. choices that change how the file system is used later on, like `INODE_BITMAP`,
+ * `DBLOCK_EXTENT_TREE` and `FS_GEOMETRY_LARGE`, are recorded in the image by
+ * `save_filesystem` and restored by `load_filesystem`.
+ * 
+ * @param fs the file system to initialize
+ * @param inode_total the total number of inodes in the file system, at most
+ *        `LARGE_MAX_INODE_COUNT` in large geometry
+ * @param dblock_total the total number of data blocks in the file system
+ * @param options the allocators and geometry to use
+ * @return SUCCESS if file system is correctly initilaized.
+ *         INVALID_INPUT if `fs` or `options` is null, or `new_filesystem` fails.
+ *         SYSTEM_ERROR if the extent tree of `DBLOCK_EXTENT_TREE` mode cannot be built.
+ */
+fs_retcode_t new_filesystem_with_options(filesystem_t *fs, size_t inode_total, size_t dblock_total, const fs_options_t *options);
+
 /**
  * free any buffer allocated for `fs`, but does not attempt to free `fs` itself.abs
  * if fs is null, then do not free anything.
@@ -150,8 +390,10 @@ void free_filesystem(filesystem_t *fs);
 /**
  * calculates the available number of inodes in a file system
  * 
- * iterates through inactive inodes via their `next_free_inode` field,
- * starting from the `available_inode` field of the file system argument
+ * returns the `free_inode_count` maintained by `claim_available_inode` and
+ * `release_inode`, less the inodes held by `fs_reserve`. `load_filesystem` computes it by
+ * iterating through inactive inodes via their `next_free_inode` field, starting from the
+ * `available_inode` field.
  * 
  * @param fs the file system to calculate the available inodes in
  * @return the number of available inodes in the `fs`. if `fs` is null, 0.
@@ -161,7 +403,9 @@ size_t available_inodes(filesystem_t *fs);
 /**
  * calculates the available number of data blocks in a file system
  * 
- * uses the bitmask in `fs` to calculate the available data blocks.
+ * returns the `free_dblock_count` maintained by `claim_available_dblock` and
+ * `release_dblock`, less the data blocks held by `fs_reserve`. the claim functions only
+ * hand out these unreserved ones. `load_filesystem` computes it from the bitmask in `fs`:
  * if the bit is set, then it is available. if not, then it is unavailable.
  * 
  * @param fs the file system to calculate the available data blocks in
@@ -176,7 +420,8 @@ size_t available_dblocks(filesystem_t *fs);
  * uses the `available_inode` field of the `fs` to claim that inode. 
  * `available_inode` needs to be correctly updated to be the index of the subsequent
  * free inode to the one being claimed. the index of the claimed inode is stored
- * in the `index` pointer.
+ * in the `index` pointer. in `INODE_BITMAP` mode the lowest available inode is claimed
+ * instead, and unlinked from wherever it is in the free list.
  * 
  * @param fs the file system to claim the inode from
  * @param index the address to store the index of the claimed inode in
@@ -193,6 +438,10 @@ fs_retcode_t claim_available_inode(filesystem_t *fs, inode_index_t *index);
  * uses the `dblock_bitmask` of `fs` to determine the index of the first available data block.
  * the bitmask is updated to mark the data block as unavailable. 
  * 
+ * the bitmask is scanned 64 dblocks at a time. in `DBLOCK_FIRST_FIT` mode (the default)
+ * the scan starts at dblock 0. in `DBLOCK_NEXT_FIT` mode the scan starts at `dblock_cursor`
+ * and wraps around to dblock 0. `dblock_cursor` is updated on every successful claim.
+ * 
  * @param fs the file system to claim the data block from
  * @param index the address to store the index of the claimed data block in
  * @return SUCCESS if the data block is successfully claimed.
@@ -201,6 +450,86 @@ fs_retcode_t claim_available_inode(filesystem_t *fs, inode_index_t *index);
  */
 fs_retcode_t claim_available_dblock(filesystem_t *fs, dblock_index_t *index);
 
+/**
+ * claims an available data block as close after `goal` as possible.
+ * 
+ * in `DBLOCK_GOAL_DIRECTED` mode `goal` itself is claimed if it is available. otherwise the
+ * block group of `goal` is scanned from `goal`, wrapping around to the start of the group, 
+ * for a byte of the bitmask whose 8 data blocks are all available, and the first of them 
+ * is claimed. only if there is no such byte is the first available data block after `goal`
+ * in the group claimed. groups without available data blocks are skipped, and the following
+ * groups are searched the same way from their start. every other mode ignores `goal` and 
+ * claims the same data block `claim_available_dblock` would.
+ * 
+ * @param fs the file system to claim the data block from
+ * @param goal the preferred data block index. out of range goals start at 0.
+ * @param index the address to store the index of the claimed data block in
+ * @return SUCCESS if the data block is successfully claimed.
+ *         INVALID_INPUT if `fs` or `index` is null.
+ *         DBLOCK_UNAVAILABLE if there are no available data blocks.
+ */
+fs_retcode_t claim_dblock_near(filesystem_t *fs, dblock_index_t goal, dblock_index_t *index);
+
+/**
+ * claims an available inode for a new file or directory inside `parent`.
+ * 
+ * in `INODE_BLOCK_GROUPS` mode a directory goes to the block group with the most available
+ * dblocks among the groups with at least the average number of available inodes, and a
+ * data file goes to the group of `parent`. the lowest available inode of that group is 
+ * claimed, moving on to the following groups if it has none. in `INODE_BITMAP` mode the
+ * first available inode after `parent` is claimed, wrapping around to the start of the
+ * inode table. every other mode claims the same inode `claim_available_inode` would.
+ * 
+ * @param fs the file system to claim the inode from
+ * @param parent the index of the directory the new inode is created in
+ * @param type the file type the inode is claimed for
+ * @param index the address to store the index of the claimed inode in
+ * @return SUCCESS if the inode is successfully claimed.
+ *         INVALID_INPUT if `fs` or `index` is null or `parent` is out of range.
+ *         INODE_UNAVAILABLE if there are no available inodes.
+ */
+fs_retcode_t claim_inode_near(filesystem_t *fs, inode_index_t parent, file_type_t type, inode_index_t *index);
+
+/**
+ * returns the built in dblock allocation policy of `mode`. `new_filesystem` and
+ * `load_filesystem` start a file system off with one of these, and every claim and release
+ * function goes through it.
+ * 
+ * @param mode the mode to get the policy of
+ * @return the policy, or NULL if `mode` is not a dblock allocation mode
+ */
+const dblock_allocator_t *dblock_allocator_for_mode(dblock_alloc_mode_t mode);
+
+/**
+ * makes `allocator` the policy the dblock claim and release functions of `fs` go through.
+ * 
+ * `dblock_alloc_mode` is set to the mode of the policy, and the policy builds what it keeps
+ * next to the bitmask with its `attach` function. the dblocks that are claimed stay claimed,
+ * whichever policy claimed them. this is the only way to change the mode, which
+ * `dblock_alloc_mode` reports: pass `dblock_allocator_for_mode` to switch to a built in one.
+ * 
+ * @param fs the file system to set the policy of
+ * @param allocator the policy, which has to outlive its use by `fs`
+ * @return SUCCESS if the policy is in use.
+ *         INVALID_INPUT if `fs` or `allocator` is null, or a function `allocator` needs is null.
+ *         whatever `attach` returns if it fails, in which case the previous policy stays.
+ */
+fs_retcode_t set_dblock_allocator(filesystem_t *fs, const dblock_allocator_t *allocator);
+
+/**
+ * changes the number of dblocks per block group and recomputes the groups.
+ * 
+ * the inodes are split evenly between the groups. the groups only affect which inodes and
+ * dblocks are handed out, so this can be called at any time.
+ * 
+ * @param fs the file system to regroup
+ * @param group_dblock_count the number of dblocks per group, a non zero multiple of 64
+ * @return SUCCESS if the groups are recomputed.
+ *         INVALID_INPUT if `fs` is null or `group_dblock_count` is not a multiple of 64.
+ *         SYSTEM_ERROR if the groups cannot be allocated.
+ */
+fs_retcode_t set_block_group_size(filesystem_t *fs, size_t group_dblock_count);
+
 /**
  * releases a claimed inode and marks it as available now
  * 
@@ -216,7 +545,7 @@ fs_retcode_t claim_available_dblock(filesystem_t *fs, dblock_index_t *index);
  * @param inode the inode to release
  * @return SUCCESS if the inode is successfully released.
  *         INVALID INPUT if either `fs` and `inode` is null.
- *         INVALID_INPUT if `inode` is the root directory.
+ *         INVALID_INPUT if `inode` is the root directory or not in the inode list.
  */
 fs_retcode_t release_inode(filesystem_t *fs, inode_t *inode);
 
@@ -234,6 +563,224 @@ fs_retcode_t release_inode(filesystem_t *fs, inode_t *inode);
  */
 fs_retcode_t release_dblock(filesystem_t *fs, byte *dblock);
 
+/**
+ * claims a run of contiguous available data blocks for the caller.
+ * 
+ * the bitmask is searched for runs of available data blocks starting at `goal` and 
+ * wrapping around to data block 0. the first run holding at least `want` data blocks 
+ * provides the claimed run. if no run is that long, the longest run is claimed instead.
+ * the start of the claimed run is stored in `start` and its length in `len`.
+ * 
+ * in `DBLOCK_ATOMIC` mode a run never crosses a 64 bit word of the bitmask, so at most 64
+ * data blocks are claimed, and the first run holding `want` data blocks inside one word wins.
+ * 
+ * in `DBLOCK_EXTENT_TREE` mode `goal` is ignored. the shortest run holding at least `want`
+ * data blocks wins, the lowest one among runs of the same length, so a run of exactly
+ * `want` data blocks is used up before a longer one is split.
+ * 
+ * @param fs the file system to claim the data blocks from
+ * @param want the maximum number of data blocks to claim
+ * @param goal the data block index to start searching from. out of range goals start at 0.
+ * @param start the address to store the index of the first claimed data block in
+ * @param len the address to store the number of claimed data blocks in
+ * @return SUCCESS if at least one data block is claimed.
+ *         INVALID_INPUT if `fs`, `start` or `len` is null or `want` is 0.
+ *         DBLOCK_UNAVAILABLE if there are no available data blocks.
+ */
+fs_retcode_t claim_dblock_range(filesystem_t *fs, size_t want, dblock_index_t goal, dblock_index_t *start, size_t *len);
+
+/**
+ * releases the `len` data blocks starting at index `start` and marks them as available.
+ * the data within the data blocks is not modified.
+ * 
+ * @param fs the file system to release the data blocks in
+ * @param start the index of the first data block to release
+ * @param len the number of data blocks to release
+ * @return SUCCESS if the data blocks are successfully released.
+ *         INVALID_INPUT if `fs` is null or `len` is 0.
+ *         INVALID_INPUT if the run does not fit inside the data blocks of `fs`.
+ */
+fs_retcode_t release_dblock_range(filesystem_t *fs, dblock_index_t start, size_t len);
+
+/**
+ * claims `n` available data blocks at once and stores their indices in `out`.
+ * the same data blocks are claimed as with `n` calls to `claim_available_dblock`, but the
+ * bitmask is only walked once. nothing is claimed if there are less than `n` available.
+ * 
+ * @param fs the file system to claim the data blocks from
+ * @param n the number of data blocks to claim
+ * @param out the array of at least `n` indices to store the claimed data blocks in
+ * @return SUCCESS if all `n` data blocks are claimed.
+ *         INVALID_INPUT if `fs` or `out` is null.
+ *         DBLOCK_UNAVAILABLE if there are less than `n` available data blocks.
+ */
+fs_retcode_t claim_available_dblocks(filesystem_t *fs, size_t n, dblock_index_t *out);
+
+/**
+ * releases the `n` data blocks listed in `indices` and marks them as available.
+ * the data within the data blocks is not modified.
+ * 
+ * @param fs the file system to release the data blocks in
+ * @param indices the indices of the data blocks to release
+ * @param n the number of indices in `indices`
+ * @return SUCCESS if the data blocks are successfully released.
+ *         INVALID_INPUT if `fs` is null, or `indices` is null while `n` is not 0.
+ *         INVALID_INPUT if any index is out of range, in which case nothing is released.
+ */
+fs_retcode_t release_dblocks(filesystem_t *fs, const dblock_index_t *indices, size_t n);
+
+/**
+ * claims `n` available inodes at once and stores their indices in `out`.
+ * the same inodes are claimed, in the same order, as with `n` calls to
+ * `claim_available_inode`. nothing is claimed if there are less than `n` available.
+ * 
+ * @param fs the file system to claim the inodes from
+ * @param n the number of inodes to claim
+ * @param out the array of at least `n` indices to store the claimed inodes in
+ * @return SUCCESS if all `n` inodes are claimed.
+ *         INVALID_INPUT if `fs` or `out` is null.
+ *         INODE_UNAVAILABLE if there are less than `n` available inodes.
+ */
+fs_retcode_t claim_available_inodes(filesystem_t *fs, size_t n, inode_index_t *out);
+
+/**
+ * releases the `n` inodes listed in `indices`, in order, like `release_inode` does.
+ * 
+ * @param fs the file system to release the inodes in
+ * @param indices the indices of the inodes to release
+ * @param n the number of indices in `indices`
+ * @return SUCCESS if the inodes are successfully released.
+ *         INVALID_INPUT if `fs` is null, or `indices` is null while `n` is not 0.
+ *         INVALID_INPUT if any index is 0 or out of range, in which case nothing is released.
+ */
+fs_retcode_t release_inodes(filesystem_t *fs, const inode_index_t *indices, size_t n);
+
+/**
+ * sets aside capacity for an operation that claims data blocks and inodes over several steps.
+ * 
+ * no data block or inode is picked. the reserved amounts are taken out of `available_dblocks`
+ * and `available_inodes`, so the claim functions cannot hand them to anyone else, and the
+ * operation can no longer run out of space half way through. before each claim the holder
+ * gives back what it is about to claim with `fs_reservation_draw`. `fs_commit` or `fs_abort`
+ * ends the reservation.
+ * 
+ * drawn units go to the calling thread only, so the claims it makes next spend them
+ * before anything else and another thread cannot take them in between.
+ * 
+ * @param fs the file system to reserve the capacity in
+ * @param ndblocks the number of data blocks to reserve
+ * @param ninodes the number of inodes to reserve
+ * @param token the reservation to fill in
+ * @return SUCCESS if the capacity is reserved.
+ *         INVALID_INPUT if `fs` or `token` is null.
+ *         INSUFFICIENT_DBLOCKS if there are less than `ndblocks` available data blocks.
+ *         INODE_UNAVAILABLE if there are less than `ninodes` available inodes.
+ *         nothing is reserved unless SUCCESS is returned.
+ */
+fs_retcode_t fs_reserve(filesystem_t *fs, size_t ndblocks, size_t ninodes, fs_reservation_t *token);
+
+/**
+ * returns part of a reservation to the available counts right before the holder claims it.
+ * 
+ * @param fs the file system the reservation was made in
+ * @param token the reservation to draw from
+ * @param ndblocks the number of data blocks about to be claimed
+ * @param ninodes the number of inodes about to be claimed
+ * @return SUCCESS if the units are drawn.
+ *         INVALID_INPUT if `fs` or `token` is null, or `token` holds less than asked for.
+ */
+fs_retcode_t fs_reservation_draw(filesystem_t *fs, fs_reservation_t *token, size_t ndblocks, size_t ninodes);
+
+/**
+ * ends a reservation after the operation succeeded. capacity that was never drawn is
+ * returned and `token` is zeroed, along with what the calling thread drew but did not claim.
+ * 
+ * @param fs the file system the reservation was made in
+ * @param token the reservation to end
+ * @return SUCCESS if the reservation is ended.
+ *         INVALID_INPUT if `fs` or `token` is null.
+ */
+fs_retcode_t fs_commit(filesystem_t *fs, fs_reservation_t *token);
+
+/**
+ * ends a reservation after the operation failed. everything not drawn yet is returned and
+ * `token` is zeroed. units already drawn belong to whatever claimed them.
+ * 
+ * @param fs the file system the reservation was made in
+ * @param token the reservation to end
+ * @return SUCCESS if the reservation is ended.
+ *         INVALID_INPUT if `fs` or `token` is null.
+ */
+fs_retcode_t fs_abort(filesystem_t *fs, fs_reservation_t *token);
+
+/**
+ * gives everything the per thread magazines hold back to the file system.
+ * 
+ * with `magazine_size` set, every thread claims dblocks and inodes into a magazine of its
+ * own `magazine_size` at a time and hands them out from there, and releases go back into
+ * it until it holds twice that many. `fs_reserve` takes from units the magazine holds
+ * before the shared counts as well. what the magazines hold is neither used nor available,
+ * so `available_dblocks` and `available_inodes` leave it out until it is drained.
+ * `save_filesystem` drains the magazines before writing, as should anything that needs the
+ * bitmask and free list to be exact, like `fs_check`.
+ * 
+ * with magazines, `claim_available_dblock(s)`, `release_dblock(s)`, `claim_available_inode(s)`
+ * and `release_inode(s)` are safe across threads in any mode, since the shared state is only
+ * touched under a lock. `claim_dblock_range` and the placement of `claim_dblock_near` and
+ * `claim_inode_near` bypass the magazines and are not. draining is not either: no other
+ * thread may use `fs` while it runs. `free_filesystem` frees the magazines.
+ * 
+ * @param fs the file system whose magazines to drain
+ * @return SUCCESS if the magazines are empty.
+ *         INVALID_INPUT if `fs` is null.
+ */
+fs_retcode_t fs_drain_magazines(filesystem_t *fs);
+
+/**
+ * zeroes dblocks released while `lazy_zero` was set, ahead of the claims that would
+ * otherwise zero them.
+ * 
+ * the dblocks live in an anonymous mapping, so dblocks nobody wrote read as zeros without
+ * being faulted in. released dblocks keep their bytes though, and with `lazy_zero` set
+ * they are only marked as needing zeros. the claim functions zero a marked dblock before
+ * handing it out, so a file never sees what an earlier one left behind. this pass does
+ * the same for up to `max_dblocks` marked dblocks at once, lowest first, so claims that
+ * follow do not have to. no other thread may use `fs` while it runs.
+ * 
+ * @param fs the file system whose released dblocks to zero
+ * @param max_dblocks the most dblocks to zero
+ * @param zeroed where the number of dblocks zeroed is stored, may be null
+ * @return SUCCESS if the dblocks are zeroed.
+ *         INVALID_INPUT if `fs` is null.
+ */
+fs_retcode_t fs_zero_released(filesystem_t *fs, size_t max_dblocks, size_t *zeroed);
+
+/**
+ * grows or shrinks a file system in place.
+ * 
+ * new inodes are added to the end of the free inode list and new dblocks are available, so
+ * growing a new file system leaves it as `new_filesystem` would have made it at the new size.
+ * only inodes and dblocks at the end that are available can be cut off. the inodes are kept
+ * in reserved address space, all CLASSIC_MAX_INODE_COUNT of them for classic images, so they
+ * grow and shrink in place and pointers to them, like those of open files and terminal
+ * contexts, stay valid. the dblocks are remapped and may move, so `fs->dblocks` has to be
+ * read again afterwards. the magazines are drained first, and no other thread may use `fs`
+ * while it runs.
+ * 
+ * @param fs the file system to resize
+ * @param new_inode_total the number of inodes it should have
+ * @param new_dblock_total the number of data blocks it should have
+ * @return SUCCESS if the file system has the new size.
+ *         INVALID_INPUT if `fs` is null, a total is 0, or more inodes or data blocks are
+ *         asked for than their indices can tell apart in the geometry of `fs`.
+ *         INODE_UNAVAILABLE if an inode that would be cut off is in use or reserved.
+ *         DBLOCK_UNAVAILABLE if a data block that would be cut off is in use or reserved.
+ *         SYSTEM_ERROR if memory cannot be allocated, or a large image outgrows the address
+ *         space reserved for its inodes and the space after it is taken. `fs` is left as it
+ *         was.
+ */
+fs_retcode_t fs_resize(filesystem_t *fs, size_t new_inode_total, size_t new_dblock_total);
+
 /*---------------------------------------------*
  |  PART 1: LOW LEVEL INODE-DATA MANIPULATION  |
  |  functions you need to implement:           |
@@ -250,6 +797,64 @@ fs_retcode_t release_dblock(filesystem_t *fs, byte *dblock);
  |      - Part 1 Functions                     |
  *---------------------------------------------*/
  
+/**
+ * returns the data block index that the next data block of an inode should be placed at.
+ * 
+ * this is the data block following the last data block of the inode. an empty inode has no
+ * data block to follow, so the hint given to `set_dblock_hint` is used instead, or 0 if it
+ * has none. `new_file` and `new_directory` set that hint to the goal of the parent directory
+ * in `DBLOCK_GOAL_DIRECTED` mode. in `INODE_BLOCK_GROUPS` mode a hint outside the block group
+ * of the inode is replaced with the first data block of that group.
+ * 
+ * @param fs the file system the inode is in
+ * @param inode the inode to place data blocks for
+ * @return the goal data block index, or 0 if `fs` or `inode` is null
+ */
+dblock_index_t inode_dblock_goal(filesystem_t *fs, inode_t *inode);
+
+/**
+ * sets the data block an empty inode places its first data block at, see `inode_dblock_goal`.
+ * 
+ * the hints are only kept in memory, next to the inodes, so they are not saved with the file
+ * system and leave the block map of the inode alone whatever its layout.
+ * 
+ * @param fs the file system the inode is in
+ * @param inode the inode to set the hint of
+ * @param hint the data block index to place the first data block at, 0 for none
+ * @return SUCCESS if the hint is set.
+ *         INVALID_INPUT if `fs` or `inode` is null, or `inode` is not in `fs`.
+ *         SYSTEM_ERROR if the hints could not be allocated.
+ */
+fs_retcode_t set_dblock_hint(filesystem_t *fs, inode_t *inode, dblock_index_t hint);
+
+/**
+ * counts the data blocks growing an inode to `end` bytes can claim, index and extent data
+ * blocks included.
+ * 
+ * this is exact for an inode mapped with a chain or a tree of index data blocks, the tree
+ * counted with the new root it takes when it grows a level. an `INODE_EXTENT_MAPPED` inode
+ * only knows how many extents it ends up with once its data blocks are claimed, so every new
+ * data block is counted as an extent of its own. the writes reserve this many data blocks
+ * and return what they do not use.
+ * 
+ * @param fs the file system the inode is in
+ * @param inode the inode to grow
+ * @param end the size the inode grows to, nothing is counted if it is not past the end
+ * @return the number of data blocks, or 0 if `fs` or `inode` is null
+ */
+size_t inode_growth_dblocks(filesystem_t *fs, inode_t *inode, size_t end);
+
+/**
+ * counts the entries the block map of an inode holds for its data blocks: one per data
+ * block for an inode mapped with index data blocks, one per extent for an
+ * `INODE_EXTENT_MAPPED` inode.
+ * 
+ * @param fs the file system the inode is in
+ * @param inode the inode to count the entries of
+ * @return the number of entries, or 0 if `fs` or `inode` is null
+ */
+size_t inode_map_entries(filesystem_t *fs, inode_t *inode);
+
 /**
  * writes data to the data blocks associated with an inode
  * 
@@ -257,6 +862,11 @@ fs_retcode_t release_dblock(filesystem_t *fs, byte *dblock);
  * data blocks and index data blocks should be allocated as necessary.
  * the direct data blocks, if not filled, should be written to first.
  * subsequently, write the remaining data to the indirect data blocks. 
+ * new data blocks are claimed with `claim_dblock_near` starting at `inode_dblock_goal`.
+ * an `INODE_EXTENT_MAPPED` inode grows its last extent while the new data blocks follow it,
+ * and starts a new extent, with an extent data block when one is full, where they do not.
+ * an `INODE_TREE_MAPPED` inode claims the index data blocks of its tree ahead of the data
+ * blocks they list, and a new root whenever the tree is full.
  * 
  * if there is not enough data blocks to satisfy the write, then the file
  * system should NOT be modified. 
@@ -312,10 +922,37 @@ fs_retcode_t inode_read_data(filesystem_t *fs, inode_t *inode, size_t offset, vo
  */
 fs_retcode_t inode_modify_data(filesystem_t *fs, inode_t *inode, size_t offset, void *buffer, size_t n);
 
+/**
+ * modifies data like `inode_modify_data`, taking the data blocks needed past the end of 
+ * the file from a preallocation window.
+ * 
+ * when the window is empty and more data blocks are needed, a run of up to 
+ * `prealloc_window` data blocks starting at `inode_dblock_goal` is claimed into it. the
+ * window keeps the data blocks it did not hand out, which stay claimed until the caller
+ * releases them. with `prealloc_window` at 0 or 1 this is `inode_modify_data`.
+ * 
+ * @param fs the file system the inode is in
+ * @param inode the inode to modify the data
+ * @param offset the offset into the data to modify the data
+ * @param buffer the new data to be stored in the inode
+ * @param n the number of bytes in the buffer to write
+ * @param window the preallocation window of the writer
+ * @return SUCCESS if the data is successfully modified
+ *         INVALID_INPUT if the fs, inode or window is null
+ *         INVALID_INPUT if the offset exceeds the size of the file
+ *         INSUFFICIENT_DBLOCKS if there is not enough available data blocks, counting
+ *         the ones in the window
+ */
+fs_retcode_t inode_modify_data_window(filesystem_t *fs, inode_t *inode, size_t offset, void *buffer, size_t n, dblock_window_t *window);
+
 /**
  * shrinks the inode file size and frees any D-block as necessary
  * 
  * if all the dblocks are freed that are referenced in an index dblock, the index dblock should then be freed.
+ * an `INODE_EXTENT_MAPPED` inode releases a run at a time, along with the extent dblocks
+ * whose extents are all gone.
+ * an `INODE_TREE_MAPPED` inode releases the nodes of its tree that only list released data
+ * blocks, and the top levels the data blocks it keeps no longer need.
  * the file size of the inode should also be updated to the new_size 
  * 
  * @param fs the file system the inode is in
@@ -348,6 +985,9 @@ struct fs_file
     filesystem_t *fs;
     inode_t *inode;
     size_t offset;
+    dblock_window_t window; // dblocks reserved for appends, returned by `fs_close`
+    fs_write_buffer_t pending; // appends not yet in the inode, see `delayed_alloc`
+    fs_reservation_t reservation; // dblocks set aside for `pending` beyond what the window holds
 };
 
 typedef struct fs_file *fs_file_t;
@@ -390,6 +1030,9 @@ fs_file_t fs_open(terminal_context_t *context, char *path);
 
 /**
  * closes a file by deallocating the file object.
+ * buffered appends are flushed first, then the data blocks left in its preallocation
+ * window and its reservation are released. appends that cannot be flushed, which only
+ * happens when `fs_flush` would fail, are lost with an error printed.
  * if file is NULL, do nothing.
  * 
  * @param file the file to be closed
@@ -399,6 +1042,8 @@ void fs_close(fs_file_t file);
 /**
  * reads the content of a file and stores it in a buffer
  * 
+ * a read that reaches into appends buffered by `fs_write` flushes them first.
+ * 
  * @param file the file handler returned by `fs_open`
  * @param buffer the buffer to store the data in
  * @param n the number of bytes to read from the file
@@ -409,6 +1054,16 @@ size_t fs_read(fs_file_t file, void *buffer, size_t n);
 /**
  * write the content of a file from a buffer
  * 
+ * when `prealloc_window` of the file system is above 1, the data blocks for appends are
+ * taken from the preallocation window of `file` so that files growing at the same time
+ * do not end up interleaved data block by data block.
+ * 
+ * when `delayed_alloc` of the file system is set, writes at the end of the file are only
+ * copied into the buffer of `file` and get their data blocks at `fs_flush` or `fs_close`,
+ * once the final size is known. the data blocks they need are reserved as they are
+ * buffered, so a write that returns `n` cannot run out of them later. any other write
+ * flushes the buffer first.
+ * 
  * @param file the file handler returned by `fs_open`
  * @param buffer the buffer to write the data from
  * @param n the number of bytes to write to the file
@@ -433,6 +1088,17 @@ typedef enum seek_mode
  */
 int fs_seek(fs_file_t file, seek_mode_t seek_mode, int offset);
 
+/**
+ * writes the appends buffered by `fs_write` to the inode of the file.
+ * the data blocks for all of them are claimed as one run when possible.
+ * 
+ * @param file the file handler returned by `fs_open`
+ * @return 0 if successful or there is nothing buffered, -1 if `file` is null or there
+ *         are not enough available data blocks, which can only happen if another handle
+ *         grew the file after the buffer was reserved. the buffer is kept on failure.
+ */
+int fs_flush(fs_file_t file);
+
 /*----------------------------------------------*
  |  PART 3: HIGH LEVEL FILE SYSTEM OPERATIONS   |
  |  functions you need to implement:            |
@@ -539,6 +1205,24 @@ char *get_path_string(terminal_context_t *context);
  */
 int tree(terminal_context_t *context, char *path);
 
+/**
+ * converts a file system to another geometry in place.
+ * 
+ * every directory is rewritten with entries of the new width. directories grow when they
+ * move to large geometry, so the dblocks they need are reserved before anything changes.
+ * the image `save_filesystem` writes afterwards is in the new geometry.
+ * 
+ * @param fs the file system to convert
+ * @param geometry the geometry it should have
+ * @return SUCCESS if `fs` has the new geometry.
+ *         INVALID_INPUT if `fs` is null, `geometry` is unknown, or `fs` has more inodes
+ *         than `geometry` can index.
+ *         INSUFFICIENT_DBLOCKS if the rewritten directories do not fit, in which case
+ *         nothing is changed.
+ *         SYSTEM_ERROR if memory for a directory cannot be allocated.
+ */
+fs_retcode_t fs_convert_geometry(filesystem_t *fs, fs_geometry_t geometry);
+
 
 // ---------------------------------------------------------------------------------------------------- //
 /**
@@ -552,21 +1236,112 @@ int tree(terminal_context_t *context, char *path);
  /**
  * loads a file system from a input file
  * 
+ * the free inode list is validated while the free inode and dblock counters are
+ * computed. a list that leaves the inode table or loops is an invalid binary format.
+ * the features listed by the trailer after the dblocks, if there is one, are turned on.
+ * images whose inode count has `FS_LARGE_GEOMETRY_FLAG` set are read with 4 byte inode
+ * indices, the others with 2 byte ones.
+ * 
  * @param file the input file to load the file system from
  * @param fs the filesystem to write the content of the input file to
  * @return SUCCESS if the file system is correctly loaded
+ *         INVALID_BINARY_FORMAT if the file is truncated or the free inode list is corrupt
+ *         INVALID_BINARY_FORMAT if the trailer is malformed or lists an unknown feature
  */
 fs_retcode_t load_filesystem(FILE* file, filesystem_t *fs);
 
 /**
  * stores a file system to an output file
  * 
+ * a trailer listing the `fs_feature_t` features in use is written after the dblocks,
+ * unless no feature is in use. the header is written in the geometry of `fs`.
+ * 
  * @param file the output file to write the file system to
  * @param fs the file system to store in the output file
  * @return SUCCESS if the file system is correctly saved
  */
 fs_retcode_t save_filesystem(FILE* file, filesystem_t *fs);
 
+/**
+ * the size of a directory entry in the geometry of `fs`, see `fs_geometry_t`.
+ * 
+ * @param fs the file system the entry belongs to
+ * @return `CLASSIC_DIRECTORY_ENTRY_SIZE` or `LARGE_DIRECTORY_ENTRY_SIZE`
+ */
+size_t directory_entry_size(const filesystem_t *fs);
+
+/**
+ * reads the inode index of a directory entry.
+ * 
+ * @param fs the file system the entry belongs to
+ * @param entry the first byte of the entry
+ * @return the inode index the entry stores
+ */
+inode_index_t directory_entry_inode(const filesystem_t *fs, const byte *entry);
+
+/**
+ * finds the name of a directory entry, which is null terminated within the entry.
+ * 
+ * @param fs the file system the entry belongs to
+ * @param entry the first byte of the entry
+ * @return the first byte of the name
+ */
+const char *directory_entry_name(const filesystem_t *fs, const byte *entry);
+
+/**
+ * fills a whole directory entry. the name is cut to MAX_FILE_NAME_LEN - 1 bytes and the
+ * rest of the entry is zeroed.
+ * 
+ * @param fs the file system the entry belongs to
+ * @param entry the first byte of the entry, `directory_entry_size(fs)` bytes long
+ * @param inode the inode index to store
+ * @param name the name to store
+ */
+void write_directory_entry(const filesystem_t *fs, byte *entry, inode_index_t inode, const char *name);
+
+/**
+ * measures how fragmented the files of a file system are.
+ * 
+ * the dblocks of every inode in use are visited in file order, index dblocks included
+ * ahead of the data dblocks they list, and split into runs of consecutive dblock indices.
+ * a file system whose files are each stored contiguously scores the average number of 
+ * dblocks per file, while one whose files are scattered one dblock at a time scores 1.
+ * 
+ * @param fs the file system to measure
+ * @return the total number of dblocks used by files divided by the number of runs they
+ *         form, or 0 if no file uses a dblock or `fs` is null
+ */
+double average_dblock_run_length(filesystem_t *fs);
+
+// what `fs_check` found when comparing the allocation state against the directory tree
+typedef struct fs_check_report
+{
+    size_t reachable_inodes;        // inodes reachable from the root directory, root included
+    size_t orphan_inodes;           // in use but not reachable
+    size_t free_reachable_inodes;   // reachable but available
+    size_t referenced_dblocks;      // dblocks used by reachable inodes, index dblocks included
+    size_t leaked_dblocks;          // in use but not referenced
+    size_t free_referenced_dblocks; // referenced but available
+    size_t shared_dblocks;          // references past the first to the same dblock
+    size_t invalid_references;      // dblock or inode indices past the end of their table
+} fs_check_report_t;
+
+/**
+ * checks that the inode and dblock allocation state agrees with the directory tree.
+ * 
+ * the tree is walked from the root directory and every inode and dblock reached is recorded
+ * in bitmaps of its own, which are then compared against the free inodes and the dblock
+ * bitmask. nothing in `fs` is modified.
+ * 
+ * @param fs the file system to check
+ * @param report where the counts are stored
+ * @return SUCCESS if every count of a problem in `report` is 0
+ *         INVALID_BINARY_FORMAT if the allocation state and the tree disagree
+ *         INVALID_INPUT if `fs` or `report` is null
+ *         SYSTEM_ERROR if memory for the walk cannot be allocated
+ */
+fs_retcode_t fs_check(filesystem_t *fs, fs_check_report_t *report);
+
 // DEBUGGING FUNCTION
 
 typedef enum fs_display_flag
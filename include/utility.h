@@ -11,7 +11,27 @@ size_t calculate_index_dblock_amount(size_t file_size);
 
 size_t calculate_necessary_dblock_amount(size_t file_size);
 
+size_t calculate_tree_height(size_t dblocks);
+
+size_t calculate_tree_index_dblock_amount(size_t dblocks);
+
 dblock_index_t *cast_dblock_ptr(void *addr);
 
+fs_retcode_t rebuild_dblock_summary(filesystem_t *fs);
+
+fs_retcode_t rebuild_block_groups(filesystem_t *fs);
+
+fs_retcode_t rebuild_extent_tree(filesystem_t *fs);
+
+fs_retcode_t rebuild_buddy_lists(filesystem_t *fs);
+
+byte *map_dblocks(size_t dblock_total);
+
+void unmap_dblocks(byte *dblocks, size_t dblock_total);
+
+inode_t *map_inodes(fs_geometry_t geometry, size_t inode_total, size_t *inode_cap);
+
+void unmap_inodes(inode_t *inodes, size_t inode_cap);
+
 
 #endif
\ No newline at end of file
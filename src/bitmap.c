@@ -0,0 +1,293 @@
+#include <string.h>
+
+#include "bitmap.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define BITMAP_HAVE_X86 1
+#else
+#define BITMAP_HAVE_X86 0
+#endif
+
+// the kernels only see whole bytes of the bitmap. the bits of the first and last byte of a
+// range that fall outside it are dealt with by the callers
+typedef struct bitmap_kernels
+{
+    size_t (*popcount)(const uint8_t *p, size_t n);
+    // returns the offset of the first byte that is not `value`, or `n` if there is none
+    size_t (*find_byte_not)(const uint8_t *p, size_t n, uint8_t value);
+} bitmap_kernels_t;
+
+const char *bitmap_isa_string_table[] = {
+    "portable",
+    "sse4.2",
+    "avx2"
+};
+
+// ----------------------- PORTABLE KERNELS ----------------------- //
+
+static size_t popcount_portable(const uint8_t *p, size_t n)
+{
+    size_t count = 0, i = 0;
+    for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        count += __builtin_popcountll(word);
+    }
+    for (; i < n; ++i) count += __builtin_popcount(p[i]);
+    return count;
+}
+
+static size_t find_byte_not_portable(const uint8_t *p, size_t n, uint8_t value)
+{
+    uint64_t pattern = 0x0101010101010101ULL * value;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        if (word != pattern) break;
+    }
+    for (; i < n; ++i)
+    {
+        if (p[i] != value) return i;
+    }
+    return n;
+}
+
+static const bitmap_kernels_t portable_kernels = { popcount_portable, find_byte_not_portable };
+
+#if BITMAP_HAVE_X86
+
+// ----------------------- SSE4.2 KERNELS ----------------------- //
+
+// processors with sse4.2 also have popcnt, which the builtin compiles to here
+__attribute__((target("sse4.2,popcnt")))
+static size_t popcount_sse42(const uint8_t *p, size_t n)
+{
+    size_t count = 0, i = 0;
+    for (; i + 2 * sizeof(uint64_t) <= n; i += 2 * sizeof(uint64_t))
+    {
+        uint64_t words[2];
+        memcpy(words, p + i, sizeof(words));
+        count += __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]);
+    }
+    for (; i < n; ++i) count += __builtin_popcount(p[i]);
+    return count;
+}
+
+__attribute__((target("sse4.2")))
+static size_t find_byte_not_sse42(const uint8_t *p, size_t n, uint8_t value)
+{
+    __m128i pattern = _mm_set1_epi8((char)value);
+    size_t i = 0;
+    for (; i + sizeof(__m128i) <= n; i += sizeof(__m128i))
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + i));
+        unsigned equal = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern));
+        if (equal != 0xFFFF) return i + __builtin_ctz(~equal);
+    }
+    for (; i < n; ++i)
+    {
+        if (p[i] != value) return i;
+    }
+    return n;
+}
+
+static const bitmap_kernels_t sse42_kernels = { popcount_sse42, find_byte_not_sse42 };
+
+// ----------------------- AVX2 KERNELS ----------------------- //
+
+// counts 32 bytes at a time by looking up the bit count of every nibble with a shuffle,
+// then sums the byte counts into four 64 bit lanes
+__attribute__((target("avx2,popcnt")))
+static size_t popcount_avx2(const uint8_t *p, size_t n)
+{
+    const __m256i lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + sizeof(__m256i) <= n; i += sizeof(__m256i))
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i low = _mm256_and_si256(chunk, low_nibbles);
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(chunk, 4), low_nibbles);
+        __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+    }
+
+    size_t count = (size_t)_mm256_extract_epi64(total, 0) + (size_t)_mm256_extract_epi64(total, 1)
+        + (size_t)_mm256_extract_epi64(total, 2) + (size_t)_mm256_extract_epi64(total, 3);
+    for (; i < n; ++i) count += __builtin_popcount(p[i]);
+    return count;
+}
+
+__attribute__((target("avx2")))
+static size_t find_byte_not_avx2(const uint8_t *p, size_t n, uint8_t value)
+{
+    __m256i pattern = _mm256_set1_epi8((char)value);
+    size_t i = 0;
+    for (; i + sizeof(__m256i) <= n; i += sizeof(__m256i))
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(p + i));
+        unsigned equal = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern));
+        if (equal != 0xFFFFFFFFu) return i + __builtin_ctz(~equal);
+    }
+    for (; i < n; ++i)
+    {
+        if (p[i] != value) return i;
+    }
+    return n;
+}
+
+static const bitmap_kernels_t avx2_kernels = { popcount_avx2, find_byte_not_avx2 };
+
+#endif
+
+// ----------------------- DISPATCH ----------------------- //
+
+static const bitmap_kernels_t *active_kernels = NULL;
+static bitmap_isa_t active_isa = BITMAP_ISA_PORTABLE;
+
+static int isa_supported(bitmap_isa_t isa)
+{
+#if BITMAP_HAVE_X86
+    __builtin_cpu_init();
+    if (isa == BITMAP_ISA_AVX2) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    if (isa == BITMAP_ISA_SSE42) return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+#endif
+    return isa == BITMAP_ISA_PORTABLE;
+}
+
+int bitmap_select_isa(bitmap_isa_t isa)
+{
+    if (!isa_supported(isa)) return -1;
+    switch (isa)
+    {
+#if BITMAP_HAVE_X86
+    case BITMAP_ISA_AVX2: active_kernels = &avx2_kernels; break;
+    case BITMAP_ISA_SSE42: active_kernels = &sse42_kernels; break;
+#endif
+    default: active_kernels = &portable_kernels; break;
+    }
+    active_isa = isa;
+    return 0;
+}
+
+static const bitmap_kernels_t *kernels(void)
+{
+    if (!active_kernels)
+    {
+        if (bitmap_select_isa(BITMAP_ISA_AVX2) != 0 && bitmap_select_isa(BITMAP_ISA_SSE42) != 0)
+            bitmap_select_isa(BITMAP_ISA_PORTABLE);
+    }
+    return active_kernels;
+}
+
+bitmap_isa_t bitmap_active_isa(void)
+{
+    kernels();
+    return active_isa;
+}
+
+// ----------------------- CORE FUNCTION ----------------------- //
+
+size_t bitmap_popcount(const uint8_t *bits, size_t from, size_t to)
+{
+    if (!bits || from >= to) return 0;
+
+    size_t first_byte = from / 8, last_byte = (to - 1) / 8;
+    uint8_t head_mask = (uint8_t)(0xFF >> (from % 8));
+    uint8_t tail_mask = (uint8_t)(0xFF << (7 - (to - 1) % 8));
+    if (first_byte == last_byte) return __builtin_popcount(bits[first_byte] & head_mask & tail_mask);
+
+    return __builtin_popcount(bits[first_byte] & head_mask)
+        + kernels()->popcount(bits + first_byte + 1, last_byte - first_byte - 1)
+        + __builtin_popcount(bits[last_byte] & tail_mask);
+}
+
+#define SCALAR_LOOKAHEAD 8
+
+// finds the lowest bit in [from, to) that is set, or clear if `set` is 0
+static int find_bit(const uint8_t *bits, size_t from, size_t to, int set, size_t *index)
+{
+    if (!bits || from >= to) return 0;
+
+    // flip the bytes when looking for clear bits so the search is always for a set one
+    uint8_t flip = set ? 0x00 : 0xFF;
+    size_t byte = from / 8;
+    uint8_t head = (uint8_t)((bits[byte] ^ flip) & (0xFF >> (from % 8)));
+    if (!head)
+    {
+        // a byte holding nothing but bits of no interest looks like `flip`. the next few
+        // bytes are looked at right here since runs tend to be short, which is not worth a
+        // call into the kernels
+        size_t end_byte = (to + 7) / 8;
+        size_t near_end = end_byte - byte > SCALAR_LOOKAHEAD ? byte + SCALAR_LOOKAHEAD : end_byte;
+        while (++byte < near_end && bits[byte] == flip);
+        if (byte == end_byte) return 0;
+        if (byte == near_end)
+        {
+            size_t offset = kernels()->find_byte_not(bits + byte, end_byte - byte, flip);
+            if (offset == end_byte - byte) return 0;
+            byte += offset;
+        }
+        head = (uint8_t)(bits[byte] ^ flip);
+    }
+
+    size_t found = byte * 8 + __builtin_clz(head) - (sizeof(unsigned) - 1) * 8;
+    if (found >= to) return 0;
+    *index = found;
+    return 1;
+}
+
+int bitmap_find_first_set(const uint8_t *bits, size_t from, size_t to, size_t *index)
+{
+    if (!index) return 0;
+    return find_bit(bits, from, to, 1, index);
+}
+
+int bitmap_find_first_clear(const uint8_t *bits, size_t from, size_t to, size_t *index)
+{
+    if (!index) return 0;
+    return find_bit(bits, from, to, 0, index);
+}
+
+int bitmap_find_run(const uint8_t *bits, size_t from, size_t to, size_t run, size_t *index)
+{
+    if (!index || run == 0) return 0;
+
+    size_t start;
+    while (to - from >= run && find_bit(bits, from, to, 1, &start))
+    {
+        // the run only has to be followed far enough to know it is long enough
+        size_t limit = to - start > run ? start + run : to;
+        size_t end;
+        if (!find_bit(bits, start, limit, 0, &end)) end = limit;
+        if (end - start >= run)
+        {
+            *index = start;
+            return 1;
+        }
+        from = end;
+    }
+    return 0;
+}
+
+size_t bitmap_count_runs(const uint8_t *bits, size_t from, size_t to, size_t run)
+{
+    if (run == 0) return 0;
+
+    size_t count = 0, start;
+    while (from < to && find_bit(bits, from, to, 1, &start))
+    {
+        size_t end;
+        if (!find_bit(bits, start, to, 0, &end)) end = to;
+        if (end - start >= run) ++count;
+        from = end;
+    }
+    return count;
+}
@@ -0,0 +1,199 @@
+#include <stdlib.h>
+
+#include "block_map_cache.h"
+
+#define INITIAL_BUCKET_COUNT 16
+#define INITIAL_CHAIN_CAPACITY 4
+
+struct cached_chain
+{
+    cached_chain_t *bucket_next;
+    cached_chain_t *newer;      // neighbours in the LRU list
+    cached_chain_t *older;
+    size_t key;
+    size_t len;                 // entries known
+    size_t capacity;            // entries there is room for
+    uint32_t *entries;
+};
+
+// inode indices are mostly small and spread evenly, so the low bits make a fine hash
+static cached_chain_t **bucket_of(block_map_cache_t *cache, size_t key)
+{
+    return &cache->buckets[key & (cache->bucket_count - 1)];
+}
+
+static cached_chain_t *lookup(block_map_cache_t *cache, size_t key)
+{
+    if (cache->bucket_count == 0) return NULL;
+    cached_chain_t *chain = *bucket_of(cache, key);
+    while (chain && chain->key != key) chain = chain->bucket_next;
+    return chain;
+}
+
+// ----------------------- LRU LIST ----------------------- //
+
+static void lru_unlink(block_map_cache_t *cache, cached_chain_t *chain)
+{
+    if (chain->newer) chain->newer->older = chain->older;
+    else cache->newest = chain->older;
+    if (chain->older) chain->older->newer = chain->newer;
+    else cache->oldest = chain->newer;
+}
+
+static void lru_push(block_map_cache_t *cache, cached_chain_t *chain)
+{
+    chain->newer = NULL;
+    chain->older = cache->newest;
+    if (cache->newest) cache->newest->newer = chain;
+    else cache->oldest = chain;
+    cache->newest = chain;
+}
+
+static void touch(block_map_cache_t *cache, cached_chain_t *chain)
+{
+    if (cache->newest == chain) return;
+    lru_unlink(cache, chain);
+    lru_push(cache, chain);
+}
+
+static void remove_chain(block_map_cache_t *cache, cached_chain_t *chain)
+{
+    cached_chain_t **link = bucket_of(cache, chain->key);
+    while (*link != chain) link = &(*link)->bucket_next;
+    *link = chain->bucket_next;
+    lru_unlink(cache, chain);
+    cache->bytes -= sizeof(cached_chain_t) + chain->capacity * sizeof(uint32_t);
+    --cache->count;
+    free(chain->entries);
+    free(chain);
+}
+
+// drops the oldest chains other than `keep` until `growth` more bytes fit in the budget
+static int make_room(block_map_cache_t *cache, const cached_chain_t *keep, size_t growth, size_t budget)
+{
+    while (cache->bytes + growth > budget && cache->oldest && cache->oldest != keep)
+    {
+        remove_chain(cache, cache->oldest);
+        ++cache->evictions;
+    }
+    return cache->bytes + growth <= budget;
+}
+
+// doubles the buckets, or makes the first ones
+static int grow_buckets(block_map_cache_t *cache)
+{
+    size_t bucket_count = cache->bucket_count ? cache->bucket_count * 2 : INITIAL_BUCKET_COUNT;
+    cached_chain_t **buckets = calloc(bucket_count, sizeof(cached_chain_t *));
+    if (!buckets) return -1;
+    for (size_t b = 0; b < cache->bucket_count; ++b)
+    {
+        cached_chain_t *chain = cache->buckets[b];
+        while (chain)
+        {
+            cached_chain_t *next = chain->bucket_next;
+            cached_chain_t **bucket = &buckets[chain->key & (bucket_count - 1)];
+            chain->bucket_next = *bucket;
+            *bucket = chain;
+            chain = next;
+        }
+    }
+    free(cache->buckets);
+    cache->bytes += (bucket_count - cache->bucket_count) * sizeof(cached_chain_t *);
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+    return 0;
+}
+
+static cached_chain_t *add_chain(block_map_cache_t *cache, size_t key, size_t budget)
+{
+    size_t growth = sizeof(cached_chain_t);
+    if (cache->count >= cache->bucket_count)
+        growth += (cache->bucket_count ? cache->bucket_count : INITIAL_BUCKET_COUNT) * sizeof(cached_chain_t *);
+    if (!make_room(cache, NULL, growth, budget)) return NULL;
+    if (cache->count >= cache->bucket_count && grow_buckets(cache) != 0) return NULL;
+
+    cached_chain_t *chain = malloc(sizeof(cached_chain_t));
+    if (!chain) return NULL;
+    chain->key = key;
+    chain->len = 0;
+    chain->capacity = 0;
+    chain->entries = NULL;
+    cached_chain_t **bucket = bucket_of(cache, key);
+    chain->bucket_next = *bucket;
+    *bucket = chain;
+    lru_push(cache, chain);
+    cache->bytes += sizeof(cached_chain_t);
+    ++cache->count;
+    return chain;
+}
+
+// ----------------------- CORE FUNCTION ----------------------- //
+
+void block_map_cache_init(block_map_cache_t *cache)
+{
+    if (!cache) return;
+    cache->buckets = NULL;
+    cache->bucket_count = 0;
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    cache->count = 0;
+    cache->bytes = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+}
+
+void block_map_cache_clear(block_map_cache_t *cache)
+{
+    if (!cache) return;
+    while (cache->newest) remove_chain(cache, cache->newest);
+    free(cache->buckets);
+    cache->buckets = NULL;
+    cache->bucket_count = 0;
+    cache->bytes = 0;
+}
+
+size_t block_map_cache_find(block_map_cache_t *cache, size_t key, const uint32_t **chain)
+{
+    cached_chain_t *found = lookup(cache, key);
+    if (!found) return 0;
+    touch(cache, found);
+    *chain = found->entries;
+    return found->len;
+}
+
+void block_map_cache_extend(block_map_cache_t *cache, size_t key, size_t k, uint32_t entry, size_t budget)
+{
+    cached_chain_t *chain = lookup(cache, key);
+    if (!chain)
+    {
+        if (k != 0 || !(chain = add_chain(cache, key, budget))) return;
+    }
+    else if (chain->len != k) return;
+    touch(cache, chain);
+
+    if (chain->len == chain->capacity)
+    {
+        size_t capacity = chain->capacity ? chain->capacity * 2 : INITIAL_CHAIN_CAPACITY;
+        size_t growth = (capacity - chain->capacity) * sizeof(uint32_t);
+        uint32_t *entries = make_room(cache, chain, growth, budget) ? realloc(chain->entries, capacity * sizeof(uint32_t)) : NULL;
+        if (!entries)
+        {
+            // the chain keeps the entries it has, an empty one is not worth keeping
+            if (chain->len == 0) remove_chain(cache, chain);
+            return;
+        }
+        chain->entries = entries;
+        chain->capacity = capacity;
+        cache->bytes += growth;
+    }
+    chain->entries[chain->len++] = entry;
+}
+
+void block_map_cache_truncate(block_map_cache_t *cache, size_t key, size_t len)
+{
+    cached_chain_t *chain = lookup(cache, key);
+    if (!chain) return;
+    if (len == 0) remove_chain(cache, chain);
+    else if (len < chain->len) chain->len = len;
+}
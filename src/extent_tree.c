@@ -0,0 +1,476 @@
+#include <stdlib.h>
+
+#include "extent_tree.h"
+
+// a red-black tree node that sits inside the structure it orders. a missing child counts
+// as a black leaf
+typedef struct rb_node
+{
+    struct rb_node *parent;
+    struct rb_node *left;
+    struct rb_node *right;
+    int red;
+} rb_node_t;
+
+struct extent
+{
+    rb_node_t by_start;
+    rb_node_t by_length;
+    size_t start;
+    size_t len;
+};
+
+#define EXTENT_OF(node, field) ((extent_t *)((char *)(node) - offsetof(extent_t, field)))
+
+typedef int (*rb_less_t)(const rb_node_t *a, const rb_node_t *b);
+
+// ----------------------- RED-BLACK TREE ----------------------- //
+
+static void rb_replace_child(rb_node_t **root, rb_node_t *parent, rb_node_t *old, rb_node_t *new_child)
+{
+    if (!parent) *root = new_child;
+    else if (parent->left == old) parent->left = new_child;
+    else parent->right = new_child;
+}
+
+static void rb_rotate_left(rb_node_t **root, rb_node_t *x)
+{
+    rb_node_t *y = x->right;
+    x->right = y->left;
+    if (y->left) y->left->parent = x;
+    y->parent = x->parent;
+    rb_replace_child(root, x->parent, x, y);
+    y->left = x;
+    x->parent = y;
+}
+
+static void rb_rotate_right(rb_node_t **root, rb_node_t *x)
+{
+    rb_node_t *y = x->left;
+    x->left = y->right;
+    if (y->right) y->right->parent = x;
+    y->parent = x->parent;
+    rb_replace_child(root, x->parent, x, y);
+    y->right = x;
+    x->parent = y;
+}
+
+static int is_red(const rb_node_t *node)
+{
+    return node && node->red;
+}
+
+static void rb_insert(rb_node_t **root, rb_node_t *node, rb_less_t less)
+{
+    rb_node_t *parent = NULL;
+    rb_node_t **link = root;
+    while (*link)
+    {
+        parent = *link;
+        link = less(node, parent) ? &parent->left : &parent->right;
+    }
+    node->parent = parent;
+    node->left = node->right = NULL;
+    node->red = 1;
+    *link = node;
+
+    // a red node under a red parent is fixed by recoloring while the uncle is red, then
+    // by at most two rotations
+    while (is_red(node->parent))
+    {
+        rb_node_t *p = node->parent;
+        rb_node_t *g = p->parent;
+        if (p == g->left)
+        {
+            rb_node_t *uncle = g->right;
+            if (is_red(uncle))
+            {
+                p->red = uncle->red = 0;
+                g->red = 1;
+                node = g;
+                continue;
+            }
+            if (node == p->right)
+            {
+                rb_rotate_left(root, p);
+                node = p;
+                p = node->parent;
+            }
+            p->red = 0;
+            g->red = 1;
+            rb_rotate_right(root, g);
+        }
+        else
+        {
+            rb_node_t *uncle = g->left;
+            if (is_red(uncle))
+            {
+                p->red = uncle->red = 0;
+                g->red = 1;
+                node = g;
+                continue;
+            }
+            if (node == p->left)
+            {
+                rb_rotate_right(root, p);
+                node = p;
+                p = node->parent;
+            }
+            p->red = 0;
+            g->red = 1;
+            rb_rotate_left(root, g);
+        }
+    }
+    (*root)->red = 0;
+}
+
+// restores the black height after a black node was removed above `node`, which may be a
+// missing leaf, so its parent is passed along
+static void rb_erase_fixup(rb_node_t **root, rb_node_t *node, rb_node_t *parent)
+{
+    while (node != *root && !is_red(node))
+    {
+        if (node == parent->left)
+        {
+            rb_node_t *sibling = parent->right;
+            if (is_red(sibling))
+            {
+                sibling->red = 0;
+                parent->red = 1;
+                rb_rotate_left(root, parent);
+                sibling = parent->right;
+            }
+            if (!is_red(sibling->left) && !is_red(sibling->right))
+            {
+                sibling->red = 1;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (!is_red(sibling->right))
+            {
+                sibling->left->red = 0;
+                sibling->red = 1;
+                rb_rotate_right(root, sibling);
+                sibling = parent->right;
+            }
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->right->red = 0;
+            rb_rotate_left(root, parent);
+            node = *root;
+        }
+        else
+        {
+            rb_node_t *sibling = parent->left;
+            if (is_red(sibling))
+            {
+                sibling->red = 0;
+                parent->red = 1;
+                rb_rotate_right(root, parent);
+                sibling = parent->left;
+            }
+            if (!is_red(sibling->left) && !is_red(sibling->right))
+            {
+                sibling->red = 1;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (!is_red(sibling->left))
+            {
+                sibling->right->red = 0;
+                sibling->red = 1;
+                rb_rotate_left(root, sibling);
+                sibling = parent->left;
+            }
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->left->red = 0;
+            rb_rotate_right(root, parent);
+            node = *root;
+        }
+    }
+    if (node) node->red = 0;
+}
+
+static void rb_erase(rb_node_t **root, rb_node_t *node)
+{
+    rb_node_t *child, *parent;
+    int removed_red;
+    if (node->left && node->right)
+    {
+        // the successor takes the place of `node`, and its old place is the one removed
+        rb_node_t *next = node->right;
+        while (next->left) next = next->left;
+        child = next->right;
+        parent = next->parent;
+        removed_red = next->red;
+        if (parent == node) parent = next;
+        else
+        {
+            if (child) child->parent = parent;
+            parent->left = child;
+            next->right = node->right;
+            node->right->parent = next;
+        }
+        next->parent = node->parent;
+        next->left = node->left;
+        node->left->parent = next;
+        next->red = node->red;
+        rb_replace_child(root, node->parent, node, next);
+    }
+    else
+    {
+        child = node->left ? node->left : node->right;
+        parent = node->parent;
+        removed_red = node->red;
+        if (child) child->parent = parent;
+        rb_replace_child(root, parent, node, child);
+    }
+    if (!removed_red) rb_erase_fixup(root, child, parent);
+}
+
+static rb_node_t *rb_first(rb_node_t *node)
+{
+    if (!node) return NULL;
+    while (node->left) node = node->left;
+    return node;
+}
+
+static rb_node_t *rb_last(rb_node_t *node)
+{
+    if (!node) return NULL;
+    while (node->right) node = node->right;
+    return node;
+}
+
+static rb_node_t *rb_next(rb_node_t *node)
+{
+    if (node->right) return rb_first(node->right);
+    while (node->parent && node == node->parent->right) node = node->parent;
+    return node->parent;
+}
+
+// ----------------------- EXTENTS ----------------------- //
+
+static int start_less(const rb_node_t *a, const rb_node_t *b)
+{
+    return EXTENT_OF(a, by_start)->start < EXTENT_OF(b, by_start)->start;
+}
+
+static int length_less(const rb_node_t *a, const rb_node_t *b)
+{
+    const extent_t *x = EXTENT_OF(a, by_length);
+    const extent_t *y = EXTENT_OF(b, by_length);
+    return x->len < y->len || (x->len == y->len && x->start < y->start);
+}
+
+static extent_t *new_extent(extent_tree_t *tree)
+{
+    extent_t *extent = tree->unused;
+    if (extent)
+    {
+        // the unused nodes are chained through their start node
+        tree->unused = (extent_t *) extent->by_start.right;
+        return extent;
+    }
+    return malloc(sizeof(extent_t));
+}
+
+static void link_extent(extent_tree_t *tree, extent_t *extent, size_t start, size_t len)
+{
+    extent->start = start;
+    extent->len = len;
+    rb_insert(&tree->by_start, &extent->by_start, start_less);
+    rb_insert(&tree->by_length, &extent->by_length, length_less);
+    ++tree->count;
+    tree->total += len;
+}
+
+static void unlink_extent(extent_tree_t *tree, extent_t *extent)
+{
+    rb_erase(&tree->by_start, &extent->by_start);
+    rb_erase(&tree->by_length, &extent->by_length);
+    --tree->count;
+    tree->total -= extent->len;
+}
+
+static void drop_extent(extent_tree_t *tree, extent_t *extent)
+{
+    extent->by_start.right = (rb_node_t *) tree->unused;
+    tree->unused = extent;
+}
+
+// the extent with the highest start at or below `at`, NULL if there is none
+static extent_t *floor_extent(const extent_tree_t *tree, size_t at)
+{
+    rb_node_t *node = tree->by_start;
+    extent_t *found = NULL;
+    while (node)
+    {
+        extent_t *extent = EXTENT_OF(node, by_start);
+        if (extent->start <= at)
+        {
+            found = extent;
+            node = node->right;
+        }
+        else node = node->left;
+    }
+    return found;
+}
+
+// the extent holding `at` or the first one after it, NULL if there is none
+static extent_t *extent_from(const extent_tree_t *tree, size_t at)
+{
+    extent_t *extent = floor_extent(tree, at);
+    if (extent && extent->start + extent->len > at) return extent;
+    rb_node_t *node = extent ? rb_next(&extent->by_start) : rb_first(tree->by_start);
+    return node ? EXTENT_OF(node, by_start) : NULL;
+}
+
+// ----------------------- CORE FUNCTION ----------------------- //
+
+void extent_tree_init(extent_tree_t *tree)
+{
+    tree->by_start = NULL;
+    tree->by_length = NULL;
+    tree->unused = NULL;
+    tree->count = 0;
+    tree->total = 0;
+}
+
+void extent_tree_clear(extent_tree_t *tree)
+{
+    if (!tree) return;
+    // children are freed before their parent, which is unlinked from its own parent as it goes
+    rb_node_t *node = tree->by_start;
+    while (node)
+    {
+        if (node->left || node->right)
+        {
+            node = node->left ? node->left : node->right;
+            continue;
+        }
+        rb_node_t *parent = node->parent;
+        if (parent && parent->left == node) parent->left = NULL;
+        else if (parent) parent->right = NULL;
+        free(EXTENT_OF(node, by_start));
+        node = parent;
+    }
+    while (tree->unused)
+    {
+        extent_t *next = (extent_t *) tree->unused->by_start.right;
+        free(tree->unused);
+        tree->unused = next;
+    }
+    extent_tree_init(tree);
+}
+
+int extent_tree_add(extent_tree_t *tree, size_t start, size_t len)
+{
+    if (!tree) return -1;
+    if (len == 0) return 0;
+
+    // every extent that overlaps or touches the new one is folded into it
+    size_t end = start + len;
+    extent_t *merged = NULL;
+    extent_t *extent = floor_extent(tree, start);
+    if (!extent || extent->start + extent->len < start)
+    {
+        rb_node_t *node = extent ? rb_next(&extent->by_start) : rb_first(tree->by_start);
+        extent = node ? EXTENT_OF(node, by_start) : NULL;
+    }
+    while (extent && extent->start <= end)
+    {
+        rb_node_t *next = rb_next(&extent->by_start);
+        if (extent->start < start) start = extent->start;
+        if (extent->start + extent->len > end) end = extent->start + extent->len;
+        unlink_extent(tree, extent);
+        if (merged) drop_extent(tree, extent);
+        else merged = extent;
+        extent = next ? EXTENT_OF(next, by_start) : NULL;
+    }
+
+    if (!merged) merged = new_extent(tree);
+    if (!merged) return -1;
+    link_extent(tree, merged, start, end - start);
+    return 0;
+}
+
+int extent_tree_remove(extent_tree_t *tree, size_t start, size_t len)
+{
+    if (!tree) return -1;
+    if (len == 0) return 0;
+
+    size_t end = start + len;
+    extent_t *extent = extent_from(tree, start);
+    while (extent && extent->start < end)
+    {
+        rb_node_t *next = rb_next(&extent->by_start);
+        size_t extent_start = extent->start;
+        size_t extent_end = extent->start + extent->len;
+        unlink_extent(tree, extent);
+
+        // what is left on either side goes back in, reusing the node for the first part
+        if (extent_start < start)
+        {
+            link_extent(tree, extent, extent_start, start - extent_start);
+            extent = NULL;
+        }
+        if (extent_end > end)
+        {
+            if (!extent) extent = new_extent(tree);
+            if (!extent) return -1;
+            link_extent(tree, extent, end, extent_end - end);
+            extent = NULL;
+        }
+        if (extent) drop_extent(tree, extent);
+        extent = next ? EXTENT_OF(next, by_start) : NULL;
+    }
+    return 0;
+}
+
+int extent_tree_best_fit(const extent_tree_t *tree, size_t len, size_t *start, size_t *found_len)
+{
+    if (!tree || !start || !found_len) return 0;
+
+    rb_node_t *node = tree->by_length;
+    const extent_t *found = NULL;
+    while (node)
+    {
+        const extent_t *extent = EXTENT_OF(node, by_length);
+        if (extent->len >= len)
+        {
+            found = extent;
+            node = node->left;
+        }
+        else node = node->right;
+    }
+    if (!found) return 0;
+    *start = found->start;
+    *found_len = found->len;
+    return 1;
+}
+
+int extent_tree_longest(const extent_tree_t *tree, size_t *start, size_t *len)
+{
+    if (!tree || !start || !len) return 0;
+
+    rb_node_t *node = rb_last(tree->by_length);
+    if (!node) return 0;
+    // the lowest of the longest extents, which sort by start among themselves
+    size_t longest = EXTENT_OF(node, by_length)->len;
+    return extent_tree_best_fit(tree, longest, start, len);
+}
+
+int extent_tree_find(const extent_tree_t *tree, size_t at, size_t *start, size_t *len)
+{
+    if (!tree || !start || !len) return 0;
+
+    const extent_t *extent = extent_from(tree, at);
+    if (!extent) return 0;
+    *start = extent->start;
+    *len = extent->len;
+    return 1;
+}
@@ -3,54 +3,63 @@
 #include "utility.h"
 #include <string.h>
 
-#define DIRECTORY_ENTRY_SIZE (sizeof(inode_index_t) + MAX_FILE_NAME_LEN)
-#define DIRECTORY_ENTRIES_PER_DATABLOCK (DATA_BLOCK_SIZE / DIRECTORY_ENTRY_SIZE)
-
-
 // ----------------------- CORE FUNCTION ----------------------- //
 
-char* write_index_and_name(inode_index_t new_inode_index, char* dest)
+// directory entries are `directory_entry_size(fs)` bytes wide, depending on the geometry
+char* write_index_and_name(filesystem_t *fs, inode_index_t new_inode_index, char* dest)
 {
-    char *new_entry = calloc(16, 1);
+    char *new_entry = calloc(directory_entry_size(fs), 1);
     if (!new_entry) return NULL;
 
-    new_entry[0] = new_inode_index & 0xFF;
-    new_entry[1] = (new_inode_index >> 8) & 0xFF;
-
-    strncpy(new_entry + 2, dest, 13);
-    new_entry[15] = '\0';
-    info(1, "New entry: %s\n", new_entry + 2);
+    write_directory_entry(fs, (byte *)new_entry, new_inode_index, dest);
+    info(1, "New entry: %s\n", directory_entry_name(fs, (byte *)new_entry));
     return new_entry;
 }
 
-inode_index_t get_index(byte *contents, int j)
+inode_index_t get_index(filesystem_t *fs, byte *contents, int j)
 {
-    inode_index_t ans = 0;
-    ans |= contents[j*16];
-    ans |= contents[j*16+1] << 8;
-    return ans;
+    return directory_entry_inode(fs, &contents[j * directory_entry_size(fs)]);
+}
+
+// copies the name of entry j into `name`, which holds MAX_FILE_NAME_LEN bytes
+static void get_name(filesystem_t *fs, byte *contents, int j, char *name)
+{
+    strncpy(name, directory_entry_name(fs, &contents[j * directory_entry_size(fs)]), MAX_FILE_NAME_LEN - 1);
+    name[MAX_FILE_NAME_LEN - 1] = '\0';
+}
+
+// true if every byte of the entry at `offset` is zero
+static int is_tombstone_entry(filesystem_t *fs, byte *contents, size_t offset)
+{
+    for(size_t j = 0; j < directory_entry_size(fs); j++) {
+        if(contents[offset + j] != 0) return 0;
+    }
+    return 1;
 }
 
-void debug_contents(byte *contents, size_t file_size)
+void debug_contents(filesystem_t *fs, byte *contents, size_t file_size)
 {
+    size_t entry_size = directory_entry_size(fs);
     info(1, "File size: %zu bytes\n", file_size);
     info(1, "Raw contents (first 32 bytes):\n");
     for(unsigned int i = 0; i < (file_size < 32 ? file_size : 32); i++) {
         info(1, "%c ", contents[i]);
-        if((i + 1) % 16 == 0) info(1, "\n");
+        if((i + 1) % 16 == 0) {
+            info(1, "\n");
+        }
     }
     info(1, "\n");
     
-    int n = file_size / 16;
+    int n = file_size / entry_size;
     info(1, "Number of entries: %d\n", n);
     
     // Debug each entry as we process it
     for(int j = 0; j < n; j++) {
         info(1, "Entry %d:\n", j);
-        info(1, "  Index bytes: %02x %02x\n", contents[j*16], contents[j*16+1]);
+        info(1, "  Index: %u\n", get_index(fs, contents, j));
         info(1, "  Name bytes: ");
-        for(int k = 2; k < 16; k++) {
-            info(1, "%c ", contents[j*16 + k]);
+        for(int k = 0; k < MAX_FILE_NAME_LEN; k++) {
+            info(1, "%c ", directory_entry_name(fs, &contents[j * entry_size])[k]);
         }
         info(1, "\n");
     }
@@ -70,9 +79,7 @@ char **split_string(char *path) {
     }
 
     char **tokens = malloc(n * sizeof(char *));
-    char *token = malloc(16);
-
-    token = strtok (path,"/");
+    char *token = strtok (path,"/");
     int i = 0;
     while (token != NULL)
     {
@@ -114,7 +121,9 @@ char *get_path_before_dest(char *path)
         strcat(dest, file_path[i]);
         strcat(dest, "/");
     }
-    dest[strlen(dest)-1] = '\0'; // Remove the trailing slash
+    if(strlen(dest) > 0) dest[strlen(dest)-1] = '\0'; // Remove the trailing slash
+    free(file_path);
+    free(dupe);
     return dest;
 }
 
@@ -139,17 +148,16 @@ inode_index_t find_index_of(terminal_context_t *context, inode_t *inode, char* p
         size_t file_size = curr_dir->internal.file_size;
         inode_read_data(context->fs, curr_dir, 0, contents, file_size, &file_size);
         
-        int n = file_size / 16;
+        int n = file_size / directory_entry_size(context->fs);
         char **content_names = malloc(n * sizeof(char *));
         inode_index_t *indices = malloc(n * sizeof(inode_index_t));
         
         // Read directory entries
         for(int j = 0; j < n; j++)
         {
-            char* name = calloc(14, 1);
-            indices[j] = get_index(contents, j);
-            strncpy(name, (char*)&contents[16*j + 2], 13);
-            name[13] = '\0';
+            char* name = calloc(MAX_FILE_NAME_LEN, 1);
+            indices[j] = get_index(context->fs, contents, j);
+            get_name(context->fs, contents, j, name);
             content_names[j] = name;
             
             info(1, "Entry %d: %s (index=%d)\n", j, name, indices[j]);
@@ -219,15 +227,14 @@ fs_file_t fs_open_dir(terminal_context_t *context, char *path)
         inode_read_data(context->fs, curr_dir, 0, contents, curr_dir->internal.file_size, &file_size);
 
 
-        int n = file_size / 16;
+        int n = file_size / directory_entry_size(context->fs);
         char **content_names = malloc(n * sizeof(char *));
         inode_index_t *indices = malloc(n * sizeof(inode_index_t));
         for(int j = 0; j < n; j++)
         {
-            char* name = calloc(14, 1);
-            indices[j] = get_index(contents, j);
-            strncpy(name, (char*)&contents[16*j + 2], 13);
-            name[13] = '\0'; // Ensure null termination
+            char* name = calloc(MAX_FILE_NAME_LEN, 1);
+            indices[j] = get_index(context->fs, contents, j);
+            get_name(context->fs, contents, j, name);
             content_names[j] = name;
             
             info(1, "%s ", content_names[j]);
@@ -263,16 +270,26 @@ fs_file_t fs_open_dir(terminal_context_t *context, char *path)
         }
         free(content_names);
         free(indices);
+        free(contents);
     }
+    free(file_path);
+    free(dupe);
     info(1, "%s\n", curr_dir->internal.file_name);
     //confirm path exists, leads to a file
     //allocate space for the file, assign its fs and inode. Set offset to 0.
     //return file
-    fs_file_t file = malloc(sizeof(fs_file_t));
+    fs_file_t file = malloc(sizeof(struct fs_file));
     if(!file) return NULL;
     file->fs = context->fs;
     file->inode = curr_dir;
     file->offset = 0;
+    file->window.start = 0;
+    file->window.len = 0;
+    file->pending.data = NULL;
+    file->pending.len = 0;
+    file->pending.cap = 0;
+    file->reservation.dblocks = 0;
+    file->reservation.inodes = 0;
     return file;
 }
 
@@ -284,16 +301,15 @@ int fs_contains(filesystem_t *fs, fs_file_t dir, char *name)
     inode_read_data(fs, dir->inode, 0, contents, dir->inode->internal.file_size, &file_size);
     // debug_contents(contents, file_size);
     //i need to put 16 bytes into a string
-    int n = file_size / 16;
+    int n = file_size / directory_entry_size(fs);
     char **content_names = malloc(n * sizeof(char *));
     inode_index_t *indices = malloc(n * sizeof(inode_index_t));
     for(int j = 0; j < n; j++)
     {
-        char* name = calloc(14, 1);
-        indices[j] = get_index(contents, j);
-        strncpy(name, (char*)&contents[16*j + 2], 13);
-        name[13] = '\0'; // Ensure null termination
-        content_names[j] = name;
+        char* entry_name = calloc(MAX_FILE_NAME_LEN, 1);
+        indices[j] = get_index(fs, contents, j);
+        get_name(fs, contents, j, entry_name);
+        content_names[j] = entry_name;
         
         info(1, "%s ", content_names[j]);
         info(1, "\n");
@@ -320,6 +336,7 @@ int fs_contains(filesystem_t *fs, fs_file_t dir, char *name)
     }
     free(content_names);
     free(indices);
+    free(contents);
 
     return found;
 }
@@ -356,7 +373,8 @@ int new_file(terminal_context_t *context, char *path, permission_t perms)
     }
     char *path_before_dest = get_path_before_dest(path);
     int path_len = get_path_length(path);
-    char *dest = split_string(path)[path_len-1];
+    char **path_tokens = split_string(path);
+    char *dest = path_tokens[path_len-1];
 
     fs_file_t curr_dir = fs_open_dir(context, path_before_dest);
     if(!curr_dir)
@@ -370,52 +388,69 @@ int new_file(terminal_context_t *context, char *path, permission_t perms)
         return -1;
     }
 
+    // Get current directory contents to find tombstone or append position
+    byte *curr_contents = malloc(curr_dir->inode->internal.file_size);
+    size_t curr_size = curr_dir->inode->internal.file_size;
+    inode_read_data(context->fs, curr_dir->inode, 0, curr_contents, curr_size, &curr_size);
+    size_t write_offset = curr_size;  // Default to appending
+    size_t entry_size = directory_entry_size(context->fs);
+    for(size_t i = 0; i < curr_size; i += entry_size) {
+        // Check all bytes of the entry for zeros
+        if(is_tombstone_entry(context->fs, curr_contents, i)) {
+            info(1, "Found tombstone at offset %zu\n", i);
+            write_offset = i;
+            break;
+        }
+    }
+    info(1, "Final write offset: %zu\n", write_offset);
+
+    // everything the file takes is reserved first so the claims below cannot run out
+    fs_reservation_t reservation;
+    size_t parent_end = write_offset + entry_size > curr_size ? write_offset + entry_size : curr_size;
+    size_t parent_growth = calculate_necessary_dblock_amount(parent_end) - calculate_necessary_dblock_amount(curr_size);
+    if(fs_reserve(context->fs, parent_growth, 1, &reservation) != SUCCESS)
+    {
+        printf("Error: Not enough dblocks for operation\n");
+        free(curr_contents);
+        return -1;
+    }
+
     //need to write the file name into the directory
     inode_index_t *new_inode_index = malloc(sizeof(inode_index_t));
-    if(claim_available_inode(context->fs, new_inode_index) == SUCCESS)
+    inode_index_t parent_index = curr_dir->inode - context->fs->inodes;
+    fs_reservation_draw(context->fs, &reservation, 0, 1);
+    if(claim_inode_near(context->fs, parent_index, DATA_FILE, new_inode_index) == SUCCESS)
     {
         info(1, "Claimed inode index: %d (0x%02x)\n", *new_inode_index, *new_inode_index);
     }
     else
     {
+        fs_abort(context->fs, &reservation);
+        free(curr_contents);
         return -1;
     }
     inode_t *new_inode = &context->fs->inodes[*new_inode_index];
     new_inode->internal.file_type = DATA_FILE;
     new_inode->internal.file_size = 0;
-    strncpy(new_inode->internal.file_name, dest, 14);
+    new_inode->internal.map_flags = context->fs->extent_map_files ? INODE_EXTENT_MAPPED :
+        context->fs->tree_map_files ? INODE_TREE_MAPPED : 0;
+    memset(new_inode->internal.file_name, 0, MAX_FILE_NAME_LEN);
+    memcpy(new_inode->internal.file_name, dest, strnlen(dest, MAX_FILE_NAME_LEN));
     for(int i = 0; i < 4; i++)
     {
         new_inode->internal.direct_data[i] = 0;
     }
     new_inode->internal.indirect_dblock = 0;
+    // the first dblock of the file should land close to the dblocks of its directory
+    set_dblock_hint(context->fs, new_inode, context->fs->dblock_alloc_mode == DBLOCK_GOAL_DIRECTED ?
+        inode_dblock_goal(context->fs, curr_dir->inode) : 0);
     new_inode->internal.file_perms = perms;
-    char *contents = write_index_and_name(*new_inode_index, dest);
-    debug_contents((byte*)contents, DIRECTORY_ENTRY_SIZE);
+    char *contents = write_index_and_name(context->fs, *new_inode_index, dest);
+    debug_contents(context->fs, (byte*)contents, entry_size);
     
-    // Get current directory contents to find tombstone or append position
-    byte *curr_contents = malloc(curr_dir->inode->internal.file_size);
-    size_t curr_size = curr_dir->inode->internal.file_size;
-    inode_read_data(context->fs, curr_dir->inode, 0, curr_contents, curr_size, &curr_size);
-    size_t write_offset = curr_size;  // Default to appending
-    for(size_t i = 0; i < curr_size; i += 16) {
-        // Check all 16 bytes for zeros
-        int is_tombstone = 1;
-        for(int j = 0; j < 16; j++) {
-            if(curr_contents[i + j] != 0) {
-                is_tombstone = 0;
-                break;
-            }
-        }
-        
-        if(is_tombstone) {
-            info(1, "Found tombstone at offset %zu\n", i);
-            write_offset = i;
-            break;
-        }
-    }
-    info(1, "Final write offset: %zu\n", write_offset);
-    inode_modify_data(context->fs, curr_dir->inode, write_offset, contents, DIRECTORY_ENTRY_SIZE);
+    fs_reservation_draw(context->fs, &reservation, parent_growth, 0);
+    inode_modify_data(context->fs, curr_dir->inode, write_offset, contents, entry_size);
+    fs_commit(context->fs, &reservation);
     // Clean up
     info(1, "Inspecting dblock index 1:\n");
     for(int i = 0; i < 64; i++) {
@@ -426,6 +461,10 @@ int new_file(terminal_context_t *context, char *path, permission_t perms)
     }
     free(contents);
     free(curr_contents);
+    free(new_inode_index);
+    free(curr_dir);
+    free(path_tokens);
+    free(path_before_dest);
     return 0;
 }
 
@@ -458,64 +497,79 @@ int new_directory(terminal_context_t *context, char *path)
         return -1;
     }
 
+    // Get current directory contents to find tombstone or append position
+    byte *curr_contents = calloc(curr_dir->inode->internal.file_size, 1);
+    size_t curr_size = curr_dir->inode->internal.file_size;
+    inode_read_data(context->fs, curr_dir->inode, 0, curr_contents, curr_size, &curr_size);
+    size_t write_offset = curr_size;  // Default to appending
+    size_t entry_size = directory_entry_size(context->fs);
+    for(size_t i = 0; i < curr_size; i += entry_size) {
+        // Check all bytes of the entry for zeros
+        if(is_tombstone_entry(context->fs, curr_contents, i)) {
+            info(1, "Found tombstone at offset %zu\n", i);
+            write_offset = i;
+            break;
+        }
+    }
+    info(1, "Final write offset: %zu\n", write_offset);
+
+    // everything the directory takes is reserved first so the claims below cannot run out
+    fs_reservation_t reservation;
+    size_t parent_end = write_offset + entry_size > curr_size ? write_offset + entry_size : curr_size;
+    size_t parent_growth = calculate_necessary_dblock_amount(parent_end) - calculate_necessary_dblock_amount(curr_size);
+    if(fs_reserve(context->fs, parent_growth + 1, 1, &reservation) != SUCCESS)
+    {
+        printf("Error: Not enough dblocks for operation\n");
+        free(curr_contents);
+        return -1;
+    }
+
     //need to write the file name into the directory
     inode_index_t *new_inode_index = malloc(sizeof(inode_index_t));
-    if(claim_available_inode(context->fs, new_inode_index) == SUCCESS)
+    inode_index_t parent_index = curr_dir->inode - context->fs->inodes;
+    fs_reservation_draw(context->fs, &reservation, 0, 1);
+    if(claim_inode_near(context->fs, parent_index, DIRECTORY, new_inode_index) == SUCCESS)
     {
         info(1, "Claimed inode index: %d (0x%02x)\n", *new_inode_index, *new_inode_index);
     }
     else
     {
+        fs_abort(context->fs, &reservation);
+        free(curr_contents);
         return -1;
     }
     inode_t *new_inode = &context->fs->inodes[*new_inode_index];
     new_inode->internal.file_type = DIRECTORY;
     new_inode->internal.file_size = 0; 
+    new_inode->internal.map_flags = 0;
     size_t dest_len = strlen(dest);
-    strncpy(new_inode->internal.file_name, dest, dest_len);
+    memcpy(new_inode->internal.file_name, dest, dest_len < MAX_FILE_NAME_LEN ? dest_len : MAX_FILE_NAME_LEN);
     if (dest_len < MAX_FILE_NAME_LEN) {
         new_inode->internal.file_name[dest_len] = '\0';
     }
     new_inode->internal.indirect_dblock = 0;
 
-    char *special_data1 = calloc(DIRECTORY_ENTRY_SIZE, 1);
-    char *special_data2 = calloc(DIRECTORY_ENTRY_SIZE, 1);
-    special_data1 = write_index_and_name(*new_inode_index, ".");
+    char *special_data1 = calloc(entry_size, 1);
+    char *special_data2 = calloc(entry_size, 1);
+    special_data1 = write_index_and_name(context->fs, *new_inode_index, ".");
     inode_index_t parent_dir_index = find_index_of(context, curr_dir->inode, path_before_dest, path_len-1);
-    special_data2 = write_index_and_name(parent_dir_index, "..");
+    special_data2 = write_index_and_name(context->fs, parent_dir_index, "..");
 
-    inode_write_data(context->fs, new_inode, special_data1 , 16);
+    set_dblock_hint(context->fs, new_inode, context->fs->dblock_alloc_mode == DBLOCK_GOAL_DIRECTED ?
+        inode_dblock_goal(context->fs, curr_dir->inode) : 0);
+    fs_reservation_draw(context->fs, &reservation, 1, 0);
+    inode_write_data(context->fs, new_inode, special_data1 , entry_size);
 
-    inode_write_data(context->fs, new_inode, special_data2, 16);
+    inode_write_data(context->fs, new_inode, special_data2, entry_size);
 
-    new_inode->internal.file_size = 32;
+    new_inode->internal.file_size = 2 * entry_size;
 
-    char *contents = write_index_and_name(*new_inode_index, dest);
-    debug_contents((byte*)contents, DIRECTORY_ENTRY_SIZE);
+    char *contents = write_index_and_name(context->fs, *new_inode_index, dest);
+    debug_contents(context->fs, (byte*)contents, entry_size);
     
-    // Get current directory contents to find tombstone or append position
-    byte *curr_contents = calloc(curr_dir->inode->internal.file_size, 1);
-    size_t curr_size = curr_dir->inode->internal.file_size;
-    inode_read_data(context->fs, curr_dir->inode, 0, curr_contents, curr_size, &curr_size);
-    size_t write_offset = curr_size;  // Default to appending
-    for(size_t i = 0; i < curr_size; i += 16) {
-        // Check all 16 bytes for zeros
-        int is_tombstone = 1;
-        for(int j = 0; j < 16; j++) {
-            if(curr_contents[i + j] != 0) {
-                is_tombstone = 0;
-                break;
-            }
-        }
-        
-        if(is_tombstone) {
-            info(1, "Found tombstone at offset %zu\n", i);
-            write_offset = i;
-            break;
-        }
-    }
-    info(1, "Final write offset: %zu\n", write_offset);
-    inode_modify_data(context->fs, curr_dir->inode, write_offset, contents, DIRECTORY_ENTRY_SIZE);
+    fs_reservation_draw(context->fs, &reservation, parent_growth, 0);
+    inode_modify_data(context->fs, curr_dir->inode, write_offset, contents, entry_size);
+    fs_commit(context->fs, &reservation);
 
     // Clean up
     info(1, "Inspecting dblock index 1:\n");
@@ -609,24 +663,25 @@ int remove_file(terminal_context_t *context, char *path)
     // }
     byte *contents = malloc(parent_dir->inode->internal.file_size);
     inode_read_data(context->fs, parent_dir->inode, 0, contents, parent_dir->inode->internal.file_size, &parent_dir->inode->internal.file_size);
-    for(size_t i = 0; i < parent_dir->inode->internal.file_size; i += 16) 
+    size_t entry_size = directory_entry_size(context->fs);
+    for(size_t i = 0; i < parent_dir->inode->internal.file_size; i += entry_size) 
     {
-        inode_index_t index = get_index(curr_contents, i/16);
+        inode_index_t index = get_index(context->fs, curr_contents, i/entry_size);
         if(index == removed_index) 
         {
             // Mark the entry as a tombstone
-            byte entry[16] = {0};
-            inode_modify_data(context->fs, parent_dir->inode, i, entry, 16);
+            byte entry[LARGE_DIRECTORY_ENTRY_SIZE] = {0};
+            inode_modify_data(context->fs, parent_dir->inode, i, entry, entry_size);
             
             int trailing_tombstone = 1;
-            for(size_t j = i + 16; j < parent_dir->inode->internal.file_size; j++) 
+            for(size_t j = i + entry_size; j < parent_dir->inode->internal.file_size; j++) 
             {
                 if(contents[j] != 0) {
                     trailing_tombstone = 0;
                 } 
             }
             if(trailing_tombstone) {
-                parent_dir->inode->internal.file_size -= 16;
+                parent_dir->inode->internal.file_size -= entry_size;
             }
             info(1, "Marked entry at offset %zu as tombstone\n", i);
             break;
@@ -650,7 +705,7 @@ int is_empty(filesystem_t *fs ,inode_t *inode)
     if(inode->internal.file_size == 0) return 1;
     byte *contents = calloc(inode->internal.file_size, 1);
     size_t file_size = inode->internal.file_size;
-    inode_read_data(fs, inode, 32, contents, inode->internal.file_size, &file_size);
+    inode_read_data(fs, inode, 2 * directory_entry_size(fs), contents, inode->internal.file_size, &file_size);
     for(size_t i = 0; i < inode->internal.file_size; i++)
     {
         if(contents[i] != 0) return 1;
@@ -677,11 +732,9 @@ void debug_dblock_bitmap(filesystem_t *fs) {
 
 // Track data block allocation and release
 void debug_dblock_operation(filesystem_t *fs, byte dblock_index, const char* operation) {
-    size_t byte_index = dblock_index / 8;
-    size_t bit_index = dblock_index % 8;
     info(1, "%s dblock %u (byte %zu, bit %zu)\n", 
-         operation, dblock_index, byte_index, bit_index);
-    info(1, "Before operation: 0x%02x\n", fs->dblocks[byte_index]);
+         operation, dblock_index, (size_t)dblock_index / 8, (size_t)dblock_index % 8);
+    info(1, "Before operation: 0x%02x\n", fs->dblocks[dblock_index / 8]);
 }
 
 // Debug inode data blocks
@@ -709,16 +762,16 @@ void debug_parent_dir(filesystem_t *fs, inode_t *parent_inode) {
     inode_read_data(fs, parent_inode, 0, contents, size, &size);
     
     info(1, "\nDirectory Entries:\n");
-    for(size_t i = 0; i < size; i += 16) {
-        inode_index_t index = get_index(contents, i/16);
-        char name[14] = {0};
-        strncpy(name, (char*)&contents[i + 2], 13);
+    size_t entry_size = directory_entry_size(fs);
+    for(size_t i = 0; i < size; i += entry_size) {
+        char name[MAX_FILE_NAME_LEN] = {0};
+        get_name(fs, contents, i/entry_size, name);
         
-        info(1, "Entry %zu:\n", i/16);
-        info(1, "  Index: %u\n", index);
+        info(1, "Entry %zu:\n", i/entry_size);
+        info(1, "  Index: %u\n", get_index(fs, contents, i/entry_size));
         info(1, "  Name: %s\n", name);
         info(1, "  Raw bytes: ");
-        for(int j = 0; j < 16; j++) {
+        for(size_t j = 0; j < entry_size; j++) {
             info(1, "%02x ", contents[i + j]);
         }
         info(1, "\n");
@@ -819,38 +872,31 @@ int remove_directory(terminal_context_t *context, char *path)
     byte *contents = malloc(parent_dir->inode->internal.file_size);
     size_t n = 0;
     inode_read_data(context->fs, parent_dir->inode, 0, contents, parent_dir->inode->internal.file_size, &n);
-    for(size_t i = 0; i < parent_dir->inode->internal.file_size; i += 16)
+    size_t entry_size = directory_entry_size(context->fs);
+    for(size_t i = 0; i < parent_dir->inode->internal.file_size; i += entry_size)
     {
-        inode_index_t index = get_index(contents, i/16);
+        inode_index_t index = get_index(context->fs, contents, i/entry_size);
         if(index == removed_index) 
         {
             debug_parent_dir(context->fs, parent_dir->inode);
 
-            byte entry[16] = {0};
-            inode_modify_data(context->fs, parent_dir->inode, i, entry, 16);
+            byte entry[LARGE_DIRECTORY_ENTRY_SIZE] = {0};
+            inode_modify_data(context->fs, parent_dir->inode, i, entry, entry_size);
             
             debug_parent_dir(context->fs, parent_dir->inode);
 
             size_t last_non_tombstone = 0;
             inode_read_data(context->fs, parent_dir->inode, 0, contents, parent_dir->inode->internal.file_size, &n);
-            for(size_t j = 0; j < parent_dir->inode->internal.file_size; j+=16) 
+            for(size_t j = 0; j < parent_dir->inode->internal.file_size; j+=entry_size) 
             {
-                int tombstone = 1;
-                for(int k = 0; k < 16; k++) {
-                    if(contents[j + k] != 0) {
-                        tombstone = 0;
-                        break;
-                    }
-                }
-
-                if(tombstone == 0) {
+                if(!is_tombstone_entry(context->fs, contents, j)) {
                     last_non_tombstone = j;
                 }
             }
-            if(last_non_tombstone+16 <= parent_dir->inode->internal.file_size) {
-                parent_dir->inode->internal.file_size = last_non_tombstone+16;
+            if(last_non_tombstone+entry_size <= parent_dir->inode->internal.file_size) {
+                parent_dir->inode->internal.file_size = last_non_tombstone+entry_size;
             } else {
-                inode_shrink_data(context->fs, parent_dir->inode, last_non_tombstone+16);
+                inode_shrink_data(context->fs, parent_dir->inode, last_non_tombstone+entry_size);
             }
         }
     }
@@ -959,10 +1005,11 @@ int list(terminal_context_t *context, char *path)
         return 0;
     }
     else {
-        for(size_t i = 0; i < file->inode->internal.file_size; i += 16) {
-            inode_index_t index = get_index(contents, i/16);
-            char name[14] = {0};
-            strncpy(name, (char*)&contents[i + 2], 13);
+        size_t entry_size = directory_entry_size(context->fs);
+        for(size_t i = 0; i < file->inode->internal.file_size; i += entry_size) {
+            inode_index_t index = get_index(context->fs, contents, i/entry_size);
+            char name[MAX_FILE_NAME_LEN] = {0};
+            get_name(context->fs, contents, i/entry_size, name);
     
             info(1, "Processing entry at offset %zu:\n", i);
             info(1, "  Index: %u\n", index);
@@ -1035,12 +1082,13 @@ char* get_length_path_str(filesystem_t *fs, inode_t *root, inode_t *dest)
     {
         char *name = calloc(16, 1);
         path_len++;
-        byte *contents = calloc(16,1);
+        size_t entry_size = directory_entry_size(fs);
+        byte *contents = calloc(entry_size,1);
         size_t len = 0;
-        inode_read_data(fs, curr_dir, 16, contents, 16, &len); 
-        inode_index_t index = get_index(contents, 0);
+        inode_read_data(fs, curr_dir, entry_size, contents, entry_size, &len); 
+        inode_index_t index = get_index(fs, contents, 0);
         char *inode_name = fs->inodes[index].internal.file_name;
-        strncpy(name, inode_name, 13);
+        memcpy(name, inode_name, strnlen(inode_name, MAX_FILE_NAME_LEN - 1));
         reversed_path[count] = name;
         count++;
         curr_dir = &fs->inodes[index];
@@ -1079,9 +1127,10 @@ void tree_dfs(inode_t *work_dir, terminal_context_t *context, inode_t *root, int
     size_t n = 0;
     inode_read_data(context->fs, root, 0, contents, root->internal.file_size, &n);
     path = calloc(16, 1);
-    for(size_t i = 0; i < root->internal.file_size; i += 16) {
+    size_t entry_size = directory_entry_size(context->fs);
+    for(size_t i = 0; i < root->internal.file_size; i += entry_size) {
         context->working_directory = root;
-        inode_index_t index = get_index(contents, i/16);
+        inode_index_t index = get_index(context->fs, contents, i/entry_size);
         if(context->fs->inodes[index].internal.file_type == DIRECTORY && visited[index] == 0) {
             // strcat(path, "/");
             // strcat(path, context->fs->inodes[index].internal.file_name);
@@ -1169,6 +1218,77 @@ int tree(terminal_context_t *context, char *path)
     return 0;
 }
 
+// true if inode n is a directory in use
+static int is_directory_in_use(filesystem_t *fs, size_t n)
+{
+    if((fs->inode_free_bits[n / 64] >> (n % 64)) & 1) return 0;
+    return fs->inodes[n].internal.file_type == DIRECTORY;
+}
+
+fs_retcode_t fs_convert_geometry(filesystem_t *fs, fs_geometry_t geometry)
+{
+    if(!fs) return INVALID_INPUT;
+    if(geometry != FS_GEOMETRY_CLASSIC && geometry != FS_GEOMETRY_LARGE) return INVALID_INPUT;
+    size_t max_inodes = geometry == FS_GEOMETRY_LARGE ? LARGE_MAX_INODE_COUNT : CLASSIC_MAX_INODE_COUNT;
+    if(fs->inode_count > max_inodes) return INVALID_INPUT;
+    if(fs->geometry == geometry) return SUCCESS;
+
+    // magazines hold inodes that look in use without being so
+    fs_drain_magazines(fs);
+    // the entry helpers only look at the geometry
+    const filesystem_t target = { .geometry = geometry };
+    size_t old_entry_size = directory_entry_size(fs);
+    size_t new_entry_size = directory_entry_size(&target);
+
+    // the dblocks growing directories take are counted first, so a conversion that does not
+    // fit changes nothing. one buffer pair sized for the largest directory serves them all
+    size_t need = 0;
+    size_t largest = 0;
+    for(size_t n = 0; n < fs->inode_count; n++)
+    {
+        if(!is_directory_in_use(fs, n)) continue;
+        size_t size = fs->inodes[n].internal.file_size;
+        size_t converted = size / old_entry_size * new_entry_size;
+        if(converted > size)
+            need += calculate_necessary_dblock_amount(converted) - calculate_necessary_dblock_amount(size);
+        if(size > largest) largest = size;
+    }
+    if(need > available_dblocks(fs)) return INSUFFICIENT_DBLOCKS;
+
+    size_t largest_converted = largest / old_entry_size * new_entry_size;
+    byte *contents = malloc(largest ? largest : 1);
+    byte *converted = malloc(largest_converted ? largest_converted : 1);
+    if(!contents || !converted)
+    {
+        free(contents);
+        free(converted);
+        return SYSTEM_ERROR;
+    }
+
+    // tombstones are all zeros in either geometry, so they convert like any other entry
+    for(size_t n = 0; n < fs->inode_count; n++)
+    {
+        if(!is_directory_in_use(fs, n)) continue;
+        inode_t *dir = &fs->inodes[n];
+        size_t size = dir->internal.file_size;
+        size_t entries = size / old_entry_size;
+        inode_read_data(fs, dir, 0, contents, size, &size);
+        for(size_t j = 0; j < entries; j++)
+        {
+            const byte *entry = &contents[j * old_entry_size];
+            write_directory_entry(&target, &converted[j * new_entry_size], directory_entry_inode(fs, entry), directory_entry_name(fs, entry));
+        }
+        size_t converted_size = entries * new_entry_size;
+        inode_modify_data(fs, dir, 0, converted, converted_size);
+        if(converted_size < dir->internal.file_size) inode_shrink_data(fs, dir, converted_size);
+    }
+    free(contents);
+    free(converted);
+
+    fs->geometry = geometry;
+    return SUCCESS;
+}
+
 //Part 2
 void new_terminal(filesystem_t *fs, terminal_context_t *term)
 {
@@ -1205,17 +1325,16 @@ fs_file_t fs_open(terminal_context_t *context, char *path)
         byte *contents = malloc(curr_dir->internal.file_size);
         size_t file_size = curr_dir->internal.file_size;
         inode_read_data(context->fs, curr_dir, 0, contents, curr_dir->internal.file_size, &file_size);
-        debug_contents(contents, file_size);
+        debug_contents(context->fs, contents, file_size);
         //i need to put 16 bytes into a string
-        int n = file_size / 16;
+        int n = file_size / directory_entry_size(context->fs);
         char **content_names = malloc(n * sizeof(char *));
         inode_index_t *indices = malloc(n * sizeof(inode_index_t));
         for(int j = 0; j < n; j++)
         {
-            char* name = calloc(14, 1);
-            indices[j] = get_index(contents, j);
-            strncpy(name, (char*)&contents[16*j + 2], 13);
-            name[13] = '\0'; // Ensure null termination
+            char* name = calloc(MAX_FILE_NAME_LEN, 1);
+            indices[j] = get_index(context->fs, contents, j);
+            get_name(context->fs, contents, j, name);
             content_names[j] = name;
             
             info(1, "%s ", content_names[j]);
@@ -1255,7 +1374,10 @@ fs_file_t fs_open(terminal_context_t *context, char *path)
         }
         free(content_names);
         free(indices);
+        free(contents);
     }
+    free(file_path);
+    free(dupe);
     info(1, "%s\n", curr_dir->internal.file_name);
     if(curr_dir->internal.file_type != DATA_FILE)
     {
@@ -1265,33 +1387,92 @@ fs_file_t fs_open(terminal_context_t *context, char *path)
     //confirm path exists, leads to a file
     //allocate space for the file, assign its fs and inode. Set offset to 0.
     //return file
-    fs_file_t file = malloc(sizeof(fs_file_t));
+    fs_file_t file = malloc(sizeof(struct fs_file));
     if(!file) return NULL;
     file->fs = context->fs;
     file->inode = curr_dir;
     file->offset = 0;
+    file->window.start = 0;
+    file->window.len = 0;
+    file->pending.data = NULL;
+    file->pending.len = 0;
+    file->pending.cap = 0;
+    file->reservation.dblocks = 0;
+    file->reservation.inodes = 0;
     return file;
 }
 
 void fs_close(fs_file_t file)
 {
-    (void)file;
+    if(!file) return;
+    // the buffer has its dblocks reserved, so this only fails if another handle grew the
+    // file past what was reserved and the file system filled up since
+    if(fs_flush(file) != 0)
+        printf("Error: Not enough dblocks for operation\n");
+    // hand the dblocks this file did not grow into back to the file system
+    if(file->window.len > 0)
+        release_dblock_range(file->fs, file->window.start, file->window.len);
+    fs_abort(file->fs, &file->reservation);
+    free(file->pending.data);
+    free(file);
 }
 
 size_t fs_read(fs_file_t file, void *buffer, size_t n)
 {
     if(!file || !buffer) return 0;
     inode_t *inode = file->inode;
+    if(file->pending.len > 0 && file->offset + n > inode->internal.file_size && fs_flush(file) != 0)
+        return 0;
     inode_read_data(file->fs, inode, file->offset, buffer, n, &n);
     file->offset += n;
     return n;
 }
 
+// appends n bytes to the buffer of a file, growing it as needed
+static int buffer_append(fs_write_buffer_t *pending, void *buffer, size_t n)
+{
+    if(pending->len + n > pending->cap)
+    {
+        size_t cap = pending->cap ? pending->cap : DATA_BLOCK_SIZE;
+        while(cap < pending->len + n) cap *= 2;
+        byte *data = realloc(pending->data, cap);
+        if(!data) return 0;
+        pending->data = data;
+        pending->cap = cap;
+    }
+    memcpy(pending->data + pending->len, buffer, n);
+    pending->len += n;
+    return 1;
+}
+
+// makes the reservation and the window of a file hold `need` dblocks between them
+static int reserve_pending(fs_file_t file, size_t need)
+{
+    size_t held = file->reservation.dblocks + file->window.len;
+    if(need <= held) return 1;
+    fs_reservation_t more;
+    if(fs_reserve(file->fs, need - held, 0, &more) != SUCCESS) return 0;
+    file->reservation.dblocks += more.dblocks;
+    return 1;
+}
+
 size_t fs_write(fs_file_t file, void *buffer, size_t n)
 {
     if(!file || !buffer) return 0;
     inode_t *inode = file->inode;
-    fs_retcode_t ret = inode_modify_data(file->fs, inode, file->offset, buffer, n);
+    size_t size = inode->internal.file_size;
+    if(file->fs->delayed_alloc && file->offset == size + file->pending.len)
+    {
+        // only hold on to data whose dblocks are reserved, so the flush cannot run out
+        size_t need = inode_growth_dblocks(file->fs, inode, size + file->pending.len + n);
+        if(!reserve_pending(file, need)) return 0;
+        if(!buffer_append(&file->pending, buffer, n)) return 0;
+        file->offset += n;
+        return n;
+    }
+    if(fs_flush(file) != 0) return 0;
+
+    fs_retcode_t ret = inode_modify_data_window(file->fs, inode, file->offset, buffer, n, &file->window);
     if(ret != SUCCESS)
     {
         return 0;
@@ -1301,6 +1482,45 @@ size_t fs_write(fs_file_t file, void *buffer, size_t n)
     return n;
 }
 
+int fs_flush(fs_file_t file)
+{
+    if(!file) return -1;
+    if(file->pending.len == 0) return 0;
+
+    filesystem_t *fs = file->fs;
+    inode_t *inode = file->inode;
+    size_t size = inode->internal.file_size;
+    size_t need = inode_growth_dblocks(fs, inode, size + file->pending.len);
+    // fs_write reserved this already, unless another handle grew the file since
+    if(!reserve_pending(file, need)) return -1;
+    // the claims below take the drawn dblocks first
+    fs_reservation_draw(fs, &file->reservation, file->reservation.dblocks, 0);
+
+    // the final size is known now, so a window too short for it is traded for one run
+    // that fits everything. the window follows the end of the file, so the new run
+    // usually starts where the window did
+    if(need > file->window.len)
+    {
+        if(file->window.len > 0)
+            release_dblock_range(fs, file->window.start, file->window.len);
+        file->window.len = 0;
+        size_t want = need > fs->prealloc_window ? need : fs->prealloc_window;
+        if(claim_dblock_range(fs, want, inode_dblock_goal(fs, inode), &file->window.start, &file->window.len) != SUCCESS)
+        {
+            // without a run the write claims its dblocks one at a time
+            file->window.start = 0;
+            file->window.len = 0;
+        }
+    }
+
+    fs_retcode_t ret = inode_modify_data_window(fs, inode, size, file->pending.data, file->pending.len, &file->window);
+    // what was drawn and not claimed goes back, and a failed flush reserves again next time
+    fs_commit(fs, &file->reservation);
+    if(ret != SUCCESS) return -1;
+    file->pending.len = 0;
+    return 0;
+}
+
 // Updates the offset stored in file based on the mode seek_mode and the offset.
 // Returns -1 on failure and 0 on a successful seek operations.
 // If the final offset is less than 0, this is a failed operation. No changes should be made to file, i.e. the state of file before the function call must be equal to its state after the function call.
@@ -1314,6 +1534,8 @@ int fs_seek(fs_file_t file, seek_mode_t seek_mode, int offset)
     if(seek_mode != FS_SEEK_START && seek_mode != FS_SEEK_CURRENT && seek_mode != FS_SEEK_END) 
         return -1;
     if(!file->inode) return -1;
+    // appends buffered by fs_write count as part of the file
+    size_t file_size = file->inode->internal.file_size + file->pending.len;
     if(seek_mode == FS_SEEK_START)
     {
         if(offset < 0)
@@ -1332,17 +1554,17 @@ int fs_seek(fs_file_t file, seek_mode_t seek_mode, int offset)
     }
     else if(seek_mode == FS_SEEK_END)
     {
-        file->offset = file->inode->internal.file_size + offset;
+        file->offset = file_size + offset;
     }
-    else if(file->offset > file->inode->internal.file_size)
+    else if(file->offset > file_size)
     {
-        file->offset = file->inode->internal.file_size;
+        file->offset = file_size;
     }
 
 
-    if(file->offset > file->inode->internal.file_size)
+    if(file->offset > file_size)
     {
-        file->offset = file->inode->internal.file_size;
+        file->offset = file_size;
         return 0;
     }
     return 0;
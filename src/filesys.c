@@ -1,61 +1,1874 @@
+// MAP_ANONYMOUS and MAP_NORESERVE are not part of the older POSIX levels the benchmarks
+// build with, and madvise, mremap and MAP_FIXED_NOREPLACE are only there with the GNU
+// extensions
+#define _GNU_SOURCE
+
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "filesys.h"
+#include "debug.h"
+#include "utility.h"
+#include "bitmap.h"
+#include "extent_tree.h"
+#include "block_map_cache.h"
+
+#define DBLOCK_MASK_SIZE(blk_count) (((blk_count) + 7) / (sizeof(byte) * 8))
+#define BITMASK_WORD_BYTES sizeof(uint64_t)
+#define BITMASK_WORD_BITS (BITMASK_WORD_BYTES * 8)
+
+#define INDIRECT_DBLOCK_INDEX_COUNT (DATA_BLOCK_SIZE / sizeof(dblock_index_t) - 1)
+#define INDIRECT_DBLOCK_MAX_DATA_SIZE ( DATA_BLOCK_SIZE * INDIRECT_DBLOCK_INDEX_COUNT )
+
+
+// ----------------------- UTILITY FUNCTION ----------------------- //
+
+// marks the nth dblock as being used 
+static void mark_dblock_as_used(byte *dblock_bitmask, size_t n)
+{
+    dblock_bitmask[n / 8] &= ~(1 << (7 - n % 8));
+}
+
+static void mark_dblock_as_unused(byte *dblock_bitmask, size_t n)
+{
+    dblock_bitmask[n / 8] |= 1 << (7 - n % 8);
+}
+
+// adds `words` to the bitmask words `alloc_stats` counts, if the caller asked for them
+static void count_bitmask_words(const filesystem_t *fs, size_t words)
+{
+    if (fs->alloc_stats) fs->alloc_stats->bitmask_words += words;
+}
+
+// loads the bits for dblocks [64 * word, 64 * word + 64) from the bitmask.
+// the bitmask stores the lowest dblock in the most significant bit of each byte, so the
+// bytes are combined big endian and the lowest dblock ends up in bit 63 of the result.
+// bits past the last dblock are cleared so they are never reported as available.
+static uint64_t load_bitmask_word(const filesystem_t *fs, size_t word)
+{
+    size_t mask_size = DBLOCK_MASK_SIZE(fs->dblock_count);
+    size_t first_byte = word * BITMASK_WORD_BYTES;
+    uint64_t bits = 0;
+    count_bitmask_words(fs, 1);
+
+    if (first_byte + BITMASK_WORD_BYTES <= mask_size)
+    {
+        memcpy(&bits, &fs->dblock_bitmask[first_byte], BITMASK_WORD_BYTES);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        bits = __builtin_bswap64(bits);
+#endif
+    }
+    else
+    {
+        for (size_t i = 0; i < BITMASK_WORD_BYTES; ++i)
+        {
+            byte b = first_byte + i < mask_size ? fs->dblock_bitmask[first_byte + i] : 0;
+            bits = (bits << 8) | b;
+        }
+    }
+
+    size_t valid_bits = fs->dblock_count - word * BITMASK_WORD_BITS;
+    if (valid_bits < BITMASK_WORD_BITS) bits &= ~(~(uint64_t) 0 >> valid_bits);
+    return bits;
+}
+
+#define SUMMARY_WORD_COUNT(bit_count) (((bit_count) + BITMASK_WORD_BITS - 1) / BITMASK_WORD_BITS)
+
+static void set_summary_bit(uint64_t *summary, size_t n)
+{
+    summary[n / BITMASK_WORD_BITS] |= (uint64_t) 1 << (n % BITMASK_WORD_BITS);
+}
+
+static void clear_summary_bit(uint64_t *summary, size_t n)
+{
+    summary[n / BITMASK_WORD_BITS] &= ~((uint64_t) 1 << (n % BITMASK_WORD_BITS));
+}
+
+// finds the first bitmask word at or after `word` that has an available dblock, using the
+// summary levels so that fully used stretches of the bitmask are skipped 4096 words at a time.
+// returns 1 and stores the word in `found` if there is one, 0 otherwise.
+static int find_summary_word(const filesystem_t *fs, size_t word, size_t *found)
+{
+    size_t word_count = SUMMARY_WORD_COUNT(fs->dblock_count);
+    size_t summary_count = SUMMARY_WORD_COUNT(word_count);
+    size_t top_count = SUMMARY_WORD_COUNT(summary_count);
+    if (word >= word_count) return 0;
+
+    // the rest of the summary word that covers `word`
+    size_t s = word / BITMASK_WORD_BITS;
+    uint64_t bits = fs->dblock_summary[s] & (~(uint64_t) 0 << (word % BITMASK_WORD_BITS));
+    if (!bits)
+    {
+        // the next summary word that is not all zero
+        if (++s >= summary_count) return 0;
+        size_t t = s / BITMASK_WORD_BITS;
+        uint64_t top = fs->dblock_summary_top[t] & (~(uint64_t) 0 << (s % BITMASK_WORD_BITS));
+        while (!top)
+        {
+            if (++t >= top_count) return 0;
+            top = fs->dblock_summary_top[t];
+        }
+        s = t * BITMASK_WORD_BITS + __builtin_ctzll(top);
+        bits = fs->dblock_summary[s];
+    }
+    *found = s * BITMASK_WORD_BITS + __builtin_ctzll(bits);
+    return 1;
+}
+
+// finds the lowest available dblock in [from, to) and stores its index in `index`.
+// returns 1 if one was found, 0 otherwise.
+static int find_available_dblock(const filesystem_t *fs, size_t from, size_t to, size_t *index)
+{
+    if (to > fs->dblock_count) to = fs->dblock_count;
+    if (from >= to) return 0;
+
+    size_t word = from / BITMASK_WORD_BITS;
+    // ignore the dblocks in the first word that come before `from`
+    uint64_t bits = load_bitmask_word(fs, word) & (~(uint64_t) 0 >> (from % BITMASK_WORD_BITS));
+    // a summary bit can be left set for an emptied word in DBLOCK_ATOMIC mode, which
+    // only costs looking at that word
+    while (!bits)
+    {
+        if (!find_summary_word(fs, word + 1, &word)) return 0;
+        bits = load_bitmask_word(fs, word);
+    }
+
+    size_t found = word * BITMASK_WORD_BITS + __builtin_clzll(bits);
+    if (found >= to) return 0;
+    *index = found;
+    return 1;
+}
+
+// finds the first of 8 available dblocks that share a byte of the bitmask in [from, to) and
+// stores its index in `index`. returns 1 if there is one, 0 otherwise.
+static int find_available_dblock_byte(const filesystem_t *fs, size_t from, size_t to, size_t *index)
+{
+    if (to > fs->dblock_count) to = fs->dblock_count;
+    from = (from + 7) / 8 * 8;
+    if (from >= to) return 0;
+
+    size_t word = from / BITMASK_WORD_BITS;
+    uint64_t bits = load_bitmask_word(fs, word) & (~(uint64_t) 0 >> (from % BITMASK_WORD_BITS));
+    while (1)
+    {
+        for (size_t i = 0; bits && i < BITMASK_WORD_BYTES; ++i)
+        {
+            size_t shift = BITMASK_WORD_BITS - 8 * (i + 1);
+            if (((bits >> shift) & 0xFF) != 0xFF) continue;
+            size_t found = word * BITMASK_WORD_BITS + 8 * i;
+            if (found >= to) return 0;
+            *index = found;
+            return 1;
+        }
+        if (!find_summary_word(fs, word + 1, &word) || word * BITMASK_WORD_BITS >= to) return 0;
+        bits = load_bitmask_word(fs, word);
+    }
+}
+
+// finds the first used dblock in [from, to) and returns it, or `to` if they are all available.
+// dblocks past the last one count as used, so runs never extend past the bitmask.
+static size_t find_used_dblock(const filesystem_t *fs, size_t from, size_t to)
+{
+    if (to > fs->dblock_count) to = fs->dblock_count;
+
+    if (from >= to) return to;
+
+    size_t found;
+    if (!bitmap_find_first_clear(fs->dblock_bitmask, from, to, &found)) found = to;
+    count_bitmask_words(fs, (found < to ? found : to - 1) / BITMASK_WORD_BITS - from / BITMASK_WORD_BITS + 1);
+    return found;
+}
+
+// recomputes the summary bits that cover bitmask words [first_word, last_word]
+static void refresh_dblock_summary(filesystem_t *fs, size_t first_word, size_t last_word)
+{
+    for (size_t word = first_word; word <= last_word; ++word)
+    {
+        if (load_bitmask_word(fs, word)) set_summary_bit(fs->dblock_summary, word);
+        else clear_summary_bit(fs->dblock_summary, word);
+    }
+    for (size_t s = first_word / BITMASK_WORD_BITS; s <= last_word / BITMASK_WORD_BITS; ++s)
+    {
+        if (fs->dblock_summary[s]) set_summary_bit(fs->dblock_summary_top, s);
+        else clear_summary_bit(fs->dblock_summary_top, s);
+    }
+}
+
+// ----------------------- BUDDY LISTS ----------------------- //
+
+// in DBLOCK_BUDDY mode the available dblocks are split into blocks of 2^k dblocks that start
+// at a multiple of 2^k, the order of the block. a block is only kept whole if its buddy, the
+// other half of the block of order k + 1 it is part of, is not available as a whole too, so
+// every run of available dblocks is split into as few blocks as alignment allows. every order
+// has a doubly linked list of its blocks, threaded through arrays indexed by first dblock
+
+#define BUDDY_MAX_ORDER 32
+#define BUDDY_NONE ((dblock_index_t) -1)
+#define BUDDY_NOT_FREE 0xFF
+
+typedef struct dblock_buddy
+{
+    size_t max_order;       // the order of the largest block that fits the dblocks
+    size_t capacity;        // dblocks the arrays have room for
+    uint64_t nonempty;      // bit k is set if the list of order k has a block
+    dblock_index_t heads[BUDDY_MAX_ORDER + 1];
+    dblock_index_t *next;   // the next block in the list of block n
+    dblock_index_t *prev;
+    uint8_t *order;         // the order of the available block starting at dblock n, BUDDY_NOT_FREE if none does
+} dblock_buddy_t;
+
+static size_t floor_log2(size_t n)
+{
+    return BITMASK_WORD_BITS - 1 - __builtin_clzll(n);
+}
+
+static size_t ceil_log2(size_t n)
+{
+    return n <= 1 ? 0 : floor_log2(n - 1) + 1;
+}
+
+static void buddy_push(dblock_buddy_t *buddy, size_t start, size_t order)
+{
+    dblock_index_t head = buddy->heads[order];
+    buddy->next[start] = head;
+    buddy->prev[start] = BUDDY_NONE;
+    if (head != BUDDY_NONE) buddy->prev[head] = start;
+    buddy->heads[order] = start;
+    buddy->order[start] = order;
+    buddy->nonempty |= (uint64_t) 1 << order;
+}
+
+static void buddy_unlink(dblock_buddy_t *buddy, size_t start)
+{
+    size_t order = buddy->order[start];
+    dblock_index_t next = buddy->next[start], prev = buddy->prev[start];
+    if (prev != BUDDY_NONE) buddy->next[prev] = next;
+    else buddy->heads[order] = next;
+    if (next != BUDDY_NONE) buddy->prev[next] = prev;
+    if (buddy->heads[order] == BUDDY_NONE) buddy->nonempty &= ~((uint64_t) 1 << order);
+    buddy->order[start] = BUDDY_NOT_FREE;
+}
+
+// finds the available block holding dblock n. a block of order k holding n can only start
+// at n rounded down to a multiple of 2^k, so there is one place to look per order.
+// returns 1 and stores the block in `start` and `order` if n is available, 0 otherwise
+static int buddy_find(const dblock_buddy_t *buddy, size_t n, size_t *start, size_t *order)
+{
+    for (size_t k = 0; k <= buddy->max_order; ++k)
+    {
+        size_t head = n & ~(((size_t) 1 << k) - 1);
+        if (buddy->order[head] != k) continue;
+        *start = head;
+        *order = k;
+        return 1;
+    }
+    return 0;
+}
+
+// adds the block of `order` at `start`, merging it with its buddy for as long as the buddy
+// is available as a whole
+static void buddy_free_block(dblock_buddy_t *buddy, size_t dblock_count, size_t start, size_t order)
+{
+    while (order < buddy->max_order)
+    {
+        size_t other = start ^ ((size_t) 1 << order);
+        if (other >= dblock_count || buddy->order[other] != order) break;
+        buddy_unlink(buddy, other);
+        if (other < start) start = other;
+        ++order;
+    }
+    buddy_push(buddy, start, order);
+}
+
+// adds the parts of the block of `order` at `start` outside of [from, to), halving it until
+// every half is either all inside or all outside
+static void buddy_keep_outside(dblock_buddy_t *buddy, size_t start, size_t order, size_t from, size_t to)
+{
+    size_t end = start + ((size_t) 1 << order);
+    if (end <= from || start >= to)
+    {
+        buddy_push(buddy, start, order);
+        return;
+    }
+    if (start >= from && end <= to) return;
+    buddy_keep_outside(buddy, start, order - 1, from, to);
+    buddy_keep_outside(buddy, start + ((size_t) 1 << (order - 1)), order - 1, from, to);
+}
+
+// puts dblocks [start, start + len), which just became available, in the lists. dblocks
+// that already are in a block are skipped, so releasing a dblock twice does nothing
+static void buddy_add_range(dblock_buddy_t *buddy, size_t dblock_count, size_t start, size_t len)
+{
+    size_t end = start + len;
+    for (size_t n = start; n < end;)
+    {
+        size_t head, order;
+        if (buddy_find(buddy, n, &head, &order))
+        {
+            n = head + ((size_t) 1 << order);
+            continue;
+        }
+        buddy_free_block(buddy, dblock_count, n++, 0);
+    }
+}
+
+// takes dblocks [start, start + len), which were just claimed, out of the lists. the blocks
+// they were part of are split, and the parts left over stay in the lists
+static void buddy_remove_range(dblock_buddy_t *buddy, size_t start, size_t len)
+{
+    size_t end = start + len;
+    for (size_t n = start; n < end;)
+    {
+        size_t head, order;
+        if (!buddy_find(buddy, n, &head, &order))
+        {
+            ++n;
+            continue;
+        }
+        buddy_unlink(buddy, head);
+        buddy_keep_outside(buddy, head, order, start, end);
+        n = head + ((size_t) 1 << order);
+    }
+}
+
+static void free_buddy(dblock_buddy_t *buddy)
+{
+    if (!buddy) return;
+    free(buddy->next);
+    free(buddy->prev);
+    free(buddy->order);
+    free(buddy);
+}
+
+// keeps the extent tree and the buddy lists, if there are any, in step with dblocks
+// [start, start + len) changing state. a tree that cannot follow is rebuilt from the bitmask
+// the next time it is needed
+static void note_dblock_change(filesystem_t *fs, size_t start, size_t len, int available)
+{
+    if (fs->buddy && !fs->buddy_stale)
+    {
+        if (available) buddy_add_range(fs->buddy, fs->dblock_count, start, len);
+        else buddy_remove_range(fs->buddy, start, len);
+    }
+    if (!fs->extents || fs->extents_stale) return;
+    int ret = available ? extent_tree_add(fs->extents, start, len) : extent_tree_remove(fs->extents, start, len);
+    if (ret != 0) fs->extents_stale = 1;
+}
+
+// marks dblocks [start, start + len) as available or used a byte of the bitmask at a time,
+// keeping the block group counters and the extent tree in sync. returns how many dblocks changed state.
+// the caller updates the free count and the summary
+static size_t mark_dblock_bits(filesystem_t *fs, size_t start, size_t len, int available)
+{
+    size_t changed = 0;
+    size_t end = start + len;
+    if (len > 0) count_bitmask_words(fs, (end - 1) / BITMASK_WORD_BITS - start / BITMASK_WORD_BITS + 1);
+    for (size_t n = start; n < end;)
+    {
+        size_t first_bit = n % 8;
+        size_t bit_count = 8 - first_bit < end - n ? 8 - first_bit : end - n;
+        byte mask = (byte) (0xFF >> first_bit) & (byte) (0xFF << (8 - first_bit - bit_count));
+        byte *b = &fs->dblock_bitmask[n / 8];
+        block_group_t *group = &fs->groups[n / fs->group_dblock_count];
+
+        if (available)
+        {
+            size_t byte_changed = __builtin_popcount((byte) ~*b & mask);
+            group->free_dblock_count += byte_changed;
+            changed += byte_changed;
+            *b |= mask;
+        }
+        else
+        {
+            size_t byte_changed = __builtin_popcount(*b & mask);
+            group->free_dblock_count -= byte_changed;
+            changed += byte_changed;
+            *b &= ~mask;
+        }
+        n += bit_count;
+    }
+    note_dblock_change(fs, start, len, available);
+    return changed;
+}
+
+// the part of a reservation this thread drew with `fs_reservation_draw` but has not claimed
+// yet. drawn units are no longer in the unreserved counts, so the claims that follow spend
+// them before any unreserved unit and no other thread can take them in between
+static _Thread_local struct reservation_credit
+{
+    filesystem_t *fs;
+    size_t dblocks;
+    size_t inodes;
+} credit;
+
+static size_t *credit_units(const filesystem_t *fs, int dblocks)
+{
+    static _Thread_local size_t none;
+    none = 0;
+    if (credit.fs != fs) return &none;
+    return dblocks ? &credit.dblocks : &credit.inodes;
+}
+
+// takes `n` units out of the credit and then `unreserved`, all or nothing.
+// returns 1 if there were enough
+static int take_units(size_t *unreserved, size_t *credit_left, size_t n)
+{
+    size_t from_credit = *credit_left < n ? *credit_left : n;
+    size_t rest = n - from_credit;
+    if (rest > 0)
+    {
+        size_t available = __atomic_load_n(unreserved, __ATOMIC_RELAXED);
+        do
+        {
+            if (available < rest) return 0;
+        } while (!__atomic_compare_exchange_n(unreserved, &available, available - rest, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+    }
+    *credit_left -= from_credit;
+    return 1;
+}
+
+// the number of dblocks this thread can claim right now
+static size_t claimable_dblocks(filesystem_t *fs)
+{
+    return available_dblocks(fs) + *credit_units(fs, 1);
+}
+
+static size_t claimable_inodes(filesystem_t *fs)
+{
+    return available_inodes(fs) + *credit_units(fs, 0);
+}
+
+// keeps the free and unreserved counts in step with dblocks changing state. the claims check
+// `claimable_dblocks` before they take anything, so the units are always there
+static void count_dblocks_taken(filesystem_t *fs, size_t n)
+{
+    int taken = take_units(&fs->unreserved_dblock_count, credit_units(fs, 1), n);
+    assert(taken && "a dblock was claimed without an unreserved unit to pay for it");
+    (void) taken;
+    fs->free_dblock_count -= n;
+}
+
+static void count_dblocks_returned(filesystem_t *fs, size_t n)
+{
+    fs->free_dblock_count += n;
+    __atomic_add_fetch(&fs->unreserved_dblock_count, n, __ATOMIC_RELAXED);
+}
+
+// marks dblocks [start, start + len) as available or used, keeping the free count and
+// the summary in sync. returns how many dblocks changed state.
+static size_t mark_dblock_range(filesystem_t *fs, size_t start, size_t len, int available)
+{
+    size_t end = start + len;
+    size_t changed = mark_dblock_bits(fs, start, len, available);
+    if (available) count_dblocks_returned(fs, changed);
+    else count_dblocks_taken(fs, changed);
+    refresh_dblock_summary(fs, start / BITMASK_WORD_BITS, (end - 1) / BITMASK_WORD_BITS);
+    return changed;
+}
+
+// marks the nth dblock as used and clears its summary bits once its word has no
+// available dblock left
+static void take_dblock(filesystem_t *fs, size_t n)
+{
+    mark_dblock_as_used(fs->dblock_bitmask, n);
+    count_dblocks_taken(fs, 1);
+    --fs->groups[n / fs->group_dblock_count].free_dblock_count;
+    note_dblock_change(fs, n, 1, 0);
+
+    size_t word = n / BITMASK_WORD_BITS;
+    if (load_bitmask_word(fs, word)) return;
+    clear_summary_bit(fs->dblock_summary, word);
+    if (!fs->dblock_summary[word / BITMASK_WORD_BITS])
+        clear_summary_bit(fs->dblock_summary_top, word / BITMASK_WORD_BITS);
+}
+
+// marks the nth dblock as available and sets its summary bits
+static void return_dblock(filesystem_t *fs, size_t n)
+{
+    size_t word = n / BITMASK_WORD_BITS;
+    count_bitmask_words(fs, 1);
+    // releasing an available dblock again must not inflate the free count
+    if (!(fs->dblock_bitmask[n / 8] & (1 << (7 - n % 8))))
+    {
+        count_dblocks_returned(fs, 1);
+        ++fs->groups[n / fs->group_dblock_count].free_dblock_count;
+        note_dblock_change(fs, n, 1, 1);
+    }
+    mark_dblock_as_unused(fs->dblock_bitmask, n);
+    set_summary_bit(fs->dblock_summary, word);
+    set_summary_bit(fs->dblock_summary_top, word / BITMASK_WORD_BITS);
+}
+
+// the extent tree in DBLOCK_EXTENT_TREE mode, rebuilt first if it missed changes. NULL in
+// the other modes, or if the tree cannot be built, in which case the bitmask is scanned
+static extent_tree_t *extent_index(filesystem_t *fs)
+{
+    if (fs->dblock_alloc_mode != DBLOCK_EXTENT_TREE) return NULL;
+    if ((!fs->extents || fs->extents_stale) && rebuild_extent_tree(fs) != SUCCESS) return NULL;
+    return fs->extents;
+}
+
+// finds the run of available dblocks a claim of up to `want` of them takes from: the
+// shortest one that holds `want`, or the longest one if none does
+static int find_extent_fit(const extent_tree_t *extents, size_t want, size_t *start, size_t *len)
+{
+    if (!extent_tree_best_fit(extents, want, start, len) && !extent_tree_longest(extents, start, len)) return 0;
+    if (*len > want) *len = want;
+    return 1;
+}
+
+// ----------------------- ATOMIC MODE ----------------------- //
+
+// in DBLOCK_ATOMIC mode the bitmask is changed a uint64_t at a time with atomic operations,
+// which is why it is allocated in whole words. the bytes of a word are in memory order, so
+// `word_order` puts the lowest dblock of the word in bit 63 like `load_bitmask_word` does
+static uint64_t *bitmask_words(const filesystem_t *fs)
+{
+    return (uint64_t *) fs->dblock_bitmask;
+}
+
+static uint64_t word_order(uint64_t bits)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap64(bits);
+#else
+    return bits;
+#endif
+}
+
+// the bits of bitmask word `word` that stand for dblocks, in dblock order
+static uint64_t valid_word_bits(const filesystem_t *fs, size_t word)
+{
+    size_t valid_bits = fs->dblock_count - word * BITMASK_WORD_BITS;
+    return valid_bits < BITMASK_WORD_BITS ? ~(~(uint64_t) 0 >> valid_bits) : ~(uint64_t) 0;
+}
+
+// the bitmask word this thread looks at first. threads start at different hashed words so
+// they do not all fight over the first cache line of the bitmask, and then keep going from
+// the word they last claimed in
+static _Thread_local size_t scan_hint;
+static _Thread_local int scan_hint_set;
+
+static size_t scan_start(size_t word_count)
+{
+    if (!scan_hint_set)
+    {
+        // the splitmix64 finalizer over the address of a thread local, which is different
+        // in every thread
+        uint64_t h = (uint64_t) (uintptr_t) &scan_hint * 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        scan_hint = h ^ (h >> 31);
+        scan_hint_set = 1;
+    }
+    return scan_hint % word_count;
+}
+
+// clears the summary bits of a word the caller emptied. a release that races with this sets
+// its dblock bit before the summary bits, so the word is looked at again after clearing and
+// the summary bit is put back if the release got in between
+static void summary_word_emptied(filesystem_t *fs, size_t word)
+{
+    size_t s = word / BITMASK_WORD_BITS;
+    uint64_t bit = (uint64_t) 1 << (word % BITMASK_WORD_BITS);
+    __atomic_fetch_and(&fs->dblock_summary[s], ~bit, __ATOMIC_ACQ_REL);
+    if (word_order(__atomic_load_n(&bitmask_words(fs)[word], __ATOMIC_ACQUIRE)) & valid_word_bits(fs, word))
+    {
+        __atomic_fetch_or(&fs->dblock_summary[s], bit, __ATOMIC_ACQ_REL);
+        return;
+    }
+    if (__atomic_load_n(&fs->dblock_summary[s], __ATOMIC_ACQUIRE)) return;
+
+    uint64_t top_bit = (uint64_t) 1 << (s % BITMASK_WORD_BITS);
+    __atomic_fetch_and(&fs->dblock_summary_top[s / BITMASK_WORD_BITS], ~top_bit, __ATOMIC_ACQ_REL);
+    if (__atomic_load_n(&fs->dblock_summary[s], __ATOMIC_ACQUIRE))
+        __atomic_fetch_or(&fs->dblock_summary_top[s / BITMASK_WORD_BITS], top_bit, __ATOMIC_ACQ_REL);
+}
+
+// clears the dblock order bits `mine` of word `word` if they are all still set. returns 1 if
+// they were, with the free counters and the summary updated
+static int take_word_bits(filesystem_t *fs, size_t word, uint64_t mine)
+{
+    uint64_t *w = &bitmask_words(fs)[word];
+    uint64_t bits = __atomic_load_n(w, __ATOMIC_RELAXED);
+    count_bitmask_words(fs, 1);
+    do
+    {
+        if ((word_order(bits) & mine) != mine) return 0;
+    } while (!__atomic_compare_exchange_n(w, &bits, bits & ~word_order(mine), 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    size_t count = __builtin_popcountll(mine);
+    if (fs->extents) __atomic_store_n(&fs->extents_stale, 1, __ATOMIC_RELAXED);
+    if (fs->buddy) __atomic_store_n(&fs->buddy_stale, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&fs->free_dblock_count, count, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&fs->groups[word * BITMASK_WORD_BITS / fs->group_dblock_count].free_dblock_count, count, __ATOMIC_RELAXED);
+    if (!(word_order(bits & ~word_order(mine)) & valid_word_bits(fs, word))) summary_word_emptied(fs, word);
+    return 1;
+}
+
+// sets the dblock order bits `mine` of word `word` and returns how many were not set yet.
+// the bits are set before the unreserved count goes up, so a claim that got a unit always
+// finds a bit for it somewhere
+static size_t return_word_bits(filesystem_t *fs, size_t word, uint64_t mine)
+{
+    uint64_t before = __atomic_fetch_or(&bitmask_words(fs)[word], word_order(mine), __ATOMIC_ACQ_REL);
+    count_bitmask_words(fs, 1);
+    size_t count = __builtin_popcountll(mine & ~word_order(before));
+    if (count == 0) return 0;
+
+    // the extent tree and the buddy lists are not kept up to date with atomic operations
+    if (fs->extents) __atomic_store_n(&fs->extents_stale, 1, __ATOMIC_RELAXED);
+    if (fs->buddy) __atomic_store_n(&fs->buddy_stale, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&fs->free_dblock_count, count, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&fs->groups[word * BITMASK_WORD_BITS / fs->group_dblock_count].free_dblock_count, count, __ATOMIC_RELAXED);
+    __atomic_fetch_or(&fs->dblock_summary[word / BITMASK_WORD_BITS], (uint64_t) 1 << (word % BITMASK_WORD_BITS), __ATOMIC_ACQ_REL);
+    __atomic_fetch_or(&fs->dblock_summary_top[word / BITMASK_WORD_BITS / BITMASK_WORD_BITS],
+        (uint64_t) 1 << (word / BITMASK_WORD_BITS % BITMASK_WORD_BITS), __ATOMIC_ACQ_REL);
+    __atomic_add_fetch(&fs->unreserved_dblock_count, count, __ATOMIC_RELEASE);
+    return count;
+}
+
+// takes `n` dblocks the caller already paid for out of the bitmask, as many as it can from
+// each word with one compare and swap
+static void take_dblocks_atomic(filesystem_t *fs, size_t n, dblock_index_t *out)
+{
+    // every unit stands for a set bit, but other threads releasing behind the scan and
+    // claiming ahead of it can make it go around more than once
+    size_t word_count = SUMMARY_WORD_COUNT(fs->dblock_count);
+    size_t word = scan_start(word_count);
+    size_t claimed = 0;
+    while (claimed < n)
+    {
+        uint64_t available = word_order(__atomic_load_n(&bitmask_words(fs)[word], __ATOMIC_RELAXED)) & valid_word_bits(fs, word);
+        count_bitmask_words(fs, 1);
+        uint64_t mine = 0;
+        for (size_t k = claimed; available && k < n; ++k)
+        {
+            uint64_t lowest = (uint64_t) 1 << (BITMASK_WORD_BITS - 1 - __builtin_clzll(available));
+            mine |= lowest;
+            available &= ~lowest;
+        }
+        if (!mine || !take_word_bits(fs, word, mine))
+        {
+            // a word another thread changed in between is looked at again
+            if (mine) continue;
+            word = word + 1 < word_count ? word + 1 : 0;
+            continue;
+        }
+
+        scan_hint = word;
+        while (mine)
+        {
+            // `mine` is in dblock order, so the lowest dblock is its highest bit
+            size_t bit = __builtin_clzll(mine);
+            out[claimed++] = word * BITMASK_WORD_BITS + bit;
+            mine &= ~((uint64_t) 1 << (BITMASK_WORD_BITS - 1 - bit));
+        }
+    }
+}
+
+// claims a dblock for `claim_available_dblock`
+static fs_retcode_t claim_dblock_atomic(filesystem_t *fs, dblock_index_t *index)
+{
+    if (!take_units(&fs->unreserved_dblock_count, credit_units(fs, 1), 1)) return DBLOCK_UNAVAILABLE;
+    take_dblocks_atomic(fs, 1, index);
+    return SUCCESS;
+}
+
+// claims a run of up to `want` dblocks for `claim_dblock_range`. a run never crosses a
+// bitmask word, so it is at most 64 dblocks long and is taken with a single compare and swap
+static fs_retcode_t claim_dblock_range_atomic(filesystem_t *fs, size_t want, dblock_index_t goal, dblock_index_t *start, size_t *len)
+{
+    if (want > BITMASK_WORD_BITS) want = BITMASK_WORD_BITS;
+    size_t *credit_left = credit_units(fs, 1);
+    size_t credit_before = *credit_left;
+    while (!take_units(&fs->unreserved_dblock_count, credit_left, want))
+    {
+        want = claimable_dblocks(fs);
+        if (want == 0) return DBLOCK_UNAVAILABLE;
+        if (want > BITMASK_WORD_BITS) want = BITMASK_WORD_BITS;
+    }
+    size_t from_credit = credit_before - *credit_left;
+
+    // the first time around only a word with a run of `want` dblocks will do, after that
+    // the first run in any word is taken
+    size_t word_count = SUMMARY_WORD_COUNT(fs->dblock_count);
+    size_t first = goal != 0 && goal < fs->dblock_count ? goal / BITMASK_WORD_BITS : scan_start(word_count);
+    size_t word = first;
+    int whole = 1;
+    while (1)
+    {
+        uint64_t available = word_order(__atomic_load_n(&bitmask_words(fs)[word], __ATOMIC_RELAXED)) & valid_word_bits(fs, word);
+        count_bitmask_words(fs, 1);
+        size_t pos = 0, take = 0;
+        if (available && whole)
+        {
+            // bits that start a run of `want` set bits, built up by doubling the run length
+            uint64_t starts = available;
+            size_t covered = 1;
+            for (; covered * 2 <= want; covered *= 2) starts &= starts << covered;
+            if (covered < want) starts &= starts << (want - covered);
+            if (starts)
+            {
+                pos = __builtin_clzll(starts);
+                take = want;
+            }
+        }
+        else if (available)
+        {
+            pos = __builtin_clzll(available);
+            uint64_t after = ~(available << pos);
+            size_t run = after ? (size_t) __builtin_clzll(after) : BITMASK_WORD_BITS - pos;
+            take = run < want ? run : want;
+        }
+
+        if (take)
+        {
+            uint64_t mine = take == BITMASK_WORD_BITS ? ~(uint64_t) 0 : (((uint64_t) 1 << take) - 1) << (BITMASK_WORD_BITS - pos - take);
+            if (!take_word_bits(fs, word, mine)) continue;
+
+            // give back the units of the dblocks that did not fit, to the credit first
+            size_t unused = want - take;
+            size_t to_credit = unused < from_credit ? unused : from_credit;
+            *credit_left += to_credit;
+            if (unused > to_credit) __atomic_add_fetch(&fs->unreserved_dblock_count, unused - to_credit, __ATOMIC_RELEASE);
+
+            scan_hint = word;
+            *start = word * BITMASK_WORD_BITS + pos;
+            *len = take;
+            return SUCCESS;
+        }
+
+        word = word + 1 < word_count ? word + 1 : 0;
+        if (word == first) whole = 0;
+    }
+}
+
+// marks dblocks [start, start + len) as available a bitmask word at a time
+static void release_dblock_range_atomic(filesystem_t *fs, size_t start, size_t len)
+{
+    size_t end = start + len;
+    for (size_t n = start; n < end;)
+    {
+        size_t first_bit = n % BITMASK_WORD_BITS;
+        size_t bit_count = BITMASK_WORD_BITS - first_bit < end - n ? BITMASK_WORD_BITS - first_bit : end - n;
+        uint64_t mine = (~(uint64_t) 0 >> first_bit) & ~(bit_count + first_bit == BITMASK_WORD_BITS ? 0 : ~(uint64_t) 0 >> (first_bit + bit_count));
+        return_word_bits(fs, n / BITMASK_WORD_BITS, mine);
+        n += bit_count;
+    }
+}
+
+static void release_dblock_list_atomic(filesystem_t *fs, const dblock_index_t *indices, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) release_dblock_range_atomic(fs, indices[i], 1);
+}
+
+// ----------------------- ALLOCATION POLICIES ----------------------- //
+
+// moves the cursor past the last dblock a claim took
+static void advance_dblock_cursor(filesystem_t *fs, size_t last)
+{
+    fs->dblock_cursor = last + 1 < fs->dblock_count ? last + 1 : 0;
+}
+
+// claims the lowest available dblock, from dblock 0 in first fit mode and from the cursor
+// wrapping around to dblock 0 in next fit mode
+static fs_retcode_t claim_scanned_dblock(filesystem_t *fs, dblock_index_t *index)
+{
+    if (claimable_dblocks(fs) == 0) return DBLOCK_UNAVAILABLE;
+
+    size_t start = fs->dblock_alloc_mode == DBLOCK_NEXT_FIT ? fs->dblock_cursor : 0;
+    size_t idx;
+    if (!find_available_dblock(fs, start, fs->dblock_count, &idx) &&
+        !find_available_dblock(fs, 0, start, &idx)) return DBLOCK_UNAVAILABLE;
+
+    *index = idx;
+    take_dblock(fs, idx);
+    advance_dblock_cursor(fs, idx);
+    return SUCCESS;
+}
+
+// takes `n` dblocks the caller already paid for out of the bitmask, handing out the same
+// dblocks as n calls to claim_scanned_dblock but taking whole runs of available dblocks at once
+static void take_scanned_dblocks(filesystem_t *fs, size_t n, dblock_index_t *out)
+{
+    size_t start = fs->dblock_alloc_mode == DBLOCK_NEXT_FIT ? fs->dblock_cursor : 0;
+    size_t bounds[2][2] = { { start, fs->dblock_count }, { 0, start } };
+    size_t claimed = 0;
+    size_t last = 0;
+    for (size_t phase = 0; phase < 2 && claimed < n; ++phase)
+    {
+        size_t run_start;
+        size_t from = bounds[phase][0];
+        while (claimed < n && find_available_dblock(fs, from, bounds[phase][1], &run_start))
+        {
+            size_t run_end = find_used_dblock(fs, run_start, run_start + (n - claimed) < bounds[phase][1] ?
+                run_start + (n - claimed) : bounds[phase][1]);
+            for (size_t i = run_start; i < run_end; ++i) out[claimed++] = i;
+            mark_dblock_bits(fs, run_start, run_end - run_start, 0);
+            refresh_dblock_summary(fs, run_start / BITMASK_WORD_BITS, (run_end - 1) / BITMASK_WORD_BITS);
+            last = run_end - 1;
+            from = run_end;
+        }
+    }
+
+    fs->free_dblock_count -= claimed;
+    advance_dblock_cursor(fs, last);
+}
+
+// claims a run of up to `want` dblocks for `claim_dblock_range`. every run of available
+// dblocks is looked at starting from the goal, wrapping around once. the first run that can
+// hold `want` dblocks wins, otherwise the longest one does
+static fs_retcode_t claim_scanned_range(filesystem_t *fs, size_t want, dblock_index_t goal, dblock_index_t *start, size_t *len)
+{
+    if (want > claimable_dblocks(fs)) want = claimable_dblocks(fs);
+    if (want == 0) return DBLOCK_UNAVAILABLE;
+    if (goal >= fs->dblock_count) goal = 0;
+
+    size_t best_start = 0, best_len = 0;
+    size_t bounds[2][2] = { { goal, fs->dblock_count }, { 0, goal } };
+    for (size_t phase = 0; phase < 2 && best_len < want; ++phase)
+    {
+        size_t run_start;
+        size_t from = bounds[phase][0];
+        while (best_len < want && find_available_dblock(fs, from, bounds[phase][1], &run_start))
+        {
+            size_t limit = want < fs->dblock_count - run_start ? run_start + want : fs->dblock_count;
+            size_t run_end = find_used_dblock(fs, run_start, limit);
+            if (run_end - run_start > best_len)
+            {
+                best_start = run_start;
+                best_len = run_end - run_start;
+            }
+            from = run_end;
+        }
+    }
+    if (best_len == 0) return DBLOCK_UNAVAILABLE;
+
+    mark_dblock_range(fs, best_start, best_len, 0);
+    advance_dblock_cursor(fs, best_start + best_len - 1);
+    *start = best_start;
+    *len = best_len;
+    return SUCCESS;
+}
+
+// marks dblocks [start, start + len) as available
+static void return_dblock_range(filesystem_t *fs, size_t start, size_t len)
+{
+    if (len == 1) return_dblock(fs, start);
+    else mark_dblock_range(fs, start, len, 1);
+}
+
+// marks the `n` dblocks in `indices` as available
+static void return_dblock_list(filesystem_t *fs, const dblock_index_t *indices, size_t n)
+{
+    size_t released = 0;
+    count_bitmask_words(fs, n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t idx = indices[i];
+        byte bit = 1 << (7 - idx % 8);
+        if (fs->dblock_bitmask[idx / 8] & bit) continue;
+        fs->dblock_bitmask[idx / 8] |= bit;
+        ++fs->groups[idx / fs->group_dblock_count].free_dblock_count;
+        set_summary_bit(fs->dblock_summary, idx / BITMASK_WORD_BITS);
+        set_summary_bit(fs->dblock_summary_top, idx / BITMASK_WORD_BITS / BITMASK_WORD_BITS);
+        note_dblock_change(fs, idx, 1, 1);
+        ++released;
+    }
+    count_dblocks_returned(fs, released);
+}
+
+// searches block group g for a dblock to claim, starting at `from` and wrapping around to
+// the start of the group. when `from` is taken, a new run is started where 8 dblocks in a
+// row are free rather than in the first gap, which another growing file would usually fill next.
+// returns 1 and stores the dblock in `index` if there is one, 0 otherwise.
+static int find_group_dblock(const filesystem_t *fs, size_t g, size_t from, size_t *index)
+{
+    if (fs->groups[g].free_dblock_count == 0) return 0;
+
+    size_t start = g * fs->group_dblock_count;
+    size_t end = start + fs->group_dblock_count;
+    return find_available_dblock_byte(fs, from, end, index) ||
+        find_available_dblock_byte(fs, start, from, index) ||
+        find_available_dblock(fs, from, end, index) ||
+        find_available_dblock(fs, start, from, index);
+}
+
+// claims `goal` if it is available, or else a dblock after it in its block group or the
+// groups that follow, see `claim_dblock_near`
+static fs_retcode_t claim_goal_dblock(filesystem_t *fs, dblock_index_t goal, dblock_index_t *index)
+{
+    if (claimable_dblocks(fs) == 0) return DBLOCK_UNAVAILABLE;
+    if (goal >= fs->dblock_count) goal = 0;
+
+    size_t idx = goal;
+    count_bitmask_words(fs, 1);
+    if (!(fs->dblock_bitmask[goal / 8] & (1 << (7 - goal % 8))))
+    {
+        size_t first = goal / fs->group_dblock_count;
+        size_t i = 0;
+        for (; i < fs->group_count; ++i)
+        {
+            size_t g = (first + i) % fs->group_count;
+            if (find_group_dblock(fs, g, i == 0 ? goal : g * fs->group_dblock_count, &idx)) break;
+        }
+        if (i == fs->group_count) return DBLOCK_UNAVAILABLE;
+    }
+
+    *index = idx;
+    take_dblock(fs, idx);
+    advance_dblock_cursor(fs, idx);
+    return SUCCESS;
+}
+
+// the extent tree hands out the first dblock of the shortest run, filling holes first
+static fs_retcode_t claim_extent_dblock(filesystem_t *fs, dblock_index_t *index)
+{
+    extent_tree_t *extents = extent_index(fs);
+    if (!extents) return claim_scanned_dblock(fs, index);
+    if (claimable_dblocks(fs) == 0) return DBLOCK_UNAVAILABLE;
+
+    size_t idx, len;
+    if (!extent_tree_best_fit(extents, 1, &idx, &len)) return DBLOCK_UNAVAILABLE;
+    *index = idx;
+    take_dblock(fs, idx);
+    advance_dblock_cursor(fs, idx);
+    return SUCCESS;
+}
+
+// takes a best fit for what is left of `n` out of the extent tree, or the longest run while
+// nothing fits it
+static void take_extent_dblocks(filesystem_t *fs, size_t n, dblock_index_t *out)
+{
+    extent_tree_t *extents = extent_index(fs);
+    if (!extents)
+    {
+        take_scanned_dblocks(fs, n, out);
+        return;
+    }
+
+    size_t claimed = 0, run_start, run_len;
+    while (claimed < n && find_extent_fit(extents, n - claimed, &run_start, &run_len))
+    {
+        for (size_t i = run_start; i < run_start + run_len; ++i) out[claimed++] = i;
+        mark_dblock_bits(fs, run_start, run_len, 0);
+        refresh_dblock_summary(fs, run_start / BITMASK_WORD_BITS, (run_start + run_len - 1) / BITMASK_WORD_BITS);
+        advance_dblock_cursor(fs, run_start + run_len - 1);
+    }
+    fs->free_dblock_count -= claimed;
+}
+
+// claims the shortest run holding `want` dblocks, without a scan, see `claim_dblock_range`
+static fs_retcode_t claim_extent_range(filesystem_t *fs, size_t want, dblock_index_t goal, dblock_index_t *start, size_t *len)
+{
+    extent_tree_t *extents = extent_index(fs);
+    if (!extents) return claim_scanned_range(fs, want, goal, start, len);
+    if (want > claimable_dblocks(fs)) want = claimable_dblocks(fs);
+
+    size_t best_start, best_len;
+    if (want == 0 || !find_extent_fit(extents, want, &best_start, &best_len)) return DBLOCK_UNAVAILABLE;
+    mark_dblock_range(fs, best_start, best_len, 0);
+    advance_dblock_cursor(fs, best_start + best_len - 1);
+    *start = best_start;
+    *len = best_len;
+    return SUCCESS;
+}
+
+// the buddy lists in DBLOCK_BUDDY mode, rebuilt first if they missed changes. NULL in the
+// other modes, or if the lists cannot be built, in which case the bitmask is scanned
+static dblock_buddy_t *buddy_index(filesystem_t *fs)
+{
+    if (fs->dblock_alloc_mode != DBLOCK_BUDDY) return NULL;
+    if ((!fs->buddy || fs->buddy_stale) && rebuild_buddy_lists(fs) != SUCCESS) return NULL;
+    return fs->buddy;
+}
+
+// finds the block a claim of `want` dblocks takes from: the block at the head of the lowest
+// order that holds them all, or else the one at the head of the highest order there is. returns 1 and
+// stores the block in `start` and `order`, 0 if there are no available dblocks
+static int find_buddy_fit(const dblock_buddy_t *buddy, size_t want, size_t *start, size_t *order)
+{
+    if (!buddy->nonempty) return 0;
+    size_t fit = ceil_log2(want);
+    uint64_t large = fit < BITMASK_WORD_BITS ? buddy->nonempty & (~(uint64_t) 0 << fit) : 0;
+    *order = large ? (size_t) __builtin_ctzll(large) : floor_log2(buddy->nonempty);
+    *start = buddy->heads[*order];
+    return 1;
+}
+
+// hands out the first dblock of the smallest block, splitting it
+static fs_retcode_t claim_buddy_dblock(filesystem_t *fs, dblock_index_t *index)
+{
+    dblock_buddy_t *buddy = buddy_index(fs);
+    if (!buddy) return claim_scanned_dblock(fs, index);
+    if (claimable_dblocks(fs) == 0) return DBLOCK_UNAVAILABLE;
+
+    size_t idx, order;
+    if (!find_buddy_fit(buddy, 1, &idx, &order)) return DBLOCK_UNAVAILABLE;
+    *index = idx;
+    take_dblock(fs, idx);
+    advance_dblock_cursor(fs, idx);
+    return SUCCESS;
+}
+
+// takes what is left of `n` from the start of the smallest block that holds it, or the whole
+// largest block while none does, so a batch stays in one aligned run when there is one
+static void take_buddy_dblocks(filesystem_t *fs, size_t n, dblock_index_t *out)
+{
+    dblock_buddy_t *buddy = buddy_index(fs);
+    if (!buddy)
+    {
+        take_scanned_dblocks(fs, n, out);
+        return;
+    }
+
+    size_t claimed = 0, run_start, order;
+    while (claimed < n && find_buddy_fit(buddy, n - claimed, &run_start, &order))
+    {
+        size_t run_len = n - claimed < ((size_t) 1 << order) ? n - claimed : (size_t) 1 << order;
+        for (size_t i = run_start; i < run_start + run_len; ++i) out[claimed++] = i;
+        mark_dblock_bits(fs, run_start, run_len, 0);
+        refresh_dblock_summary(fs, run_start / BITMASK_WORD_BITS, (run_start + run_len - 1) / BITMASK_WORD_BITS);
+        advance_dblock_cursor(fs, run_start + run_len - 1);
+    }
+    fs->free_dblock_count -= claimed;
+}
+
+// claims up to `want` dblocks from the start of the smallest block that holds them, see
+// `claim_dblock_range`
+static fs_retcode_t claim_buddy_range(filesystem_t *fs, size_t want, dblock_index_t goal, dblock_index_t *start, size_t *len)
+{
+    dblock_buddy_t *buddy = buddy_index(fs);
+    if (!buddy) return claim_scanned_range(fs, want, goal, start, len);
+    if (want > claimable_dblocks(fs)) want = claimable_dblocks(fs);
+
+    size_t run_start, order;
+    if (want == 0 || !find_buddy_fit(buddy, want, &run_start, &order)) return DBLOCK_UNAVAILABLE;
+    size_t run_len = want < ((size_t) 1 << order) ? want : (size_t) 1 << order;
+    mark_dblock_range(fs, run_start, run_len, 0);
+    advance_dblock_cursor(fs, run_start + run_len - 1);
+    *start = run_start;
+    *len = run_len;
+    return SUCCESS;
+}
+
+// the built in policy of every mode, in the order of `dblock_alloc_mode_t`
+static const dblock_allocator_t dblock_allocators[] = {
+    [DBLOCK_FIRST_FIT] = {
+        .name = "first-fit", .mode = DBLOCK_FIRST_FIT,
+        .claim = claim_scanned_dblock, .take = take_scanned_dblocks, .claim_range = claim_scanned_range,
+        .release_range = return_dblock_range, .release_list = return_dblock_list
+    },
+    [DBLOCK_NEXT_FIT] = {
+        .name = "next-fit", .mode = DBLOCK_NEXT_FIT,
+        .claim = claim_scanned_dblock, .take = take_scanned_dblocks, .claim_range = claim_scanned_range,
+        .release_range = return_dblock_range, .release_list = return_dblock_list
+    },
+    [DBLOCK_GOAL_DIRECTED] = {
+        .name = "goal", .mode = DBLOCK_GOAL_DIRECTED,
+        .claim = claim_scanned_dblock, .claim_near = claim_goal_dblock, .take = take_scanned_dblocks,
+        .claim_range = claim_scanned_range, .release_range = return_dblock_range, .release_list = return_dblock_list
+    },
+    [DBLOCK_ATOMIC] = {
+        .name = "atomic", .mode = DBLOCK_ATOMIC, .concurrent = 1,
+        .claim = claim_dblock_atomic, .take = take_dblocks_atomic, .claim_range = claim_dblock_range_atomic,
+        .release_range = release_dblock_range_atomic, .release_list = release_dblock_list_atomic
+    },
+    [DBLOCK_EXTENT_TREE] = {
+        .name = "extent-tree", .mode = DBLOCK_EXTENT_TREE, .attach = rebuild_extent_tree,
+        .claim = claim_extent_dblock, .take = take_extent_dblocks, .claim_range = claim_extent_range,
+        .release_range = return_dblock_range, .release_list = return_dblock_list
+    },
+    [DBLOCK_BUDDY] = {
+        .name = "buddy", .mode = DBLOCK_BUDDY, .attach = rebuild_buddy_lists,
+        .claim = claim_buddy_dblock, .take = take_buddy_dblocks, .claim_range = claim_buddy_range,
+        .release_range = return_dblock_range, .release_list = return_dblock_list
+    }
+};
+
+#define DBLOCK_ALLOCATOR_COUNT (sizeof(dblock_allocators) / sizeof(*dblock_allocators))
+
+static void count_dblocks_claimed(const filesystem_t *fs, size_t n)
+{
+    if (fs->alloc_stats) fs->alloc_stats->dblocks_claimed += n;
+}
+
+static void count_dblocks_released(const filesystem_t *fs, size_t n)
+{
+    if (fs->alloc_stats) fs->alloc_stats->dblocks_released += n;
+}
+
+// the arrays `rebuild_dblock_summary` fills, allocated apart from filling them so that
+// `fs_resize` can allocate them before it changes anything
+typedef struct summary_arrays
+{
+    uint64_t *summary;
+    uint64_t *top;
+} summary_arrays_t;
+
+static void free_summary_arrays(summary_arrays_t *arrays)
+{
+    free(arrays->summary);
+    free(arrays->top);
+}
+
+static fs_retcode_t alloc_summary_arrays(size_t dblock_total, summary_arrays_t *arrays)
+{
+    size_t summary_count = SUMMARY_WORD_COUNT(SUMMARY_WORD_COUNT(dblock_total));
+    arrays->summary = calloc(summary_count, sizeof(uint64_t));
+    arrays->top = calloc(SUMMARY_WORD_COUNT(summary_count), sizeof(uint64_t));
+    if (arrays->summary && arrays->top) return SUCCESS;
+    free_summary_arrays(arrays);
+    return SYSTEM_ERROR;
+}
+
+// fills arrays allocated for `fs->dblock_count` dblocks from the bitmask and hands them to `fs`
+static void install_summary_arrays(filesystem_t *fs, summary_arrays_t *arrays)
+{
+    size_t word_count = SUMMARY_WORD_COUNT(fs->dblock_count);
+    size_t summary_count = SUMMARY_WORD_COUNT(word_count);
+    for (size_t word = 0; word < word_count; ++word)
+    {
+        if (load_bitmask_word(fs, word)) set_summary_bit(arrays->summary, word);
+    }
+    for (size_t s = 0; s < summary_count; ++s)
+    {
+        if (arrays->summary[s]) set_summary_bit(arrays->top, s);
+    }
+
+    free(fs->dblock_summary);
+    free(fs->dblock_summary_top);
+    fs->dblock_summary = arrays->summary;
+    fs->dblock_summary_top = arrays->top;
+}
+
+fs_retcode_t rebuild_dblock_summary(filesystem_t *fs)
+{
+    summary_arrays_t arrays;
+    if (alloc_summary_arrays(fs->dblock_count, &arrays) != SUCCESS) return SYSTEM_ERROR;
+    install_summary_arrays(fs, &arrays);
+    return SUCCESS;
+}
+
+fs_retcode_t rebuild_extent_tree(filesystem_t *fs)
+{
+    if (!fs->extents)
+    {
+        fs->extents = malloc(sizeof(extent_tree_t));
+        if (!fs->extents) return SYSTEM_ERROR;
+        extent_tree_init(fs->extents);
+    }
+    extent_tree_clear(fs->extents);
+
+    // the tree stays stale until every run of the bitmask is in it
+    fs->extents_stale = 1;
+    size_t run_start, from = 0;
+    while (find_available_dblock(fs, from, fs->dblock_count, &run_start))
+    {
+        size_t run_end = find_used_dblock(fs, run_start, fs->dblock_count);
+        if (extent_tree_add(fs->extents, run_start, run_end - run_start) != 0) return SYSTEM_ERROR;
+        from = run_end;
+    }
+    fs->extents_stale = 0;
+    return SUCCESS;
+}
+
+fs_retcode_t rebuild_buddy_lists(filesystem_t *fs)
+{
+    dblock_buddy_t *buddy = fs->buddy;
+    if (!buddy)
+    {
+        buddy = calloc(1, sizeof(dblock_buddy_t));
+        if (!buddy) return SYSTEM_ERROR;
+        fs->buddy = buddy;
+    }
+    // the lists stay stale until every run of the bitmask is in them
+    fs->buddy_stale = 1;
+    if (buddy->capacity != fs->dblock_count)
+    {
+        dblock_index_t *next = realloc(buddy->next, fs->dblock_count * sizeof(dblock_index_t));
+        if (next) buddy->next = next;
+        dblock_index_t *prev = realloc(buddy->prev, fs->dblock_count * sizeof(dblock_index_t));
+        if (prev) buddy->prev = prev;
+        uint8_t *order = realloc(buddy->order, fs->dblock_count);
+        if (order) buddy->order = order;
+        if (!next || !prev || !order) return SYSTEM_ERROR;
+        buddy->capacity = fs->dblock_count;
+    }
+    buddy->max_order = floor_log2(fs->dblock_count);
+    buddy->nonempty = 0;
+    for (size_t k = 0; k <= BUDDY_MAX_ORDER; ++k) buddy->heads[k] = BUDDY_NONE;
+    memset(buddy->order, BUDDY_NOT_FREE, fs->dblock_count);
+
+    // every run is cut into the largest aligned blocks that fit, from its start
+    size_t run_start, from = 0;
+    while (find_available_dblock(fs, from, fs->dblock_count, &run_start))
+    {
+        size_t run_end = find_used_dblock(fs, run_start, fs->dblock_count);
+        for (size_t n = run_start; n < run_end;)
+        {
+            size_t order = floor_log2(run_end - n);
+            if (n != 0 && (size_t) __builtin_ctzll(n) < order) order = __builtin_ctzll(n);
+            buddy_push(buddy, n, order);
+            n += (size_t) 1 << order;
+        }
+        from = run_end;
+    }
+    fs->buddy_stale = 0;
+    return SUCCESS;
+}
+
+static int inode_is_available(const filesystem_t *fs, size_t n)
+{
+    return (fs->inode_free_bits[n / BITMASK_WORD_BITS] >> (n % BITMASK_WORD_BITS)) & 1;
+}
+
+// unlinks the nth inode from the free list wherever it is in the list, for a caller that
+// already paid for it
+static void unlink_inode(filesystem_t *fs, inode_index_t n)
+{
+    inode_index_t prev = fs->inode_free_prev[n];
+    inode_index_t next = fs->inodes[n].next_free_inode;
+    if (prev) fs->inodes[prev].next_free_inode = next;
+    else fs->available_inode = next;
+    if (next) fs->inode_free_prev[next] = prev;
+
+    fs->inode_free_bits[n / BITMASK_WORD_BITS] &= ~((uint64_t) 1 << (n % BITMASK_WORD_BITS));
+    --fs->free_inode_count;
+    --fs->groups[n / fs->group_inode_count].free_inode_count;
+}
+
+// the claims check `claimable_inodes` before they take anything, so the unit is always there
+static void take_inode(filesystem_t *fs, inode_index_t n)
+{
+    int taken = take_units(&fs->unreserved_inode_count, credit_units(fs, 0), 1);
+    assert(taken && "an inode was claimed without an unreserved unit to pay for it");
+    (void) taken;
+    unlink_inode(fs, n);
+}
+
+// pushes the nth inode onto the head of the free list. an inode that is already in the
+// list is pushed again without being counted twice, which leaves the list looping through it
+static void return_inode(filesystem_t *fs, inode_index_t n)
+{
+    fs->inodes[n].next_free_inode = fs->available_inode;
+    if (fs->available_inode) fs->inode_free_prev[fs->available_inode] = n;
+    fs->inode_free_prev[n] = 0;
+    fs->available_inode = n;
+
+    if (inode_is_available(fs, n)) return;
+    fs->inode_free_bits[n / BITMASK_WORD_BITS] |= (uint64_t) 1 << (n % BITMASK_WORD_BITS);
+    ++fs->free_inode_count;
+    __atomic_add_fetch(&fs->unreserved_inode_count, 1, __ATOMIC_RELAXED);
+    ++fs->groups[n / fs->group_inode_count].free_inode_count;
+}
+
+// finds the lowest available inode in [from, to) and stores its index in `index`.
+// returns 1 if one was found, 0 otherwise.
+static int find_available_inode(const filesystem_t *fs, size_t from, size_t to, size_t *index)
+{
+    if (to > fs->inode_count) to = fs->inode_count;
+    if (from >= to) return 0;
+
+    size_t word = from / BITMASK_WORD_BITS;
+    uint64_t bits = fs->inode_free_bits[word] & (~(uint64_t) 0 << (from % BITMASK_WORD_BITS));
+    while (!bits)
+    {
+        if (++word * BITMASK_WORD_BITS >= to) return 0;
+        bits = fs->inode_free_bits[word];
+    }
+
+    size_t found = word * BITMASK_WORD_BITS + __builtin_ctzll(bits);
+    if (found >= to) return 0;
+    *index = found;
+    return 1;
+}
+
+// the arrays `rebuild_block_groups` fills, allocated apart from filling them like
+// `summary_arrays_t`
+typedef struct group_arrays
+{
+    block_group_t *groups;
+    uint64_t *free_bits;
+    inode_index_t *free_prev;
+} group_arrays_t;
+
+static size_t block_group_count(filesystem_t *fs, size_t dblock_total)
+{
+    if (fs->group_dblock_count == 0) fs->group_dblock_count = DEFAULT_BLOCK_GROUP_DBLOCK_COUNT;
+    return (dblock_total + fs->group_dblock_count - 1) / fs->group_dblock_count;
+}
+
+static void free_group_arrays(group_arrays_t *arrays)
+{
+    free(arrays->groups);
+    free(arrays->free_bits);
+    free(arrays->free_prev);
+}
+
+static fs_retcode_t alloc_group_arrays(filesystem_t *fs, size_t inode_total, size_t dblock_total, group_arrays_t *arrays)
+{
+    arrays->groups = calloc(block_group_count(fs, dblock_total), sizeof(block_group_t));
+    arrays->free_bits = calloc(SUMMARY_WORD_COUNT(inode_total), sizeof(uint64_t));
+    arrays->free_prev = calloc(inode_total, sizeof(inode_index_t));
+    if (arrays->groups && arrays->free_bits && arrays->free_prev) return SUCCESS;
+    free_group_arrays(arrays);
+    return SYSTEM_ERROR;
+}
+
+// fills arrays allocated for the inodes and dblocks of `fs` from its free inode list and
+// bitmask, and hands them to `fs`
+static void install_group_arrays(filesystem_t *fs, group_arrays_t *arrays)
+{
+    size_t group_count = block_group_count(fs, fs->dblock_count);
+    size_t group_inode_count = (fs->inode_count + group_count - 1) / group_count;
+    block_group_t *groups = arrays->groups;
+    uint64_t *free_bits = arrays->free_bits;
+    inode_index_t *free_prev = arrays->free_prev;
+
+    // the free inode list has been validated by the caller, so it ends
+    inode_index_t prev = 0;
+    for (inode_index_t iter = fs->available_inode; iter != 0; iter = fs->inodes[iter].next_free_inode)
+    {
+        free_bits[iter / BITMASK_WORD_BITS] |= (uint64_t) 1 << (iter % BITMASK_WORD_BITS);
+        free_prev[iter] = prev;
+        ++groups[iter / group_inode_count].free_inode_count;
+        prev = iter;
+    }
+
+    for (size_t g = 0; g < group_count; ++g)
+    {
+        size_t first = g * fs->group_dblock_count;
+        size_t last = first + fs->group_dblock_count < fs->dblock_count ? first + fs->group_dblock_count : fs->dblock_count;
+        groups[g].free_dblock_count = bitmap_popcount(fs->dblock_bitmask, first, last);
+    }
+
+    free(fs->groups);
+    free(fs->inode_free_bits);
+    free(fs->inode_free_prev);
+    fs->groups = groups;
+    fs->group_count = group_count;
+    fs->group_inode_count = group_inode_count;
+    fs->inode_free_bits = free_bits;
+    fs->inode_free_prev = free_prev;
+}
+
+fs_retcode_t rebuild_block_groups(filesystem_t *fs)
+{
+    group_arrays_t arrays;
+    if (alloc_group_arrays(fs, fs->inode_count, fs->dblock_count, &arrays) != SUCCESS) return SYSTEM_ERROR;
+    install_group_arrays(fs, &arrays);
+    return SUCCESS;
+}
+
+// ----------------------- MAGAZINES ----------------------- //
+
+// a thread's private stack of claimed dblocks and inodes, along with units it took out of the
+// unreserved counts that no dblock or inode stands behind yet. claims pop the stacks and
+// releases push onto them, so the shared allocator state is only touched once per
+// `magazine_size` claims or releases
+struct fs_magazine
+{
+    struct fs_magazine *next; // the next magazine of the same file system
+    size_t capacity;          // twice the batch moved to or from the file system at once
+    size_t dblock_len;
+    size_t inode_len;
+    size_t spare_dblocks;
+    size_t spare_inodes;
+    dblock_index_t *dblocks;  // the top of the stack is popped first
+    inode_index_t *inodes;
+};
+
+// the stamp given to the last file system that got magazines. a file system made at the
+// address of one that was freed gets a new stamp, so threads do not mistake its magazines
+static size_t last_magazine_stamp;
+
+static _Thread_local struct thread_magazine
+{
+    filesystem_t *fs;
+    size_t stamp;
+    fs_magazine_t *magazine;
+} local_magazine;
+
+// guards the inode free list and, outside of DBLOCK_ATOMIC mode, the dblock bitmask while
+// a magazine refills or empties
+static void lock_magazines(filesystem_t *fs)
+{
+    while (__atomic_exchange_n(&fs->magazine_lock, 1, __ATOMIC_ACQUIRE))
+    {
+        while (__atomic_load_n(&fs->magazine_lock, __ATOMIC_RELAXED));
+    }
+}
+
+static void unlock_magazines(filesystem_t *fs)
+{
+    __atomic_store_n(&fs->magazine_lock, 0, __ATOMIC_RELEASE);
+}
+
+// returns the magazine of this thread for `fs`, making it the first time. NULL if magazines
+// are off, in which case claims and releases go straight to the file system
+static fs_magazine_t *thread_magazine(filesystem_t *fs)
+{
+    if (fs->magazine_size == 0) return NULL;
+    if (local_magazine.fs == fs && local_magazine.stamp == __atomic_load_n(&fs->magazine_stamp, __ATOMIC_ACQUIRE))
+        return local_magazine.magazine;
+
+    size_t capacity = 2 * fs->magazine_size;
+    fs_magazine_t *magazine = malloc(sizeof(fs_magazine_t) + capacity * (sizeof(dblock_index_t) + sizeof(inode_index_t)));
+    if (!magazine) return NULL;
+    magazine->capacity = capacity;
+    magazine->dblock_len = magazine->inode_len = 0;
+    magazine->spare_dblocks = magazine->spare_inodes = 0;
+    magazine->dblocks = (dblock_index_t *) (magazine + 1);
+    magazine->inodes = (inode_index_t *) (magazine->dblocks + capacity);
+
+    lock_magazines(fs);
+    if (fs->magazine_stamp == 0)
+        __atomic_store_n(&fs->magazine_stamp, __atomic_add_fetch(&last_magazine_stamp, 1, __ATOMIC_RELAXED), __ATOMIC_RELEASE);
+    magazine->next = fs->magazines;
+    fs->magazines = magazine;
+    unlock_magazines(fs);
+
+    local_magazine.fs = fs;
+    local_magazine.stamp = fs->magazine_stamp;
+    local_magazine.magazine = magazine;
+    return magazine;
+}
+
+// a claim served from the magazine would have spent what the thread drew from a reservation,
+// which is kept as spare units instead. `spent` is how many moved
+static size_t credit_to_spare(size_t *credit_left, size_t *spare, size_t n)
+{
+    size_t spent = *credit_left < n ? *credit_left : n;
+    *credit_left -= spent;
+    *spare += spent;
+    return spent;
+}
+
+// keeps the spare units of a magazine from piling up where no other thread can use them
+static void trim_spare(size_t *unreserved, size_t *spare, size_t capacity)
+{
+    if (*spare <= capacity) return;
+    __atomic_add_fetch(unreserved, *spare - capacity / 2, __ATOMIC_RELAXED);
+    *spare = capacity / 2;
+}
+
+static void reverse_dblocks(dblock_index_t *indices, size_t n)
+{
+    for (size_t i = 0; i < n / 2; ++i)
+    {
+        dblock_index_t tmp = indices[i];
+        indices[i] = indices[n - 1 - i];
+        indices[n - 1 - i] = tmp;
+    }
+}
+
+// fills the empty dblock stack with up to a batch of dblocks, paid for with unreserved units
+// and only with spare ones once those run short. returns how many it got
+static size_t refill_dblocks(filesystem_t *fs, fs_magazine_t *magazine)
+{
+    size_t batch = magazine->capacity / 2;
+    size_t want = batch;
+    // the spare units are kept for reservations while the shared count has enough
+    size_t no_spare = 0;
+    size_t *pool = &no_spare;
+    while (!take_units(&fs->unreserved_dblock_count, pool, want))
+    {
+        pool = &magazine->spare_dblocks;
+        want = magazine->spare_dblocks + available_dblocks(fs);
+        if (want == 0) return 0;
+        if (want > batch) want = batch;
+    }
+
+    const dblock_allocator_t *allocator = fs->allocator;
+    if (allocator->concurrent) allocator->take(fs, want, magazine->dblocks);
+    else
+    {
+        lock_magazines(fs);
+        allocator->take(fs, want, magazine->dblocks);
+        unlock_magazines(fs);
+    }
+    // hand out the lowest dblock first, like the allocator would
+    reverse_dblocks(magazine->dblocks, want);
+    magazine->dblock_len = want;
+    return want;
+}
+
+static void return_dblocks_locked(filesystem_t *fs, const dblock_index_t *indices, size_t n)
+{
+    const dblock_allocator_t *allocator = fs->allocator;
+    if (allocator->concurrent)
+    {
+        allocator->release_list(fs, indices, n);
+        return;
+    }
+    lock_magazines(fs);
+    allocator->release_list(fs, indices, n);
+    unlock_magazines(fs);
+}
+
+static fs_retcode_t magazine_claim_dblocks(filesystem_t *fs, fs_magazine_t *magazine, size_t n, dblock_index_t *out)
+{
+    size_t *credit_left = credit_units(fs, 1);
+    size_t spent = credit_to_spare(credit_left, &magazine->spare_dblocks, n);
+    if (n > magazine->dblock_len + magazine->spare_dblocks + available_dblocks(fs))
+    {
+        *credit_left += spent;
+        magazine->spare_dblocks -= spent;
+        return DBLOCK_UNAVAILABLE;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (magazine->dblock_len == 0 && refill_dblocks(fs, magazine) == 0)
+        {
+            // other threads took what was left in between
+            return_dblocks_locked(fs, out, i);
+            return DBLOCK_UNAVAILABLE;
+        }
+        out[i] = magazine->dblocks[--magazine->dblock_len];
+    }
+    trim_spare(&fs->unreserved_dblock_count, &magazine->spare_dblocks, magazine->capacity);
+    return SUCCESS;
+}
+
+static void magazine_release_dblocks(filesystem_t *fs, fs_magazine_t *magazine, const dblock_index_t *indices, size_t n)
+{
+    size_t batch = magazine->capacity / 2;
+    for (size_t i = 0; i < n; ++i)
+    {
+        // releasing an available dblock, or one already in the magazine, does nothing
+        dblock_index_t idx = indices[i];
+        if (__atomic_load_n(&fs->dblock_bitmask[idx / 8], __ATOMIC_RELAXED) & (1 << (7 - idx % 8))) continue;
+        size_t j = 0;
+        while (j < magazine->dblock_len && magazine->dblocks[j] != idx) ++j;
+        if (j < magazine->dblock_len) continue;
+
+        // a full stack gives its bottom half back
+        if (magazine->dblock_len == magazine->capacity)
+        {
+            return_dblocks_locked(fs, magazine->dblocks, batch);
+            magazine->dblock_len -= batch;
+            memmove(magazine->dblocks, magazine->dblocks + batch, magazine->dblock_len * sizeof(dblock_index_t));
+        }
+        magazine->dblocks[magazine->dblock_len++] = idx;
+    }
+}
+
+// fills the empty inode stack with up to a batch of inodes, in the order claim_available_inode
+// would hand them out
+static size_t refill_inodes(filesystem_t *fs, fs_magazine_t *magazine)
+{
+    size_t batch = magazine->capacity / 2;
+    size_t want = batch;
+    // the spare units are kept for reservations while the shared count has enough
+    size_t no_spare = 0;
+    size_t *pool = &no_spare;
+    while (!take_units(&fs->unreserved_inode_count, pool, want))
+    {
+        pool = &magazine->spare_inodes;
+        want = magazine->spare_inodes + available_inodes(fs);
+        if (want == 0) return 0;
+        if (want > batch) want = batch;
+    }
+
+    lock_magazines(fs);
+    size_t next = 1;
+    for (size_t i = 0; i < want; ++i)
+    {
+        if (fs->inode_alloc_mode == INODE_BITMAP) find_available_inode(fs, next, fs->inode_count, &next);
+        else next = fs->available_inode;
+        magazine->inodes[want - 1 - i] = next;
+        unlink_inode(fs, next);
+    }
+    unlock_magazines(fs);
+    magazine->inode_len = want;
+    return want;
+}
+
+static void return_inodes_locked(filesystem_t *fs, const inode_index_t *indices, size_t n)
+{
+    lock_magazines(fs);
+    for (size_t i = 0; i < n; ++i) return_inode(fs, indices[i]);
+    unlock_magazines(fs);
+}
+
+static fs_retcode_t magazine_claim_inodes(filesystem_t *fs, fs_magazine_t *magazine, size_t n, inode_index_t *out)
+{
+    size_t *credit_left = credit_units(fs, 0);
+    size_t spent = credit_to_spare(credit_left, &magazine->spare_inodes, n);
+    if (n > magazine->inode_len + magazine->spare_inodes + available_inodes(fs))
+    {
+        *credit_left += spent;
+        magazine->spare_inodes -= spent;
+        return INODE_UNAVAILABLE;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (magazine->inode_len == 0 && refill_inodes(fs, magazine) == 0)
+        {
+            return_inodes_locked(fs, out, i);
+            return INODE_UNAVAILABLE;
+        }
+        out[i] = magazine->inodes[--magazine->inode_len];
+    }
+    trim_spare(&fs->unreserved_inode_count, &magazine->spare_inodes, magazine->capacity);
+    return SUCCESS;
+}
+
+static void magazine_release_inodes(filesystem_t *fs, fs_magazine_t *magazine, const inode_index_t *indices, size_t n)
+{
+    size_t batch = magazine->capacity / 2;
+    for (size_t i = 0; i < n; ++i)
+    {
+        inode_index_t idx = indices[i];
+        if ((__atomic_load_n(&fs->inode_free_bits[idx / BITMASK_WORD_BITS], __ATOMIC_RELAXED) >> (idx % BITMASK_WORD_BITS)) & 1) continue;
+        size_t j = 0;
+        while (j < magazine->inode_len && magazine->inodes[j] != idx) ++j;
+        if (j < magazine->inode_len) continue;
+
+        if (magazine->inode_len == magazine->capacity)
+        {
+            return_inodes_locked(fs, magazine->inodes, batch);
+            magazine->inode_len -= batch;
+            memmove(magazine->inodes, magazine->inodes + batch, magazine->inode_len * sizeof(inode_index_t));
+        }
+        magazine->inodes[magazine->inode_len++] = idx;
+    }
+}
 
-#include "filesys.h"
-#include "debug.h"
-#include "utility.h"
+// ----------------------- ARENAS ----------------------- //
 
-#define DBLOCK_MASK_SIZE(blk_count) (((blk_count) + 7) / (sizeof(byte) * 8))
+// large images reserve address space for this many inodes, or as many as they hold if that
+// is more. builds that keep many large file systems open under an address space limit can
+// lower it
+#ifndef LARGE_INODE_ARENA_RESERVE
+#define LARGE_INODE_ARENA_RESERVE ((size_t) 1 << 20)
+#endif
 
-#define INDIRECT_DBLOCK_INDEX_COUNT (DATA_BLOCK_SIZE / sizeof(dblock_index_t) - 1)
-#define INDIRECT_DBLOCK_MAX_DATA_SIZE ( DATA_BLOCK_SIZE * INDIRECT_DBLOCK_INDEX_COUNT )
+static size_t page_round(size_t bytes)
+{
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    return (bytes + page - 1) / page * page;
+}
 
-#define DIRECTORY_ENTRY_SIZE (sizeof(inode_index_t) + MAX_FILE_NAME_LEN)
-#define DIRECTORY_ENTRIES_PER_DATABLOCK (DATA_BLOCK_SIZE / DIRECTORY_ENTRY_SIZE)
+// the inodes live in an arena that reserves the address space of more inodes than are in
+// use, and only makes the bytes in use accessible. resizing the file system within the
+// reservation resizes that part in place, so open files and terminal contexts can keep
+// pointers to inodes. anonymous pages read as zeros and only take memory once written
+static void *map_arena(size_t reserved, size_t used)
+{
+    void *arena = mmap(NULL, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (arena == MAP_FAILED) return NULL;
+    if (mprotect(arena, used, PROT_READ | PROT_WRITE) != 0)
+    {
+        munmap(arena, reserved);
+        return NULL;
+    }
+    return arena;
+}
 
-// ----------------------- UTILITY FUNCTION ----------------------- //
+// makes the first `new_used` bytes of an arena accessible. the bytes past the old end read
+// as zeros. returns whether the system could commit them
+static int grow_arena(void *arena, size_t new_used)
+{
+    return mprotect(arena, new_used, PROT_READ | PROT_WRITE) == 0;
+}
 
-// marks the nth dblock as being used 
-static void mark_dblock_as_used(byte *dblock_bitmask, size_t n)
+// gives the pages of an arena past `new_used` bytes back to the system. the rest of the last
+// page kept is cleared, so the arena reads as zeros past its end if it grows again
+static void shrink_arena(void *arena, size_t old_used, size_t new_used)
 {
-    dblock_bitmask[n / 8] &= ~(1 << (7 - n % 8));
+    size_t kept_end = page_round(new_used);
+    size_t old_end = page_round(old_used);
+    memset((byte *) arena + new_used, 0, (kept_end < old_used ? kept_end : old_used) - new_used);
+    if (old_end <= kept_end) return;
+    madvise((byte *) arena + kept_end, old_end - kept_end, MADV_DONTNEED);
+    mprotect((byte *) arena + kept_end, old_end - kept_end, PROT_NONE);
 }
 
-static void mark_dblock_as_unused(byte *dblock_bitmask, size_t n)
+// reserves the address space right after an arena, so it can grow past `reserved` bytes
+// without moving. returns 0 if something else is mapped there
+static int extend_arena(void *arena, size_t reserved, size_t new_reserved)
 {
-    dblock_bitmask[n / 8] |= 1 << (7 - n % 8);
+    byte *end = (byte *) arena + reserved;
+    void *extra = mmap(end, new_reserved - reserved, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+    if (extra == MAP_FAILED) return 0;
+    // kernels older than MAP_FIXED_NOREPLACE take the address as a hint and map elsewhere
+    if (extra != end)
+    {
+        munmap(extra, new_reserved - reserved);
+        return 0;
+    }
+    return 1;
+}
+
+// classic images can never hold more than CLASSIC_MAX_INODE_COUNT inodes, which is only a
+// few MiB of address space, so they reserve all of it
+static size_t inode_arena_cap(fs_geometry_t geometry, size_t inode_total)
+{
+    if (geometry == FS_GEOMETRY_CLASSIC) return CLASSIC_MAX_INODE_COUNT;
+    return inode_total > LARGE_INODE_ARENA_RESERVE ? inode_total : LARGE_INODE_ARENA_RESERVE;
+}
+
+inode_t *map_inodes(fs_geometry_t geometry, size_t inode_total, size_t *inode_cap)
+{
+    *inode_cap = inode_arena_cap(geometry, inode_total);
+    return map_arena(page_round(*inode_cap * sizeof(inode_t)), inode_total * sizeof(inode_t));
+}
+
+void unmap_inodes(inode_t *inodes, size_t inode_cap)
+{
+    if (inodes) munmap(inodes, page_round(inode_cap * sizeof(inode_t)));
+}
+
+// makes room for `new_inode_total` inodes. a file system that outgrows its reservation
+// doubles it in place, and fails rather than move the inodes if the address space after
+// them is taken
+static int grow_inodes(filesystem_t *fs, size_t new_inode_total)
+{
+    if (new_inode_total > fs->inode_arena_cap)
+    {
+        size_t new_cap = fs->inode_arena_cap * 2 > new_inode_total ? fs->inode_arena_cap * 2 : new_inode_total;
+        if (new_cap > LARGE_MAX_INODE_COUNT) new_cap = LARGE_MAX_INODE_COUNT;
+        if (!extend_arena(fs->inodes, page_round(fs->inode_arena_cap * sizeof(inode_t)), page_round(new_cap * sizeof(inode_t))))
+            return 0;
+        fs->inode_arena_cap = new_cap;
+    }
+    return grow_arena(fs->inodes, new_inode_total * sizeof(inode_t));
+}
+
+// the dblocks only take the pages they need and are resized with mremap, which moves the
+// pages rather than copying them when the mapping cannot grow in place. nothing keeps a
+// pointer into the dblocks across calls, so they are free to move
+byte *map_dblocks(size_t dblock_total)
+{
+    void *dblocks = mmap(NULL, page_round(dblock_total * DATA_BLOCK_SIZE), PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return dblocks == MAP_FAILED ? NULL : dblocks;
+}
+
+void unmap_dblocks(byte *dblocks, size_t dblock_total)
+{
+    if (dblocks) munmap(dblocks, page_round(dblock_total * DATA_BLOCK_SIZE));
+}
+
+// resizes the dblocks from `old_total` to `new_total` and returns where they are now, or
+// NULL if they could not grow. the rest of the last page kept is cleared when they shrink,
+// so dblocks past the end read as zeros if they grow again
+static byte *remap_dblocks(byte *dblocks, size_t old_total, size_t new_total)
+{
+    size_t old_bytes = page_round(old_total * DATA_BLOCK_SIZE);
+    size_t new_bytes = page_round(new_total * DATA_BLOCK_SIZE);
+    if (new_total < old_total)
+    {
+        size_t end = new_bytes < old_total * DATA_BLOCK_SIZE ? new_bytes : old_total * DATA_BLOCK_SIZE;
+        memset(dblocks + new_total * DATA_BLOCK_SIZE, 0, end - new_total * DATA_BLOCK_SIZE);
+    }
+    if (old_bytes == new_bytes) return dblocks;
+    void *moved = mremap(dblocks, old_bytes, new_bytes, MREMAP_MAYMOVE);
+    return moved == MAP_FAILED ? NULL : moved;
+}
+
+// ----------------------- LAZY ZEROING ----------------------- //
+
+// the bits of needs-zero word `word` that fall inside dblocks [start, end)
+static uint64_t needs_zero_mask(size_t word, size_t start, size_t end)
+{
+    size_t first = word * BITMASK_WORD_BITS;
+    size_t from = start > first ? start - first : 0;
+    size_t to = end - first < BITMASK_WORD_BITS ? end - first : BITMASK_WORD_BITS;
+    uint64_t mask = ~(uint64_t) 0 << from;
+    if (to < BITMASK_WORD_BITS) mask &= ~(~(uint64_t) 0 << to);
+    return mask;
+}
+
+// marks dblocks [start, start + len) as needing zeros. a release marks its dblocks before
+// they become available, so a claim in another thread that gets them also sees the marks
+static void mark_released_dblocks(filesystem_t *fs, size_t start, size_t len)
+{
+    if (!fs->lazy_zero || len == 0) return;
+    size_t end = start + len;
+    for (size_t word = start / BITMASK_WORD_BITS; word <= (end - 1) / BITMASK_WORD_BITS; ++word)
+        __atomic_fetch_or(&fs->dblock_needs_zero[word], needs_zero_mask(word, start, end), __ATOMIC_RELAXED);
+}
+
+// zeroes the dblocks of [start, start + len) that are marked as needing it and clears their
+// marks. the caller owns the dblocks, so nothing else writes them in between
+static size_t zero_marked_dblocks(filesystem_t *fs, size_t start, size_t len)
+{
+    size_t zeroed = 0;
+    size_t end = start + len;
+    for (size_t word = start / BITMASK_WORD_BITS; len > 0 && word <= (end - 1) / BITMASK_WORD_BITS; ++word)
+    {
+        uint64_t mask = needs_zero_mask(word, start, end);
+        if (!(__atomic_load_n(&fs->dblock_needs_zero[word], __ATOMIC_RELAXED) & mask)) continue;
+        uint64_t marked = __atomic_fetch_and(&fs->dblock_needs_zero[word], ~mask, __ATOMIC_RELAXED) & mask;
+        while (marked)
+        {
+            // runs of marked dblocks are cleared with one memset
+            size_t first = __builtin_ctzll(marked);
+            uint64_t run = marked >> first;
+            size_t run_len = ~run ? (size_t) __builtin_ctzll(~run) : BITMASK_WORD_BITS - first;
+            memset(&fs->dblocks[(word * BITMASK_WORD_BITS + first) * DATA_BLOCK_SIZE], 0, run_len * DATA_BLOCK_SIZE);
+            marked &= run_len + first < BITMASK_WORD_BITS ? ~(uint64_t) 0 << (first + run_len) : 0;
+            zeroed += run_len;
+        }
+    }
+    return zeroed;
+}
+
+static void zero_claimed_dblock_list(filesystem_t *fs, const dblock_index_t *indices, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) zero_marked_dblocks(fs, indices[i], 1);
 }
 
 // ----------------------- CORE FUNCTION ----------------------- //
 
-fs_retcode_t new_filesystem(filesystem_t *fs, size_t inode_total, size_t dblock_total)
+// the most inodes a file system of `geometry` can index
+static size_t max_inode_count(fs_geometry_t geometry)
+{
+    return geometry == FS_GEOMETRY_LARGE ? LARGE_MAX_INODE_COUNT : CLASSIC_MAX_INODE_COUNT;
+}
+
+static fs_retcode_t create_filesystem(filesystem_t *fs, size_t inode_total, size_t dblock_total, fs_geometry_t geometry)
 {
     if (!fs) return INVALID_INPUT;
     if (inode_total == 0 || dblock_total == 0) return INVALID_INPUT;
+    if (geometry != FS_GEOMETRY_CLASSIC && geometry != FS_GEOMETRY_LARGE) return INVALID_INPUT;
+    if (inode_total > max_inode_count(geometry)) return INVALID_INPUT;
 
-    // allocate the inodes
-    inode_t *inodes = calloc(inode_total, sizeof(inode_t));
+    // allocate the inodes, which start out as zeros like the dblocks
+    inode_t *inodes = map_inodes(geometry, inode_total, &fs->inode_arena_cap);
     if (!inodes) return SYSTEM_ERROR;
 
     for (size_t i = 0; i < inode_total - 1; ++i) inodes[i].next_free_inode = i + 1;
     inodes[inode_total - 1].next_free_inode = 0;
 
-    // allocate the dblocks
-    byte *dblocks = calloc(dblock_total, DATA_BLOCK_SIZE);
+    // allocate the dblocks, which are zero until written without being cleared here
+    byte *dblocks = map_dblocks(dblock_total);
     if (!dblocks) return SYSTEM_ERROR;
 
-    // allocate the bitmask for the dblock availability
+    // allocate the bitmask for the dblock availability. it is padded to whole uint64_t words
+    // for DBLOCK_ATOMIC mode
     size_t bit_mask_byte_size = DBLOCK_MASK_SIZE(dblock_total);
-    byte *dblock_bitmask = malloc(bit_mask_byte_size * sizeof(byte));
+    byte *dblock_bitmask = calloc(SUMMARY_WORD_COUNT(dblock_total), BITMASK_WORD_BYTES);
     if (!dblock_bitmask) return SYSTEM_ERROR;
     memset(dblock_bitmask, 0xFF, bit_mask_byte_size);
     
     // initialize root directory
     inodes[0].internal.file_type = DIRECTORY;
     inodes[0].internal.file_perms = FS_READ | FS_WRITE | FS_EXECUTE;
-    // we will set this the size of one directory entry
-    inodes[0].internal.file_size = DIRECTORY_ENTRY_SIZE;
+    // we will set this the size of one directory entry, which depends on the geometry
+    fs->geometry = geometry;
+    inodes[0].internal.file_size = directory_entry_size(fs);
     inodes[0].internal.direct_data[0] = 0; // point to the first data block
     strcpy(inodes[0].internal.file_name, "root");
     size_t available_inode = 1; // next available inode is index 1
@@ -64,10 +1877,8 @@ fs_retcode_t new_filesystem(filesystem_t *fs, size_t inode_total, size_t dblock_
     // we will manually populate the data for this data block.
     dblock_bitmask[0] = 0x7F;
 
-    // first copy the inode index
-    // however we exploit how we calloced the memory so it is already set to 0
-    // now we set the '.' directory
-    dblocks[sizeof(inode_index_t)] = '.'; 
+    // the entry holds inode index 0 and the '.' directory
+    write_directory_entry(fs, dblocks, 0, ".");
 
     // finally write the data when there is no errors
     fs->available_inode = inode_total > 1 ? available_inode : 0;
@@ -76,73 +1887,240 @@ fs_retcode_t new_filesystem(filesystem_t *fs, size_t inode_total, size_t dblock_
     fs->dblock_bitmask = dblock_bitmask;
     fs->dblocks = dblocks;
     fs->dblock_count = dblock_total;
+    fs->dblock_alloc_mode = DBLOCK_FIRST_FIT;
+    fs->allocator = &dblock_allocators[DBLOCK_FIRST_FIT];
+    fs->alloc_stats = NULL;
+    fs->dblock_cursor = 0;
+    fs->dblock_hints = NULL;
+    fs->prealloc_window = 0;
+    fs->delayed_alloc = 0;
+    fs->free_inode_count = inode_total - 1; // every inode but the root
+    fs->free_dblock_count = dblock_total - 1; // every dblock but the root's
+    fs->unreserved_inode_count = fs->free_inode_count;
+    fs->unreserved_dblock_count = fs->free_dblock_count;
+    fs->dblock_summary = NULL;
+    fs->dblock_summary_top = NULL;
+    fs->inode_alloc_mode = INODE_FREE_LIST;
+    fs->groups = NULL;
+    fs->group_dblock_count = 0;
+    fs->inode_free_bits = NULL;
+    fs->inode_free_prev = NULL;
+    fs->magazine_size = 0;
+    fs->magazines = NULL;
+    fs->magazine_stamp = 0;
+    fs->magazine_lock = 0;
+    fs->extents = NULL;
+    fs->extents_stale = 0;
+    fs->buddy = NULL;
+    fs->buddy_stale = 0;
+    fs->extent_map_files = 0;
+    fs->tree_map_files = 0;
+    fs->map_cache_budget = 0;
+    fs->map_cache = NULL;
+    fs->lazy_zero = 0;
+    fs->dblock_needs_zero = calloc(SUMMARY_WORD_COUNT(dblock_total), sizeof(uint64_t));
+
+    if (!fs->dblock_needs_zero || rebuild_dblock_summary(fs) != SUCCESS || rebuild_block_groups(fs) != SUCCESS)
+    {
+        free_filesystem(fs);
+        return SYSTEM_ERROR;
+    }
 
     return SUCCESS;
 }
 
+fs_retcode_t new_filesystem(filesystem_t *fs, size_t inode_total, size_t dblock_total)
+{
+    return create_filesystem(fs, inode_total, dblock_total, FS_GEOMETRY_CLASSIC);
+}
+
+fs_retcode_t new_filesystem_with_options(filesystem_t *fs, size_t inode_total, size_t dblock_total, const fs_options_t *options)
+{
+    if (!options) return INVALID_INPUT;
+    fs_retcode_t ret = create_filesystem(fs, inode_total, dblock_total, options->geometry);
+    if (ret != SUCCESS) return ret;
+
+    fs->inode_alloc_mode = options->inode_alloc_mode;
+    const dblock_allocator_t *allocator = dblock_allocator_for_mode(options->dblock_alloc_mode);
+    ret = allocator ? set_dblock_allocator(fs, allocator) : INVALID_INPUT;
+    if (ret != SUCCESS) free_filesystem(fs);
+    return ret;
+}
+
 void free_filesystem(filesystem_t *fs)
 {
     if (!fs) return;
-    free(fs->inodes);
+    unmap_inodes(fs->inodes, fs->inode_arena_cap);
     free(fs->dblock_bitmask);
-    free(fs->dblocks);
+    free(fs->dblock_hints);
+    unmap_dblocks(fs->dblocks, fs->dblock_count);
+    free(fs->dblock_needs_zero);
+    free(fs->dblock_summary);
+    free(fs->dblock_summary_top);
+    free(fs->groups);
+    free(fs->inode_free_bits);
+    free(fs->inode_free_prev);
+    extent_tree_clear(fs->extents);
+    free(fs->extents);
+    free_buddy(fs->buddy);
+    block_map_cache_clear(fs->map_cache);
+    free(fs->map_cache);
+    while (fs->magazines)
+    {
+        fs_magazine_t *next = fs->magazines->next;
+        free(fs->magazines);
+        fs->magazines = next;
+    }
+    if (local_magazine.fs == fs) local_magazine.fs = NULL;
 }
 
 size_t available_inodes(filesystem_t *fs)
 {
     if (!fs) return 0;
-    size_t count = 0;
-    inode_index_t iter = fs->available_inode;
-    while (iter != 0)
-    {
-        ++count;
-        iter = fs->inodes[iter].next_free_inode;
-    } 
-    return count;
+    return __atomic_load_n(&fs->unreserved_inode_count, __ATOMIC_RELAXED);
 }
 
 size_t available_dblocks(filesystem_t *fs)
 {
     if (!fs) return 0;
-    size_t count = 0;
-    for (size_t i = 0; i < fs->dblock_count; ++i)
-    {
-        size_t block_idx = i / 8;
-        size_t bit_idx = i % 8;
-        if (fs->dblock_bitmask[block_idx] & (1 << (7 - bit_idx))) ++count;
-    }
-    return count;
+    return __atomic_load_n(&fs->unreserved_dblock_count, __ATOMIC_RELAXED);
 }
 
 fs_retcode_t claim_available_inode(filesystem_t *fs, inode_index_t *index)
 {
     if (!fs || !index) return INVALID_INPUT;
+    fs_magazine_t *magazine = thread_magazine(fs);
+    if (magazine) return magazine_claim_inodes(fs, magazine, 1, index);
 
     inode_index_t idx = fs->available_inode;
-    if (!idx) return INODE_UNAVAILABLE;
-    fs->available_inode = fs->inodes[idx].next_free_inode;
+    if (!idx || claimable_inodes(fs) == 0) return INODE_UNAVAILABLE;
+    size_t lowest;
+    if (fs->inode_alloc_mode == INODE_BITMAP && find_available_inode(fs, 1, fs->inode_count, &lowest))
+        idx = lowest;
+    take_inode(fs, idx);
     *index = idx;
     return SUCCESS;
 }
 
-fs_retcode_t claim_available_dblock(filesystem_t *fs, dblock_index_t *index)
+// picks the block group for a new directory: the one with the most available dblocks
+// among the groups that have at least the average number of available inodes
+static size_t find_directory_group(const filesystem_t *fs)
+{
+    size_t average_free_inodes = fs->free_inode_count / fs->group_count;
+    size_t best = 0;
+    int found = 0;
+    for (size_t g = 0; g < fs->group_count; ++g)
+    {
+        const block_group_t *group = &fs->groups[g];
+        if (group->free_inode_count == 0 || group->free_inode_count < average_free_inodes) continue;
+        if (!found || group->free_dblock_count > fs->groups[best].free_dblock_count) best = g;
+        found = 1;
+    }
+    return best;
+}
+
+fs_retcode_t claim_inode_near(filesystem_t *fs, inode_index_t parent, file_type_t type, inode_index_t *index)
 {
     if (!fs || !index) return INVALID_INPUT;
+    if (parent >= fs->inode_count) return INVALID_INPUT;
+    if (claimable_inodes(fs) == 0) return INODE_UNAVAILABLE;
+    if (fs->inode_alloc_mode == INODE_BITMAP)
+    {
+        // keep the inode next to its directory so walking the directory stays in one place
+        size_t idx;
+        if (!find_available_inode(fs, parent + 1, fs->inode_count, &idx) &&
+            !find_available_inode(fs, 1, parent + 1, &idx)) return INODE_UNAVAILABLE;
+        take_inode(fs, idx);
+        *index = idx;
+        return SUCCESS;
+    }
+    if (fs->inode_alloc_mode != INODE_BLOCK_GROUPS) return claim_available_inode(fs, index);
 
-    for (size_t i = 0; i < fs->dblock_count; ++i)
+    // the scan is bounded to one group at a time and skips groups without available inodes
+    size_t first = type == DIRECTORY ? find_directory_group(fs) : parent / fs->group_inode_count;
+    for (size_t i = 0; i < fs->group_count; ++i)
     {
-        size_t block_idx = i / 8;
-        size_t bit_idx = i % 8;
-        // check if dblock is available via the mask
-        if (fs->dblock_bitmask[block_idx] & (1 << (7 - bit_idx)))
-        {
-            // claim the data block
-            *index = i;
-            mark_dblock_as_used(fs->dblock_bitmask, i);
-            return SUCCESS;
-        }
+        size_t g = (first + i) % fs->group_count;
+        if (fs->groups[g].free_inode_count == 0) continue;
+
+        size_t idx;
+        if (!find_available_inode(fs, g * fs->group_inode_count, (g + 1) * fs->group_inode_count, &idx)) continue;
+        take_inode(fs, idx);
+        *index = idx;
+        return SUCCESS;
+    }
+    return INODE_UNAVAILABLE;
+}
+
+const dblock_allocator_t *dblock_allocator_for_mode(dblock_alloc_mode_t mode)
+{
+    if ((size_t) mode >= DBLOCK_ALLOCATOR_COUNT) return NULL;
+    return &dblock_allocators[mode];
+}
+
+fs_retcode_t set_dblock_allocator(filesystem_t *fs, const dblock_allocator_t *allocator)
+{
+    if (!fs || !allocator) return INVALID_INPUT;
+    if (!allocator->claim || !allocator->take || !allocator->claim_range || !allocator->release_range || !allocator->release_list)
+        return INVALID_INPUT;
+
+    // the policy has to be in place before it builds anything, since what it builds may
+    // depend on the mode
+    const dblock_allocator_t *previous = fs->allocator;
+    dblock_alloc_mode_t previous_mode = fs->dblock_alloc_mode;
+    fs->allocator = allocator;
+    fs->dblock_alloc_mode = allocator->mode;
+    fs_retcode_t ret = allocator->attach ? allocator->attach(fs) : SUCCESS;
+    if (ret != SUCCESS)
+    {
+        fs->allocator = previous;
+        fs->dblock_alloc_mode = previous_mode;
+    }
+    // the block map cache is not kept up to date while writes may run on several threads
+    else if (allocator->concurrent) block_map_cache_clear(fs->map_cache);
+    return ret;
+}
+
+fs_retcode_t set_block_group_size(filesystem_t *fs, size_t group_dblock_count)
+{
+    if (!fs) return INVALID_INPUT;
+    if (group_dblock_count == 0 || group_dblock_count % BITMASK_WORD_BITS != 0) return INVALID_INPUT;
+
+    size_t old_group_dblock_count = fs->group_dblock_count;
+    fs->group_dblock_count = group_dblock_count;
+    if (rebuild_block_groups(fs) != SUCCESS)
+    {
+        fs->group_dblock_count = old_group_dblock_count;
+        return SYSTEM_ERROR;
     }
-    return DBLOCK_UNAVAILABLE;
+    return SUCCESS;
+}
+
+fs_retcode_t claim_available_dblock(filesystem_t *fs, dblock_index_t *index)
+{
+    if (!fs || !index) return INVALID_INPUT;
+    fs_magazine_t *magazine = thread_magazine(fs);
+    fs_retcode_t ret;
+    if (magazine) ret = magazine_claim_dblocks(fs, magazine, 1, index);
+    else ret = fs->allocator->claim(fs, index);
+
+    if (ret != SUCCESS) return ret;
+    count_dblocks_claimed(fs, 1);
+    zero_marked_dblocks(fs, *index, 1);
+    return SUCCESS;
+}
+
+fs_retcode_t claim_dblock_near(filesystem_t *fs, dblock_index_t goal, dblock_index_t *index)
+{
+    if (!fs || !index) return INVALID_INPUT;
+    const dblock_allocator_t *allocator = fs->allocator;
+    if (!allocator->claim_near) return claim_available_dblock(fs, index);
+
+    fs_retcode_t ret = allocator->claim_near(fs, goal, index);
+    if (ret != SUCCESS) return ret;
+    count_dblocks_claimed(fs, 1);
+    zero_marked_dblocks(fs, *index, 1);
+    return SUCCESS;
 }
 
 fs_retcode_t release_inode(filesystem_t *fs, inode_t *inode)
@@ -150,13 +2128,15 @@ fs_retcode_t release_inode(filesystem_t *fs, inode_t *inode)
     if (!fs || !inode) return INVALID_INPUT;
 
     // determine if inode is within the inode list. if not error
-    // if (inode < fs->inodes || inode >= fs->inodes + fs->inode_count) return INVALID_INPUT;
+    if (inode < fs->inodes || inode >= fs->inodes + fs->inode_count) return INVALID_INPUT;
     // root inode cannot be released
     if (inode == &fs->inodes[0]) return INVALID_INPUT;
     
     // add inode to the free "list"
-    inode->next_free_inode = fs->available_inode;
-    fs->available_inode = inode - fs->inodes; // inode - fs->inodes is index of inode
+    inode_index_t idx = inode - fs->inodes; // inode - fs->inodes is index of inode
+    fs_magazine_t *magazine = thread_magazine(fs);
+    if (magazine) magazine_release_inodes(fs, magazine, &idx, 1);
+    else return_inode(fs, idx);
 
     return SUCCESS;
 }
@@ -169,10 +2149,382 @@ fs_retcode_t release_dblock(filesystem_t *fs, byte *dblock)
     ptrdiff_t dblock_diff = dblock - fs->dblocks;
     if (dblock_diff % DATA_BLOCK_SIZE != 0) return INVALID_INPUT;
     ptrdiff_t dblock_idx = dblock_diff / DATA_BLOCK_SIZE;
-    // if (dblock_idx < 0 || dblock_idx >= (long) fs->dblock_count) return INVALID_INPUT;
+    if (dblock_idx < 0 || dblock_idx >= (long) fs->dblock_count) return INVALID_INPUT;
 
     // enable bit in the bitmask marking availablity
-    mark_dblock_as_unused(fs->dblock_bitmask, dblock_idx);
+    mark_released_dblocks(fs, dblock_idx, 1);
+    fs_magazine_t *magazine = thread_magazine(fs);
+    dblock_index_t idx = dblock_idx;
+    if (magazine) magazine_release_dblocks(fs, magazine, &idx, 1);
+    else fs->allocator->release_range(fs, dblock_idx, 1);
+    count_dblocks_released(fs, 1);
+
+    return SUCCESS;
+}
+
+fs_retcode_t claim_dblock_range(filesystem_t *fs, size_t want, dblock_index_t goal, dblock_index_t *start, size_t *len)
+{
+    if (!fs || !start || !len || want == 0) return INVALID_INPUT;
+    fs_retcode_t ret = fs->allocator->claim_range(fs, want, goal, start, len);
+    if (ret != SUCCESS) return ret;
+    count_dblocks_claimed(fs, *len);
+    zero_marked_dblocks(fs, *start, *len);
+    return SUCCESS;
+}
+
+fs_retcode_t release_dblock_range(filesystem_t *fs, dblock_index_t start, size_t len)
+{
+    if (!fs || len == 0) return INVALID_INPUT;
+    if (start >= fs->dblock_count || len > fs->dblock_count - start) return INVALID_INPUT;
+
+    mark_released_dblocks(fs, start, len);
+    fs->allocator->release_range(fs, start, len);
+    count_dblocks_released(fs, len);
+    return SUCCESS;
+}
+
+fs_retcode_t claim_available_dblocks(filesystem_t *fs, size_t n, dblock_index_t *out)
+{
+    if (!fs || !out) return INVALID_INPUT;
+    fs_magazine_t *magazine = thread_magazine(fs);
+    fs_retcode_t ret = SUCCESS;
+    if (magazine) ret = magazine_claim_dblocks(fs, magazine, n, out);
+    else if (n > 0 && !take_units(&fs->unreserved_dblock_count, credit_units(fs, 1), n)) ret = DBLOCK_UNAVAILABLE;
+    else if (n > 0) fs->allocator->take(fs, n, out);
+
+    if (ret != SUCCESS) return ret;
+    count_dblocks_claimed(fs, n);
+    zero_claimed_dblock_list(fs, out, n);
+    return SUCCESS;
+}
+
+fs_retcode_t release_dblocks(filesystem_t *fs, const dblock_index_t *indices, size_t n)
+{
+    if (!fs || (!indices && n > 0)) return INVALID_INPUT;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (indices[i] >= fs->dblock_count) return INVALID_INPUT;
+    }
+
+    for (size_t i = 0; i < n; ++i) mark_released_dblocks(fs, indices[i], 1);
+    fs_magazine_t *magazine = thread_magazine(fs);
+    if (magazine) magazine_release_dblocks(fs, magazine, indices, n);
+    else fs->allocator->release_list(fs, indices, n);
+    count_dblocks_released(fs, n);
+    return SUCCESS;
+}
+
+fs_retcode_t claim_available_inodes(filesystem_t *fs, size_t n, inode_index_t *out)
+{
+    if (!fs || !out) return INVALID_INPUT;
+    fs_magazine_t *magazine = thread_magazine(fs);
+    if (magazine) return magazine_claim_inodes(fs, magazine, n, out);
+    if (n > claimable_inodes(fs)) return INODE_UNAVAILABLE;
+
+    // the same inodes as n calls to claim_available_inode, from the head of the free list
+    // or in increasing order in bitmap mode
+    size_t next = 1;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (fs->inode_alloc_mode == INODE_BITMAP) find_available_inode(fs, next, fs->inode_count, &next);
+        else next = fs->available_inode;
+        out[i] = next;
+        take_inode(fs, out[i]);
+    }
+    return SUCCESS;
+}
+
+fs_retcode_t release_inodes(filesystem_t *fs, const inode_index_t *indices, size_t n)
+{
+    if (!fs || (!indices && n > 0)) return INVALID_INPUT;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (indices[i] == 0 || indices[i] >= fs->inode_count) return INVALID_INPUT;
+    }
+
+    fs_magazine_t *magazine = thread_magazine(fs);
+    if (magazine) magazine_release_inodes(fs, magazine, indices, n);
+    else for (size_t i = 0; i < n; ++i) return_inode(fs, indices[i]);
+    return SUCCESS;
+}
+
+fs_retcode_t fs_reserve(filesystem_t *fs, size_t ndblocks, size_t ninodes, fs_reservation_t *token)
+{
+    if (!fs || !token) return INVALID_INPUT;
+
+    // the spare units of the magazine come first, which keeps steady appends off the shared counts
+    fs_magazine_t *magazine = thread_magazine(fs);
+    size_t *dblock_pool = magazine ? &magazine->spare_dblocks : credit_units(fs, 1);
+    size_t *inode_pool = magazine ? &magazine->spare_inodes : credit_units(fs, 0);
+    if (magazine && (ndblocks > magazine->spare_dblocks + available_dblocks(fs) ||
+        ninodes > magazine->spare_inodes + available_inodes(fs)))
+    {
+        // what this thread's own magazine holds could make up the difference
+        return_dblocks_locked(fs, magazine->dblocks, magazine->dblock_len);
+        return_inodes_locked(fs, magazine->inodes, magazine->inode_len);
+        magazine->dblock_len = magazine->inode_len = 0;
+    }
+    if (!take_units(&fs->unreserved_dblock_count, dblock_pool, ndblocks)) return INSUFFICIENT_DBLOCKS;
+    if (!take_units(&fs->unreserved_inode_count, inode_pool, ninodes))
+    {
+        if (magazine) magazine->spare_dblocks += ndblocks;
+        else __atomic_add_fetch(&fs->unreserved_dblock_count, ndblocks, __ATOMIC_RELAXED);
+        return INODE_UNAVAILABLE;
+    }
+
+    token->dblocks = ndblocks;
+    token->inodes = ninodes;
+    return SUCCESS;
+}
+
+// gives the units of this thread's credit back to the unreserved counts of its file system
+static void return_credit(void)
+{
+    if (!credit.fs) return;
+    __atomic_add_fetch(&credit.fs->unreserved_dblock_count, credit.dblocks, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&credit.fs->unreserved_inode_count, credit.inodes, __ATOMIC_RELAXED);
+    credit.fs = NULL;
+    credit.dblocks = credit.inodes = 0;
+}
+
+fs_retcode_t fs_reservation_draw(filesystem_t *fs, fs_reservation_t *token, size_t ndblocks, size_t ninodes)
+{
+    if (!fs || !token) return INVALID_INPUT;
+    if (ndblocks > token->dblocks || ninodes > token->inodes) return INVALID_INPUT;
+
+    if (credit.fs != fs) return_credit();
+    credit.fs = fs;
+    token->dblocks -= ndblocks;
+    token->inodes -= ninodes;
+    credit.dblocks += ndblocks;
+    credit.inodes += ninodes;
+    return SUCCESS;
+}
+
+fs_retcode_t fs_commit(filesystem_t *fs, fs_reservation_t *token)
+{
+    // whatever the operation did not draw was not needed after all, and neither was what
+    // it drew without claiming
+    return fs_abort(fs, token);
+}
+
+fs_retcode_t fs_abort(filesystem_t *fs, fs_reservation_t *token)
+{
+    if (!fs || !token) return INVALID_INPUT;
+
+    // with a magazine the units stay with this thread for its next reservation
+    fs_magazine_t *magazine = thread_magazine(fs);
+    if (magazine)
+    {
+        magazine->spare_dblocks += token->dblocks;
+        magazine->spare_inodes += token->inodes;
+        token->dblocks = token->inodes = 0;
+        if (credit.fs == fs)
+        {
+            magazine->spare_dblocks += credit.dblocks;
+            magazine->spare_inodes += credit.inodes;
+            credit.fs = NULL;
+            credit.dblocks = credit.inodes = 0;
+        }
+        trim_spare(&fs->unreserved_dblock_count, &magazine->spare_dblocks, magazine->capacity);
+        trim_spare(&fs->unreserved_inode_count, &magazine->spare_inodes, magazine->capacity);
+        return SUCCESS;
+    }
+
+    __atomic_add_fetch(&fs->unreserved_dblock_count, token->dblocks, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&fs->unreserved_inode_count, token->inodes, __ATOMIC_RELAXED);
+    token->dblocks = token->inodes = 0;
+    if (credit.fs == fs) return_credit();
+    return SUCCESS;
+}
+
+fs_retcode_t fs_drain_magazines(filesystem_t *fs)
+{
+    if (!fs) return INVALID_INPUT;
+
+    lock_magazines(fs);
+    for (fs_magazine_t *magazine = fs->magazines; magazine; magazine = magazine->next)
+    {
+        fs->allocator->release_list(fs, magazine->dblocks, magazine->dblock_len);
+        for (size_t i = 0; i < magazine->inode_len; ++i) return_inode(fs, magazine->inodes[i]);
+        __atomic_add_fetch(&fs->unreserved_dblock_count, magazine->spare_dblocks, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&fs->unreserved_inode_count, magazine->spare_inodes, __ATOMIC_RELAXED);
+        magazine->dblock_len = magazine->inode_len = 0;
+        magazine->spare_dblocks = magazine->spare_inodes = 0;
+    }
+    unlock_magazines(fs);
+    return SUCCESS;
+}
+
+fs_retcode_t fs_zero_released(filesystem_t *fs, size_t max_dblocks, size_t *zeroed)
+{
+    if (!fs) return INVALID_INPUT;
+
+    size_t done = 0;
+    size_t word_count = SUMMARY_WORD_COUNT(fs->dblock_count);
+    for (size_t word = 0; word < word_count && done < max_dblocks; ++word)
+    {
+        uint64_t marked = fs->dblock_needs_zero[word];
+        // only as many of the word's dblocks as are left to do, lowest first
+        for (size_t left = max_dblocks - done; marked && left < (size_t) __builtin_popcountll(marked);)
+            marked &= ~((uint64_t) 1 << (BITMASK_WORD_BITS - 1 - __builtin_clzll(marked)));
+        while (marked)
+        {
+            size_t first = __builtin_ctzll(marked);
+            uint64_t run = marked >> first;
+            size_t run_len = ~run ? (size_t) __builtin_ctzll(~run) : BITMASK_WORD_BITS - first;
+            done += zero_marked_dblocks(fs, word * BITMASK_WORD_BITS + first, run_len);
+            marked &= run_len + first < BITMASK_WORD_BITS ? ~(uint64_t) 0 << (first + run_len) : 0;
+        }
+    }
+    if (zeroed) *zeroed = done;
+    return SUCCESS;
+}
+
+// points the free list past its current tail at inodes [from, to), in increasing order
+static void append_free_inodes(filesystem_t *fs, size_t from, size_t to)
+{
+    for (size_t n = from; n < to; ++n) fs->inodes[n].next_free_inode = n + 1 < to ? n + 1 : 0;
+
+    inode_index_t tail = fs->available_inode;
+    if (!tail)
+    {
+        fs->available_inode = from;
+        return;
+    }
+    while (fs->inodes[tail].next_free_inode) tail = fs->inodes[tail].next_free_inode;
+    fs->inodes[tail].next_free_inode = from;
+}
+
+// takes inodes [from, inode_count) out of the free list. they are all in it
+static void remove_free_inodes(filesystem_t *fs, size_t from)
+{
+    for (size_t n = from; n < fs->inode_count; ++n)
+    {
+        inode_index_t prev = fs->inode_free_prev[n];
+        inode_index_t next = fs->inodes[n].next_free_inode;
+        if (prev) fs->inodes[prev].next_free_inode = next;
+        else fs->available_inode = next;
+        if (next) fs->inode_free_prev[next] = prev;
+    }
+}
+
+// grows the arrays of `fs` with an entry per inode or dblock to the new totals, keeping what
+// they hold. an arena that grew is shrunk back if a later one cannot grow, so `fs` holds the
+// same file system either way
+static fs_retcode_t grow_arrays(filesystem_t *fs, size_t new_inode_total, size_t new_dblock_total)
+{
+    size_t old_inode_total = fs->inode_count;
+    size_t old_dblock_total = fs->dblock_count;
+    size_t old_words = SUMMARY_WORD_COUNT(old_dblock_total);
+    size_t new_words = SUMMARY_WORD_COUNT(new_dblock_total);
+    if (new_words > old_words)
+    {
+        byte *bitmask = realloc(fs->dblock_bitmask, new_words * BITMASK_WORD_BYTES);
+        if (!bitmask) return SYSTEM_ERROR;
+        memset(bitmask + old_words * BITMASK_WORD_BYTES, 0, (new_words - old_words) * BITMASK_WORD_BYTES);
+        fs->dblock_bitmask = bitmask;
+        uint64_t *needs_zero = realloc(fs->dblock_needs_zero, new_words * sizeof(uint64_t));
+        if (!needs_zero) return SYSTEM_ERROR;
+        memset(needs_zero + old_words, 0, (new_words - old_words) * sizeof(uint64_t));
+        fs->dblock_needs_zero = needs_zero;
+    }
+    if (fs->dblock_hints && new_inode_total > old_inode_total)
+    {
+        dblock_index_t *hints = realloc(fs->dblock_hints, new_inode_total * sizeof(dblock_index_t));
+        if (!hints) return SYSTEM_ERROR;
+        memset(hints + old_inode_total, 0, (new_inode_total - old_inode_total) * sizeof(dblock_index_t));
+        fs->dblock_hints = hints;
+    }
+
+    if (new_inode_total > old_inode_total && !grow_inodes(fs, new_inode_total)) return SYSTEM_ERROR;
+    if (new_dblock_total > old_dblock_total)
+    {
+        byte *dblocks = remap_dblocks(fs->dblocks, old_dblock_total, new_dblock_total);
+        if (!dblocks)
+        {
+            if (new_inode_total > old_inode_total)
+                shrink_arena(fs->inodes, new_inode_total * sizeof(inode_t), old_inode_total * sizeof(inode_t));
+            return SYSTEM_ERROR;
+        }
+        fs->dblocks = dblocks;
+    }
+    return SUCCESS;
+}
+
+fs_retcode_t fs_resize(filesystem_t *fs, size_t new_inode_total, size_t new_dblock_total)
+{
+    if (!fs || new_inode_total == 0 || new_dblock_total == 0) return INVALID_INPUT;
+    // every inode and dblock has to have an index
+    if (new_inode_total > max_inode_count(fs->geometry) || new_dblock_total > (size_t) UINT32_MAX + 1) return INVALID_INPUT;
+
+    // what the magazines hold is claimed in the bitmask and the free list without being used
+    fs_drain_magazines(fs);
+    size_t old_inode_total = fs->inode_count;
+    size_t old_dblock_total = fs->dblock_count;
+    size_t removed_inodes = old_inode_total > new_inode_total ? old_inode_total - new_inode_total : 0;
+    size_t removed_dblocks = old_dblock_total > new_dblock_total ? old_dblock_total - new_dblock_total : 0;
+
+    // only an available tail can be cut off, and not while a reservation counts on it
+    for (size_t n = new_inode_total; n < old_inode_total; ++n)
+    {
+        if (!inode_is_available(fs, n)) return INODE_UNAVAILABLE;
+    }
+    if (removed_inodes > available_inodes(fs)) return INODE_UNAVAILABLE;
+    if (bitmap_popcount(fs->dblock_bitmask, new_dblock_total, old_dblock_total) != removed_dblocks ||
+        removed_dblocks > available_dblocks(fs)) return DBLOCK_UNAVAILABLE;
+
+    // everything that can fail is allocated before anything changes, so running out of
+    // memory leaves `fs` as it was
+    summary_arrays_t summary;
+    group_arrays_t groups;
+    if (alloc_summary_arrays(new_dblock_total, &summary) != SUCCESS) return SYSTEM_ERROR;
+    if (alloc_group_arrays(fs, new_inode_total, new_dblock_total, &groups) != SUCCESS)
+    {
+        free_summary_arrays(&summary);
+        return SYSTEM_ERROR;
+    }
+    if (grow_arrays(fs, new_inode_total, new_dblock_total) != SUCCESS)
+    {
+        free_summary_arrays(&summary);
+        free_group_arrays(&groups);
+        return SYSTEM_ERROR;
+    }
+    size_t new_words = SUMMARY_WORD_COUNT(new_dblock_total);
+
+    // new inodes go after the ones already in the free list, like new_filesystem orders them
+    if (new_inode_total > old_inode_total) append_free_inodes(fs, old_inode_total, new_inode_total);
+    else remove_free_inodes(fs, new_inode_total);
+
+    // new dblocks are available, along with the bits past the last one in its byte as
+    // new_filesystem sets them. bytes past the bitmask and marks past the end are cleared
+    size_t new_mask_size = DBLOCK_MASK_SIZE(new_dblock_total);
+    fs->dblock_count = new_dblock_total;
+    if (new_dblock_total > old_dblock_total)
+    {
+        size_t first_byte = (old_dblock_total + 7) / 8;
+        for (size_t n = old_dblock_total; n < first_byte * 8; ++n) mark_dblock_as_unused(fs->dblock_bitmask, n);
+        memset(fs->dblock_bitmask + first_byte, 0xFF, new_mask_size - first_byte);
+    }
+    memset(fs->dblock_bitmask + new_mask_size, 0, new_words * BITMASK_WORD_BYTES - new_mask_size);
+    if (new_dblock_total % BITMASK_WORD_BITS)
+        fs->dblock_needs_zero[new_words - 1] &= ~(~(uint64_t) 0 << (new_dblock_total % BITMASK_WORD_BITS));
+
+    // a mapping only ever shrinks in place
+    if (new_dblock_total < old_dblock_total) fs->dblocks = remap_dblocks(fs->dblocks, old_dblock_total, new_dblock_total);
+    if (new_inode_total < old_inode_total)
+        shrink_arena(fs->inodes, old_inode_total * sizeof(inode_t), new_inode_total * sizeof(inode_t));
+
+    fs->inode_count = new_inode_total;
+    fs->free_inode_count = fs->free_inode_count + new_inode_total - old_inode_total;
+    fs->unreserved_inode_count = fs->unreserved_inode_count + new_inode_total - old_inode_total;
+    fs->free_dblock_count = fs->free_dblock_count + new_dblock_total - old_dblock_total;
+    fs->unreserved_dblock_count = fs->unreserved_dblock_count + new_dblock_total - old_dblock_total;
+    if (fs->dblock_cursor >= new_dblock_total) fs->dblock_cursor = 0;
+    if (fs->extents) fs->extents_stale = 1;
+    if (fs->buddy) fs->buddy_stale = 1;
 
+    install_summary_arrays(fs, &summary);
+    install_group_arrays(fs, &groups);
     return SUCCESS;
 }
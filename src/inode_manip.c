@@ -1,12 +1,17 @@
 #include "filesys.h"
 
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
 
 #include "utility.h"
+#include "block_map_cache.h"
 #include "debug.h"
 #include <stdio.h>
 #include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define INDIRECT_DBLOCK_INDEX_COUNT (DATA_BLOCK_SIZE / sizeof(dblock_index_t) - 1)
 #define INDIRECT_DBLOCK_MAX_DATA_SIZE ( DATA_BLOCK_SIZE * INDIRECT_DBLOCK_INDEX_COUNT )
@@ -15,7 +20,8 @@
 
 // ----------------------- UTILITY FUNCTION ----------------------- //
 
-int min(int a, int b) {
+static size_t min_size(size_t a, size_t b)
+{
     return (a < b) ? a : b;
 }
 
@@ -45,719 +51,946 @@ uint64_t combine_bytes_to_int(uint8_t *transfer, int start, int end, int size)
     return 0;
 }
 
-// ----------------------- CORE FUNCTION ----------------------- //
 
-// write data will allocate new dblocks (if necessary) in the inode and copy data from void* data (an array) into the dblocks
-// Assume we are appending to the existing data in the inode
+// ----------------------- BLOCK MAP ----------------------- //
 
-// Writes n bytes of data from data to the data D-blocks of an inode. It allocates D-blocks as necessary.
-// Data written is appended and does not modify any existing data in the inode.
-// D-blocks are allocated as needed to store the data being written.
-// Allocated D-blocks are stored in the direct D-blocks first before being stored indirectly via index D-blocks
-// If there is not enough D-blocks available to store all the data, then the function should do nothing except return INSUFFICIENT_DBLOCKS. The state of the file system after the call to the function should be identical to the state of file system before the call.
-// Will need to update inode->internal.file_size appropriately to reflect the new size of the file.
-// This function should not claim any extra D-blocks than is needed.
-// Possible return values are:
-// If fs or inode is NULL, return INVALID_INPUT
-// If there is not enough available D-blocks in the system to satisfy the request, return INSUFFICIENT_DBLOCKS
-// If the data is successfully written, return SUCCESS
+// the data dblocks of an inode are numbered in file order. the first INODE_DIRECT_BLOCK_COUNT
+// are stored in direct_data, the rest are listed INDIRECT_DBLOCK_INDEX_COUNT at a time by the
+// chain of index dblocks starting at indirect_dblock. the last entry of an index dblock is the
+// index of the next one in the chain. an `INODE_TREE_MAPPED` inode lists them
+// INODE_TREE_FANOUT at a time in the leaves of a tree rooted at indirect_dblock instead
+typedef struct block_map_pos
+{
+    size_t n;                       // position of the data dblock within the file
+    dblock_index_t index_dblock;    // index dblock listing data dblock n, unused while n is direct
+} block_map_pos_t;
+
+// an inode with both map flags is extent mapped
+static int is_tree_mapped(const inode_t *inode)
+{
+    return (inode->internal.map_flags & (INODE_TREE_MAPPED | INODE_EXTENT_MAPPED)) == INODE_TREE_MAPPED;
+}
 
-void free_dblock(filesystem_t *fs, dblock_index_t to_free)
+static size_t data_dblock_amount(size_t file_size)
 {
-    release_dblock(fs, &fs->dblocks[(to_free * 64)]);
+    return (file_size + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE;
 }
 
+// true if data dblock n is the first one listed by an index dblock
+static int starts_index_dblock(size_t n)
+{
+    return n >= INODE_DIRECT_BLOCK_COUNT && (n - INODE_DIRECT_BLOCK_COUNT) % INDIRECT_DBLOCK_INDEX_COUNT == 0;
+}
 
-void put_index_into_index_dblock(filesystem_t *fs, dblock_index_t address_of_claimed_block, int destination)
+static dblock_index_t *index_entry(filesystem_t *fs, dblock_index_t index_dblock, size_t slot)
 {
-    byte first = address_of_claimed_block & 0xff;
-    byte second = address_of_claimed_block & 0xff << 8;
-    byte third = address_of_claimed_block & 0xff << 16;
-    byte fourth = address_of_claimed_block & 0xff << 24;
-    fs->dblocks[destination] = first;
-    fs->dblocks[destination+1] = second;
-    fs->dblocks[destination+2] = third;
-    fs->dblocks[destination+3] = fourth;
-    // //printf("dblocks: %2x %2x %2x %2x \n", first, second, third, fourth);
+    return cast_dblock_ptr(&fs->dblocks[index_dblock * DATA_BLOCK_SIZE + slot * sizeof(dblock_index_t)]);
 }
 
-int write_to_dblock(filesystem_t *fs, int indx, byte *data, int start_index, size_t l)
+// the direct_data slot or index dblock entry that stores the data dblock at `pos`
+static dblock_index_t *map_entry(filesystem_t *fs, inode_t *inode, const block_map_pos_t *pos)
 {
-    int real_indx_claimed = (int) indx;
-    int n = (int) l;
-    int count = 0;
-    if(start_index < n)
+    if (pos->n < INODE_DIRECT_BLOCK_COUNT) return &inode->internal.direct_data[pos->n];
+    size_t per_index_dblock = is_tree_mapped(inode) ? INODE_TREE_FANOUT : INDIRECT_DBLOCK_INDEX_COUNT;
+    return index_entry(fs, pos->index_dblock, (pos->n - INODE_DIRECT_BLOCK_COUNT) % per_index_dblock);
+}
+
+// the data dblocks listed below one entry of a tree node at `level`, 1 for a leaf
+static size_t tree_span(size_t level)
+{
+    size_t span = 1;
+    for (; level > 1; --level) span *= INODE_TREE_FANOUT;
+    return span;
+}
+
+// the leaf of the tree of height `height` that lists entry m, counted past the direct slots
+static dblock_index_t tree_leaf(filesystem_t *fs, inode_t *inode, size_t m, size_t height)
+{
+    dblock_index_t node = inode->internal.indirect_dblock;
+    for (size_t span = tree_span(height); span > 1; span /= INODE_TREE_FANOUT)
+        node = *index_entry(fs, node, m / span % INODE_TREE_FANOUT);
+    return node;
+}
+
+// the position in the index dblock chain of the index dblock listing data dblock n
+static size_t chain_position(size_t n)
+{
+    return (n - INODE_DIRECT_BLOCK_COUNT) / INDIRECT_DBLOCK_INDEX_COUNT;
+}
+
+// the block map cache of `fs`, made the first time it is needed. NULL while
+// `map_cache_budget` is 0, in DBLOCK_ATOMIC mode and for inodes outside of `fs`
+static block_map_cache_t *map_cache(filesystem_t *fs, inode_t *inode)
+{
+    if (fs->dblock_alloc_mode == DBLOCK_ATOMIC) return NULL;
+    if (fs->map_cache_budget == 0)
     {
-        int j = 0;
-        for(int i = start_index; i < start_index+min(64, n-start_index); i++)
-        {
-            count++;
-            fs->dblocks[real_indx_claimed + j] = data[i];
-            j++;
-        }
+        // chains cached before the budget was taken away are not kept up to date from here on
+        if (fs->map_cache && fs->map_cache->count > 0) block_map_cache_clear(fs->map_cache);
+        return NULL;
     }
-    else
+    if (inode < fs->inodes || inode >= fs->inodes + fs->inode_count) return NULL;
+    if (!fs->map_cache && (fs->map_cache = malloc(sizeof(block_map_cache_t)))) block_map_cache_init(fs->map_cache);
+    return fs->map_cache;
+}
+
+// tells the cache that the index dblock at position k of the chain of the inode is `index_dblock`
+static void cache_chain_entry(filesystem_t *fs, inode_t *inode, size_t k, dblock_index_t index_dblock)
+{
+    block_map_cache_t *cache = map_cache(fs, inode);
+    if (cache) block_map_cache_extend(cache, inode - fs->inodes, k, index_dblock, fs->map_cache_budget);
+}
+
+// the index dblock at position k of the chain of the inode. the cache answers when it knows
+// it, otherwise the chain is followed from the furthest index dblock the cache knows and the
+// ones on the way are cached
+static dblock_index_t chain_seek(filesystem_t *fs, inode_t *inode, size_t k)
+{
+    dblock_index_t index_dblock = inode->internal.indirect_dblock;
+    block_map_cache_t *cache = map_cache(fs, inode);
+    if (!cache)
     {
-        int j = 0;
-        for(int i = 0; i < n - start_index; i++)
-        {
-            fs->dblocks[real_indx_claimed + j] = data[start_index + i];
-            count++;
-        }
+        for (; k > 0; --k) index_dblock = *index_entry(fs, index_dblock, INDIRECT_DBLOCK_INDEX_COUNT);
+        return index_dblock;
+    }
+
+    size_t key = inode - fs->inodes;
+    const dblock_index_t *chain = NULL;
+    size_t known = block_map_cache_find(cache, key, &chain);
+    if (known > 0 && chain[0] != index_dblock)
+    {
+        // the inode was given another chain without going through the inode functions
+        block_map_cache_truncate(cache, key, 0);
+        known = 0;
+    }
+    if (k < known)
+    {
+        ++cache->hits;
+        return chain[k];
     }
 
-    return count;
+    ++cache->misses;
+    size_t i = 0;
+    if (known > 0) index_dblock = chain[i = known - 1];
+    else block_map_cache_extend(cache, key, 0, index_dblock, fs->map_cache_budget);
+    while (i < k)
+    {
+        index_dblock = *index_entry(fs, index_dblock, INDIRECT_DBLOCK_INDEX_COUNT);
+        block_map_cache_extend(cache, key, ++i, index_dblock, fs->map_cache_budget);
+    }
+    return index_dblock;
 }
 
+// points `pos` at data dblock n of the inode, walking the index dblock chain at most once
+static void map_seek(filesystem_t *fs, inode_t *inode, size_t n, block_map_pos_t *pos)
+{
+    pos->n = n;
+    if (n < INODE_DIRECT_BLOCK_COUNT) pos->index_dblock = inode->internal.indirect_dblock;
+    else if (is_tree_mapped(inode))
+        pos->index_dblock = tree_leaf(fs, inode, n - INODE_DIRECT_BLOCK_COUNT, calculate_tree_height(data_dblock_amount(inode->internal.file_size)));
+    else pos->index_dblock = chain_seek(fs, inode, chain_position(n));
+}
 
-dblock_index_t get_next_idx_dblock(filesystem_t *fs, dblock_index_t curr)
+// advances `pos` to the following data dblock, which must already be mapped
+static void map_next(filesystem_t *fs, inode_t *inode, block_map_pos_t *pos)
 {
-    int result = 0;
-    result |= fs->dblocks[curr * 64 + 60];
-    result |= fs->dblocks[curr * 64 + 61] << 8;
-    result |= fs->dblocks[curr * 64 + 62] << 16;
-    result |= fs->dblocks[curr * 64 + 63] << 24;
-    return result;
+    ++pos->n;
+    if (is_tree_mapped(inode))
+    {
+        // a tree has no links between its leaves, the next one is found from the root
+        if (pos->n >= INODE_DIRECT_BLOCK_COUNT && (pos->n - INODE_DIRECT_BLOCK_COUNT) % INODE_TREE_FANOUT == 0)
+            map_seek(fs, inode, pos->n, pos);
+        return;
+    }
+    if (pos->n == INODE_DIRECT_BLOCK_COUNT)
+        pos->index_dblock = inode->internal.indirect_dblock;
+    else if (starts_index_dblock(pos->n))
+        pos->index_dblock = *index_entry(fs, pos->index_dblock, INDIRECT_DBLOCK_INDEX_COUNT);
+    else return;
+    cache_chain_entry(fs, inode, chain_position(pos->n), pos->index_dblock);
 }
-dblock_index_t get_ith_indirect_dblock(filesystem_t *fs, dblock_index_t curr, int i)
+
+// ----------------------- EXTENT MAP ----------------------- //
+
+// the extents of an `INODE_EXTENT_MAPPED` inode are numbered in file order. extent i is a
+// (start, length) pair in direct_data while i < INODE_INLINE_EXTENT_COUNT, and otherwise a
+// (start, length, logical dblock) record in slot (i - INODE_INLINE_EXTENT_COUNT) %
+// EXTENT_DBLOCK_RECORD_COUNT of an extent dblock in the chain starting at indirect_dblock
+#define EXTENT_RECORD_SIZE (3 * sizeof(dblock_index_t))
+
+typedef struct extent_map_pos
 {
-    dblock_index_t result = 0;
-    result |= fs->dblocks[curr * 64 + i*4];
-    result |= fs->dblocks[curr * 64 + i*4+1];
-    result |= fs->dblocks[curr * 64 + i*4+2];
-    result |= fs->dblocks[curr * 64 + i*4+3];
-    return result;
+    size_t i;                       // number of the extent within the map
+    size_t logical;                 // the data dblock of the file extent i starts at
+    dblock_index_t map_dblock;      // extent dblock holding extent i, unused while i is inline
+} extent_map_pos_t;
+
+static int is_extent_mapped(const inode_t *inode)
+{
+    return inode->internal.map_flags & INODE_EXTENT_MAPPED;
 }
 
-dblock_index_t travel_i_dblocks(filesystem_t *fs, int num_dblocks_curr, inode_t *inode, int offset)
+// true if extent i is the first one held by an extent dblock
+static int starts_extent_dblock(size_t i)
 {
-    dblock_index_t curr = inode->internal.indirect_dblock;
-    int num_indx_dblocks = calculate_index_dblock_amount(inode->internal.file_size) - 1;
-    while(num_indx_dblocks > 0)
-    {
-        curr = get_next_idx_dblock(fs, curr);
-        num_indx_dblocks--;
-    }
-    return get_ith_indirect_dblock(fs, curr, offset);
+    return i >= INODE_INLINE_EXTENT_COUNT && (i - INODE_INLINE_EXTENT_COUNT) % EXTENT_DBLOCK_RECORD_COUNT == 0;
 }
-fs_retcode_t inode_write_data(filesystem_t *fs, inode_t *inode, void *data, size_t n)
-{    
-    if(!fs || !inode) return INVALID_INPUT;
-    if(available_dblocks(fs) == 0) return INSUFFICIENT_DBLOCKS;
 
-    size_t existing_size = inode->internal.file_size;
-    if(inode->internal.file_size <= 256)
-    {
-        // pretend as if you're writing the existing data to the 4 direct datablocks 
-        int num_dblocks_used = calculate_necessary_dblock_amount(existing_size);
-        dblock_index_t idx_of_last_dblock_used = 0;
-        
-        if(num_dblocks_used <= 4)
-        {
-            // // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
-            // printf("name: %s\n", inode->internal.file_name);
-            if(num_dblocks_used == 0)
-                idx_of_last_dblock_used = 0;
-            else
-                idx_of_last_dblock_used = num_dblocks_used-1;
-            int where_written_data_ends = existing_size % 64;
-            // if it evenly divides into 64 bytes, then that means that the whole block is fully written to.
-            if(where_written_data_ends == 0 && num_dblocks_used > 0)
-                where_written_data_ends = 64;
-            uint64_t i = 0;
-            if(existing_size == 0)
-            {
-                dblock_index_t *address_of_claimed_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_block);
-                inode->internal.direct_data[0] = *address_of_claimed_block;
-            }
-            while(where_written_data_ends < 64 && i < n)
-            {
-                fs->dblocks[inode->internal.direct_data[idx_of_last_dblock_used] * 64 + where_written_data_ends] = (byte)((byte *)data)[i];
-                i++;
-                where_written_data_ends++;
-                // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
+static size_t extent_dblock_amount(size_t extents)
+{
+    if (extents <= INODE_INLINE_EXTENT_COUNT) return 0;
+    return (extents - INODE_INLINE_EXTENT_COUNT + EXTENT_DBLOCK_RECORD_COUNT - 1) / EXTENT_DBLOCK_RECORD_COUNT;
+}
 
-            }
+static dblock_index_t *next_extent_dblock(filesystem_t *fs, dblock_index_t map_dblock)
+{
+    return cast_dblock_ptr(&fs->dblocks[map_dblock * DATA_BLOCK_SIZE + NEXT_INDIRECT_INDEX_OFFSET]);
+}
 
-            idx_of_last_dblock_used++;
-            // // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
+// the extent at `pos`: [0] is its start, [1] its length and [2] its logical dblock, which
+// only extents in an extent dblock store
+static dblock_index_t *extent_at(filesystem_t *fs, inode_t *inode, const extent_map_pos_t *pos)
+{
+    if (pos->i < INODE_INLINE_EXTENT_COUNT) return &inode->internal.direct_data[2 * pos->i];
+    size_t slot = (pos->i - INODE_INLINE_EXTENT_COUNT) % EXTENT_DBLOCK_RECORD_COUNT;
+    return cast_dblock_ptr(&fs->dblocks[pos->map_dblock * DATA_BLOCK_SIZE + slot * EXTENT_RECORD_SIZE]);
+}
 
-            while(idx_of_last_dblock_used < 4 && i < n)
-            {
-                dblock_index_t *address_of_claimed_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_block);
-                // i am writing to a dblock like a fucking idiot, the error is here, otherwise everything works well
-                write_to_dblock(fs, *address_of_claimed_block * 64, data, i, n);
-                i+= 64;
-                inode->internal.direct_data[idx_of_last_dblock_used] = *address_of_claimed_block;
-                idx_of_last_dblock_used++;
-                // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
-            }
-            // // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
-            // now we are going to allocate this index datablock
-            if (i < n)
+static dblock_index_t *extent_first(filesystem_t *fs, inode_t *inode, extent_map_pos_t *pos)
+{
+    pos->i = 0;
+    pos->logical = 0;
+    pos->map_dblock = inode->internal.indirect_dblock;
+    return extent_at(fs, inode, pos);
+}
+
+// advances `pos` past the extent of `len` dblocks it is at, to the following extent
+static dblock_index_t *extent_next(filesystem_t *fs, inode_t *inode, extent_map_pos_t *pos, size_t len)
+{
+    ++pos->i;
+    pos->logical += len;
+    if (pos->i == INODE_INLINE_EXTENT_COUNT)
+        pos->map_dblock = inode->internal.indirect_dblock;
+    else if (starts_extent_dblock(pos->i))
+        pos->map_dblock = *next_extent_dblock(fs, pos->map_dblock);
+    return extent_at(fs, inode, pos);
+}
+
+// points `pos` at the extent holding data dblock n of the inode. an extent dblock that is
+// followed by another one is full, so it is skipped whole when the first extent of the next
+// one does not start past n
+static dblock_index_t *extent_seek(filesystem_t *fs, inode_t *inode, size_t n, extent_map_pos_t *pos)
+{
+    dblock_index_t *extent = extent_first(fs, inode, pos);
+    while (pos->logical + extent[1] <= n)
+    {
+        dblock_index_t next;
+        if (starts_extent_dblock(pos->i) && (next = *next_extent_dblock(fs, pos->map_dblock)) != 0)
+        {
+            dblock_index_t *following = cast_dblock_ptr(&fs->dblocks[next * DATA_BLOCK_SIZE]);
+            if (following[2] <= n)
             {
-                // // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
-                dblock_index_t *address_of_claimed_index_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_index_block);
-                inode->internal.indirect_dblock = *address_of_claimed_index_block;
-                while(i < n) //while i still have data to write
-                {
-                    // // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
-                    for(int count = 0; count < 16; count++)
-                    {
-                        dblock_index_t *address_of_claimed_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                        claim_available_dblock(fs, address_of_claimed_block);
-                        put_index_into_index_dblock(fs, *address_of_claimed_block, *address_of_claimed_index_block*64+count*4);
-                        write_to_dblock(fs, *address_of_claimed_block * 64, data, i, n);
-                        i+=64;
-                        // // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
-                        if(i >= n) break;
-                    }
-                }
+                pos->i += EXTENT_DBLOCK_RECORD_COUNT;
+                pos->logical = following[2];
+                pos->map_dblock = next;
+                extent = following;
+                continue;
             }
-            
         }
+        extent = extent_next(fs, inode, pos, extent[1]);
     }
-    else
+    return extent;
+}
+
+// counts the extents of the inode, which cover its `dblocks` data dblocks
+static size_t extent_count(filesystem_t *fs, inode_t *inode, size_t dblocks)
+{
+    if (dblocks == 0) return 0;
+    extent_map_pos_t pos;
+    extent_seek(fs, inode, dblocks - 1, &pos);
+    return pos.i + 1;
+}
+
+// ----------------------- DATA COPY ----------------------- //
+
+// overwrites of at least this many bytes are stored around the cache, since they would only
+// push the rest of the working set out of it. shorter runs of such a write are still copied
+// normally, non-temporal stores only pay off over long stretches of memory. data dblocks a
+// write claims are never streamed to: the arena pages they sit on may be touched for the
+// first time, and the kernel has just zeroed those through the cache
+#define STREAM_WRITE_BYTES ((size_t) 4 << 20)
+#define STREAM_RUN_BYTES 4096
+
+typedef enum copy_mode
+{
+    COPY_FROM_INODE,
+    COPY_TO_INODE,
+    STREAM_TO_INODE,    // like COPY_TO_INODE with non-temporal stores where the target supports them
+} copy_mode_t;
+
+#ifdef __SSE2__
+// copies len bytes from `buffer` to `run` with non-temporal stores. the head and tail that do
+// not fill an aligned 16 bytes are copied normally
+static void stream_run(byte *run, const byte *buffer, size_t len)
+{
+    size_t head = min_size(-(uintptr_t) run % sizeof(__m128i), len);
+    memcpy(run, buffer, head);
+    size_t i = head;
+    for (; i + sizeof(__m128i) <= len; i += sizeof(__m128i))
+        _mm_stream_si128((__m128i *)(run + i), _mm_loadu_si128((const __m128i *)(buffer + i)));
+    memcpy(run + i, buffer + i, len - i);
+}
+#endif
+
+// copies len bytes between a run of data dblocks and `buffer`
+static void copy_run(byte *run, byte *buffer, size_t len, copy_mode_t mode)
+{
+    if (mode == COPY_FROM_INODE) memcpy(buffer, run, len);
+#ifdef __SSE2__
+    else if (mode == STREAM_TO_INODE && len >= STREAM_RUN_BYTES) stream_run(run, buffer, len);
+#endif
+    else memcpy(run, buffer, len);
+}
+
+// gathers the stretches of the arena a copy goes through into runs, and copies a run with
+// one memcpy once the next stretch does not follow it
+typedef struct run_copier
+{
+    byte *buffer;       // where the bytes of the current run are copied from or to
+    size_t left;        // bytes not gathered into a run yet
+    byte *run;
+    size_t run_len;
+    copy_mode_t mode;
+} run_copier_t;
+
+static void start_copy(run_copier_t *copier, byte *buffer, size_t n, copy_mode_t mode)
+{
+    copier->buffer = buffer;
+    copier->left = n;
+    copier->run = NULL;
+    copier->run_len = 0;
+    copier->mode = mode;
+}
+
+static void flush_run(run_copier_t *copier)
+{
+    if (copier->run_len == 0) return;
+    copy_run(copier->run, copier->buffer, copier->run_len, copier->mode);
+    copier->buffer += copier->run_len;
+    copier->run_len = 0;
+}
+
+// adds up to `len` bytes of the arena starting at `at` to the copy
+static inline void copy_next(run_copier_t *copier, byte *at, size_t len)
+{
+    if (copier->run_len > 0 && at != copier->run + copier->run_len) flush_run(copier);
+    if (copier->run_len == 0) copier->run = at;
+    len = min_size(len, copier->left);
+    copier->run_len += len;
+    copier->left -= len;
+}
+
+// copies the last run, then orders the non-temporal stores of the copy before whatever the
+// caller stores next
+static inline void finish_copy(run_copier_t *copier)
+{
+    flush_run(copier);
+#ifdef __SSE2__
+    if (copier->mode == STREAM_TO_INODE) _mm_sfence();
+#endif
+}
+
+// copies n bytes between `buffer` and the data of an extent mapped inode, starting `within`
+// bytes past the start of `extent`, the extent at `pos`. the dblocks of an extent are next to
+// each other in the arena, so an extent is copied whole unless it runs into the next one
+static void copy_extent_range(filesystem_t *fs, inode_t *inode, extent_map_pos_t *pos, dblock_index_t *extent, size_t within, byte *buffer, size_t n, copy_mode_t mode)
+{
+    run_copier_t copier;
+    start_copy(&copier, buffer, n, mode);
+    while (1)
     {
-        int num_of_idx_dblocks = calculate_index_dblock_amount(inode->internal.file_size);
-        dblock_index_t curr = inode->internal.indirect_dblock;
-        num_of_idx_dblocks--;
-        while(num_of_idx_dblocks > 0)
+        size_t extent_bytes = (size_t) extent[1] * DATA_BLOCK_SIZE;
+        if (within < extent_bytes)
         {
-            curr = get_next_idx_dblock(fs, curr);
-            printf("Curr: %d\n Num Index remaining: %d\n", curr, num_of_idx_dblocks);
-            num_of_idx_dblocks--;
+            copy_next(&copier, &fs->dblocks[(size_t) extent[0] * DATA_BLOCK_SIZE + within], extent_bytes - within);
+            if (copier.left == 0) break;
+            within = 0;
         }
-        // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
+        else within -= extent_bytes;
+        extent = extent_next(fs, inode, pos, extent[1]);
+    }
+    finish_copy(&copier);
+}
 
-        // this is the idx of the last datablock in the current index datablock we are using. IT IS AN INT, NOT A DBLOCK INDEX
-        // THESE IMAGINARY INDICES RANGE FROM 0 TO 16
-        int offset_within_curr = (calculate_necessary_dblock_amount(inode->internal.file_size) - 4 - calculate_index_dblock_amount(inode->internal.file_size)) % 16;
-        int offset_within_dblock = inode->internal.file_size % 64;
-        if(offset_within_dblock == 0)
-        {
-            offset_within_dblock = 64;
-        }
-        uint64_t i = 0;
-        while(offset_within_dblock < 64 && i < n)
-        {
-            fs->dblocks[curr * 64 + offset_within_curr * 4] = (byte)((byte *)data)[i];
-            i++;
-            offset_within_dblock++;
-            // // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
-        }
-        // if i still have more data to write:
-        offset_within_curr++;
-        while(i < n)
+// copies n bytes between `buffer` and the data of a block mapped inode, starting `within`
+// bytes into the data dblock at `pos`. the mapping is followed once per data dblock, but data
+// dblocks that sit right after one another in the arena are copied as a single run
+static void copy_mapped_range(filesystem_t *fs, inode_t *inode, block_map_pos_t *pos, size_t within, byte *buffer, size_t n, copy_mode_t mode)
+{
+    run_copier_t copier;
+    start_copy(&copier, buffer, n, mode);
+    copy_next(&copier, &fs->dblocks[*map_entry(fs, inode, pos) * DATA_BLOCK_SIZE + within], DATA_BLOCK_SIZE - within);
+    while (copier.left > 0)
+    {
+        map_next(fs, inode, pos);
+        copy_next(&copier, &fs->dblocks[*map_entry(fs, inode, pos) * DATA_BLOCK_SIZE], DATA_BLOCK_SIZE);
+    }
+    finish_copy(&copier);
+}
+
+// copies n bytes between `buffer` and the data of the inode starting at `offset`.
+// the whole range must already be backed by data dblocks
+static void copy_inode_range(filesystem_t *fs, inode_t *inode, size_t offset, byte *buffer, size_t n, copy_mode_t mode)
+{
+    if (n == 0) return;
+    if (is_extent_mapped(inode))
+    {
+        extent_map_pos_t pos;
+        dblock_index_t *extent = extent_seek(fs, inode, offset / DATA_BLOCK_SIZE, &pos);
+        copy_extent_range(fs, inode, &pos, extent, offset - pos.logical * DATA_BLOCK_SIZE, buffer, n, mode);
+        return;
+    }
+
+    block_map_pos_t pos;
+    map_seek(fs, inode, offset / DATA_BLOCK_SIZE, &pos);
+    copy_mapped_range(fs, inode, &pos, offset % DATA_BLOCK_SIZE, buffer, n, mode);
+}
+
+dblock_index_t inode_dblock_goal(filesystem_t *fs, inode_t *inode)
+{
+    if (!fs || !inode || fs->dblock_count == 0) return 0;
+
+    size_t dblocks = data_dblock_amount(inode->internal.file_size);
+    dblock_index_t goal;
+    if (dblocks == 0)
+    {
+        // an empty inode has only the placement hint it was created with
+        size_t slot = (size_t)(inode - fs->inodes);
+        goal = fs->dblock_hints && slot < fs->inode_count ? fs->dblock_hints[slot] : 0;
+        if (fs->inode_alloc_mode == INODE_BLOCK_GROUPS)
         {
-            // // // // // // // // // // // // display_filesystem(fs, DISPLAY_ALL);
-            // at this point, my last datablock that i used must be filled in
-            int count = offset_within_curr;
-            for(; count < 15; count++)
-            {
-                dblock_index_t *address_of_claimed_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_block);
-                put_index_into_index_dblock(fs, *address_of_claimed_block, curr*64+count*4);
-                write_to_dblock(fs, *address_of_claimed_block * 64, data, i, n);
-                i+=64;
-                if(i >= n) break;
-            }
-            if (i < n)
-            {
-                dblock_index_t *address_of_claimed_index_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_index_block);
-                put_index_into_index_dblock(fs, *address_of_claimed_index_block, curr*64+count*4);
-                offset_within_curr = 0;
-                curr = *address_of_claimed_index_block;
-            }
-            count = 0;
+            // keep the data in the block group of the inode
+            size_t group = (size_t)(inode - fs->inodes) / fs->group_inode_count;
+            if (goal / fs->group_dblock_count != group && group < fs->group_count)
+                goal = group * fs->group_dblock_count;
         }
     }
-    inode->internal.file_size += n;
+    else if (is_extent_mapped(inode))
+    {
+        extent_map_pos_t pos;
+        dblock_index_t *extent = extent_seek(fs, inode, dblocks - 1, &pos);
+        goal = extent[0] + extent[1];
+    }
+    else
+    {
+        block_map_pos_t pos;
+        map_seek(fs, inode, dblocks - 1, &pos);
+        goal = *map_entry(fs, inode, &pos) + 1;
+    }
+    return goal < fs->dblock_count ? goal : 0;
+}
+
+fs_retcode_t set_dblock_hint(filesystem_t *fs, inode_t *inode, dblock_index_t hint)
+{
+    if (!fs || !inode) return INVALID_INPUT;
+    size_t slot = (size_t)(inode - fs->inodes);
+    if (slot >= fs->inode_count) return INVALID_INPUT;
+    if (!fs->dblock_hints)
+    {
+        // most file systems never set a hint, so the hints are only allocated for one
+        if (hint == 0) return SUCCESS;
+        fs->dblock_hints = calloc(fs->inode_count, sizeof(dblock_index_t));
+        if (!fs->dblock_hints) return SYSTEM_ERROR;
+    }
+    fs->dblock_hints[slot] = hint;
     return SUCCESS;
 }
 
+size_t inode_growth_dblocks(filesystem_t *fs, inode_t *inode, size_t end)
+{
+    if (!fs || !inode) return 0;
+    size_t size = inode->internal.file_size;
+    if (end <= size) return 0;
+    size_t dblocks = data_dblock_amount(size);
+    size_t growth = data_dblock_amount(end) - dblocks;
+    if (is_tree_mapped(inode))
+        return growth + calculate_tree_index_dblock_amount(dblocks + growth) - calculate_tree_index_dblock_amount(dblocks);
+    if (!is_extent_mapped(inode)) return calculate_necessary_dblock_amount(end) - calculate_necessary_dblock_amount(size);
+
+    size_t extents = extent_count(fs, inode, dblocks);
+    return growth + extent_dblock_amount(extents + growth) - extent_dblock_amount(extents);
+}
 
-// Reads n bytes of data starting from offset bytes from the beginning of the contents of inode. Stores this data in buffer.
-// If there are not n bytes of data starting from offset, only read the number of bytes until the end of the inode.
-// Set bytes_read to the number of bytes actually read by the function. This should be the number of bytes written to buffer as well.
-// Possible Return values are:
-// If fs, inode, or bytes_read is NULL, return INVALID_INPUT
-// If the read operation was successful, return SUCCESS
-fs_retcode_t inode_read_data(filesystem_t *fs, inode_t *inode, size_t offset, void *buffer, size_t n, size_t *bytes_read)
+size_t inode_map_entries(filesystem_t *fs, inode_t *inode)
 {
-    //first get to the offset of bytes, then read from there
-    byte *transfer = (byte *)buffer;
-    if(!fs || !bytes_read || !inode) return INVALID_INPUT;
-    int read = 0;
-    if (n >= inode->internal.file_size - offset) n = inode->internal.file_size - offset;
-    
-    if(offset <= 256)
-    {
-        int num_dblocks_used = calculate_necessary_dblock_amount(offset);
-        int index_in_dblock_array = num_dblocks_used-1;
-        if (offset == 0)
-            index_in_dblock_array = 0;
-        
-        int offset_within_dblock = offset % 64;
-        if(offset_within_dblock == 0 && num_dblocks_used > 0)
-            offset_within_dblock = 64;
-        
-        while(read < min(n, inode->internal.file_size) && index_in_dblock_array < 4)
-        {
-            while(read < min(n, inode->internal.file_size) && offset_within_dblock < 64)
-            {
-                transfer[read] = fs->dblocks[inode->internal.direct_data[index_in_dblock_array] * 64 + offset_within_dblock];
-                offset_within_dblock++;
-                read++;
-            }
-            offset_within_dblock = 0;
-            index_in_dblock_array++;
-        }
-        if((unsigned) read < n)
-        {
-            dblock_index_t curr = inode->internal.indirect_dblock;
-            int i = 0;
-            // do this until youve read what you needed to read
-            while((unsigned) read < n)
-            {
-                // read every indirect block in the index dblock
-                while(i < 16)
-                {
-                    // get the indirect datablock
-                    dblock_index_t ith_indirect = get_ith_indirect_dblock(fs, curr, i);
-                    // loop through it and copy all of the data
-                    int offset_bc_of_terrible_implementation = read;
-                    // error here!
-                    for(int j = offset_bc_of_terrible_implementation; j < offset_bc_of_terrible_implementation + min(64, n - offset_bc_of_terrible_implementation); j++)
-                    {
-                        transfer[j] = fs->dblocks[ith_indirect*64 + j-offset_bc_of_terrible_implementation];
-                        read++;
-                    }
-                    // if everything is read, break
-                    if(read>=min(n, inode->internal.file_size))
-                        break;
-                    // increment
-                    i++;
-                }
-                // increment current to the next index block
-                curr = get_ith_indirect_dblock(fs, curr, 16);
-                i=0;
-            }
-        }
+    if (!fs || !inode) return 0;
+    size_t dblocks = data_dblock_amount(inode->internal.file_size);
+    return is_extent_mapped(inode) ? extent_count(fs, inode, dblocks) : dblocks;
+}
 
+// dblocks claimed and released per call to the batch functions
+#define DBLOCK_BATCH_SIZE 64
+
+// hands out the dblocks a write needs in the order the block map links them
+typedef struct dblock_claimer
+{
+    dblock_window_t *window;
+    fs_reservation_t *reservation;  // covers every dblock not taken from the window
+    size_t remaining;               // dblocks the write has yet to claim
+    dblock_index_t batch[DBLOCK_BATCH_SIZE];
+    size_t batch_next;
+    size_t batch_len;
+} dblock_claimer_t;
+
+// claims the next dblock of a file, taking it from the window when there is one. an empty
+// window is refilled with a run of up to `prealloc_window` dblocks starting at the goal.
+// first and next fit do not use the goal, so without a window the dblocks are claimed
+// DBLOCK_BATCH_SIZE at a time. dblocks that do not come out of the window are drawn from
+// the reservation right before they are claimed
+static void claim_file_dblock(filesystem_t *fs, dblock_claimer_t *claimer, dblock_index_t goal, dblock_index_t *index)
+{
+    dblock_window_t *window = claimer->window;
+    --claimer->remaining;
+    if (window && window->len == 0 && fs->prealloc_window > 1)
+    {
+        // only the first dblock of the new window is certain to be used
+        fs_reservation_draw(fs, claimer->reservation, 1, 0);
+        claim_dblock_range(fs, fs->prealloc_window, goal, &window->start, &window->len);
     }
-    else
+
+    if (window && window->len > 0)
+    {
+        *index = window->start++;
+        --window->len;
+        return;
+    }
+    if (fs->dblock_alloc_mode == DBLOCK_GOAL_DIRECTED)
     {
-        offset-=256;
-        n = min(n, inode->internal.file_size);
-        dblock_index_t curr = inode->internal.indirect_dblock;
-        int num_of_idx_dblocks = calculate_index_dblock_amount(offset) - 1;
+        fs_reservation_draw(fs, claimer->reservation, 1, 0);
+        claim_dblock_near(fs, goal, index);
+        return;
+    }
 
-        while(num_of_idx_dblocks > 0)
-        {
-            curr = get_next_idx_dblock(fs, curr);
-            num_of_idx_dblocks--;
-        }
+    if (claimer->batch_next == claimer->batch_len)
+    {
+        claimer->batch_len = min_size(claimer->remaining + 1, DBLOCK_BATCH_SIZE);
+        claimer->batch_next = 0;
+        fs_reservation_draw(fs, claimer->reservation, claimer->batch_len, 0);
+        claim_available_dblocks(fs, claimer->batch_len, claimer->batch);
+    }
+    *index = claimer->batch[claimer->batch_next++];
+}
 
-        int offset_within_dblock = offset % 64;
-        if(offset_within_dblock == 0)
-            offset_within_dblock = 64;
-        int offset_within_curr = (calculate_necessary_dblock_amount(offset) - calculate_index_dblock_amount(offset)) % 16;
-        if (offset_within_curr != 0)
-            offset_within_curr-=1;
-        curr = get_ith_indirect_dblock(fs, curr, offset_within_curr);
-        while((unsigned) read < n && offset_within_dblock < 64)
-        {
-            transfer[read] = fs->dblocks[curr * 64 + offset_within_dblock];
-            offset_within_dblock++;
-            read++;
-        }
-        offset_within_dblock = 0;
-        offset_within_curr++;
-        while( (unsigned) read < n)
+// claims an extent dblock, drawn from the reservation since it never comes out of the window
+// or a batch. it is not placed at the goal, where it would split the extent it is claimed for
+static void claim_map_dblock(filesystem_t *fs, fs_reservation_t *reservation, dblock_index_t *index)
+{
+    fs_reservation_draw(fs, reservation, 1, 0);
+    claim_available_dblock(fs, index);
+    *next_extent_dblock(fs, *index) = 0;
+}
+
+// claims the index dblocks a tree mapped inode needs before entry m past the direct slots can
+// be stored, m being a multiple of INODE_TREE_FANOUT, and returns the leaf it goes in. a full
+// tree first grows a level with a new root listing the old one. every index dblock is
+// claimed ahead of the ones below it, like the index dblocks of a chain
+static dblock_index_t grow_tree(filesystem_t *fs, inode_t *inode, size_t m, dblock_claimer_t *claimer, dblock_index_t *goal)
+{
+    size_t height = calculate_tree_height(m + INODE_DIRECT_BLOCK_COUNT);
+    if (m == 0 || m == tree_span(height + 1))
+    {
+        dblock_index_t root;
+        claim_file_dblock(fs, claimer, *goal, &root);
+        *goal = root + 1;
+        if (m > 0) *index_entry(fs, root, 0) = inode->internal.indirect_dblock;
+        inode->internal.indirect_dblock = root;
+        ++height;
+    }
+
+    dblock_index_t node = inode->internal.indirect_dblock;
+    for (size_t span = tree_span(height); span > 1; span /= INODE_TREE_FANOUT)
+    {
+        dblock_index_t *entry = index_entry(fs, node, m / span % INODE_TREE_FANOUT);
+        if (m % span == 0)
         {
-            while((unsigned) read < n && offset_within_curr < 15)
-            {
-                dblock_index_t ith_indirect = get_ith_indirect_dblock(fs, curr, offset_within_curr);
-                while((unsigned) read < n && offset_within_dblock < 64)
-                {
-                    transfer[read] = fs->dblocks[ith_indirect * 64 + offset_within_dblock];
-                    offset_within_dblock++;
-                    read++;
-                }
-                offset_within_dblock = 0;
-                offset_within_curr++;
-            }
-            curr = get_ith_indirect_dblock(fs, curr, 16);
+            claim_file_dblock(fs, claimer, *goal, entry);
+            *goal = *entry + 1;
         }
-        // if(read < min(n, inode->internal.file_size))
-        // {
-        //     dblock_index_t curr = inode->internal.indirect_dblock;
-        //     int i = (calculate_necessary_dblock_amount(offset) - calculate_index_dblock_amount(offset)) % 16;
-        //     int offset_within_dblock = offset % 64;
-        //     // do this until youve read what you needed to read
-        //     while(read < min(n, inode->internal.file_size))
-        //     {
-        //         // read every indirect block in the index dblock
-        //         while(i < 16)
-        //         {
-        //             // get the indirect datablock
-        //             dblock_index_t ith_indirect = get_ith_indirect_dblock(fs, curr, i);
-        //             // loop through it and copy all of the data
-        //             int offset_bc_of_terrible_implementation = read;
-        //             // error here!
-        //             for(int j = offset_bc_of_terrible_implementation; j < offset_bc_of_terrible_implementation + offset_within_dblock + min(64, n - offset_bc_of_terrible_implementation); j++)
-        //             {
-        //                 transfer[j] = fs->dblocks[ith_indirect*64 + j-offset_bc_of_terrible_implementation + offset_within_dblock];
-        //                 read++;
-        //             }
-        //             printf("\n\n");
-        //             for(int j = 0; j < read; j++)
-        //                 printf("%x ", transfer[j]);
-        //             // if everything is read, break
-        //             if(read>=min(n, inode->internal.file_size))
-        //                 break;
-        //             // increment
-        //             i++;
-        //         }
-        //         // increment current to the next index block
-        //         curr = get_ith_indirect_dblock(fs, curr, 16);
-        //         i=0;
-        //     }
-        // }
-    }
-    buffer = transfer;
-    *bytes_read = read;
-    return SUCCESS;
-    
-    //check to make sure inputs are valid
+        node = *entry;
+    }
+    return node;
+}
 
-    //for 0 to n, use the helper function to read and copy 1 byte at a time
+// reserves the dblocks that growing the inode to `end` bytes takes beyond what the window
+// holds. an extent mapped inode only takes data dblocks from the window
+static fs_retcode_t reserve_growth(filesystem_t *fs, inode_t *inode, size_t end, dblock_window_t *window, fs_reservation_t *reservation)
+{
+    size_t size = inode->internal.file_size;
+    size_t need = inode_growth_dblocks(fs, inode, end);
+    size_t from_window = is_extent_mapped(inode) && end > size ? data_dblock_amount(end) - data_dblock_amount(size) : need;
+    size_t held = window ? min_size(from_window, window->len) : 0;
+    if (fs_reserve(fs, need - held, 0, reservation) != SUCCESS) return INSUFFICIENT_DBLOCKS;
+    return SUCCESS;
 }
 
-fs_retcode_t inode_modify_data(filesystem_t *fs, inode_t *inode, size_t offset, void *buffer, size_t n)
+// maps the data dblocks an extent mapped inode needs to grow to `end` bytes, claiming them
+// with the dblocks held by `reservation` and adding each one to the copy of `copier` as it
+// is mapped. `pos` and `last` are at the last extent, or `last` is NULL for an empty inode.
+// a new data dblock that follows the last extent grows it, any other one starts a new extent
+static void grow_extents(filesystem_t *fs, inode_t *inode, size_t end, extent_map_pos_t pos, dblock_index_t *last, dblock_window_t *window, fs_reservation_t *reservation, run_copier_t *copier)
 {
-    byte *transfer = (byte *)buffer;
-    if(!fs || !inode || !buffer) return INVALID_INPUT;
-    if (offset > inode->internal.file_size) return INVALID_INPUT;
-    int num_to_reserve = (int) n - ((int) inode->internal.file_size - (int) offset);
-    if (num_to_reserve < 0)
-        num_to_reserve = 0;
-        
-    if (available_dblocks(fs) < calculate_necessary_dblock_amount(num_to_reserve)) 
-        return INSUFFICIENT_DBLOCKS;
-
-    // display_filesystem(fs, DISPLAY_ALL);
-
-    if(offset <= 256)
-    {
-        uint64_t i = 0;
-        int num_dblocks_used = calculate_necessary_dblock_amount(offset);
-        int num_dblocks_reserved = calculate_necessary_dblock_amount(inode->internal.file_size);
-        int index_in_dblock_array = num_dblocks_used-1;
-        if (offset == 0)
-            index_in_dblock_array = 0;
-        
-        int offset_within_dblock = offset % 64;
-        if(offset_within_dblock == 0 && num_dblocks_used > 0)
-            offset_within_dblock = 64;
-        
-        dblock_index_t curr = inode->internal.direct_data[index_in_dblock_array];
-
-        while(offset_within_dblock < 64 && i < n)
-        {
-            fs->dblocks[curr * 64 + offset_within_dblock] = (byte)((byte *)transfer)[i];
-            i++;
-            offset_within_dblock++;
-            // display_filesystem(fs, DISPLAY_ALL);
-        }
-        index_in_dblock_array++;
-        offset_within_dblock = 0;
-        // ive now filled in the datablock that was last used.
-        while(index_in_dblock_array < 4 && i < n)
+    size_t dblocks = data_dblock_amount(inode->internal.file_size);
+    dblock_index_t goal = last ? last[0] + last[1] : inode_dblock_goal(fs, inode);
+    if (goal >= fs->dblock_count) goal = 0;
+
+    dblock_claimer_t claimer;
+    claimer.window = window;
+    claimer.reservation = reservation;
+    claimer.remaining = data_dblock_amount(end) - dblocks;
+    claimer.batch_next = 0;
+    claimer.batch_len = 0;
+
+    // the claims below cannot fail since the dblocks they take are reserved
+    while (claimer.remaining > 0)
+    {
+        dblock_index_t dblock;
+        claim_file_dblock(fs, &claimer, goal, &dblock);
+        if (last && dblock == last[0] + last[1]) ++last[1];
+        else
         {
-            curr = inode->internal.direct_data[index_in_dblock_array];
-            while(offset_within_dblock < 64 && i < n)
+            if (last) pos.logical += last[1];
+            pos.i = last ? pos.i + 1 : 0;
+            if (starts_extent_dblock(pos.i))
             {
-                fs->dblocks[curr * 64 + offset_within_dblock] = (byte)((byte *)transfer)[i];
-                i++;
-                offset_within_dblock++;
-                // display_filesystem(fs, DISPLAY_ALL);
-            }
-            index_in_dblock_array++;
-            offset_within_dblock = 0;
-            if (index_in_dblock_array >= 4)
-                break;
-            // if need to reserve direct data blocks, reserve them
-            if(index_in_dblock_array > num_dblocks_reserved - 1)
-            {
-                dblock_index_t *address_of_claimed_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_block);
-                inode->internal.direct_data[index_in_dblock_array] = *address_of_claimed_block;
-                i+= write_to_dblock(fs, *address_of_claimed_block * 64, transfer, i, n);
-                if(i >= n) break;
-                // display_filesystem(fs, DISPLAY_ALL);
+                dblock_index_t map_dblock;
+                claim_map_dblock(fs, reservation, &map_dblock);
+                if (pos.i == INODE_INLINE_EXTENT_COUNT) inode->internal.indirect_dblock = map_dblock;
+                else *next_extent_dblock(fs, pos.map_dblock) = map_dblock;
+                pos.map_dblock = map_dblock;
             }
+            last = extent_at(fs, inode, &pos);
+            last[0] = dblock;
+            last[1] = 1;
+            if (pos.i >= INODE_INLINE_EXTENT_COUNT) last[2] = pos.logical;
         }
+        goal = last[0] + last[1];
+        copy_next(copier, &fs->dblocks[dblock * DATA_BLOCK_SIZE], DATA_BLOCK_SIZE);
+    }
+    inode->internal.file_size = end;
+}
 
-        //now, if i still have more data to write, i just do the same exact thing as in the else branch
-        if (i < n)
+// maps the data dblocks a block mapped inode needs to grow to `end` bytes like
+// `grow_extents`, along with the index dblocks that list them. `pos` is at the last data
+// dblock of a non-empty inode
+static void grow_block_map(filesystem_t *fs, inode_t *inode, size_t end, block_map_pos_t pos, dblock_window_t *window, fs_reservation_t *reservation, run_copier_t *copier)
+{
+    size_t dblocks = data_dblock_amount(inode->internal.file_size);
+    if (data_dblock_amount(end) > dblocks)
+    {
+        // same as inode_dblock_goal without walking the block map again
+        dblock_index_t goal = dblocks > 0 ? *map_entry(fs, inode, &pos) + 1 : inode_dblock_goal(fs, inode);
+        if (goal >= fs->dblock_count) goal = 0;
+
+        dblock_claimer_t claimer;
+        claimer.window = window;
+        claimer.reservation = reservation;
+        claimer.remaining = inode_growth_dblocks(fs, inode, end);
+        claimer.batch_next = 0;
+        claimer.batch_len = 0;
+
+        // the claims below cannot fail since the dblocks they take are reserved
+        for (; dblocks < data_dblock_amount(end); ++dblocks)
         {
-            // int num_of_idx_dblocks = calculate_index_dblock_amount(offset);
-            if(inode->internal.file_size <= 256)
+            pos.n = dblocks;
+            if (is_tree_mapped(inode))
             {
-                dblock_index_t *address_of_claimed_index_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_index_block);
-                inode->internal.indirect_dblock = *address_of_claimed_index_block;
+                if (pos.n >= INODE_DIRECT_BLOCK_COUNT && (pos.n - INODE_DIRECT_BLOCK_COUNT) % INODE_TREE_FANOUT == 0)
+                    pos.index_dblock = grow_tree(fs, inode, pos.n - INODE_DIRECT_BLOCK_COUNT, &claimer, &goal);
             }
-            dblock_index_t curr = inode->internal.indirect_dblock;
-            dblock_index_t curr_indx_block = curr;
-            // display_filesystem(fs, DISPLAY_ALL);
-            // printf("curr: %d\n", curr);
-
-            int num_indirect_dblocks = calculate_necessary_dblock_amount(offset) - 4 - calculate_index_dblock_amount(offset);
-            if(num_indirect_dblocks < 0)
-                num_indirect_dblocks = 0;
-
-            int offset_within_curr = num_indirect_dblocks % 15;
-
-            if (offset_within_curr != 0)
-                offset_within_curr-=1;
-
-            curr = get_ith_indirect_dblock(fs, curr_indx_block, offset_within_curr);
-            int num_allocated = (calculate_necessary_dblock_amount(inode->internal.file_size) - 4 - calculate_index_dblock_amount(inode->internal.file_size));
-            int blocks_used_by_offset = (calculate_necessary_dblock_amount(offset) - 4 - calculate_index_dblock_amount(offset));
-            if(blocks_used_by_offset < 0)
-                blocks_used_by_offset = 0;
-            while(i < n && blocks_used_by_offset < num_allocated)
+            else if (starts_index_dblock(pos.n))
             {
-                for(; offset_within_curr < 15; offset_within_curr++)
-                {
-                    if(blocks_used_by_offset >= num_allocated) break;
-                    curr = get_ith_indirect_dblock(fs, curr_indx_block, offset_within_curr);
-                    i += write_to_dblock(fs, curr * 64, transfer, i, n);
-                    blocks_used_by_offset++;
-                    // display_filesystem(fs, DISPLAY_ALL);
-                }
-
-                if (i < n && blocks_used_by_offset < num_allocated)
-                {
-                    curr_indx_block = get_next_idx_dblock(fs, curr_indx_block);
-                    offset_within_curr = 0;
-                    curr = get_ith_indirect_dblock(fs, curr_indx_block, offset_within_curr);
-                }
-                else break;
+                // the index dblock is claimed ahead of the data dblocks it lists
+                dblock_index_t index_dblock;
+                claim_file_dblock(fs, &claimer, goal, &index_dblock);
+                if (pos.n == INODE_DIRECT_BLOCK_COUNT) inode->internal.indirect_dblock = index_dblock;
+                else *index_entry(fs, pos.index_dblock, INDIRECT_DBLOCK_INDEX_COUNT) = index_dblock;
+                pos.index_dblock = index_dblock;
+                cache_chain_entry(fs, inode, chain_position(pos.n), index_dblock);
+                goal = index_dblock + 1;
             }
 
-            // now ive used all my allocated blocks, i must start allocating new data
-            while(i < n)
-            {
-                for(; offset_within_curr < 15; offset_within_curr++)
-                {
-                    // i reserve the space and write at most 64 bytes
-                    dblock_index_t *address_of_claimed_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                    claim_available_dblock(fs, address_of_claimed_block);
-                    put_index_into_index_dblock(fs, *address_of_claimed_block, curr_indx_block*64 + offset_within_curr*4);
-                    i += write_to_dblock(fs, *address_of_claimed_block * 64, transfer, i, n);
-                    if(i >= n) break;
-                    // display_filesystem(fs, DISPLAY_ALL);
-                }
-                if (i < n)
-                {
-                    dblock_index_t *address_of_claimed_index_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                    claim_available_dblock(fs, address_of_claimed_index_block);
-                    put_index_into_index_dblock(fs, *address_of_claimed_index_block, curr_indx_block*64 + offset_within_curr*4);
-                    offset_within_curr = 0;
-                    curr_indx_block = *address_of_claimed_index_block;
-                    // display_filesystem(fs, DISPLAY_ALL);
-                }
-                offset_within_curr = 0;
-                // display_filesystem(fs, DISPLAY_ALL);
-            }
+            dblock_index_t *entry = map_entry(fs, inode, &pos);
+            claim_file_dblock(fs, &claimer, goal, entry);
+            goal = *entry + 1;
+            copy_next(copier, &fs->dblocks[*entry * DATA_BLOCK_SIZE], DATA_BLOCK_SIZE);
         }
     }
-    else
+    inode->internal.file_size = end;
+}
+
+// ----------------------- CORE FUNCTION ----------------------- //
+
+// the write engine behind `inode_write_data` and `inode_modify_data`. the n bytes at `offset`
+// are copied into the data dblocks already backing them a run at a time, and the data
+// dblocks past those are claimed with the dblocks held by `reservation` and filled a run at a
+// time as they are mapped. the reservation is committed before returning. `offset` must not
+// be past the end of the inode. the block map is walked at most twice: once to the last data
+// dblock to grow the inode, and once to `offset` when the write starts before that
+static fs_retcode_t write_range(filesystem_t *fs, inode_t *inode, size_t offset, byte *src, size_t n, dblock_window_t *window, fs_reservation_t *reservation)
+{
+    if (n == 0) return fs_commit(fs, reservation);
+
+    size_t size = inode->internal.file_size;
+    size_t end = offset + n;
+    size_t dblocks = data_dblock_amount(size);
+    size_t mapped = min_size(end, dblocks * DATA_BLOCK_SIZE) - offset;  // bytes going to data dblocks the inode has
+    int grows = end > size;
+    int from_last = grows && offset / DATA_BLOCK_SIZE + 1 == dblocks;
+    copy_mode_t mode = mapped >= STREAM_WRITE_BYTES ? STREAM_TO_INODE : COPY_TO_INODE;
+    run_copier_t copier;
+    start_copy(&copier, src + mapped, n - mapped, COPY_TO_INODE);
+
+    if (is_extent_mapped(inode))
     {
-        int num_of_idx_dblocks = calculate_index_dblock_amount(offset);
-        dblock_index_t curr = inode->internal.indirect_dblock;
-        num_of_idx_dblocks--;
-        while(num_of_idx_dblocks > 0)
+        extent_map_pos_t pos = { 0 };
+        dblock_index_t *last = NULL;
+        if (grows && dblocks > 0) last = extent_seek(fs, inode, dblocks - 1, &pos);
+        if (mapped > 0)
         {
-            curr = get_next_idx_dblock(fs, curr);
-            num_of_idx_dblocks--;
+            extent_map_pos_t at = pos;
+            dblock_index_t *extent = from_last ? last : extent_seek(fs, inode, offset / DATA_BLOCK_SIZE, &at);
+            copy_extent_range(fs, inode, &at, extent, offset - at.logical * DATA_BLOCK_SIZE, src, mapped, mode);
         }
-        dblock_index_t curr_indx_block = curr;
-        // display_filesystem(fs, DISPLAY_ALL);
-        // printf("curr: %d\n", curr);
-
-        int num_indirect_dblocks = calculate_necessary_dblock_amount(offset) - 4 - calculate_index_dblock_amount(offset);
-        int offset_within_curr = num_indirect_dblocks % 15;
-        if (offset_within_curr != 0)
-            offset_within_curr-=1;
-
-        int offset_within_dblock = offset % 64;
-        if(offset_within_dblock == 0)
-            offset_within_dblock = 64;
-        
-        uint64_t i = 0;
-        curr = get_ith_indirect_dblock(fs, curr_indx_block, offset_within_curr);
-        while(offset_within_dblock < 64 && i < n)
+        if (grows) grow_extents(fs, inode, end, pos, last, window, reservation, &copier);
+    }
+    else
+    {
+        block_map_pos_t pos = { 0 };
+        if (grows && dblocks > 0) map_seek(fs, inode, dblocks - 1, &pos);
+        if (mapped > 0)
         {
-            fs->dblocks[curr * 64 + offset_within_dblock] = (byte)((byte *)transfer)[i];
-            i++;
-            offset_within_dblock++;
-            // display_filesystem(fs, DISPLAY_ALL);
+            block_map_pos_t at = pos;
+            if (!from_last) map_seek(fs, inode, offset / DATA_BLOCK_SIZE, &at);
+            copy_mapped_range(fs, inode, &at, offset % DATA_BLOCK_SIZE, src, mapped, mode);
         }
-        // now i filled in my last indirect dblock
+        if (grows) grow_block_map(fs, inode, end, pos, window, reservation, &copier);
+    }
+    finish_copy(&copier);
+    return fs_commit(fs, reservation);
+}
 
+// Writes n bytes of data from data to the data D-blocks of an inode. It allocates D-blocks as necessary.
+// Data written is appended and does not modify any existing data in the inode.
+// D-blocks are allocated as needed to store the data being written.
+// Allocated D-blocks are stored in the direct D-blocks first before being stored indirectly via index D-blocks
+// If there is not enough D-blocks available to store all the data, then the function should do nothing except return INSUFFICIENT_DBLOCKS. The state of the file system after the call to the function should be identical to the state of file system before the call.
+// Will need to update inode->internal.file_size appropriately to reflect the new size of the file.
+// This function should not claim any extra D-blocks than is needed.
+// Possible return values are:
+// If fs or inode is NULL, return INVALID_INPUT
+// If there is not enough available D-blocks in the system to satisfy the request, return INSUFFICIENT_DBLOCKS
+// If the data is successfully written, return SUCCESS
+fs_retcode_t inode_write_data(filesystem_t *fs, inode_t *inode, void *data, size_t n)
+{
+    if(!fs || !inode) return INVALID_INPUT;
 
-        offset_within_curr++;
-        int num_allocated = (calculate_necessary_dblock_amount(inode->internal.file_size) - 4 - calculate_index_dblock_amount(inode->internal.file_size));
-        int blocks_used_by_offset = (calculate_necessary_dblock_amount(offset) - 4 - calculate_index_dblock_amount(offset));
+    size_t size = inode->internal.file_size;
+    fs_reservation_t reservation;
+    fs_retcode_t ret = reserve_growth(fs, inode, size + n, NULL, &reservation);
+    if (ret != SUCCESS) return ret;
+    return write_range(fs, inode, size, (byte *)data, n, NULL, &reservation);
+}
 
-        while(i < n && blocks_used_by_offset < num_allocated)
-        {
-            for(; offset_within_curr < 15; offset_within_curr++)
-            {
-                if(blocks_used_by_offset >= num_allocated) break;
-                curr = get_ith_indirect_dblock(fs, curr_indx_block, offset_within_curr);
-                i += write_to_dblock(fs, curr * 64, transfer, i, n);
-                blocks_used_by_offset++;
-                // display_filesystem(fs, DISPLAY_ALL);
-            }
+// Reads n bytes of data starting from offset bytes from the beginning of the contents of inode. Stores this data in buffer.
+// If there are not n bytes of data starting from offset, only read the number of bytes until the end of the inode.
+// Set bytes_read to the number of bytes actually read by the function. This should be the number of bytes written to buffer as well.
+// Possible Return values are:
+// If fs, inode, or bytes_read is NULL, return INVALID_INPUT
+// If the read operation was successful, return SUCCESS
+fs_retcode_t inode_read_data(filesystem_t *fs, inode_t *inode, size_t offset, void *buffer, size_t n, size_t *bytes_read)
+{
+    if(!fs || !bytes_read || !inode) return INVALID_INPUT;
 
-            if (i < n && blocks_used_by_offset < num_allocated)
-            {
-                curr_indx_block = get_next_idx_dblock(fs, curr_indx_block);
-                offset_within_curr = 0;
-                curr = get_ith_indirect_dblock(fs, curr_indx_block, offset_within_curr);
-            }
-            else break;
-        }
+    size_t size = inode->internal.file_size;
+    if (offset >= size) n = 0;
+    else n = min_size(n, size - offset);
 
-        // now ive used all my allocated blocks, i must start allocating new data
-        while(i < n)
-        {
-            for(; offset_within_curr < 15; offset_within_curr++)
-            {
-                // i reserve the space and write at most 64 bytes
-                dblock_index_t *address_of_claimed_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_block);
-                put_index_into_index_dblock(fs, *address_of_claimed_block, curr_indx_block*64 + offset_within_curr*4);
-                i += write_to_dblock(fs, *address_of_claimed_block * 64, transfer, i, n);
-                if(i >= n) break;
-                // display_filesystem(fs, DISPLAY_ALL);
-            }
-            if (i < n)
-            {
-                dblock_index_t *address_of_claimed_index_block = cast_dblock_ptr(malloc(sizeof(dblock_index_t)));
-                claim_available_dblock(fs, address_of_claimed_index_block);
-                put_index_into_index_dblock(fs, *address_of_claimed_index_block, curr_indx_block*64 + offset_within_curr*4);
-                offset_within_curr = 0;
-                curr_indx_block = *address_of_claimed_index_block;
-                // display_filesystem(fs, DISPLAY_ALL);
-            }
-            offset_within_curr = 0;
-            // display_filesystem(fs, DISPLAY_ALL);
-        }
-    }
-    // (void)fs;
-    inode->internal.file_size += num_to_reserve;
-    // (void)offset;
-    // (void)buffer;
-    // (void)n;
+    copy_inode_range(fs, inode, offset, (byte *)buffer, n, COPY_FROM_INODE);
+    *bytes_read = n;
     return SUCCESS;
+}
 
-    //check to see if the input is valid
+static fs_retcode_t modify_data(filesystem_t *fs, inode_t *inode, size_t offset, void *buffer, size_t n, dblock_window_t *window)
+{
+    size_t size = inode->internal.file_size;
+    if (offset > size) return INVALID_INPUT;
 
-    //calculate the final filesize and verify there are enough blocks to support it
-    //use calculate_necessary_dblock_amount and available_dblocks
+    //calculate the final filesize and reserve the blocks to support it
+    fs_reservation_t reservation;
+    fs_retcode_t ret = reserve_growth(fs, inode, offset + n, window, &reservation);
+    if (ret != SUCCESS) return ret;
 
+    //overwrite the existing data and append the rest in one pass
+    return write_range(fs, inode, offset, (byte *)buffer, n, window, &reservation);
+}
 
-    //Write to existing data in your inode
+fs_retcode_t inode_modify_data(filesystem_t *fs, inode_t *inode, size_t offset, void *buffer, size_t n)
+{
+    //check to see if the input is valid
+    if(!fs || !inode || !buffer) return INVALID_INPUT;
+    return modify_data(fs, inode, offset, buffer, n, NULL);
+}
 
-    //For the new data, call "inode_write_data" and return
+fs_retcode_t inode_modify_data_window(filesystem_t *fs, inode_t *inode, size_t offset, void *buffer, size_t n, dblock_window_t *window)
+{
+    if(!fs || !inode || !buffer || !window) return INVALID_INPUT;
+    return modify_data(fs, inode, offset, buffer, n, window);
 }
 
-fs_retcode_t inode_shrink_data(filesystem_t *fs, inode_t *inode, size_t new_size)
+// cuts an extent mapped inode down to its first `keep` of `dblocks` data dblocks. the
+// extent holding the last kept dblock is shortened, and every dblock after it is released a
+// run at a time along with the extent dblocks that only hold released extents. releasing
+// does not touch the contents of a dblock so the chain can still be followed
+static void shrink_extents(filesystem_t *fs, inode_t *inode, size_t keep, size_t dblocks)
 {
-    
-    if(!fs || !inode) return INVALID_INPUT;
-    if(new_size > inode->internal.file_size) return INVALID_INPUT;
-    if(inode->internal.file_size == 0) return SUCCESS;
-    int num_dblocks_new = calculate_necessary_dblock_amount(new_size);
-    int num_dblocks_curr = calculate_necessary_dblock_amount(inode->internal.file_size);
-    if(num_dblocks_curr == 1)
+    extent_map_pos_t pos;
+    dblock_index_t *extent = keep > 0 ? extent_seek(fs, inode, keep - 1, &pos) : extent_first(fs, inode, &pos);
+    int kept_in_map_dblock = keep > 0 && pos.i >= INODE_INLINE_EXTENT_COUNT;
+    dblock_index_t last_map_dblock = pos.map_dblock;
+
+    size_t cut = keep - pos.logical;
+    size_t len = extent[1];
+    if (cut < len) release_dblock_range(fs, extent[0] + cut, len - cut);
+    extent[1] = cut;
+    while (pos.logical + len < dblocks)
     {
-
-        inode->internal.file_size = new_size;
-        release_dblock(fs, &fs->dblocks[inode->internal.direct_data[0] * 64]);
-        return SUCCESS;
+        extent = extent_next(fs, inode, &pos, len);
+        if (starts_extent_dblock(pos.i)) release_dblock_range(fs, pos.map_dblock, 1);
+        len = extent[1];
+        release_dblock_range(fs, extent[0], len);
     }
 
-    // int to_remove = num_dblocks_curr - num_dblocks_new;
-    // first need to get to last dblock of the data
-    while(num_dblocks_curr > 4 && num_dblocks_curr != num_dblocks_new)
+    // the chain ends at the last extent dblock still in use
+    if (kept_in_map_dblock) *next_extent_dblock(fs, last_map_dblock) = 0;
+    else inode->internal.indirect_dblock = 0;
+}
+
+// dblocks to release, handed to `release_dblocks` DBLOCK_BATCH_SIZE at a time
+typedef struct dblock_releaser
+{
+    dblock_index_t batch[DBLOCK_BATCH_SIZE];
+    size_t len;
+} dblock_releaser_t;
+
+static void release_later(filesystem_t *fs, dblock_releaser_t *releaser, dblock_index_t index)
+{
+    if (releaser->len == DBLOCK_BATCH_SIZE)
     {
-        int offset = ((calculate_necessary_dblock_amount(inode->internal.file_size) - 4 - calculate_index_dblock_amount(inode->internal.file_size)) % 16);
-        
-        dblock_index_t curr = travel_i_dblocks(fs, num_dblocks_curr, inode, offset);
-        free_dblock(fs, curr);
-        inode->internal.file_size -= 64;
-        num_dblocks_curr--;
-        if (num_dblocks_curr <= 4)
-            free_dblock(fs, inode->internal.indirect_dblock);
+        release_dblocks(fs, releaser->batch, releaser->len);
+        releaser->len = 0;
     }
-    if(inode->internal.file_size == 0)
+    releaser->batch[releaser->len++] = index;
+}
+
+// releases the entries of the tree node `node` at `level`, 1 for a leaf, from entry position
+// `keep` up to `end`, counted from the first position the node covers, along with the nodes
+// below it that only list released positions
+static void shrink_tree_node(filesystem_t *fs, dblock_releaser_t *releaser, dblock_index_t node, size_t level, size_t keep, size_t end)
+{
+    size_t span = tree_span(level);
+    for (size_t slot = keep / span; slot * span < end; ++slot)
     {
-        free_dblock(fs, inode->internal.direct_data[0]);
-        inode->internal.file_size = 0;
-        return SUCCESS;
+        dblock_index_t child = *index_entry(fs, node, slot);
+        size_t first = slot * span;
+        if (level > 1)
+        {
+            size_t child_keep = keep > first ? keep - first : 0;
+            shrink_tree_node(fs, releaser, child, level - 1, child_keep, min_size(end - first, span));
+            if (child_keep > 0) continue;
+        }
+        release_later(fs, releaser, child);
     }
-    num_dblocks_curr--;
-    // display_filesystem(fs, DISPLAY_ALL);
-    if(num_dblocks_new != 0)
-        num_dblocks_new--;
-    int curr = inode->internal.direct_data[num_dblocks_curr];
+}
 
-    while(num_dblocks_new != num_dblocks_curr)
+// cuts a tree mapped inode down to its first `keep` of `dblocks` data dblocks. the root
+// gives way to its first entry until the tree is no higher than the kept dblocks need.
+// releasing does not touch the contents of a dblock so the tree can still be followed
+static void shrink_tree(filesystem_t *fs, inode_t *inode, size_t keep, size_t dblocks)
+{
+    dblock_releaser_t releaser;
+    releaser.len = 0;
+    for (size_t n = keep; n < dblocks && n < INODE_DIRECT_BLOCK_COUNT; ++n)
+        release_later(fs, &releaser, inode->internal.direct_data[n]);
+
+    if (dblocks > INODE_DIRECT_BLOCK_COUNT)
     {
-        free_dblock(fs, curr);
-        num_dblocks_curr--;
-        curr = inode->internal.direct_data[num_dblocks_curr];
+        size_t kept = keep > INODE_DIRECT_BLOCK_COUNT ? keep - INODE_DIRECT_BLOCK_COUNT : 0;
+        size_t height = calculate_tree_height(dblocks);
+        dblock_index_t root = inode->internal.indirect_dblock;
+        shrink_tree_node(fs, &releaser, root, height, kept, dblocks - INODE_DIRECT_BLOCK_COUNT);
+        for (size_t new_height = calculate_tree_height(keep); height > new_height; --height)
+        {
+            release_later(fs, &releaser, root);
+            root = height > 1 ? *index_entry(fs, root, 0) : 0;
+        }
+        inode->internal.indirect_dblock = root;
     }
-    
-    inode->internal.file_size = new_size;
-    if (inode->internal.file_size == 0)
-    {
-        // //display_filesystem(fs, DISPLAY_INODES);
-        free_dblock(fs, inode->internal.direct_data[0]);
-        // display_filesystem(fs, DISPLAY_INODES);
+    release_dblocks(fs, releaser.batch, releaser.len);
+}
 
-    }
-    return SUCCESS;
+fs_retcode_t inode_shrink_data(filesystem_t *fs, inode_t *inode, size_t new_size)
+{
     //check to see if inputs are in valid range
+    if(!fs || !inode) return INVALID_INPUT;
+    if(new_size > inode->internal.file_size) return INVALID_INPUT;
 
     //Calculate how many blocks to remove
+    size_t keep = data_dblock_amount(new_size);
+    size_t dblocks = data_dblock_amount(inode->internal.file_size);
 
-    //helper function to free all indirect blocks
-
-    //remove the remaining direct dblocks
+    if (is_extent_mapped(inode) || is_tree_mapped(inode))
+    {
+        if (keep < dblocks) (is_extent_mapped(inode) ? shrink_extents : shrink_tree)(fs, inode, keep, dblocks);
+        inode->internal.file_size = new_size;
+        return SUCCESS;
+    }
 
-    //update filesize and return
+    // release the data dblocks past the new end, along with every index dblock that
+    // only lists released data dblocks. releasing does not touch the contents of a dblock
+    // so the chain can still be followed after its index dblocks are released
+    if (keep < dblocks)
+    {
+        dblock_index_t batch[DBLOCK_BATCH_SIZE];
+        size_t batch_len = 0;
+        block_map_pos_t pos;
+        map_seek(fs, inode, keep, &pos);
+        while (1)
+        {
+            if (batch_len + 2 > DBLOCK_BATCH_SIZE)
+            {
+                release_dblocks(fs, batch, batch_len);
+                batch_len = 0;
+            }
+            if (starts_index_dblock(pos.n)) batch[batch_len++] = pos.index_dblock;
+            batch[batch_len++] = *map_entry(fs, inode, &pos);
+            if (pos.n + 1 == dblocks) break;
+            map_next(fs, inode, &pos);
+        }
+        release_dblocks(fs, batch, batch_len);
 
+        // the cached chain ends with the last index dblock still in use
+        block_map_cache_t *cache = map_cache(fs, inode);
+        if (cache) block_map_cache_truncate(cache, inode - fs->inodes, keep > INODE_DIRECT_BLOCK_COUNT ? chain_position(keep - 1) + 1 : 0);
+    }
 
+    //update filesize and return
+    inode->internal.file_size = new_size;
+    return SUCCESS;
 }
 
 // make new_size to 0
 fs_retcode_t inode_release_data(filesystem_t *fs, inode_t *inode)
 {
-
-    return inode_shrink_data(fs, inode, 0);
-    
     //shrink to size 0
+    return inode_shrink_data(fs, inode, 0);
 }
@@ -1,5 +1,6 @@
 #include "filesys.h"
 #include "utility.h"
+#include "bitmap.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -17,6 +18,17 @@
 #define INDIRECT_DBLOCK_MAX_DATA_SIZE ( DATA_BLOCK_SIZE * INDIRECT_DBLOCK_INDEX_COUNT )
 #define NEXT_INDIRECT_INDEX_OFFSET (DATA_BLOCK_SIZE - sizeof(dblock_index_t))
 #define DBLOCK_DISPLAY_LEN 16
+#define BITMASK_WORD_BITS 64
+
+// "FSX1" read as a little endian uint32_t, marks the optional trailer after the dblocks
+#define FS_TRAILER_MAGIC 0x31585346u
+#define FS_KNOWN_FEATURES (FS_FEATURE_INODE_BITMAP | FS_FEATURE_EXTENT_TREE | FS_FEATURE_EXTENT_MAP | FS_FEATURE_INDIRECT_TREE)
+
+typedef struct fs_trailer
+{
+    uint32_t magic;
+    uint32_t features; // fs_feature_t flags
+} fs_trailer_t;
 
 const char *fs_retcode_string_table[FS_RETCODE_TOTAL] = {
     "Success",
@@ -68,16 +80,47 @@ static void display_direct_dblock_indices(filesystem_t *fs, inode_t *node)
     }
 }
 
-static void set_inode_mask(filesystem_t *fs, byte *mask)
+// the (start, length) pair of extent i of an extent mapped inode, see `INODE_EXTENT_MAPPED`.
+// `map_blk_idx` starts out as the indirect dblock and follows the chain of extent dblocks as
+// i counts up from 0. returns NULL at a corrupt chain or an empty extent, which would never
+// reach the end of the file
+static const dblock_index_t *extent_record(filesystem_t *fs, inode_t *node, size_t i, dblock_index_t *map_blk_idx)
 {
-    inode_index_t iter = fs->available_inode;
-    while (iter != 0)
+    const dblock_index_t *extent;
+    if (i < INODE_INLINE_EXTENT_COUNT) extent = &node->internal.direct_data[2 * i];
+    else
     {
-        mask[iter / 8] |= 1 << (iter % 8);
-        iter = fs->inodes[iter].next_free_inode;
+        size_t slot = (i - INODE_INLINE_EXTENT_COUNT) % EXTENT_DBLOCK_RECORD_COUNT;
+        if (slot == 0 && i > INODE_INLINE_EXTENT_COUNT)
+            *map_blk_idx = *cast_dblock_ptr(&fs->dblocks[ *map_blk_idx * DATA_BLOCK_SIZE + NEXT_INDIRECT_INDEX_OFFSET ]);
+        if (*map_blk_idx >= fs->dblock_count) return NULL;
+        extent = cast_dblock_ptr(&fs->dblocks[ *map_blk_idx * DATA_BLOCK_SIZE + slot * 3 * sizeof(dblock_index_t) ]);
+    }
+    return extent[1] ? extent : NULL;
+}
+
+static void display_extents(filesystem_t *fs, inode_t *node)
+{
+    size_t dblocks_needed = (node->internal.file_size + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE;
+    dblock_index_t map_blk_idx = node->internal.indirect_dblock;
+    size_t n = 0;
+    for (size_t i = 0; n < dblocks_needed; ++i)
+    {
+        const dblock_index_t *extent = extent_record(fs, node, i, &map_blk_idx);
+        if (!extent) return;
+        printf("%u+%u ", extent[0], extent[1]);
+        n += extent[1];
     }
 }
 
+// copies the free inode bits into `mask`, which holds inode n in bit n % 8 of byte n / 8
+static void set_inode_mask(filesystem_t *fs, byte *mask)
+{
+    size_t mask_size = (fs->inode_count + 7) / 8;
+    for (size_t i = 0; i < mask_size; ++i)
+        mask[i] = (byte)(fs->inode_free_bits[i / 8] >> (i % 8 * 8));
+}
+
 static void display_indirect_dblock_indices(filesystem_t *fs, inode_t *node)
 {
     size_t file_size = node->internal.file_size;
@@ -106,6 +149,33 @@ static void display_indirect_dblock_indices(filesystem_t *fs, inode_t *node)
     };  
 }
 
+// prints the dblocks below the tree node `idx` at `level`, 1 for a leaf, the index dblocks
+// if `index_dblocks` is set and the data dblocks otherwise. `n` counts the data dblocks
+// listed so far and stops the walk at `dblocks_needed`, as does a corrupt index
+static void display_tree_node(filesystem_t *fs, dblock_index_t idx, size_t level, size_t *n, size_t dblocks_needed, int index_dblocks)
+{
+    if (idx >= fs->dblock_count) return;
+    if (index_dblocks) printf("%u ", idx);
+    for (size_t slot = 0; slot < INODE_TREE_FANOUT && *n < dblocks_needed; ++slot)
+    {
+        dblock_index_t child = *cast_dblock_ptr(&fs->dblocks[ idx * DATA_BLOCK_SIZE + slot * sizeof(dblock_index_t) ]);
+        if (level > 1)
+        {
+            display_tree_node(fs, child, level - 1, n, dblocks_needed, index_dblocks);
+            continue;
+        }
+        if (!index_dblocks) printf("%u ", child);
+        ++*n;
+    }
+}
+
+static void display_tree_indices(filesystem_t *fs, inode_t *node, int index_dblocks)
+{
+    size_t dblocks_needed = (node->internal.file_size + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE;
+    size_t n = INODE_DIRECT_BLOCK_COUNT;
+    display_tree_node(fs, node->internal.indirect_dblock, calculate_tree_height(dblocks_needed), &n, dblocks_needed, index_dblocks);
+}
+
 static void display_indirect_index_indices(filesystem_t *fs, inode_t *node)
 {
     size_t file_size = node->internal.file_size;
@@ -130,6 +200,30 @@ static void display_indirect_index_indices(filesystem_t *fs, inode_t *node)
     };  
 }
 
+// walks the free inode list to count it. returns 0 if the list leaves the inode table
+// or loops back on itself, since a valid list holds at most every non root inode. classic
+// images only store the low 2 bytes of each link, the ones above them are cleared
+static int count_free_inodes(filesystem_t *fs, size_t *count)
+{
+    size_t n = 0;
+    inode_index_t iter = fs->available_inode;
+    while (iter != 0)
+    {
+        if (iter >= fs->inode_count || n == fs->inode_count - 1) return 0;
+        ++n;
+        if (fs->geometry == FS_GEOMETRY_CLASSIC) fs->inodes[iter].next_free_inode &= 0xFFFF;
+        iter = fs->inodes[iter].next_free_inode;
+    }
+    *count = n;
+    return 1;
+}
+
+static size_t count_free_dblocks(filesystem_t *fs)
+{
+    // the last byte may have bits set past the last dblock, which the range leaves out
+    return bitmap_popcount(fs->dblock_bitmask, 0, fs->dblock_count);
+}
+
 // -------------------------------- CORE FUNCTIONS -------------------------------- //
 
 // calculates the number of index dblocks used for a file size
@@ -146,6 +240,31 @@ size_t calculate_necessary_dblock_amount(size_t file_size)
     return (file_size + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE + calculate_index_dblock_amount(file_size);
 }   
 
+// the height of the index dblock tree of an `INODE_TREE_MAPPED` inode with `dblocks` data
+// dblocks, 0 while the direct slots hold all of them
+size_t calculate_tree_height(size_t dblocks)
+{
+    if (dblocks <= INODE_DIRECT_BLOCK_COUNT) return 0;
+    size_t height = 1;
+    for (size_t span = INODE_TREE_FANOUT; span < dblocks - INODE_DIRECT_BLOCK_COUNT; span *= INODE_TREE_FANOUT) ++height;
+    return height;
+}
+
+// the number of index dblocks in the tree of an `INODE_TREE_MAPPED` inode with `dblocks`
+// data dblocks, every level listing the one below it
+size_t calculate_tree_index_dblock_amount(size_t dblocks)
+{
+    if (dblocks <= INODE_DIRECT_BLOCK_COUNT) return 0;
+    size_t level = dblocks - INODE_DIRECT_BLOCK_COUNT;
+    size_t total = 0;
+    do
+    {
+        level = (level + INODE_TREE_FANOUT - 1) / INODE_TREE_FANOUT;
+        total += level;
+    } while (level > 1);
+    return total;
+}
+
 // non UB way to convert byte pointer to dblock_index_t pointer
 dblock_index_t *cast_dblock_ptr(void *addr)
 {
@@ -157,12 +276,37 @@ dblock_index_t *cast_dblock_ptr(void *addr)
     return ptr;
 }
 
+// true if an inode in use has `map_flag` set
+static int has_mapped_inode(filesystem_t *fs, uint8_t map_flag)
+{
+    for (size_t i = 0; i < fs->inode_count; ++i)
+    {
+        int available = (fs->inode_free_bits[i / BITMASK_WORD_BITS] >> (i % BITMASK_WORD_BITS)) & 1;
+        if (!available && fs->inodes[i].internal.map_flags & map_flag) return 1;
+    }
+    return 0;
+}
+
 fs_retcode_t save_filesystem(FILE* file, filesystem_t *fs)
 {
     if (!fs || !file) return INVALID_INPUT;
+    // what the magazines hold is claimed in the bitmask and the free list but not used
+    fs_drain_magazines(fs);
 
-    fwrite(&fs->inode_count, sizeof(fs->inode_count), 1, file); // write the inode count
-    fwrite(&fs->available_inode, sizeof(fs->available_inode), 1, file); // write the next available inode
+    // the geometry decides how wide the next available inode is, and is flagged in the inode count
+    if (fs->geometry == FS_GEOMETRY_LARGE)
+    {
+        size_t inode_count = fs->inode_count | FS_LARGE_GEOMETRY_FLAG;
+        uint32_t available_inode = fs->available_inode;
+        fwrite(&inode_count, sizeof(inode_count), 1, file); // write the inode count
+        fwrite(&available_inode, sizeof(available_inode), 1, file); // write the next available inode
+    }
+    else
+    {
+        uint16_t available_inode = fs->available_inode;
+        fwrite(&fs->inode_count, sizeof(fs->inode_count), 1, file); // write the inode count
+        fwrite(&available_inode, sizeof(available_inode), 1, file); // write the next available inode
+    }
     fwrite(&fs->dblock_count, sizeof(fs->dblock_count), 1, file); // write the dblock count
 
     fwrite(fs->inodes, sizeof(inode_t), fs->inode_count, file); // write the inodes to file
@@ -172,32 +316,160 @@ fs_retcode_t save_filesystem(FILE* file, filesystem_t *fs)
 
     fwrite(fs->dblocks, DATA_BLOCK_SIZE, fs->dblock_count, file); // write the data blocks
 
+    // the trailer is only written when a feature needs it, so plain images stay as they were
+    fs_trailer_t trailer = { FS_TRAILER_MAGIC, 0 };
+    if (fs->inode_alloc_mode == INODE_BITMAP) trailer.features |= FS_FEATURE_INODE_BITMAP;
+    if (fs->dblock_alloc_mode == DBLOCK_EXTENT_TREE) trailer.features |= FS_FEATURE_EXTENT_TREE;
+    if (has_mapped_inode(fs, INODE_EXTENT_MAPPED)) trailer.features |= FS_FEATURE_EXTENT_MAP;
+    if (has_mapped_inode(fs, INODE_TREE_MAPPED)) trailer.features |= FS_FEATURE_INDIRECT_TREE;
+    if (trailer.features) fwrite(&trailer, sizeof(trailer), 1, file);
+
     return SUCCESS;
 }
 
+size_t directory_entry_size(const filesystem_t *fs)
+{
+    return fs->geometry == FS_GEOMETRY_LARGE ? LARGE_DIRECTORY_ENTRY_SIZE : CLASSIC_DIRECTORY_ENTRY_SIZE;
+}
+
+// bytes the inode index takes at the start of a directory entry
+static size_t directory_entry_index_size(const filesystem_t *fs)
+{
+    return fs->geometry == FS_GEOMETRY_LARGE ? sizeof(uint32_t) : sizeof(uint16_t);
+}
+
+inode_index_t directory_entry_inode(const filesystem_t *fs, const byte *entry)
+{
+    if (fs->geometry == FS_GEOMETRY_LARGE)
+    {
+        uint32_t index;
+        memcpy(&index, entry, sizeof(index));
+        return index;
+    }
+    uint16_t index;
+    memcpy(&index, entry, sizeof(index));
+    return index;
+}
+
+const char *directory_entry_name(const filesystem_t *fs, const byte *entry)
+{
+    return (const char *)entry + directory_entry_index_size(fs);
+}
+
+void write_directory_entry(const filesystem_t *fs, byte *entry, inode_index_t inode, const char *name)
+{
+    memset(entry, 0, directory_entry_size(fs));
+    if (fs->geometry == FS_GEOMETRY_LARGE)
+    {
+        uint32_t index = inode;
+        memcpy(entry, &index, sizeof(index));
+    }
+    else
+    {
+        uint16_t index = inode;
+        memcpy(entry, &index, sizeof(index));
+    }
+    strncpy((char *)entry + directory_entry_index_size(fs), name, MAX_FILE_NAME_LEN - 1);
+}
+
 fs_retcode_t load_filesystem(FILE* file, filesystem_t *fs)
 {
     if (!fs || !file) return INVALID_INPUT;
+    // nothing is allocated yet, so `free_filesystem` is safe even if loading fails
+    fs->inodes = NULL;
+    fs->inode_arena_cap = 0;
+    fs->dblock_bitmask = NULL;
+    fs->dblocks = NULL;
+    fs->dblock_hints = NULL;
+    fs->dblock_summary = NULL;
+    fs->dblock_summary_top = NULL;
+    fs->groups = NULL;
+    fs->inode_free_bits = NULL;
+    fs->inode_free_prev = NULL;
+    fs->magazines = NULL;
+    fs->magazine_size = 0;
+    fs->magazine_stamp = 0;
+    fs->magazine_lock = 0;
+    fs->extents = NULL;
+    fs->extents_stale = 0;
+    fs->buddy = NULL;
+    fs->buddy_stale = 0;
+    fs->extent_map_files = 0;
+    fs->tree_map_files = 0;
+    fs->map_cache_budget = 0;
+    fs->map_cache = NULL;
+    fs->lazy_zero = 0;
+    fs->dblock_needs_zero = NULL;
+    fs->allocator = dblock_allocator_for_mode(DBLOCK_FIRST_FIT);
+    fs->alloc_stats = NULL;
     // read the inode count 
     if (fread(&fs->inode_count, sizeof(fs->inode_count), 1, file) != 1) return INVALID_BINARY_FORMAT;
-    // read the next available inode
-    if (fread(&fs->available_inode, sizeof(fs->available_inode), 1, file) != 1) return INVALID_BINARY_FORMAT; 
+    // read the next available inode, as wide as the geometry flagged in the inode count says
+    fs->geometry = fs->inode_count & FS_LARGE_GEOMETRY_FLAG ? FS_GEOMETRY_LARGE : FS_GEOMETRY_CLASSIC;
+    fs->inode_count &= ~FS_LARGE_GEOMETRY_FLAG;
+    if (fs->geometry == FS_GEOMETRY_LARGE)
+    {
+        uint32_t available_inode;
+        if (fread(&available_inode, sizeof(available_inode), 1, file) != 1) return INVALID_BINARY_FORMAT;
+        fs->available_inode = available_inode;
+    }
+    else
+    {
+        uint16_t available_inode;
+        if (fread(&available_inode, sizeof(available_inode), 1, file) != 1) return INVALID_BINARY_FORMAT;
+        fs->available_inode = available_inode;
+    }
+    size_t max_inode_count = fs->geometry == FS_GEOMETRY_LARGE ? LARGE_MAX_INODE_COUNT : CLASSIC_MAX_INODE_COUNT;
+    if (fs->inode_count == 0 || fs->inode_count > max_inode_count) return INVALID_BINARY_FORMAT;
     // read the dblock count
     if (fread(&fs->dblock_count, sizeof(fs->dblock_count), 1, file) != 1) return INVALID_BINARY_FORMAT; 
 
-    fs->inodes = malloc(fs->inode_count * sizeof(inode_t));
+    fs->inodes = map_inodes(fs->geometry, fs->inode_count, &fs->inode_arena_cap);
+    if (!fs->inodes) return SYSTEM_ERROR;
     // read the inodes
     if (fread(fs->inodes, sizeof(inode_t), fs->inode_count, file) != fs->inode_count) return INVALID_BINARY_FORMAT; 
 
     size_t block_bitmask_size = DBLOCK_MASK_SIZE(fs->dblock_count);
-    fs->dblock_bitmask = malloc(block_bitmask_size * sizeof(byte));
+    // padded to whole uint64_t words like new_filesystem does
+    fs->dblock_bitmask = calloc((block_bitmask_size + sizeof(uint64_t) - 1) / sizeof(uint64_t), sizeof(uint64_t));
     // read the data blocks
     if (fread(fs->dblock_bitmask, sizeof(byte), block_bitmask_size, file) != block_bitmask_size) return INVALID_BINARY_FORMAT; 
 
-    fs->dblocks = malloc(fs->dblock_count * DATA_BLOCK_SIZE);
+    fs->dblocks = map_dblocks(fs->dblock_count);
+    if (!fs->dblocks) return SYSTEM_ERROR;
     // read the data blocks
     if (fread(fs->dblocks, DATA_BLOCK_SIZE, fs->dblock_count, file) != fs->dblock_count) return INVALID_BINARY_FORMAT; 
 
+    // read the optional trailer, refusing features this code does not know about
+    fs_trailer_t trailer = { FS_TRAILER_MAGIC, 0 };
+    size_t trailer_size = fread(&trailer, 1, sizeof(trailer), file);
+    if (trailer_size != 0 && (trailer_size != sizeof(trailer) || trailer.magic != FS_TRAILER_MAGIC)) return INVALID_BINARY_FORMAT;
+    if (trailer.features & ~(uint32_t) FS_KNOWN_FEATURES) return INVALID_BINARY_FORMAT;
+    // older images may have anything in the byte `map_flags` took over from the padding, so
+    // only the flags of the features the image lists are kept
+    uint8_t map_flags = (trailer.features & FS_FEATURE_EXTENT_MAP ? INODE_EXTENT_MAPPED : 0) |
+        (trailer.features & FS_FEATURE_INDIRECT_TREE ? INODE_TREE_MAPPED : 0);
+    for (size_t i = 0; i < fs->inode_count; ++i) fs->inodes[i].internal.map_flags &= map_flags;
+
+    // the rest of the allocator state is not part of the binary format
+    fs->dblock_alloc_mode = DBLOCK_FIRST_FIT;
+    fs->dblock_cursor = 0;
+    fs->prealloc_window = 0;
+    fs->delayed_alloc = 0;
+    if (!count_free_inodes(fs, &fs->free_inode_count)) return INVALID_BINARY_FORMAT;
+    fs->free_dblock_count = count_free_dblocks(fs);
+    fs->unreserved_inode_count = fs->free_inode_count;
+    fs->unreserved_dblock_count = fs->free_dblock_count;
+    if (rebuild_dblock_summary(fs) != SUCCESS) return SYSTEM_ERROR;
+    fs->inode_alloc_mode = trailer.features & FS_FEATURE_INODE_BITMAP ? INODE_BITMAP : INODE_FREE_LIST;
+    fs->group_dblock_count = 0;
+    if (rebuild_block_groups(fs) != SUCCESS) return SYSTEM_ERROR;
+    fs->dblock_needs_zero = calloc((fs->dblock_count + BITMASK_WORD_BITS - 1) / BITMASK_WORD_BITS, sizeof(uint64_t));
+    if (!fs->dblock_needs_zero) return SYSTEM_ERROR;
+    // the extent tree is never saved, only the bitmask it is built from
+    if (trailer.features & FS_FEATURE_EXTENT_TREE &&
+        set_dblock_allocator(fs, dblock_allocator_for_mode(DBLOCK_EXTENT_TREE)) != SUCCESS) return SYSTEM_ERROR;
+
     return SUCCESS;
 }
 
@@ -255,7 +527,13 @@ void display_filesystem(filesystem_t *fs, fs_display_flag_t flag)
 
                 size_t file_size = inode->internal.file_size;
 
-                if (file_size > 0)
+                if (file_size > 0 && inode->internal.map_flags & INODE_EXTENT_MAPPED)
+                {
+                    printf("\t\tExtents: ");
+                    display_extents(fs, inode);
+                    puts("");
+                }
+                else if (file_size > 0)
                 {
                     printf("\t\tDirect Data Blocks: ");
                     display_direct_dblock_indices(fs, inode);
@@ -263,12 +541,15 @@ void display_filesystem(filesystem_t *fs, fs_display_flag_t flag)
                     
                     if (file_size > DATA_BLOCK_SIZE * INODE_DIRECT_BLOCK_COUNT)
                     {
+                        int tree = inode->internal.map_flags & INODE_TREE_MAPPED;
                         printf("\t\tIndirect Data Blocks: ");
-                        display_indirect_dblock_indices(fs, inode);
+                        if (tree) display_tree_indices(fs, inode, 0);
+                        else display_indirect_dblock_indices(fs, inode);
                         puts("");
 
-                        printf("\t\tIndirect Index Blocks: ");
-                        display_indirect_index_indices(fs, inode);
+                        printf(tree ? "\t\tTree Index Blocks: " : "\t\tIndirect Index Blocks: ");
+                        if (tree) display_tree_indices(fs, inode, 1);
+                        else display_indirect_index_indices(fs, inode);
                         puts("");
                     }
                 }
@@ -299,6 +580,230 @@ void display_filesystem(filesystem_t *fs, fs_display_flag_t flag)
     }
 }
 
+// tracks the contiguous runs formed by a sequence of dblocks
+struct dblock_run_count
+{
+    size_t dblocks;
+    size_t runs;
+    dblock_index_t last;
+};
+
+// called with every dblock of an inode. `n` is the number of the data dblock in the file,
+// or SIZE_MAX for an index dblock
+typedef void (*dblock_visitor_t)(void *arg, dblock_index_t idx, size_t n);
+
+static void count_dblock(void *arg, dblock_index_t idx, size_t n)
+{
+    struct dblock_run_count *count = arg;
+    if (count->dblocks == 0 || idx != count->last + 1) ++count->runs;
+    count->last = idx;
+    ++count->dblocks;
+}
+
+// visits the dblocks of an extent mapped inode in file order, every extent dblock ahead of
+// the extents it holds
+static void visit_extent_dblocks(filesystem_t *fs, inode_t *node, dblock_visitor_t visit, void *arg)
+{
+    size_t dblocks_needed = (node->internal.file_size + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE;
+
+    dblock_index_t map_blk_idx = node->internal.indirect_dblock;
+    size_t n = 0;
+    for (size_t i = 0; n < dblocks_needed; ++i)
+    {
+        const dblock_index_t *extent = extent_record(fs, node, i, &map_blk_idx);
+        if (!extent) return;
+        if (i >= INODE_INLINE_EXTENT_COUNT && (i - INODE_INLINE_EXTENT_COUNT) % EXTENT_DBLOCK_RECORD_COUNT == 0)
+            visit(arg, map_blk_idx, SIZE_MAX);
+        for (size_t k = 0; k < extent[1] && n < dblocks_needed; ++k) visit(arg, extent[0] + k, n++);
+    }
+}
+
+// visits the tree node `idx` at `level`, 1 for a leaf, and then the dblocks below it in
+// file order. `n` counts the data dblocks visited and stops the walk at `dblocks_needed`
+static void visit_tree_node(filesystem_t *fs, dblock_index_t idx, size_t level, size_t *n, size_t dblocks_needed, dblock_visitor_t visit, void *arg)
+{
+    // stop at a corrupt tree rather than reading past the dblocks
+    if (idx >= fs->dblock_count) return;
+    visit(arg, idx, SIZE_MAX);
+    for (size_t slot = 0; slot < INODE_TREE_FANOUT && *n < dblocks_needed; ++slot)
+    {
+        dblock_index_t child = *cast_dblock_ptr(&fs->dblocks[ idx * DATA_BLOCK_SIZE + slot * sizeof(dblock_index_t) ]);
+        if (level > 1) visit_tree_node(fs, child, level - 1, n, dblocks_needed, visit, arg);
+        else visit(arg, child, (*n)++);
+    }
+}
+
+// visits the dblocks of `node` in the order they are read. every index dblock is
+// visited ahead of the data dblocks it lists since that is also the order they are claimed
+static void visit_inode_dblocks(filesystem_t *fs, inode_t *node, dblock_visitor_t visit, void *arg)
+{
+    if (node->internal.map_flags & INODE_EXTENT_MAPPED)
+    {
+        visit_extent_dblocks(fs, node, visit, arg);
+        return;
+    }
+    size_t dblocks_needed = (node->internal.file_size + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE;
+
+    for (size_t i = 0; i < dblocks_needed && i < INODE_DIRECT_BLOCK_COUNT; ++i)
+        visit(arg, node->internal.direct_data[i], i);
+
+    if (node->internal.map_flags & INODE_TREE_MAPPED)
+    {
+        size_t n = INODE_DIRECT_BLOCK_COUNT;
+        if (dblocks_needed > n)
+            visit_tree_node(fs, node->internal.indirect_dblock, calculate_tree_height(dblocks_needed), &n, dblocks_needed, visit, arg);
+        return;
+    }
+
+    dblock_index_t index_blk_idx = node->internal.indirect_dblock;
+    for (size_t i = INODE_DIRECT_BLOCK_COUNT; i < dblocks_needed; ++i)
+    {
+        size_t indirect_idx_offset = (i - INODE_DIRECT_BLOCK_COUNT) % INDIRECT_DBLOCK_INDEX_COUNT;
+        if (indirect_idx_offset == 0)
+        {
+            if (i > INODE_DIRECT_BLOCK_COUNT)
+                index_blk_idx = *cast_dblock_ptr(&fs->dblocks[ index_blk_idx * DATA_BLOCK_SIZE + NEXT_INDIRECT_INDEX_OFFSET ]);
+            // stop at a corrupt chain rather than reading past the dblocks
+            if (index_blk_idx >= fs->dblock_count) return;
+            visit(arg, index_blk_idx, SIZE_MAX);
+        }
+        visit(arg, *cast_dblock_ptr(&fs->dblocks[ index_blk_idx * DATA_BLOCK_SIZE + indirect_idx_offset * sizeof(dblock_index_t) ]), i);
+    }
+}
+
+static void count_inode_dblock_runs(filesystem_t *fs, inode_t *node, struct dblock_run_count *count)
+{
+    count->dblocks = count->runs = 0;
+    visit_inode_dblocks(fs, node, count_dblock, count);
+}
+
+double average_dblock_run_length(filesystem_t *fs)
+{
+    if (!fs) return 0;
+
+    byte *inode_mask = calloc((fs->inode_count + 7) / 8, sizeof(byte));
+    if (!inode_mask) return 0;
+    set_inode_mask(fs, inode_mask);
+
+    size_t dblocks = 0, runs = 0;
+    for (size_t i = 0; i < fs->inode_count; ++i)
+    {
+        if (inode_mask[i / 8] & (1 << (i % 8))) continue;
+
+        struct dblock_run_count count;
+        count_inode_dblock_runs(fs, &fs->inodes[i], &count);
+        dblocks += count.dblocks;
+        runs += count.runs;
+    }
+    free(inode_mask);
+    return runs ? (double)dblocks / runs : 0;
+}
+
+// the state `fs_check` keeps while it walks the directory tree
+struct fs_check_walk
+{
+    filesystem_t *fs;
+    fs_check_report_t *report;
+    byte *referenced;           // dblock bitmap in the layout of `dblock_bitmask`
+    uint64_t *reached;          // inode bitmap in the layout of `inode_free_bits`
+    inode_index_t *stack;       // directories reached but not read yet
+    size_t stack_len;
+    inode_t *node;              // the inode whose dblocks are being visited
+};
+
+static void reach_inode(struct fs_check_walk *walk, inode_index_t idx)
+{
+    uint64_t bit = (uint64_t) 1 << (idx % BITMASK_WORD_BITS);
+    if (walk->reached[idx / BITMASK_WORD_BITS] & bit) return;
+    walk->reached[idx / BITMASK_WORD_BITS] |= bit;
+    walk->stack[walk->stack_len++] = idx;
+}
+
+// marks a dblock of `walk->node` as referenced and, for directories, reaches the inodes
+// listed in it
+static void check_dblock(void *arg, dblock_index_t idx, size_t n)
+{
+    struct fs_check_walk *walk = arg;
+    filesystem_t *fs = walk->fs;
+    if (idx >= fs->dblock_count)
+    {
+        ++walk->report->invalid_references;
+        return;
+    }
+
+    byte bit = 1 << (7 - idx % 8);
+    if (walk->referenced[idx / 8] & bit) ++walk->report->shared_dblocks;
+    walk->referenced[idx / 8] |= bit;
+    if (n == SIZE_MAX || walk->node->internal.file_type != DIRECTORY) return;
+
+    size_t size = walk->node->internal.file_size - n * DATA_BLOCK_SIZE;
+    if (size > DATA_BLOCK_SIZE) size = DATA_BLOCK_SIZE;
+    size_t entry_size = directory_entry_size(fs);
+    for (size_t offset = 0; offset + entry_size <= size; offset += entry_size)
+    {
+        const byte *entry = &fs->dblocks[idx * DATA_BLOCK_SIZE + offset];
+        const char *name = directory_entry_name(fs, entry);
+        if (name[0] == '\0' || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+        inode_index_t child = directory_entry_inode(fs, entry);
+        if (child >= fs->inode_count) ++walk->report->invalid_references;
+        else reach_inode(walk, child);
+    }
+}
+
+fs_retcode_t fs_check(filesystem_t *fs, fs_check_report_t *report)
+{
+    if (!fs || !report) return INVALID_INPUT;
+    memset(report, 0, sizeof(*report));
+
+    size_t mask_size = DBLOCK_MASK_SIZE(fs->dblock_count);
+    size_t inode_words = (fs->inode_count + BITMASK_WORD_BITS - 1) / BITMASK_WORD_BITS;
+    struct fs_check_walk walk = { fs, report, calloc(mask_size, 1), calloc(inode_words, sizeof(uint64_t)),
+        malloc(fs->inode_count * sizeof(inode_index_t)), 0, NULL };
+    byte *scratch = malloc(mask_size);
+    if (!walk.referenced || !walk.reached || !walk.stack || !scratch)
+    {
+        free(walk.referenced);
+        free(walk.reached);
+        free(walk.stack);
+        free(scratch);
+        return SYSTEM_ERROR;
+    }
+
+    // every inode is pushed at most once, so the stack never overflows
+    reach_inode(&walk, 0);
+    while (walk.stack_len > 0)
+    {
+        walk.node = &fs->inodes[walk.stack[--walk.stack_len]];
+        visit_inode_dblocks(fs, walk.node, check_dblock, &walk);
+    }
+
+    for (size_t w = 0; w < inode_words; ++w)
+    {
+        uint64_t valid = fs->inode_count - w * BITMASK_WORD_BITS < BITMASK_WORD_BITS ?
+            ((uint64_t) 1 << (fs->inode_count - w * BITMASK_WORD_BITS)) - 1 : ~(uint64_t) 0;
+        report->reachable_inodes += __builtin_popcountll(walk.reached[w]);
+        report->orphan_inodes += __builtin_popcountll(~walk.reached[w] & ~fs->inode_free_bits[w] & valid);
+        report->free_reachable_inodes += __builtin_popcountll(walk.reached[w] & fs->inode_free_bits[w]);
+    }
+
+    // compare the referenced dblocks against the bitmask a whole bitmap at a time
+    report->referenced_dblocks = bitmap_popcount(walk.referenced, 0, fs->dblock_count);
+    for (size_t i = 0; i < mask_size; ++i) scratch[i] = ~(fs->dblock_bitmask[i] | walk.referenced[i]);
+    report->leaked_dblocks = bitmap_popcount(scratch, 0, fs->dblock_count);
+    for (size_t i = 0; i < mask_size; ++i) scratch[i] = fs->dblock_bitmask[i] & walk.referenced[i];
+    report->free_referenced_dblocks = bitmap_popcount(scratch, 0, fs->dblock_count);
+
+    free(walk.referenced);
+    free(walk.reached);
+    free(walk.stack);
+    free(scratch);
+
+    int consistent = !report->orphan_inodes && !report->free_reachable_inodes && !report->leaked_dblocks &&
+        !report->free_referenced_dblocks && !report->shared_dblocks && !report->invalid_references;
+    return consistent ? SUCCESS : INVALID_BINARY_FORMAT;
+}
+
 
 
 
@@ -6,6 +6,8 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
 extern "C"
@@ -22,6 +24,9 @@ extern "C"
 
 void compare_fs_files(char *output_buf, size_t output_size, char *expected_buf, size_t expected_size);
 
+// whether bit `n` of a bitmask is set, counting from the most significant bit of each byte
+bool bit_is_set(const std::vector<uint8_t> &bits, size_t n);
+
 template<typename Test>
 struct stdout_logger_lock
 {
@@ -61,4 +61,24 @@ TEST_F(AvailableDBlocksSuite, Test4)
 
     ASSERT_EQ(expected_val, output_val);
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// the count is maintained by claiming and releasing dblocks
+TEST_F(AvailableDBlocksSuite, Test5)
+{
+    filesystem_t fs;
+    load_fs(INPUT "medium.bin", fs);
+
+    dblock_index_t idx0, idx1;
+    ASSERT_EQ(claim_available_dblock(&fs, &idx0), SUCCESS);
+    ASSERT_EQ(claim_available_dblock(&fs, &idx1), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 8);
+
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[idx0 * DATA_BLOCK_SIZE]), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 9);
+
+    // releasing an already available dblock does not change the count
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[idx0 * DATA_BLOCK_SIZE]), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 9);
+    free_filesystem(&fs);
+}
@@ -61,4 +61,37 @@ TEST_F(AvailableInodesSuite, Test4)
 
     ASSERT_EQ(expected_val, output_val);
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// the count is maintained by claiming and releasing inodes
+TEST_F(AvailableInodesSuite, Test5)
+{
+    filesystem_t fs;
+    load_fs(INPUT "medium.bin", fs);
+
+    inode_index_t idx0, idx1;
+    ASSERT_EQ(claim_available_inode(&fs, &idx0), SUCCESS);
+    ASSERT_EQ(claim_available_inode(&fs, &idx1), SUCCESS);
+    ASSERT_EQ(available_inodes(&fs), 4);
+
+    ASSERT_EQ(release_inode(&fs, &fs.inodes[idx0]), SUCCESS);
+    ASSERT_EQ(available_inodes(&fs), 5);
+    free_filesystem(&fs);
+}
+
+// a free inode list that loops back on itself cannot be counted and is rejected on load
+TEST_F(AvailableInodesSuite, CorruptFreeList0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "medium.bin", fs);
+
+    inode_index_t head = fs.available_inode;
+    fs.inodes[head].next_free_inode = head;
+    ASSERT_EQ(save_filesystem(output_file, &fs), SUCCESS);
+    free_filesystem(&fs);
+
+    rewind(output_file);
+    filesystem_t corrupt;
+    ASSERT_EQ(load_filesystem(output_file, &corrupt), INVALID_BINARY_FORMAT);
+    free_filesystem(&corrupt);
+}
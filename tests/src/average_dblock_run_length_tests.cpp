@@ -0,0 +1,37 @@
+#include "test_util.hpp"
+
+using AverageDBlockRunLengthSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(AverageDBlockRunLengthSuite, InvalidInput)
+{
+    ASSERT_EQ(average_dblock_run_length(NULL), 0);
+}
+
+// only the root directory uses a dblock
+TEST_F(AverageDBlockRunLengthSuite, Empty0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 4, 16);
+    ASSERT_EQ(average_dblock_run_length(&fs), 1);
+    free_filesystem(&fs);
+}
+
+// root uses dblocks 0 and 45, every other file is contiguous including the index
+// dblocks of large.txt. 46 dblocks form 7 runs
+TEST_F(AverageDBlockRunLengthSuite, Large0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "large.bin", fs);
+    ASSERT_DOUBLE_EQ(average_dblock_run_length(&fs), 46.0 / 7);
+    free_filesystem(&fs);
+}
+
+// root uses dblocks 0 and 18, the other 6 files are contiguous. 29 dblocks form 8 runs
+TEST_F(AverageDBlockRunLengthSuite, MediumText0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "medium_text.bin", fs);
+    ASSERT_DOUBLE_EQ(average_dblock_run_length(&fs), 29.0 / 8);
+    free_filesystem(&fs);
+}
@@ -0,0 +1,78 @@
+#include "test_util.hpp"
+
+#include <random>
+#include <vector>
+
+extern "C"
+{
+    #include "bitmap.h"
+}
+
+using BitmapFindFirstSetSuite = fs_internal_test;
+
+// sparse bitmaps leave long stretches for the vector kernels to skip
+TEST_F(BitmapFindFirstSetSuite, MatchesReference0)
+{
+    std::mt19937 rng(2);
+    std::vector<uint8_t> bits(1031);
+    for (auto &b : bits) b = rng() % 64 == 0 ? 1 << (rng() % 8) : 0;
+    size_t bit_total = bits.size() * 8;
+
+    bitmap_isa_t original = bitmap_active_isa();
+    for (bitmap_isa_t isa : { BITMAP_ISA_PORTABLE, BITMAP_ISA_SSE42, BITMAP_ISA_AVX2 })
+    {
+        if (bitmap_select_isa(isa) != 0) continue;
+        for (int trial = 0; trial < 200; ++trial)
+        {
+            size_t from = rng() % bit_total, to = rng() % (bit_total + 1);
+            size_t expected = to;
+            for (size_t n = from; n < to && expected == to; ++n)
+                if (bit_is_set(bits, n)) expected = n;
+
+            size_t found = to;
+            int ret = bitmap_find_first_set(bits.data(), from, to, &found);
+            ASSERT_EQ(ret, expected < to) << "Return values do not match with " << bitmap_isa_string_table[isa];
+            ASSERT_EQ(found, expected) << "Bits found do not match for [" << from << ", " << to << ")";
+        }
+    }
+    bitmap_select_isa(original);
+}
+
+// clear bits are searched for the same way in a mostly full bitmap
+TEST_F(BitmapFindFirstSetSuite, FindFirstClear0)
+{
+    std::mt19937 rng(3);
+    std::vector<uint8_t> bits(1031);
+    for (auto &b : bits) b = rng() % 64 == 0 ? (uint8_t)~(1 << (rng() % 8)) : 0xFF;
+    size_t bit_total = bits.size() * 8;
+
+    bitmap_isa_t original = bitmap_active_isa();
+    for (bitmap_isa_t isa : { BITMAP_ISA_PORTABLE, BITMAP_ISA_SSE42, BITMAP_ISA_AVX2 })
+    {
+        if (bitmap_select_isa(isa) != 0) continue;
+        for (int trial = 0; trial < 200; ++trial)
+        {
+            size_t from = rng() % bit_total, to = rng() % (bit_total + 1);
+            size_t expected = to;
+            for (size_t n = from; n < to && expected == to; ++n)
+                if (!bit_is_set(bits, n)) expected = n;
+
+            size_t found = to;
+            int ret = bitmap_find_first_clear(bits.data(), from, to, &found);
+            ASSERT_EQ(ret, expected < to) << "Return values do not match with " << bitmap_isa_string_table[isa];
+            ASSERT_EQ(found, expected) << "Bits found do not match for [" << from << ", " << to << ")";
+        }
+    }
+    bitmap_select_isa(original);
+}
+
+// a set bit past the end of the range in the last byte is not reported
+TEST_F(BitmapFindFirstSetSuite, RangeEnd0)
+{
+    uint8_t bits[] = { 0x00, 0x01 };
+    size_t found;
+    ASSERT_EQ(bitmap_find_first_set(bits, 0, 15, &found), 0);
+    ASSERT_EQ(bitmap_find_first_set(bits, 0, 16, &found), 1);
+    ASSERT_EQ(found, 15);
+    ASSERT_EQ(bitmap_find_first_set(bits, 0, 16, NULL), 0);
+}
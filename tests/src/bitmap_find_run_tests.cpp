@@ -0,0 +1,72 @@
+#include "test_util.hpp"
+
+#include <random>
+#include <vector>
+
+extern "C"
+{
+    #include "bitmap.h"
+}
+
+using BitmapFindRunSuite = fs_internal_test;
+
+// runs of every length are found where a bit by bit scan finds them
+TEST_F(BitmapFindRunSuite, MatchesReference0)
+{
+    std::mt19937 rng(4);
+    std::vector<uint8_t> bits(613);
+    // runs of set and clear bits of random lengths
+    size_t bit_total = bits.size() * 8;
+    for (size_t n = 0; n < bit_total;)
+    {
+        bool set = rng() % 2;
+        size_t len = 1 + rng() % 100;
+        for (; len > 0 && n < bit_total; --len, ++n)
+            if (set) bits[n / 8] |= 1 << (7 - n % 8);
+    }
+
+    for (int trial = 0; trial < 300; ++trial)
+    {
+        size_t from = rng() % bit_total, to = from + rng() % (bit_total - from + 1);
+        size_t run = 1 + rng() % 120;
+
+        size_t expected = to, expected_count = 0;
+        for (size_t n = from; n < to;)
+        {
+            if (!bit_is_set(bits, n))
+            {
+                ++n;
+                continue;
+            }
+            size_t end = n;
+            while (end < to && bit_is_set(bits, end)) ++end;
+            if (end - n >= run)
+            {
+                if (expected == to) expected = n;
+                ++expected_count;
+            }
+            n = end;
+        }
+
+        size_t found = to;
+        ASSERT_EQ(bitmap_find_run(bits.data(), from, to, run, &found), expected < to)
+            << "Return values do not match for [" << from << ", " << to << ") run " << run;
+        ASSERT_EQ(found, expected) << "Runs found do not match for [" << from << ", " << to << ") run " << run;
+        ASSERT_EQ(bitmap_count_runs(bits.data(), from, to, run), expected_count)
+            << "Run counts do not match for [" << from << ", " << to << ") run " << run;
+    }
+}
+
+// the run has to fit inside the range
+TEST_F(BitmapFindRunSuite, RangeEnd0)
+{
+    uint8_t bits[] = { 0x0F, 0xF0 };
+    size_t found;
+    ASSERT_EQ(bitmap_find_run(bits, 0, 16, 8, &found), 1);
+    ASSERT_EQ(found, 4);
+    ASSERT_EQ(bitmap_find_run(bits, 0, 11, 8, &found), 0);
+    ASSERT_EQ(bitmap_find_run(bits, 5, 16, 8, &found), 0);
+    ASSERT_EQ(bitmap_find_run(bits, 0, 16, 0, &found), 0);
+    ASSERT_EQ(bitmap_count_runs(bits, 0, 16, 1), 1);
+    ASSERT_EQ(bitmap_count_runs(bits, 0, 10, 4), 1);
+}
@@ -0,0 +1,46 @@
+#include "test_util.hpp"
+
+#include <random>
+#include <vector>
+
+extern "C"
+{
+    #include "bitmap.h"
+}
+
+using BitmapPopcountSuite = fs_internal_test;
+
+// every instruction set the processor has counts the same as a bit by bit loop
+TEST_F(BitmapPopcountSuite, MatchesReference0)
+{
+    std::mt19937 rng(1);
+    std::vector<uint8_t> bits(517);
+    for (auto &b : bits) b = rng();
+    size_t bit_total = bits.size() * 8;
+
+    bitmap_isa_t original = bitmap_active_isa();
+    for (bitmap_isa_t isa : { BITMAP_ISA_PORTABLE, BITMAP_ISA_SSE42, BITMAP_ISA_AVX2 })
+    {
+        if (bitmap_select_isa(isa) != 0) continue;
+        for (int trial = 0; trial < 200; ++trial)
+        {
+            size_t from = rng() % bit_total, to = rng() % (bit_total + 1);
+            size_t expected = 0;
+            for (size_t n = from; n < to; ++n) expected += bit_is_set(bits, n);
+            ASSERT_EQ(bitmap_popcount(bits.data(), from, to), expected)
+                << "Counts do not match for [" << from << ", " << to << ") with " << bitmap_isa_string_table[isa];
+        }
+    }
+    bitmap_select_isa(original);
+}
+
+// the bits of a partial byte outside the range are left out
+TEST_F(BitmapPopcountSuite, PartialBytes0)
+{
+    uint8_t bits[] = { 0xFF, 0xFF, 0xFF };
+    ASSERT_EQ(bitmap_popcount(bits, 3, 5), 2);
+    ASSERT_EQ(bitmap_popcount(bits, 3, 21), 18);
+    ASSERT_EQ(bitmap_popcount(bits, 5, 5), 0);
+    ASSERT_EQ(bitmap_popcount(bits, 6, 2), 0);
+    ASSERT_EQ(bitmap_popcount(NULL, 0, 8), 0);
+}
@@ -0,0 +1,110 @@
+#include "test_util.hpp"
+
+extern "C"
+{
+    #include "block_map_cache.h"
+}
+
+using BlockMapCacheSuite = fs_internal_test;
+
+constexpr inline std::size_t UNLIMITED = (std::size_t) -1;
+
+// entries are only added right after the last known one, and chains are found by key
+TEST_F(BlockMapCacheSuite, Extend0)
+{
+    block_map_cache_t cache;
+    block_map_cache_init(&cache);
+    const uint32_t *chain = NULL;
+
+    block_map_cache_extend(&cache, 5, 1, 40, UNLIMITED);
+    ASSERT_EQ( block_map_cache_find(&cache, 5, &chain), 0 );
+    ASSERT_EQ( cache.count, 0 );
+
+    for (uint32_t k = 0; k < 100; ++k) block_map_cache_extend(&cache, 5, k, 1000 + k, UNLIMITED);
+    block_map_cache_extend(&cache, 5, 102, 7, UNLIMITED);
+    block_map_cache_extend(&cache, 5, 50, 7, UNLIMITED);
+    // keys hashing to the same bucket
+    for (size_t key = 21; key < 1000; key += 16) block_map_cache_extend(&cache, key, 0, (uint32_t) key, UNLIMITED);
+
+    ASSERT_EQ( block_map_cache_find(&cache, 5, &chain), 100 );
+    for (uint32_t k = 0; k < 100; ++k) ASSERT_EQ( chain[k], 1000 + k );
+    for (size_t key = 21; key < 1000; key += 16)
+    {
+        ASSERT_EQ( block_map_cache_find(&cache, key, &chain), 1 );
+        ASSERT_EQ( chain[0], key );
+    }
+    ASSERT_EQ( block_map_cache_find(&cache, 6, &chain), 0 );
+    ASSERT_EQ( cache.count, 63 );
+    ASSERT_EQ( cache.evictions, 0 );
+
+    block_map_cache_clear(&cache);
+    ASSERT_EQ( cache.count, 0 );
+    ASSERT_EQ( cache.bytes, 0 );
+    ASSERT_EQ( block_map_cache_find(&cache, 5, &chain), 0 );
+}
+
+// truncating keeps a prefix of the chain, or drops the chain when nothing is left
+TEST_F(BlockMapCacheSuite, Truncate0)
+{
+    block_map_cache_t cache;
+    block_map_cache_init(&cache);
+    const uint32_t *chain = NULL;
+    for (uint32_t k = 0; k < 10; ++k) block_map_cache_extend(&cache, 3, k, k * 2, UNLIMITED);
+    size_t bytes = cache.bytes;
+
+    block_map_cache_truncate(&cache, 3, 12);
+    ASSERT_EQ( block_map_cache_find(&cache, 3, &chain), 10 );
+    block_map_cache_truncate(&cache, 3, 4);
+    ASSERT_EQ( block_map_cache_find(&cache, 3, &chain), 4 );
+    block_map_cache_extend(&cache, 3, 4, 99, UNLIMITED);
+    ASSERT_EQ( block_map_cache_find(&cache, 3, &chain), 5 );
+    ASSERT_EQ( chain[3], 6 );
+    ASSERT_EQ( chain[4], 99 );
+    ASSERT_EQ( cache.bytes, bytes );
+
+    block_map_cache_truncate(&cache, 3, 0);
+    ASSERT_EQ( block_map_cache_find(&cache, 3, &chain), 0 );
+    ASSERT_EQ( cache.count, 0 );
+    ASSERT_LT( cache.bytes, bytes );
+    block_map_cache_truncate(&cache, 8, 0);
+    block_map_cache_clear(&cache);
+}
+
+// the least recently used chains are dropped to make room, and a chain that does not fit on
+// its own stops growing
+TEST_F(BlockMapCacheSuite, Budget0)
+{
+    block_map_cache_t cache;
+    block_map_cache_init(&cache);
+    const uint32_t *chain = NULL;
+    for (uint32_t k = 0; k < 4; ++k) block_map_cache_extend(&cache, 1, k, 10 + k, UNLIMITED);
+    for (uint32_t k = 0; k < 4; ++k) block_map_cache_extend(&cache, 2, k, 20 + k, UNLIMITED);
+    size_t budget = cache.bytes;
+
+    // chain 2 is now the oldest, and makes room for chain 3
+    ASSERT_EQ( block_map_cache_find(&cache, 1, &chain), 4 );
+    for (uint32_t k = 0; k < 4; ++k) block_map_cache_extend(&cache, 3, k, 30 + k, budget);
+    ASSERT_EQ( block_map_cache_find(&cache, 2, &chain), 0 );
+    ASSERT_EQ( block_map_cache_find(&cache, 1, &chain), 4 );
+    ASSERT_EQ( block_map_cache_find(&cache, 3, &chain), 4 );
+    ASSERT_EQ( chain[3], 33 );
+    ASSERT_EQ( cache.evictions, 1 );
+    ASSERT_EQ( cache.bytes, budget );
+
+    // growing chain 3 past its capacity drops chain 1, which leaves room for a few more entries
+    for (uint32_t k = 4; k < 100; ++k) block_map_cache_extend(&cache, 3, k, 30 + k, budget);
+    ASSERT_EQ( block_map_cache_find(&cache, 1, &chain), 0 );
+    size_t len = block_map_cache_find(&cache, 3, &chain);
+    ASSERT_GE( len, 8 );
+    ASSERT_LT( len, 100 );
+    ASSERT_EQ( chain[len - 1], 30 + len - 1 );
+    ASSERT_EQ( cache.evictions, 2 );
+    ASSERT_LE( cache.bytes, budget );
+
+    // nothing fits in a budget of 0
+    block_map_cache_clear(&cache);
+    block_map_cache_extend(&cache, 4, 0, 1, 0);
+    ASSERT_EQ( block_map_cache_find(&cache, 4, &chain), 0 );
+    ASSERT_EQ( cache.bytes, 0 );
+    block_map_cache_clear(&cache);
+}
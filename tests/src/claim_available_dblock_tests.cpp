@@ -106,4 +106,94 @@ TEST_F(ClaimAvailableDBlockSuite, DBlockComplexClaim0)
 
     check_fs(OUTPUT "DBlockComplexClaim0.bin", fs);
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// next fit resumes after the previous claim instead of reusing a lower released dblock
+TEST_F(ClaimAvailableDBlockSuite, NextFitClaim0)
+{
+    dblock_index_t expected_claimed_list[] = { 1, 3, 4, 5 };
+
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_NEXT_FIT)), SUCCESS);
+
+    for (size_t i = 0; i < std::size(expected_claimed_list); ++i)
+    {
+        dblock_index_t output_dblock_index = 0;
+        ASSERT_EQ(claim_available_dblock(&fs, &output_dblock_index), SUCCESS) << "Return value do not match for index " << i << "!";
+        ASSERT_EQ(output_dblock_index, expected_claimed_list[i]) << "D-Block claimed by " << i << "th call is incorrect!";
+    }
+
+    // dblock 1 is available again but the cursor is already past it
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[1 * DATA_BLOCK_SIZE]), SUCCESS);
+
+    dblock_index_t output_dblock_index = 0;
+    ASSERT_EQ(claim_available_dblock(&fs, &output_dblock_index), SUCCESS);
+    ASSERT_EQ(output_dblock_index, 6) << "Next fit should continue from the last claimed D-Block!";
+
+    free_filesystem(&fs);
+}
+
+// next fit wraps around to the beginning once the end of the bitmask is reached
+TEST_F(ClaimAvailableDBlockSuite, NextFitWrapAround0)
+{
+    constexpr size_t dblock_total = 130;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_NEXT_FIT)), SUCCESS);
+
+    // claims every dblock, crossing several 64 bit words of the bitmask
+    for (size_t i = 1; i < dblock_total; ++i)
+    {
+        dblock_index_t output_dblock_index = 0;
+        ASSERT_EQ(claim_available_dblock(&fs, &output_dblock_index), SUCCESS);
+        ASSERT_EQ(output_dblock_index, i) << "D-Block claimed by " << i << "th call is incorrect!";
+    }
+
+    dblock_index_t tmp;
+    ASSERT_EQ(claim_available_dblock(&fs, &tmp), DBLOCK_UNAVAILABLE) << "Bits past the last D-Block must not be claimed!";
+
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[100 * DATA_BLOCK_SIZE]), SUCCESS);
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[3 * DATA_BLOCK_SIZE]), SUCCESS);
+
+    dblock_index_t output_dblock_index = 0;
+    ASSERT_EQ(claim_available_dblock(&fs, &output_dblock_index), SUCCESS);
+    ASSERT_EQ(output_dblock_index, 3);
+    ASSERT_EQ(claim_available_dblock(&fs, &output_dblock_index), SUCCESS);
+    ASSERT_EQ(output_dblock_index, 100);
+
+    // the cursor is now past dblock 100 so the search has to wrap around
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[3 * DATA_BLOCK_SIZE]), SUCCESS);
+    ASSERT_EQ(claim_available_dblock(&fs, &output_dblock_index), SUCCESS);
+    ASSERT_EQ(output_dblock_index, 3) << "Next fit should wrap around to the first available D-Block!";
+
+    free_filesystem(&fs);
+}
+
+// the summary bitmask lets first fit skip long stretches of used dblocks
+TEST_F(ClaimAvailableDBlockSuite, SummaryClaim0)
+{
+    constexpr size_t dblock_total = 300000;
+    constexpr dblock_index_t far_dblocks[] = { 299999, 4097, 262143 };
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+
+    dblock_index_t idx;
+    while (claim_available_dblock(&fs, &idx) == SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+
+    for (auto&& far_idx : far_dblocks)
+        ASSERT_EQ(release_dblock(&fs, &fs.dblocks[far_idx * DATA_BLOCK_SIZE]), SUCCESS);
+
+    constexpr dblock_index_t expected_claimed_list[] = { 4097, 262143, 299999 };
+    for (auto&& expected_idx : expected_claimed_list)
+    {
+        ASSERT_EQ(claim_available_dblock(&fs, &idx), SUCCESS);
+        ASSERT_EQ(idx, expected_idx) << "First fit should claim the lowest available D-Block!";
+    }
+    ASSERT_EQ(claim_available_dblock(&fs, &idx), DBLOCK_UNAVAILABLE);
+
+    free_filesystem(&fs);
+}
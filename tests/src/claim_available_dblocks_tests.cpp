@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "test_util.hpp"
+
+using ClaimAvailableDBlocksSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(ClaimAvailableDBlocksSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    dblock_index_t out[1];
+    auto output_retcode0 = claim_available_dblocks(NULL, 1, out);
+    auto output_retcode1 = claim_available_dblocks(&fs, 1, NULL);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for out = NULL case!";
+}
+
+// one batch claims the same dblocks as DBlockComplexClaim0 does one at a time
+TEST_F(ClaimAvailableDBlocksSuite, ComplexClaim0)
+{
+    constexpr size_t actual_dblock_count = 16;
+
+    dblock_index_t expected_claimed_list[actual_dblock_count] = { 
+        1, 3, 4, 5, 6, 8, 9, 14, 16, 17, 18, 19, 22, 25, 26, 29
+    };
+    dblock_index_t output_claimed_list[actual_dblock_count];
+    for (auto&& idx : output_claimed_list) idx = -1; // set to dummy values
+
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+
+    ASSERT_EQ(claim_available_dblocks(&fs, actual_dblock_count, output_claimed_list), SUCCESS);
+    for (size_t i = 0; i < actual_dblock_count; ++i)
+    {
+        ASSERT_EQ(output_claimed_list[i], expected_claimed_list[i]) << "D-Block claimed at " << i << " is incorrect!";
+    }
+    ASSERT_EQ(available_dblocks(&fs), 0);
+
+    check_fs(OUTPUT "DBlockComplexClaim0.bin", fs);
+    free_filesystem(&fs);
+}
+
+// nothing is claimed when there are not enough available dblocks
+TEST_F(ClaimAvailableDBlocksSuite, DBlockUnavailable0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+
+    dblock_index_t out[17];
+    ASSERT_EQ(claim_available_dblocks(&fs, std::size(out), out), DBLOCK_UNAVAILABLE);
+
+    check_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    free_filesystem(&fs);
+}
+
+// next fit batches resume after the previous claim and wrap around, like single claims
+TEST_F(ClaimAvailableDBlocksSuite, NextFitClaim0)
+{
+    filesystem_t single, batch;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", single);
+    load_fs(INPUT "empty_random_inode_fragmented.bin", batch);
+    ASSERT_EQ(set_dblock_allocator(&single, dblock_allocator_for_mode(DBLOCK_NEXT_FIT)), SUCCESS);
+    ASSERT_EQ(set_dblock_allocator(&batch, dblock_allocator_for_mode(DBLOCK_NEXT_FIT)), SUCCESS);
+
+    dblock_index_t expected[10], output[10];
+    for (size_t i = 0; i < 6; ++i) ASSERT_EQ(claim_available_dblock(&single, &expected[i]), SUCCESS);
+    ASSERT_EQ(claim_available_dblocks(&batch, 6, output), SUCCESS);
+    for (dblock_index_t idx : { 3, 5 })
+    {
+        release_dblock(&single, &single.dblocks[idx * DATA_BLOCK_SIZE]);
+        release_dblock(&batch, &batch.dblocks[idx * DATA_BLOCK_SIZE]);
+    }
+    for (size_t i = 6; i < 10; ++i) ASSERT_EQ(claim_available_dblock(&single, &expected[i]), SUCCESS);
+    ASSERT_EQ(claim_available_dblocks(&batch, 4, output + 6), SUCCESS);
+
+    for (size_t i = 0; i < std::size(expected); ++i)
+    {
+        ASSERT_EQ(output[i], expected[i]) << "D-Block claimed at " << i << " is incorrect!";
+    }
+    ASSERT_EQ(available_dblocks(&batch), available_dblocks(&single));
+    free_filesystem(&single);
+    free_filesystem(&batch);
+}
+
+// buddy mode batches come out of one aligned block when there is one, and random claims and
+// releases keep the lists in step with the bitmask
+TEST_F(ClaimAvailableDBlocksSuite, BuddyClaim0)
+{
+    constexpr size_t dblock_total = 1000;
+
+    filesystem_t fs;
+    fs_options_t options = { INODE_FREE_LIST, DBLOCK_BUDDY, FS_GEOMETRY_CLASSIC };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 2, dblock_total, &options), SUCCESS);
+
+    dblock_index_t out[64];
+    ASSERT_EQ(claim_available_dblocks(&fs, 48, out), SUCCESS);
+    ASSERT_EQ(out[0] % 64, 0) << "A batch should start at an aligned block!";
+    for (size_t i = 1; i < 48; ++i) ASSERT_EQ(out[i], out[0] + i) << "A batch should be one run!";
+    ASSERT_EQ(release_dblocks(&fs, out, 48), SUCCESS);
+
+    std::vector<bool> used(dblock_total);
+    std::vector<dblock_index_t> held;
+    used[0] = true;
+    uint64_t rng = 12345;
+    for (size_t step = 0; step < 5000; ++step)
+    {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t n = 1 + (rng >> 33) % std::size(out);
+        if ((rng >> 20) % 3 == 0 && !held.empty())
+        {
+            // release a random handful of the held dblocks
+            n = std::min(n, held.size());
+            for (size_t i = 0; i < n; ++i)
+            {
+                size_t victim = (rng >> (i % 16)) % held.size();
+                out[i] = held[victim];
+                used[out[i]] = false;
+                held[victim] = held.back();
+                held.pop_back();
+            }
+            ASSERT_EQ(release_dblocks(&fs, out, n), SUCCESS);
+            continue;
+        }
+        if (claim_available_dblocks(&fs, n, out) != SUCCESS) continue;
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_FALSE(used[out[i]]) << "D-Block " << out[i] << " was claimed twice!";
+            used[out[i]] = true;
+            held.push_back(out[i]);
+        }
+    }
+
+    // every dblock that is not held is handed out once more
+    dblock_index_t idx;
+    size_t claimed = 0;
+    while (claim_available_dblock(&fs, &idx) == SUCCESS)
+    {
+        ASSERT_FALSE(used[idx]) << "D-Block " << idx << " was claimed twice!";
+        used[idx] = true;
+        ++claimed;
+    }
+    ASSERT_EQ(claimed, dblock_total - 1 - held.size());
+    free_filesystem(&fs);
+}
+
+// threads claiming at once in atomic mode never hand out a dblock twice, and the counters
+// and bitmask agree once they are done
+TEST_F(ClaimAvailableDBlocksSuite, AtomicThreads0)
+{
+    constexpr size_t dblock_total = 20000;
+    constexpr size_t thread_total = 8;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_ATOMIC)), SUCCESS);
+
+    std::vector<dblock_index_t> claimed[thread_total];
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_total; ++t)
+    {
+        threads.emplace_back([&fs, &mine = claimed[t], t] {
+            dblock_index_t out[5];
+            size_t batch = t % 2 ? 5 : 1;
+            while (true)
+            {
+                if (claim_available_dblocks(&fs, batch, out) == SUCCESS) mine.insert(mine.end(), out, out + batch);
+                else if (batch > 1) batch = 1;
+                else break;
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    std::vector<dblock_index_t> all;
+    for (auto &mine : claimed) all.insert(all.end(), mine.begin(), mine.end());
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(all.size(), dblock_total - 1);
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+        ASSERT_EQ(all[i], i + 1) << "D-Block " << i + 1 << " was not claimed exactly once!";
+    }
+    ASSERT_EQ(available_dblocks(&fs), 0);
+    ASSERT_EQ(fs.free_dblock_count, 0);
+
+    // and hand them all back at once
+    threads.clear();
+    for (size_t t = 0; t < thread_total; ++t)
+    {
+        threads.emplace_back([&fs, &mine = claimed[t]] {
+            release_dblocks(&fs, mine.data(), mine.size());
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 1);
+    ASSERT_EQ(fs.free_dblock_count, dblock_total - 1);
+    dblock_index_t first;
+    ASSERT_EQ(claim_available_dblocks(&fs, 1, &first), SUCCESS);
+    free_filesystem(&fs);
+}
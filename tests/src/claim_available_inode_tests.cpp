@@ -109,4 +109,23 @@ TEST_F(ClaimAvailableINodeSuite, ComplexClaim0)
 
     check_fs(OUTPUT "ComplexClaim0.bin", fs);
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// the bitmap allocator claims the lowest available inode regardless of the free list order
+TEST_F(ClaimAvailableINodeSuite, BitmapClaim0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    fs.inode_alloc_mode = INODE_BITMAP;
+
+    for (inode_index_t expected = 1; expected < 32; ++expected)
+    {
+        inode_index_t idx;
+        ASSERT_EQ(claim_available_inode(&fs, &idx), SUCCESS);
+        ASSERT_EQ(idx, expected);
+    }
+    inode_index_t idx;
+    ASSERT_EQ(claim_available_inode(&fs, &idx), INODE_UNAVAILABLE);
+    ASSERT_EQ(fs.available_inode, 0);
+    free_filesystem(&fs);
+}
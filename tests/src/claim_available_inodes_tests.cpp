@@ -0,0 +1,57 @@
+#include "test_util.hpp"
+
+using ClaimAvailableINodesSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(ClaimAvailableINodesSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    inode_index_t out[1];
+    auto output_retcode0 = claim_available_inodes(NULL, 1, out);
+    auto output_retcode1 = claim_available_inodes(&fs, 1, NULL);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for out = NULL case!";
+}
+
+// one batch claims the same inodes as ComplexClaim0 does one at a time
+TEST_F(ClaimAvailableINodesSuite, ComplexClaim0)
+{
+    constexpr size_t actual_inode_count = 31;
+    
+    inode_index_t expected_claimed_list[actual_inode_count] = { 
+        17, 22, 19, 25, 21, 20, 18, 28, 
+        29,  5, 14,  4, 24, 31, 30,  2,
+         3,  1, 10, 15, 27, 23, 11,  8,
+         6,  7,  9, 16, 13, 26, 12
+    };
+    inode_index_t output_claimed_list[actual_inode_count];
+    for (auto&& idx : output_claimed_list) idx = -1; // set to dummy values
+
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+
+    ASSERT_EQ(claim_available_inodes(&fs, actual_inode_count, output_claimed_list), SUCCESS);
+    for (size_t i = 0; i < actual_inode_count; ++i)
+    {
+        ASSERT_EQ(output_claimed_list[i], expected_claimed_list[i]) << "INode claimed at " << i << " is incorrect!";
+    }
+
+    check_fs(OUTPUT "ComplexClaim0.bin", fs);
+    free_filesystem(&fs);
+}
+
+// nothing is claimed when there are not enough available inodes
+TEST_F(ClaimAvailableINodesSuite, INodeUnavailable0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+
+    inode_index_t out[32];
+    ASSERT_EQ(claim_available_inodes(&fs, std::size(out), out), INODE_UNAVAILABLE);
+
+    check_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    free_filesystem(&fs);
+}
@@ -0,0 +1,104 @@
+#include "test_util.hpp"
+
+using ClaimDBlockNearSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(ClaimDBlockNearSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    dblock_index_t idx;
+    auto output_retcode0 = claim_dblock_near(NULL, 0, &idx);
+    auto output_retcode1 = claim_dblock_near(&fs, 0, NULL);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for index = NULL case!";
+}
+
+// the goal is ignored outside of goal directed mode
+TEST_F(ClaimDBlockNearSuite, FirstFitIgnoresGoal0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 64);
+
+    dblock_index_t idx;
+    ASSERT_EQ(claim_dblock_near(&fs, 20, &idx), SUCCESS);
+    ASSERT_EQ(idx, 1);
+    free_filesystem(&fs);
+}
+
+// an available goal is claimed, a taken one moves to the next fully available bitmask byte
+TEST_F(ClaimDBlockNearSuite, GoalClaim0)
+{
+    struct { dblock_index_t goal; dblock_index_t expected; } cases[] = {
+        { 20, 20 },     // goal available
+        { 21, 21 },     // still available
+        { 20, 24 },     // goal taken, [22, 24) are available but share a byte with 20 and 21
+        { 0, 8 },       // root's dblock is taken
+        { 100, 8 },     // out of range goals start at 0
+    };
+
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 64);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_GOAL_DIRECTED)), SUCCESS);
+    for (auto&& c : cases)
+    {
+        size_t expected_available = available_dblocks(&fs) - 1;
+        dblock_index_t idx;
+        ASSERT_EQ(claim_dblock_near(&fs, c.goal, &idx), SUCCESS);
+        ASSERT_EQ(idx, c.expected) << "Incorrect dblock for goal = " << c.goal;
+        ASSERT_EQ(available_dblocks(&fs), expected_available);
+
+        // hand out the same dblock for the next out of range case
+        if (c.expected == 8) release_dblock(&fs, &fs.dblocks[8 * DATA_BLOCK_SIZE]);
+    }
+    free_filesystem(&fs);
+}
+
+// without a fully available byte the first available dblock after the goal is claimed
+TEST_F(ClaimDBlockNearSuite, GoalClaim1)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 16);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_GOAL_DIRECTED)), SUCCESS);
+
+    dblock_index_t idx;
+    while (claim_available_dblock(&fs, &idx) == SUCCESS);
+    release_dblock(&fs, &fs.dblocks[3 * DATA_BLOCK_SIZE]);
+    release_dblock(&fs, &fs.dblocks[12 * DATA_BLOCK_SIZE]);
+
+    ASSERT_EQ(claim_dblock_near(&fs, 5, &idx), SUCCESS);
+    ASSERT_EQ(idx, 12);
+    ASSERT_EQ(claim_dblock_near(&fs, 13, &idx), SUCCESS);
+    ASSERT_EQ(idx, 3) << "The search should wrap around to dblock 0";
+    ASSERT_EQ(claim_dblock_near(&fs, 0, &idx), DBLOCK_UNAVAILABLE);
+    free_filesystem(&fs);
+}
+
+// with several block groups the search stays in the group of the goal and then moves on
+// to the start of the following groups, skipping the ones that are full
+TEST_F(ClaimDBlockNearSuite, BlockGroupClaim0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 4, 256);
+    ASSERT_EQ(set_block_group_size(&fs, 64), SUCCESS);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_GOAL_DIRECTED)), SUCCESS);
+
+    dblock_index_t start;
+    size_t len;
+    ASSERT_EQ(claim_dblock_range(&fs, 64, 64, &start, &len), SUCCESS);
+    ASSERT_EQ(claim_dblock_range(&fs, 60, 128, &start, &len), SUCCESS);
+    ASSERT_EQ(fs.groups[1].free_dblock_count, 0);
+    ASSERT_EQ(fs.groups[2].free_dblock_count, 4);
+
+    dblock_index_t idx;
+    ASSERT_EQ(claim_dblock_near(&fs, 70, &idx), SUCCESS);
+    ASSERT_EQ(idx, 188) << "Group 1 is full, group 2 only has its last 4 dblocks";
+    ASSERT_EQ(claim_dblock_near(&fs, 130, &idx), SUCCESS);
+    ASSERT_EQ(idx, 189);
+    ASSERT_EQ(claim_dblock_near(&fs, 250, &idx), SUCCESS);
+    ASSERT_EQ(idx, 250);
+    ASSERT_EQ(fs.groups[3].free_dblock_count, 63);
+    free_filesystem(&fs);
+}
@@ -0,0 +1,213 @@
+#include "test_util.hpp"
+
+using ClaimDBlockRangeSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(ClaimDBlockRangeSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    dblock_index_t start;
+    size_t len;
+    auto output_retcode0 = claim_dblock_range(NULL, 1, 0, &start, &len);
+    auto output_retcode1 = claim_dblock_range(&fs, 1, 0, NULL, &len);
+    auto output_retcode2 = claim_dblock_range(&fs, 1, 0, &start, NULL);
+    auto output_retcode3 = claim_dblock_range(&fs, 0, 0, &start, &len);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for start = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode2) << "Return values do not match for len = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode3) << "Return values do not match for want = 0 case!";
+}
+
+// the available runs of the fragmented image are
+// [1], [3, 6], [8, 9], [14], [16, 19], [22], [25, 26], [29]
+TEST_F(ClaimDBlockRangeSuite, SimpleClaimRange0)
+{
+    struct { size_t want; dblock_index_t goal; dblock_index_t expected_start; size_t expected_len; } cases[] = {
+        { 3, 0, 3, 3 },     // first run long enough
+        { 4, 7, 16, 4 },    // search starts at the goal
+        { 8, 0, 3, 4 },     // nothing is long enough so the first longest run is taken
+        { 2, 27, 3, 2 },    // wraps around past the end of the bitmask
+        { 1, 100, 1, 1 },   // out of range goals start at 0
+    };
+
+    for (auto&& c : cases)
+    {
+        filesystem_t fs;
+        load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+        size_t expected_available = available_dblocks(&fs) - c.expected_len;
+
+        dblock_index_t output_start = 0;
+        size_t output_len = 0;
+        ASSERT_EQ(claim_dblock_range(&fs, c.want, c.goal, &output_start, &output_len), SUCCESS);
+        ASSERT_EQ(output_start, c.expected_start) << "Incorrect run start for want = " << c.want << " goal = " << c.goal;
+        ASSERT_EQ(output_len, c.expected_len) << "Incorrect run length for want = " << c.want << " goal = " << c.goal;
+        ASSERT_EQ(available_dblocks(&fs), expected_available);
+
+        // the claimed run is no longer available to single dblock claims
+        dblock_index_t idx;
+        while (claim_available_dblock(&fs, &idx) == SUCCESS)
+        {
+            ASSERT_FALSE(idx >= output_start && idx < output_start + output_len) << "D-Block " << idx << " was claimed twice!";
+        }
+        free_filesystem(&fs);
+    }
+}
+
+// runs can span several bytes and words of the bitmask
+TEST_F(ClaimDBlockRangeSuite, LargeClaimRange0)
+{
+    constexpr size_t dblock_total = 1000;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+
+    dblock_index_t output_start = 0;
+    size_t output_len = 0;
+    ASSERT_EQ(claim_dblock_range(&fs, 300, 5, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 5);
+    ASSERT_EQ(output_len, 300);
+
+    ASSERT_EQ(claim_dblock_range(&fs, 2000, 0, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 305) << "The longest run is after the first claim!";
+    ASSERT_EQ(output_len, dblock_total - 305);
+
+    ASSERT_EQ(claim_dblock_range(&fs, 10, 0, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 1);
+    ASSERT_EQ(output_len, 4);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+
+    free_filesystem(&fs);
+}
+
+// there are no dblocks available to be claimed
+TEST_F(ClaimDBlockRangeSuite, DBlockUnavailable0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "full_medium.bin", fs);
+
+    dblock_index_t output_start = 0;
+    size_t output_len = 0;
+    ASSERT_EQ(claim_dblock_range(&fs, 1, 0, &output_start, &output_len), DBLOCK_UNAVAILABLE);
+
+    check_fs(INPUT "full_medium.bin", fs);
+    free_filesystem(&fs);
+}
+
+// atomic mode takes a run from inside one bitmask word, so runs stop at 64 dblocks
+TEST_F(ClaimDBlockRangeSuite, AtomicClaim0)
+{
+    constexpr size_t dblock_total = 1000;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_ATOMIC)), SUCCESS);
+
+    dblock_index_t output_start = 0;
+    size_t output_len = 0;
+    ASSERT_EQ(claim_dblock_range(&fs, 10, 5, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 1);
+    ASSERT_EQ(output_len, 10);
+
+    ASSERT_EQ(claim_dblock_range(&fs, 200, 128, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 128);
+    ASSERT_EQ(output_len, 64);
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 75);
+
+    ASSERT_EQ(release_dblock_range(&fs, 128, 64), SUCCESS);
+    ASSERT_EQ(release_dblock_range(&fs, 1, 10), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 1);
+    free_filesystem(&fs);
+}
+
+// the extent tree takes the shortest run that fits instead of the first one, ignoring the goal.
+// the available runs of the fragmented image are
+// [1], [3, 6], [8, 9], [14], [16, 19], [22], [25, 26], [29]
+TEST_F(ClaimDBlockRangeSuite, ExtentTreeClaim0)
+{
+    struct { size_t want; dblock_index_t expected_start; size_t expected_len; } cases[] = {
+        { 2, 8, 2 },    // an exact fit rather than the first run long enough
+        { 3, 3, 3 },    // the shortest run that is long enough
+        { 8, 16, 4 },   // nothing is long enough so the first longest run is taken
+        { 1, 1, 1 },
+    };
+
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_EXTENT_TREE)), SUCCESS);
+    for (auto&& c : cases)
+    {
+        size_t expected_available = available_dblocks(&fs) - c.expected_len;
+        dblock_index_t output_start = 0;
+        size_t output_len = 0;
+        ASSERT_EQ(claim_dblock_range(&fs, c.want, 20, &output_start, &output_len), SUCCESS);
+        ASSERT_EQ(output_start, c.expected_start) << "Incorrect run start for want = " << c.want;
+        ASSERT_EQ(output_len, c.expected_len) << "Incorrect run length for want = " << c.want;
+        ASSERT_EQ(available_dblocks(&fs), expected_available);
+    }
+
+    // single dblocks come from the shortest run left, [6]
+    dblock_index_t idx;
+    ASSERT_EQ(claim_available_dblock(&fs, &idx), SUCCESS);
+    ASSERT_EQ(idx, 6);
+
+    // a released run is found again, and the tree follows the bitmask
+    ASSERT_EQ(release_dblock_range(&fs, 3, 3), SUCCESS);
+    dblock_index_t output_start = 0;
+    size_t output_len = 0;
+    ASSERT_EQ(claim_dblock_range(&fs, 3, 0, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 3);
+    ASSERT_EQ(output_len, 3);
+    free_filesystem(&fs);
+}
+
+// in buddy mode the available dblocks [1, 63] are the blocks 1, [2, 3], [4, 7], [8, 15],
+// [16, 31] and [32, 63], and a run comes from the start of the smallest block that holds it.
+// blocks of the same order are handed out most recently split or released first
+TEST_F(ClaimDBlockRangeSuite, BuddyClaimRange0)
+{
+    struct { size_t want; dblock_index_t expected_start; size_t expected_len; } cases[] = {
+        { 8, 8, 8 },    // a block of exactly the size wanted
+        { 5, 16, 5 },   // the start of [16, 31], leaving 21, [22, 23] and [24, 31]
+        { 3, 4, 3 },    // the start of [4, 7], leaving 7
+        { 8, 24, 8 },   // what was left of [16, 31] is found again
+        { 64, 32, 32 }, // nothing is long enough so the largest block is taken
+        { 2, 22, 2 },   // the block split off last is handed out first
+        { 4, 2, 2 },
+        { 4, 7, 1 },    // only single dblocks are left, 1, 7 and 21
+    };
+
+    filesystem_t fs;
+    fs_options_t options = { INODE_FREE_LIST, DBLOCK_BUDDY, FS_GEOMETRY_CLASSIC };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 2, 64, &options), SUCCESS);
+    for (auto&& c : cases)
+    {
+        size_t expected_available = available_dblocks(&fs) - c.expected_len;
+        dblock_index_t output_start = 0;
+        size_t output_len = 0;
+        ASSERT_EQ(claim_dblock_range(&fs, c.want, 0, &output_start, &output_len), SUCCESS);
+        ASSERT_EQ(output_start, c.expected_start) << "Incorrect run start for want = " << c.want;
+        ASSERT_EQ(output_len, c.expected_len) << "Incorrect run length for want = " << c.want;
+        ASSERT_EQ(available_dblocks(&fs), expected_available);
+    }
+
+    // released blocks merge with their buddies into one block again
+    ASSERT_EQ(release_dblock_range(&fs, 32, 32), SUCCESS);
+    ASSERT_EQ(release_dblock_range(&fs, 8, 8), SUCCESS);
+    ASSERT_EQ(release_dblock_range(&fs, 16, 5), SUCCESS);
+    ASSERT_EQ(release_dblock_range(&fs, 22, 10), SUCCESS);
+    dblock_index_t output_start = 0;
+    size_t output_len = 0;
+    ASSERT_EQ(claim_dblock_range(&fs, 64, 0, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 32);
+    ASSERT_EQ(output_len, 32);
+    ASSERT_EQ(claim_dblock_range(&fs, 16, 0, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 16);
+    ASSERT_EQ(output_len, 16);
+    ASSERT_EQ(claim_dblock_range(&fs, 8, 0, &output_start, &output_len), SUCCESS);
+    ASSERT_EQ(output_start, 8);
+    ASSERT_EQ(output_len, 8);
+    free_filesystem(&fs);
+}
@@ -0,0 +1,127 @@
+#include "test_util.hpp"
+
+using ClaimINodeNearSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(ClaimINodeNearSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    new_filesystem(&fs, 4, 4);
+    inode_index_t idx;
+    auto output_retcode0 = claim_inode_near(NULL, 0, DATA_FILE, &idx);
+    auto output_retcode1 = claim_inode_near(&fs, 0, DATA_FILE, NULL);
+    auto output_retcode2 = claim_inode_near(&fs, 4, DATA_FILE, &idx);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for index = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode2) << "Return values do not match for parent out of range case!";
+    free_filesystem(&fs);
+}
+
+// the parent is ignored outside of block group mode
+TEST_F(ClaimINodeNearSuite, FreeListIgnoresParent0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "half_random_inode_fragmented.bin", fs);
+    inode_index_t expected = fs.available_inode;
+
+    inode_index_t idx;
+    ASSERT_EQ(claim_inode_near(&fs, 20, DATA_FILE, &idx), SUCCESS);
+    ASSERT_EQ(idx, expected);
+    free_filesystem(&fs);
+}
+
+// 4 groups of 8 inodes and 64 dblocks each
+TEST_F(ClaimINodeNearSuite, BlockGroupClaim0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 32, 256);
+    ASSERT_EQ(set_block_group_size(&fs, 64), SUCCESS);
+    ASSERT_EQ(fs.group_count, 4);
+    ASSERT_EQ(fs.group_inode_count, 8);
+    fs.inode_alloc_mode = INODE_BLOCK_GROUPS;
+
+    inode_index_t idx;
+    // files stay in the group of their parent
+    ASSERT_EQ(claim_inode_near(&fs, 0, DATA_FILE, &idx), SUCCESS);
+    ASSERT_EQ(idx, 1);
+    ASSERT_EQ(claim_inode_near(&fs, 20, DATA_FILE, &idx), SUCCESS);
+    ASSERT_EQ(idx, 16);
+
+    // directories go to the group with the most available dblocks among the ones with
+    // at least the average number of available inodes. group 0 has the root's dblock
+    ASSERT_EQ(claim_inode_near(&fs, 0, DIRECTORY, &idx), SUCCESS);
+    ASSERT_EQ(idx, 8);
+
+    dblock_index_t start;
+    size_t len;
+    ASSERT_EQ(claim_dblock_range(&fs, 64, 192, &start, &len), SUCCESS);
+    ASSERT_EQ(fs.groups[3].free_dblock_count, 0);
+    ASSERT_EQ(claim_inode_near(&fs, 0, DIRECTORY, &idx), SUCCESS);
+    ASSERT_EQ(idx, 9) << "Group 2 is below the average number of available inodes";
+
+    ASSERT_EQ(fs.groups[0].free_inode_count, 6);
+    ASSERT_EQ(fs.groups[1].free_inode_count, 6);
+    ASSERT_EQ(fs.groups[2].free_inode_count, 7);
+    ASSERT_EQ(fs.groups[3].free_inode_count, 8);
+    free_filesystem(&fs);
+}
+
+// a full group moves on to the following ones, and the free inode list stays intact
+TEST_F(ClaimINodeNearSuite, BlockGroupClaim1)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 32, 256);
+    ASSERT_EQ(set_block_group_size(&fs, 64), SUCCESS);
+    fs.inode_alloc_mode = INODE_BLOCK_GROUPS;
+
+    inode_index_t idx;
+    for (inode_index_t expected = 24; expected < 32; ++expected)
+    {
+        ASSERT_EQ(claim_inode_near(&fs, 30, DATA_FILE, &idx), SUCCESS);
+        ASSERT_EQ(idx, expected);
+    }
+    ASSERT_EQ(claim_inode_near(&fs, 30, DATA_FILE, &idx), SUCCESS);
+    ASSERT_EQ(idx, 1) << "The search should wrap around to group 0";
+    ASSERT_EQ(available_inodes(&fs), 22);
+
+    // the inodes left in the free list are exactly the unclaimed ones
+    size_t listed = 0;
+    for (inode_index_t iter = fs.available_inode; iter != 0; iter = fs.inodes[iter].next_free_inode)
+    {
+        ASSERT_TRUE(iter >= 2 && iter < 24) << "Inode " << iter << " is claimed but still listed";
+        ++listed;
+    }
+    ASSERT_EQ(listed, 22);
+
+    // claiming the rest through the free list takes every remaining inode once
+    while (claim_available_inode(&fs, &idx) == SUCCESS);
+    ASSERT_EQ(available_inodes(&fs), 0);
+    ASSERT_EQ(claim_inode_near(&fs, 0, DATA_FILE, &idx), INODE_UNAVAILABLE);
+    free_filesystem(&fs);
+}
+
+// the bitmap allocator claims the first available inode after the parent
+TEST_F(ClaimINodeNearSuite, BitmapClaim0)
+{
+    filesystem_t fs;
+    fs_options_t options { INODE_BITMAP, DBLOCK_FIRST_FIT, FS_GEOMETRY_CLASSIC };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 16, 16, &options), SUCCESS);
+
+    inode_index_t idx;
+    ASSERT_EQ(claim_inode_near(&fs, 9, DATA_FILE, &idx), SUCCESS);
+    ASSERT_EQ(idx, 10);
+    ASSERT_EQ(claim_inode_near(&fs, 9, DIRECTORY, &idx), SUCCESS);
+    ASSERT_EQ(idx, 11);
+    ASSERT_EQ(claim_inode_near(&fs, 0, DATA_FILE, &idx), SUCCESS);
+    ASSERT_EQ(idx, 1);
+
+    // wraps around to the start of the table past the last inode
+    for (inode_index_t i = 12; i < 16; ++i) ASSERT_EQ(claim_inode_near(&fs, 11, DATA_FILE, &idx), SUCCESS);
+    ASSERT_EQ(claim_inode_near(&fs, 14, DATA_FILE, &idx), SUCCESS);
+    ASSERT_EQ(idx, 2);
+    ASSERT_EQ(available_inodes(&fs), 16 - 1 - 8);
+    free_filesystem(&fs);
+}
@@ -0,0 +1,129 @@
+#include "test_util.hpp"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+extern "C"
+{
+    #include "extent_tree.h"
+}
+
+using ExtentTreeAddSuite = fs_internal_test;
+
+// the maximal runs of set entries in `used`, as (start, length) pairs
+static std::vector<std::pair<size_t, size_t>> reference_runs(const std::vector<bool> &used)
+{
+    std::vector<std::pair<size_t, size_t>> runs;
+    for (size_t n = 0; n < used.size();)
+    {
+        if (!used[n])
+        {
+            ++n;
+            continue;
+        }
+        size_t end = n;
+        while (end < used.size() && used[end]) ++end;
+        runs.emplace_back(n, end - n);
+        n = end;
+    }
+    return runs;
+}
+
+// the extents of `tree` in order of their start
+static std::vector<std::pair<size_t, size_t>> tree_runs(const extent_tree_t &tree)
+{
+    std::vector<std::pair<size_t, size_t>> runs;
+    size_t start, len, at = 0;
+    while (extent_tree_find(&tree, at, &start, &len))
+    {
+        runs.emplace_back(start, len);
+        at = start + len;
+    }
+    return runs;
+}
+
+// touching and overlapping extents merge into one
+TEST_F(ExtentTreeAddSuite, Merge0)
+{
+    extent_tree_t tree;
+    extent_tree_init(&tree);
+
+    ASSERT_EQ(extent_tree_add(&tree, 10, 5), 0);
+    ASSERT_EQ(extent_tree_add(&tree, 20, 5), 0);
+    ASSERT_EQ(extent_tree_add(&tree, 30, 5), 0);
+    ASSERT_EQ(tree.count, 3);
+    ASSERT_EQ(tree.total, 15);
+
+    // fills the gap before 20 exactly and overlaps the extent at 30
+    ASSERT_EQ(extent_tree_add(&tree, 15, 5), 0);
+    ASSERT_EQ(extent_tree_add(&tree, 24, 8), 0);
+    ASSERT_EQ(tree.count, 1);
+    ASSERT_EQ(tree.total, 25);
+
+    size_t start = 0, len = 0;
+    ASSERT_EQ(extent_tree_find(&tree, 0, &start, &len), 1);
+    ASSERT_EQ(start, 10);
+    ASSERT_EQ(len, 25);
+
+    // adding nothing changes nothing
+    ASSERT_EQ(extent_tree_add(&tree, 100, 0), 0);
+    ASSERT_EQ(tree.count, 1);
+    extent_tree_clear(&tree);
+    ASSERT_EQ(tree.count, 0);
+    ASSERT_EQ(extent_tree_find(&tree, 0, &start, &len), 0);
+}
+
+// removing the middle of an extent splits it in two
+TEST_F(ExtentTreeAddSuite, Split0)
+{
+    extent_tree_t tree;
+    extent_tree_init(&tree);
+
+    ASSERT_EQ(extent_tree_add(&tree, 0, 100), 0);
+    ASSERT_EQ(extent_tree_remove(&tree, 40, 10), 0);
+    ASSERT_EQ(tree.count, 2);
+    ASSERT_EQ(tree.total, 90);
+
+    auto runs = tree_runs(tree);
+    ASSERT_EQ(runs.size(), 2);
+    ASSERT_EQ(runs[0], std::make_pair(size_t{ 0 }, size_t{ 40 }));
+    ASSERT_EQ(runs[1], std::make_pair(size_t{ 50 }, size_t{ 50 }));
+
+    // removing across both pieces and past the end
+    ASSERT_EQ(extent_tree_remove(&tree, 30, 100), 0);
+    runs = tree_runs(tree);
+    ASSERT_EQ(runs.size(), 1);
+    ASSERT_EQ(runs[0], std::make_pair(size_t{ 0 }, size_t{ 30 }));
+    extent_tree_clear(&tree);
+}
+
+// random adds and removes leave the same extents as marking the entries one by one
+TEST_F(ExtentTreeAddSuite, MatchesReference0)
+{
+    constexpr size_t total = 4000;
+
+    std::mt19937 rng(15);
+    std::vector<bool> used(total);
+    extent_tree_t tree;
+    extent_tree_init(&tree);
+
+    for (int trial = 0; trial < 5000; ++trial)
+    {
+        size_t start = rng() % total;
+        size_t len = 1 + rng() % 40;
+        if (len > total - start) len = total - start;
+        bool add = rng() % 2;
+        for (size_t n = start; n < start + len; ++n) used[n] = add;
+        ASSERT_EQ(add ? extent_tree_add(&tree, start, len) : extent_tree_remove(&tree, start, len), 0);
+
+        if (trial % 50 != 0) continue;
+        auto expected = reference_runs(used);
+        size_t expected_total = 0;
+        for (auto &&run : expected) expected_total += run.second;
+        ASSERT_EQ(tree_runs(tree), expected) << "Extents do not match after trial " << trial;
+        ASSERT_EQ(tree.count, expected.size());
+        ASSERT_EQ(tree.total, expected_total);
+    }
+    extent_tree_clear(&tree);
+}
@@ -0,0 +1,106 @@
+#include "test_util.hpp"
+
+#include <random>
+#include <vector>
+
+extern "C"
+{
+    #include "extent_tree.h"
+}
+
+using ExtentTreeBestFitSuite = fs_internal_test;
+
+// the shortest extent that fits wins, the lowest among those of the same length
+TEST_F(ExtentTreeBestFitSuite, SimpleBestFit0)
+{
+    extent_tree_t tree;
+    extent_tree_init(&tree);
+    // extents of length 8, 3, 5, 3 and 12
+    ASSERT_EQ(extent_tree_add(&tree, 0, 8), 0);
+    ASSERT_EQ(extent_tree_add(&tree, 20, 3), 0);
+    ASSERT_EQ(extent_tree_add(&tree, 30, 5), 0);
+    ASSERT_EQ(extent_tree_add(&tree, 40, 3), 0);
+    ASSERT_EQ(extent_tree_add(&tree, 50, 12), 0);
+
+    struct { size_t want; size_t expected_start; size_t expected_len; } cases[] = {
+        { 1, 20, 3 },   // the lowest of the shortest extents
+        { 3, 20, 3 },   // an exact fit
+        { 4, 30, 5 },
+        { 6, 0, 8 },
+        { 12, 50, 12 },
+    };
+    for (auto &&c : cases)
+    {
+        size_t start = 0, len = 0;
+        ASSERT_EQ(extent_tree_best_fit(&tree, c.want, &start, &len), 1);
+        ASSERT_EQ(start, c.expected_start) << "Incorrect extent start for want = " << c.want;
+        ASSERT_EQ(len, c.expected_len) << "Incorrect extent length for want = " << c.want;
+    }
+
+    size_t start = 0, len = 0;
+    ASSERT_EQ(extent_tree_best_fit(&tree, 13, &start, &len), 0);
+    ASSERT_EQ(extent_tree_longest(&tree, &start, &len), 1);
+    ASSERT_EQ(start, 50);
+    ASSERT_EQ(len, 12);
+    extent_tree_clear(&tree);
+}
+
+// an empty set has nothing to fit
+TEST_F(ExtentTreeBestFitSuite, Empty0)
+{
+    extent_tree_t tree;
+    extent_tree_init(&tree);
+
+    size_t start = 0, len = 0;
+    ASSERT_EQ(extent_tree_best_fit(&tree, 1, &start, &len), 0);
+    ASSERT_EQ(extent_tree_longest(&tree, &start, &len), 0);
+    ASSERT_EQ(extent_tree_best_fit(NULL, 1, &start, &len), 0);
+}
+
+// best fits after random churn match a scan over every extent
+TEST_F(ExtentTreeBestFitSuite, MatchesReference0)
+{
+    constexpr size_t total = 3000;
+
+    std::mt19937 rng(16);
+    std::vector<bool> used(total);
+    extent_tree_t tree;
+    extent_tree_init(&tree);
+
+    for (int trial = 0; trial < 3000; ++trial)
+    {
+        size_t start = rng() % total;
+        size_t len = 1 + rng() % 30;
+        if (len > total - start) len = total - start;
+        bool add = rng() % 3 != 0;
+        for (size_t n = start; n < start + len; ++n) used[n] = add;
+        ASSERT_EQ(add ? extent_tree_add(&tree, start, len) : extent_tree_remove(&tree, start, len), 0);
+
+        size_t want = 1 + rng() % 60;
+        size_t expected_start = 0, expected_len = 0;
+        for (size_t n = 0; n < total;)
+        {
+            if (!used[n])
+            {
+                ++n;
+                continue;
+            }
+            size_t end = n;
+            while (end < total && used[end]) ++end;
+            if (end - n >= want && (expected_len == 0 || end - n < expected_len))
+            {
+                expected_start = n;
+                expected_len = end - n;
+            }
+            n = end;
+        }
+
+        size_t found_start = 0, found_len = 0;
+        ASSERT_EQ(extent_tree_best_fit(&tree, want, &found_start, &found_len), expected_len != 0)
+            << "Return values do not match for want = " << want << " at trial " << trial;
+        if (expected_len == 0) continue;
+        ASSERT_EQ(found_start, expected_start) << "Best fits do not match for want = " << want << " at trial " << trial;
+        ASSERT_EQ(found_len, expected_len);
+    }
+    extent_tree_clear(&tree);
+}
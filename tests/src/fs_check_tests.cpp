@@ -0,0 +1,87 @@
+#include "test_util.hpp"
+
+using FSCheckSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(FSCheckSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    fs_check_report_t report;
+    auto output_retcode0 = fs_check(NULL, &report);
+    auto output_retcode1 = fs_check(&fs, NULL);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for report = NULL case!";
+}
+
+// a new file system is only its root directory
+TEST_F(FSCheckSuite, Empty0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 4, 16);
+
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), SUCCESS);
+    ASSERT_EQ(report.reachable_inodes, 1);
+    ASSERT_EQ(report.referenced_dblocks, 1);
+    free_filesystem(&fs);
+}
+
+// the files of large.bin use 46 dblocks in all, index dblocks included
+TEST_F(FSCheckSuite, Large0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "large.bin", fs);
+
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), SUCCESS);
+    ASSERT_EQ(report.reachable_inodes, 7);
+    ASSERT_EQ(report.referenced_dblocks, 46);
+    ASSERT_EQ(report.leaked_dblocks, 0);
+    free_filesystem(&fs);
+}
+
+// claims that no file records show up as leaked, and releasing a used dblock shows up too
+TEST_F(FSCheckSuite, Inconsistent0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "medium_text.bin", fs);
+
+    dblock_index_t dblock;
+    inode_index_t inode;
+    ASSERT_EQ(claim_available_dblock(&fs, &dblock), SUCCESS);
+    ASSERT_EQ(claim_available_inode(&fs, &inode), SUCCESS);
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[fs.inodes[0].internal.direct_data[0] * DATA_BLOCK_SIZE]), SUCCESS);
+
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), INVALID_BINARY_FORMAT);
+    ASSERT_EQ(report.leaked_dblocks, 1);
+    ASSERT_EQ(report.orphan_inodes, 1);
+    ASSERT_EQ(report.free_referenced_dblocks, 1);
+    ASSERT_EQ(report.shared_dblocks, 0);
+    free_filesystem(&fs);
+}
+
+// two files pointing at the same dblock
+TEST_F(FSCheckSuite, Shared0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "large.bin", fs);
+
+    inode_t *root = &fs.inodes[0];
+    for (size_t i = 1; i < fs.inode_count; ++i)
+    {
+        inode_t *inode = &fs.inodes[i];
+        if (inode->internal.file_type != DATA_FILE || inode->internal.file_size == 0) continue;
+        inode->internal.direct_data[0] = root->internal.direct_data[0];
+        break;
+    }
+
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), INVALID_BINARY_FORMAT);
+    ASSERT_EQ(report.shared_dblocks, 1);
+    ASSERT_EQ(report.leaked_dblocks, 1);
+    free_filesystem(&fs);
+}
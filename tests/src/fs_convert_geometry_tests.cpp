@@ -0,0 +1,138 @@
+#include <vector>
+
+#include "test_util.hpp"
+
+using FSConvertGeometrySuite = fs_internal_test;
+
+// the bytes `save_filesystem` writes for `fs`
+static std::vector<char> saved_image(filesystem_t &fs)
+{
+    std::vector<char> image;
+    FILE *file = tmpfile();
+    if (!file || save_filesystem(file, &fs) != SUCCESS) return image;
+    image.resize(ftell(file));
+    rewind(file);
+    if (fread(image.data(), 1, image.size(), file) != image.size()) image.clear();
+    fclose(file);
+    return image;
+}
+
+// test invalid input
+TEST_F(FSConvertGeometrySuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    fs_options_t options { INODE_FREE_LIST, DBLOCK_FIRST_FIT, FS_GEOMETRY_LARGE };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 70000, 8, &options), SUCCESS);
+    auto output_retcode0 = fs_convert_geometry(NULL, FS_GEOMETRY_LARGE);
+    auto output_retcode1 = fs_convert_geometry(&fs, (fs_geometry_t) 7);
+    auto output_retcode2 = fs_convert_geometry(&fs, FS_GEOMETRY_CLASSIC);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for unknown geometry case!";
+    ASSERT_EQ(expected_retcode, output_retcode2) << "Return values do not match for too many inodes case!";
+    ASSERT_EQ(fs.geometry, FS_GEOMETRY_LARGE);
+    free_filesystem(&fs);
+}
+
+// the converted tree reads the same and survives saving and loading
+TEST_F(FSConvertGeometrySuite, Tree0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "medium.bin", fs);
+    ASSERT_EQ(fs_convert_geometry(&fs, FS_GEOMETRY_LARGE), SUCCESS);
+    ASSERT_EQ(fs.geometry, FS_GEOMETRY_LARGE);
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), SUCCESS);
+
+    FILE *image = tmpfile();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(save_filesystem(image, &fs), SUCCESS);
+    free_filesystem(&fs);
+    rewind(image);
+    filesystem_t loaded;
+    ASSERT_EQ(load_filesystem(image, &loaded), SUCCESS);
+    fclose(image);
+    ASSERT_EQ(loaded.geometry, FS_GEOMETRY_LARGE);
+
+    terminal_context_t ctx { &loaded, &loaded.inodes[0] };
+    int ret;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ret = tree(&ctx, PATH("."));
+    }   // end stdout logging
+    ASSERT_EQ(ret, 0);
+    check_stdout(OUTPUT "Tree2.txt");
+    free_filesystem(&loaded);
+}
+
+// new entries take the wide layout, and converting back gives a classic tree that checks out
+TEST_F(FSConvertGeometrySuite, RoundTrip0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "medium.bin", fs);
+    size_t inodes_before = available_inodes(&fs);
+    size_t dblocks_before = available_dblocks(&fs);
+    ASSERT_EQ(fs_convert_geometry(&fs, FS_GEOMETRY_LARGE), SUCCESS);
+    ASSERT_LT(available_dblocks(&fs), dblocks_before) << "Wider entries should take more dblocks!";
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    int ret;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ret = new_file(&ctx, PATH("a/wide.txt"), FS_READ);
+    }   // end stdout logging
+    ASSERT_EQ(ret, 0);
+    fs_file_t file = fs_open(&ctx, PATH("a/wide.txt"));
+    ASSERT_NE(file, nullptr);
+    fs_close(file);
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ret = remove_file(&ctx, PATH("a/wide.txt"));
+    }   // end stdout logging
+    ASSERT_EQ(ret, 0);
+
+    ASSERT_EQ(fs_convert_geometry(&fs, FS_GEOMETRY_CLASSIC), SUCCESS);
+    ASSERT_EQ(fs.geometry, FS_GEOMETRY_CLASSIC);
+    ASSERT_EQ(available_inodes(&fs), inodes_before);
+    ASSERT_EQ(available_dblocks(&fs), dblocks_before);
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), SUCCESS);
+
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ret = tree(&ctx, PATH("."));
+    }   // end stdout logging
+    ASSERT_EQ(ret, 0);
+    check_stdout(OUTPUT "Tree2.txt");
+    free_filesystem(&fs);
+}
+
+// a conversion the dblocks cannot hold changes nothing
+TEST_F(FSConvertGeometrySuite, InsufficientDBlocks0)
+{
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 8, 16), SUCCESS);
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        new_file(&ctx, PATH("./x"), FS_READ);
+        new_file(&ctx, PATH("./y"), FS_READ);
+        new_file(&ctx, PATH("./z"), FS_READ);
+    }   // end stdout logging
+    ASSERT_EQ(fs.inodes[0].internal.file_size, 4 * CLASSIC_DIRECTORY_ENTRY_SIZE);
+
+    // the root directory needs a second dblock in large geometry
+    std::vector<dblock_index_t> taken(available_dblocks(&fs));
+    ASSERT_EQ(claim_available_dblocks(&fs, taken.size(), taken.data()), SUCCESS);
+    auto before = saved_image(fs);
+    ASSERT_EQ(fs_convert_geometry(&fs, FS_GEOMETRY_LARGE), INSUFFICIENT_DBLOCKS);
+    ASSERT_EQ(saved_image(fs), before);
+
+    ASSERT_EQ(release_dblocks(&fs, taken.data(), 1), SUCCESS);
+    ASSERT_EQ(fs_convert_geometry(&fs, FS_GEOMETRY_LARGE), SUCCESS);
+    ASSERT_EQ(fs.inodes[0].internal.file_size, 4 * LARGE_DIRECTORY_ENTRY_SIZE);
+    ASSERT_STREQ(directory_entry_name(&fs, &fs.dblocks[LARGE_DIRECTORY_ENTRY_SIZE]), "x");
+    free_filesystem(&fs);
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "test_util.hpp"
+
+using FSDrainMagazinesSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(FSDrainMagazinesSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    auto output_retcode0 = fs_drain_magazines(NULL);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+}
+
+// what the magazine holds is neither used nor available until it is drained
+TEST_F(FSDrainMagazinesSuite, HeldUntilDrained0)
+{
+    constexpr size_t dblock_total = 100;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 16, dblock_total), SUCCESS);
+    fs.magazine_size = 8;
+
+    dblock_index_t dblock;
+    ASSERT_EQ(claim_available_dblock(&fs, &dblock), SUCCESS);
+    ASSERT_EQ(dblock, 1);
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 1 - 8) << "The whole batch should be in the magazine!";
+
+    ASSERT_EQ(fs_drain_magazines(&fs), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 2);
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[dblock * DATA_BLOCK_SIZE]), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 2) << "The release should stay in the magazine!";
+    ASSERT_EQ(fs_drain_magazines(&fs), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 1);
+    free_filesystem(&fs);
+}
+
+// saving drains the magazines, so claims that were all released leave the image as it was
+TEST_F(FSDrainMagazinesSuite, SaveDrains0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    fs.magazine_size = 4;
+
+    dblock_index_t dblocks[2];
+    inode_index_t inode;
+    ASSERT_EQ(claim_available_dblocks(&fs, 2, dblocks), SUCCESS);
+    ASSERT_EQ(dblocks[0], 1);
+    ASSERT_EQ(dblocks[1], 3);
+    ASSERT_EQ(claim_available_inode(&fs, &inode), SUCCESS);
+    ASSERT_EQ(release_dblocks(&fs, dblocks, 2), SUCCESS);
+    ASSERT_EQ(release_inode(&fs, &fs.inodes[inode]), SUCCESS);
+
+    check_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    free_filesystem(&fs);
+}
+
+// reservations are made from the units the magazine holds before the shared counts
+TEST_F(FSDrainMagazinesSuite, Reserve0)
+{
+    constexpr size_t dblock_total = 100;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 16, dblock_total), SUCCESS);
+    fs.magazine_size = 8;
+
+    fs_reservation_t reservation;
+    dblock_index_t dblocks[3];
+    ASSERT_EQ(fs_reserve(&fs, 3, 0, &reservation), SUCCESS);
+    ASSERT_EQ(fs_reservation_draw(&fs, &reservation, 3, 0), SUCCESS);
+    ASSERT_EQ(claim_available_dblocks(&fs, 3, dblocks), SUCCESS);
+    ASSERT_EQ(fs_commit(&fs, &reservation), SUCCESS);
+    size_t available = available_dblocks(&fs);
+
+    ASSERT_EQ(fs_reserve(&fs, 3, 0, &reservation), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), available) << "The reservation should come out of the magazine!";
+    ASSERT_EQ(fs_abort(&fs, &reservation), SUCCESS);
+
+    ASSERT_EQ(fs_drain_magazines(&fs), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 1 - 3);
+    free_filesystem(&fs);
+}
+
+// threads claiming through their magazines in first fit mode never get the same dblock or
+// inode, and everything is back once they released it all and the magazines are drained
+TEST_F(FSDrainMagazinesSuite, Threads0)
+{
+    constexpr size_t inode_total = 2000;
+    constexpr size_t dblock_total = 20000;
+    constexpr size_t thread_total = 8;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, inode_total, dblock_total), SUCCESS);
+    fs.magazine_size = 16;
+
+    std::vector<dblock_index_t> dblocks[thread_total];
+    std::vector<inode_index_t> inodes[thread_total];
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_total; ++t)
+    {
+        threads.emplace_back([&fs, &mine = dblocks[t], &mine_inodes = inodes[t]] {
+            dblock_index_t out[3];
+            inode_index_t inode;
+            bool more_dblocks = true, more_inodes = true;
+            while (more_dblocks || more_inodes)
+            {
+                if (more_dblocks && claim_available_dblocks(&fs, 3, out) == SUCCESS) mine.insert(mine.end(), out, out + 3);
+                else if (more_dblocks && claim_available_dblock(&fs, out) == SUCCESS) mine.push_back(out[0]);
+                else more_dblocks = false;
+                if (more_inodes && claim_available_inode(&fs, &inode) == SUCCESS) mine_inodes.push_back(inode);
+                else more_inodes = false;
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    // the magazines of other threads may still hold a few, but none twice
+    std::vector<dblock_index_t> all_dblocks;
+    std::vector<inode_index_t> all_inodes;
+    for (auto &mine : dblocks) all_dblocks.insert(all_dblocks.end(), mine.begin(), mine.end());
+    for (auto &mine : inodes) all_inodes.insert(all_inodes.end(), mine.begin(), mine.end());
+    std::sort(all_dblocks.begin(), all_dblocks.end());
+    std::sort(all_inodes.begin(), all_inodes.end());
+    ASSERT_EQ(std::adjacent_find(all_dblocks.begin(), all_dblocks.end()), all_dblocks.end()) << "A D-Block was claimed twice!";
+    ASSERT_EQ(std::adjacent_find(all_inodes.begin(), all_inodes.end()), all_inodes.end()) << "An inode was claimed twice!";
+    ASSERT_GE(all_dblocks.size(), dblock_total - 1 - thread_total * 2 * fs.magazine_size);
+    ASSERT_GE(all_inodes.size(), inode_total - 1 - thread_total * 2 * fs.magazine_size);
+
+    threads.clear();
+    for (size_t t = 0; t < thread_total; ++t)
+    {
+        threads.emplace_back([&fs, &mine = dblocks[t], &mine_inodes = inodes[t]] {
+            release_dblocks(&fs, mine.data(), mine.size());
+            release_inodes(&fs, mine_inodes.data(), mine_inodes.size());
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    ASSERT_EQ(fs_drain_magazines(&fs), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), dblock_total - 1);
+    ASSERT_EQ(available_inodes(&fs), inode_total - 1);
+    ASSERT_EQ(fs.free_dblock_count, dblock_total - 1);
+    ASSERT_EQ(fs.free_inode_count, inode_total - 1);
+    free_filesystem(&fs);
+}
@@ -0,0 +1,170 @@
+#include <vector>
+
+#include "test_util.hpp"
+
+using FSFlushSuite = fs_internal_test;
+
+TEST_F(FSFlushSuite, InvalidInput)
+{
+    int output_ret;
+    {
+        stdout_logger_lock lk{ this };
+        output_ret = fs_flush(NULL);
+    }
+    ASSERT_EQ( output_ret, -1 );
+    check_stdout(OUTPUT "Empty.txt");
+}
+
+// nothing is buffered without delayed allocation, so flushing changes nothing
+TEST_F(FSFlushSuite, NothingBuffered0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "medium_text.bin", fs);
+
+    inode_t *inode = &fs.inodes[1];
+    struct fs_file file {
+        &fs,
+        inode,
+        0,
+        {},
+        {},
+        {}
+    };
+    int output_ret;
+    {   // begin logging stdout
+        stdout_logger_lock lk{ this };
+        output_ret = fs_flush(&file);
+    }   // stop logging stdout
+    ASSERT_EQ(output_ret, 0);
+    check_stdout(OUTPUT "Empty.txt");
+    check_fs(INPUT "medium_text.bin", fs);
+
+    free_filesystem(&fs);
+}
+
+// appends to two files in turn stay in their buffers, with their dblocks reserved, and
+// each file gets one run of dblocks when it is flushed
+TEST_F(FSFlushSuite, DelayedAlloc0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 8, 64);
+    fs.delayed_alloc = 1;
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    fs_file_t a, b;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ASSERT_EQ(new_file(&ctx, PATH("./a"), FS_READ), 0);
+        ASSERT_EQ(new_file(&ctx, PATH("./b"), FS_READ), 0);
+        a = fs_open(&ctx, PATH("./a"));
+        b = fs_open(&ctx, PATH("./b"));
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+
+    char data[40];
+    memset(data, 'x', sizeof(data));
+    size_t dblocks = available_dblocks(&fs);
+    for (int i = 0; i < 8; ++i)
+    {
+        ASSERT_EQ(fs_write(a, data, std::size(data)), std::size(data));
+        ASSERT_EQ(fs_write(b, data, std::size(data)), std::size(data));
+    }
+    // 320 bytes take 4 direct dblocks and an index dblock listing a fifth one
+    ASSERT_EQ(available_dblocks(&fs), dblocks - 12);
+    ASSERT_EQ(a->inode->internal.file_size, 0);
+    ASSERT_EQ(a->offset, 320);
+    ASSERT_EQ(fs_seek(a, FS_SEEK_END, 0), 0);
+    ASSERT_EQ(a->offset, 320);
+
+    ASSERT_EQ(fs_flush(a), 0);
+    ASSERT_EQ(a->inode->internal.file_size, 320);
+    ASSERT_EQ(available_dblocks(&fs), dblocks - 12);
+    for (size_t i = 1; i < INODE_DIRECT_BLOCK_COUNT; ++i)
+        ASSERT_EQ(a->inode->internal.direct_data[i], a->inode->internal.direct_data[0] + i);
+    ASSERT_EQ(a->inode->internal.indirect_dblock, a->inode->internal.direct_data[0] + 4);
+
+    inode_t *inode_b = b->inode;
+    fs_close(a);
+    fs_close(b);
+    ASSERT_EQ(inode_b->internal.file_size, 320);
+    ASSERT_EQ(available_dblocks(&fs), dblocks - 12);
+    for (size_t i = 1; i < INODE_DIRECT_BLOCK_COUNT; ++i)
+        ASSERT_EQ(inode_b->internal.direct_data[i], inode_b->internal.direct_data[0] + i);
+    free_filesystem(&fs);
+}
+
+// reading back buffered appends flushes them first
+TEST_F(FSFlushSuite, ReadBuffered0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 8, 64);
+    fs.delayed_alloc = 1;
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    fs_file_t file;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ASSERT_EQ(new_file(&ctx, PATH("./a"), FS_READ), 0);
+        file = fs_open(&ctx, PATH("./a"));
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    ASSERT_NE(file, nullptr);
+
+    char data[100];
+    for (size_t i = 0; i < std::size(data); ++i) data[i] = (char)i;
+    ASSERT_EQ(fs_write(file, data, 30), 30);
+    ASSERT_EQ(fs_write(file, data + 30, 70), 70);
+    ASSERT_EQ(file->inode->internal.file_size, 0);
+
+    char buffer[100] = { 0 };
+    ASSERT_EQ(fs_seek(file, FS_SEEK_START, 0), 0);
+    ASSERT_EQ(fs_read(file, buffer, std::size(buffer)), std::size(buffer));
+    ASSERT_EQ(file->inode->internal.file_size, 100);
+    ASSERT_EQ(memcmp(buffer, data, std::size(data)), 0);
+
+    fs_close(file);
+    free_filesystem(&fs);
+}
+
+// buffered appends keep their dblocks when the file system fills up before they are flushed
+TEST_F(FSFlushSuite, ReservedBuffer0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 8, 16);
+    fs.delayed_alloc = 1;
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    fs_file_t file;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ASSERT_EQ(new_file(&ctx, PATH("./a"), FS_READ), 0);
+        file = fs_open(&ctx, PATH("./a"));
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    ASSERT_NE(file, nullptr);
+
+    char data[3 * DATA_BLOCK_SIZE];
+    for (size_t i = 0; i < std::size(data); ++i) data[i] = (char)(i * 3);
+    ASSERT_EQ(fs_write(file, data, std::size(data)), std::size(data));
+
+    // everything else is claimed, and the next append has nothing left to reserve
+    std::vector<dblock_index_t> taken;
+    dblock_index_t dblock;
+    while (claim_available_dblock(&fs, &dblock) == SUCCESS) taken.push_back(dblock);
+    ASSERT_EQ(fs_write(file, data, 1), 0);
+
+    inode_t *inode = file->inode;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        fs_close(file);
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    ASSERT_EQ(inode->internal.file_size, std::size(data));
+    char output[std::size(data)];
+    size_t read = 0;
+    ASSERT_EQ(inode_read_data(&fs, inode, 0, output, std::size(output), &read), SUCCESS);
+    ASSERT_EQ(memcmp(output, data, std::size(data)), 0);
+    free_filesystem(&fs);
+}
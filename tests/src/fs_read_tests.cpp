@@ -29,7 +29,10 @@ TEST_F(FSReadSuite, SimpleRead0)
     struct fs_file file {
         &fs,
         inode,
-        offset
+        offset,
+        {},
+        {},
+        {}
     };
     char buffer[buffer_size + OVERFLOW] = { 0 };
     size_t output_size;
@@ -75,7 +78,10 @@ TEST_F(FSReadSuite, SimpleRead1)
     struct fs_file file {
         &fs,
         inode,
-        offset
+        offset,
+        {},
+        {},
+        {}
     };
     char buffer[buffer_size + OVERFLOW] = { 0 };
     size_t output_size;
@@ -121,7 +127,10 @@ TEST_F(FSReadSuite, ReadUntilEOF0)
     struct fs_file file {
         &fs,
         inode,
-        offset
+        offset,
+        {},
+        {},
+        {}
     };
     char buffer[buffer_size + OVERFLOW] = { 0 };
     size_t output_size;
@@ -167,7 +176,10 @@ TEST_F(FSReadSuite, ReadFullFile0)
     struct fs_file file {
         &fs,
         inode,
-        offset
+        offset,
+        {},
+        {},
+        {}
     };
     char buffer[buffer_size + OVERFLOW] = { 0 };
     size_t output_size;
@@ -0,0 +1,81 @@
+#include "test_util.hpp"
+
+using FSReserveSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(FSReserveSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    fs_reservation_t reservation;
+    auto output_retcode0 = fs_reserve(NULL, 1, 1, &reservation);
+    auto output_retcode1 = fs_reserve(&fs, 1, 1, NULL);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for token = NULL case!";
+}
+
+// nothing is held when the capacity is not there
+TEST_F(FSReserveSuite, Insufficient0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    size_t dblocks = available_dblocks(&fs), inodes = available_inodes(&fs);
+
+    fs_reservation_t reservation;
+    ASSERT_EQ(fs_reserve(&fs, dblocks + 1, 0, &reservation), INSUFFICIENT_DBLOCKS);
+    ASSERT_EQ(fs_reserve(&fs, 0, inodes + 1, &reservation), INODE_UNAVAILABLE);
+    ASSERT_EQ(available_dblocks(&fs), dblocks);
+    ASSERT_EQ(available_inodes(&fs), inodes);
+
+    check_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    free_filesystem(&fs);
+}
+
+// reserved capacity cannot be claimed by anyone but the holder
+TEST_F(FSReserveSuite, HoldsCapacity0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    size_t dblocks = available_dblocks(&fs), inodes = available_inodes(&fs);
+    ASSERT_GT(inodes, 0);
+
+    fs_reservation_t reservation;
+    ASSERT_EQ(fs_reserve(&fs, dblocks, inodes, &reservation), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+    ASSERT_EQ(available_inodes(&fs), 0);
+
+    dblock_index_t dblock;
+    inode_index_t inode;
+    ASSERT_EQ(claim_available_dblock(&fs, &dblock), DBLOCK_UNAVAILABLE);
+    ASSERT_EQ(claim_available_inode(&fs, &inode), INODE_UNAVAILABLE);
+
+    // the holder draws a unit right before claiming it
+    ASSERT_EQ(fs_reservation_draw(&fs, &reservation, 1, 1), SUCCESS);
+    ASSERT_EQ(claim_available_dblock(&fs, &dblock), SUCCESS);
+    ASSERT_EQ(claim_available_inode(&fs, &inode), SUCCESS);
+    ASSERT_EQ(fs_reservation_draw(&fs, &reservation, dblocks, 0), INVALID_INPUT);
+
+    // committing returns whatever was not drawn
+    ASSERT_EQ(fs_commit(&fs, &reservation), SUCCESS);
+    ASSERT_EQ(reservation.dblocks, 0);
+    ASSERT_EQ(reservation.inodes, 0);
+    ASSERT_EQ(available_dblocks(&fs), dblocks - 1);
+    ASSERT_EQ(available_inodes(&fs), inodes - 1);
+    free_filesystem(&fs);
+}
+
+// aborting returns the whole reservation and leaves the file system untouched
+TEST_F(FSReserveSuite, Abort0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+
+    fs_reservation_t reservation;
+    ASSERT_EQ(fs_reserve(&fs, 4, 1, &reservation), SUCCESS);
+    ASSERT_EQ(fs_abort(&fs, &reservation), SUCCESS);
+
+    check_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    free_filesystem(&fs);
+}
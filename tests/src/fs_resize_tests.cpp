@@ -0,0 +1,161 @@
+#include <vector>
+
+#include "test_util.hpp"
+
+using FSResizeSuite = fs_internal_test;
+
+// the bytes `save_filesystem` writes for `fs`
+static std::vector<char> saved_image(filesystem_t &fs)
+{
+    std::vector<char> image;
+    FILE *file = tmpfile();
+    if (!file || save_filesystem(file, &fs) != SUCCESS) return image;
+    image.resize(ftell(file));
+    rewind(file);
+    if (fread(image.data(), 1, image.size(), file) != image.size()) image.clear();
+    fclose(file);
+    return image;
+}
+
+// test invalid input
+TEST_F(FSResizeSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 8, 8), SUCCESS);
+    auto output_retcode0 = fs_resize(NULL, 8, 8);
+    auto output_retcode1 = fs_resize(&fs, 0, 8);
+    auto output_retcode2 = fs_resize(&fs, 8, 0);
+    auto output_retcode3 = fs_resize(&fs, 70000, 8);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for new_inode_total = 0 case!";
+    ASSERT_EQ(expected_retcode, output_retcode2) << "Return values do not match for new_dblock_total = 0 case!";
+    ASSERT_EQ(expected_retcode, output_retcode3) << "Return values do not match for too many inodes case!";
+    free_filesystem(&fs);
+}
+
+// growing a new file system gives the image new_filesystem makes at the larger size, and
+// shrinking it back gives the original image
+TEST_F(FSResizeSuite, GrowShrink0)
+{
+    filesystem_t small, large, fs;
+    ASSERT_EQ(new_filesystem(&small, 8, 10), SUCCESS);
+    ASSERT_EQ(new_filesystem(&large, 20, 300), SUCCESS);
+    ASSERT_EQ(new_filesystem(&fs, 8, 10), SUCCESS);
+
+    ASSERT_EQ(fs_resize(&fs, 20, 300), SUCCESS);
+    ASSERT_EQ(available_inodes(&fs), 19);
+    ASSERT_EQ(available_dblocks(&fs), 299);
+    ASSERT_EQ(saved_image(fs), saved_image(large));
+
+    ASSERT_EQ(fs_resize(&fs, 8, 10), SUCCESS);
+    ASSERT_EQ(available_inodes(&fs), 7);
+    ASSERT_EQ(available_dblocks(&fs), 9);
+    ASSERT_EQ(saved_image(fs), saved_image(small));
+
+    // the dblocks that were cut off read as zeros when they come back
+    ASSERT_EQ(fs_resize(&fs, 20, 300), SUCCESS);
+    ASSERT_EQ(saved_image(fs), saved_image(large));
+    free_filesystem(&small);
+    free_filesystem(&large);
+    free_filesystem(&fs);
+}
+
+// the new inodes and dblocks of a used file system can all be claimed, after what it had
+TEST_F(FSResizeSuite, GrowInUse0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "large.bin", fs);
+    size_t inode_total = fs.inode_count, dblock_total = fs.dblock_count;
+    size_t inodes_before = available_inodes(&fs), dblocks_before = available_dblocks(&fs);
+
+    ASSERT_EQ(fs_resize(&fs, inode_total + 10, dblock_total + 1000), SUCCESS);
+    ASSERT_EQ(available_inodes(&fs), inodes_before + 10);
+    ASSERT_EQ(available_dblocks(&fs), dblocks_before + 1000);
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), SUCCESS);
+
+    // the inodes that were available come first, the new ones after them in order
+    inode_index_t inode = 0;
+    for (size_t i = 0; i < inodes_before; ++i) ASSERT_EQ(claim_available_inode(&fs, &inode), SUCCESS);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(claim_available_inode(&fs, &inode), SUCCESS);
+        ASSERT_EQ(inode, inode_total + i);
+    }
+    ASSERT_EQ(claim_available_inode(&fs, &inode), INODE_UNAVAILABLE);
+
+    dblock_index_t dblock = 0;
+    size_t claimed = 0;
+    while (claim_available_dblock(&fs, &dblock) == SUCCESS)
+    {
+        ASSERT_LT(dblock, dblock_total + 1000);
+        if (dblock >= dblock_total)
+        {
+            for (size_t i = 0; i < DATA_BLOCK_SIZE; ++i)
+                ASSERT_EQ(fs.dblocks[dblock * DATA_BLOCK_SIZE + i], 0) << "New dblocks should read as zeros!";
+        }
+        ++claimed;
+    }
+    ASSERT_EQ(claimed, dblocks_before + 1000);
+    free_filesystem(&fs);
+}
+
+// a tail that is in use or reserved cannot be cut off, and the failed call changes nothing
+TEST_F(FSResizeSuite, ShrinkInUse0)
+{
+    constexpr size_t dblock_total = 200;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 16, dblock_total), SUCCESS);
+    dblock_index_t start;
+    size_t len;
+    ASSERT_EQ(claim_dblock_range(&fs, 150, 0, &start, &len), SUCCESS);
+    inode_index_t inodes[12];
+    ASSERT_EQ(claim_available_inodes(&fs, 12, inodes), SUCCESS);
+    auto before = saved_image(fs);
+
+    ASSERT_EQ(fs_resize(&fs, 16, 100), DBLOCK_UNAVAILABLE);
+    ASSERT_EQ(fs_resize(&fs, 8, dblock_total), INODE_UNAVAILABLE);
+    fs_reservation_t reservation;
+    ASSERT_EQ(fs_reserve(&fs, 40, 0, &reservation), SUCCESS);
+    ASSERT_EQ(fs_resize(&fs, 16, 180), DBLOCK_UNAVAILABLE) << "The reservation needs the tail!";
+    ASSERT_EQ(fs_abort(&fs, &reservation), SUCCESS);
+    ASSERT_EQ(saved_image(fs), before);
+
+    // once the tail is free it can go
+    ASSERT_EQ(release_dblock_range(&fs, 100, 51), SUCCESS);
+    ASSERT_EQ(release_inodes(&fs, inodes + 7, 5), SUCCESS);
+    ASSERT_EQ(fs_resize(&fs, 8, 100), SUCCESS);
+    ASSERT_EQ(available_inodes(&fs), 0);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+    for (inode_index_t iter = fs.available_inode; iter != 0; iter = fs.inodes[iter].next_free_inode)
+        ASSERT_LT(iter, 8) << "A cut off inode is still in the free list!";
+    fs_check_report_t report;
+    fs_check(&fs, &report);
+    ASSERT_EQ(report.free_referenced_dblocks, 0);
+    free_filesystem(&fs);
+}
+
+// large geometry file systems can grow past the inodes a classic one can index, without
+// moving the inodes they have
+TEST_F(FSResizeSuite, LargeGeometry0)
+{
+    filesystem_t fs;
+    fs_options_t options { INODE_FREE_LIST, DBLOCK_FIRST_FIT, FS_GEOMETRY_LARGE };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 8, 8, &options), SUCCESS);
+    inode_t *root = &fs.inodes[0];
+
+    ASSERT_EQ(fs_resize(&fs, 100000, 8), SUCCESS);
+    ASSERT_EQ(&fs.inodes[0], root);
+    ASSERT_EQ(available_inodes(&fs), 99999);
+    std::vector<inode_index_t> inodes(99999);
+    ASSERT_EQ(claim_available_inodes(&fs, inodes.size(), inodes.data()), SUCCESS);
+    ASSERT_EQ(inodes[99998], 99999);
+    fs_check_report_t report;
+    fs_check(&fs, &report);
+    ASSERT_EQ(report.free_reachable_inodes, 0);
+    free_filesystem(&fs);
+}
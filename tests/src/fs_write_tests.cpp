@@ -30,7 +30,10 @@ TEST_F(FSWriteSuite, SimpleWrite0)
     struct fs_file file {
         &fs,
         inode,
-        offset
+        offset,
+        {},
+        {},
+        {}
     };
     char buffer[buffer_size] = { 0 };
     memset(buffer, 0x24, buffer_size);
@@ -73,7 +76,10 @@ TEST_F(FSWriteSuite, SimpleWrite1)
     struct fs_file file {
         &fs,
         inode,
-        offset
+        offset,
+        {},
+        {},
+        {}
     };
     char buffer[buffer_size] = { 0 };
     memset(buffer, 0x30, buffer_size);
@@ -116,7 +122,10 @@ TEST_F(FSWriteSuite, WriteFromEOF0)
     struct fs_file file {
         &fs,
         inode,
-        offset
+        offset,
+        {},
+        {},
+        {}
     };
     char buffer[buffer_size] = { 0 };
     memset(buffer, 0x41, buffer_size);
@@ -159,7 +168,10 @@ TEST_F(FSWriteSuite, WriteExpandFile0)
     struct fs_file file {
         &fs,
         inode,
-        offset
+        offset,
+        {},
+        {},
+        {}
     };
     char buffer[buffer_size] = { 0 };
     memset(buffer, 0x44, buffer_size);
@@ -183,4 +195,180 @@ TEST_F(FSWriteSuite, WriteExpandFile0)
     check_fs(OUTPUT "WriteExpandFile0.bin", fs);
 
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// two files appended to in turn take their dblocks from their own preallocation windows,
+// and closing them returns what they did not use
+TEST_F(FSWriteSuite, PreallocWindow0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 8, 64);
+    fs.prealloc_window = 8;
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    fs_file_t a, b;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ASSERT_EQ(new_file(&ctx, PATH("./a"), (permission_t)(FS_READ | FS_WRITE)), 0);
+        ASSERT_EQ(new_file(&ctx, PATH("./b"), (permission_t)(FS_READ | FS_WRITE)), 0);
+        a = fs_open(&ctx, PATH("./a"));
+        b = fs_open(&ctx, PATH("./b"));
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+
+    char data[DATA_BLOCK_SIZE] = { 0 };
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ(fs_write(a, data, std::size(data)), std::size(data));
+        ASSERT_EQ(fs_write(b, data, std::size(data)), std::size(data));
+    }
+
+    // each file got a run of its own instead of every other dblock
+    for (size_t i = 1; i < 3; ++i)
+    {
+        ASSERT_EQ(a->inode->internal.direct_data[i], a->inode->internal.direct_data[0] + i);
+        ASSERT_EQ(b->inode->internal.direct_data[i], b->inode->internal.direct_data[0] + i);
+    }
+    ASSERT_EQ(a->window.len, 5);
+    ASSERT_EQ(b->window.len, 5);
+
+    size_t claimed = 64 - available_dblocks(&fs);
+    fs_close(a);
+    fs_close(b);
+    ASSERT_EQ(64 - available_dblocks(&fs), claimed - 10);
+    free_filesystem(&fs);
+}
+
+// files made while `extent_map_files` is set are extent mapped, so two files appended to in
+// turn through windows of 8 dblocks take one extent per window
+TEST_F(FSWriteSuite, ExtentFiles0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 8, 256);
+    fs.prealloc_window = 8;
+    fs.extent_map_files = 1;
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    fs_file_t a, b;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ASSERT_EQ(new_file(&ctx, PATH("./a"), (permission_t)(FS_READ | FS_WRITE)), 0);
+        ASSERT_EQ(new_file(&ctx, PATH("./b"), (permission_t)(FS_READ | FS_WRITE)), 0);
+        a = fs_open(&ctx, PATH("./a"));
+        b = fs_open(&ctx, PATH("./b"));
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    ASSERT_EQ(a->inode->internal.map_flags, INODE_EXTENT_MAPPED);
+    ASSERT_EQ(fs.inodes[0].internal.map_flags, 0);
+
+    char data[DATA_BLOCK_SIZE];
+    for (int i = 0; i < 24; ++i)
+    {
+        memset(data, 'a' + i, std::size(data));
+        ASSERT_EQ(fs_write(a, data, std::size(data)), std::size(data));
+        memset(data, 'A' + i, std::size(data));
+        ASSERT_EQ(fs_write(b, data, std::size(data)), std::size(data));
+    }
+    ASSERT_EQ(inode_map_entries(&fs, a->inode), 3);
+    ASSERT_EQ(inode_map_entries(&fs, b->inode), 3);
+    inode_t *a_inode = a->inode;
+    fs_close(a);
+    fs_close(b);
+
+    char output[DATA_BLOCK_SIZE];
+    size_t bytes_read = 0;
+    ASSERT_EQ(inode_read_data(&fs, a_inode, 17 * DATA_BLOCK_SIZE, output, std::size(output), &bytes_read), SUCCESS);
+    ASSERT_EQ(output[0], 'a' + 17);
+
+    // the extent dblocks count as referenced like index dblocks do
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), SUCCESS);
+    ASSERT_EQ(report.referenced_dblocks, 1 + 48 + 2);
+    free_filesystem(&fs);
+}
+
+// files made while `tree_map_files` is set are tree mapped, and `fs_check` follows their trees
+TEST_F(FSWriteSuite, TreeFiles0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 8, 512);
+    fs.tree_map_files = 1;
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    fs_file_t a;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ASSERT_EQ(new_file(&ctx, PATH("./a"), (permission_t)(FS_READ | FS_WRITE)), 0);
+        a = fs_open(&ctx, PATH("./a"));
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    ASSERT_NE(a, nullptr);
+    ASSERT_EQ(a->inode->internal.map_flags, INODE_TREE_MAPPED);
+
+    char data[DATA_BLOCK_SIZE];
+    for (int i = 0; i < 280; ++i)
+    {
+        memset(data, 'a' + i % 26, std::size(data));
+        ASSERT_EQ(fs_write(a, data, std::size(data)), std::size(data));
+    }
+    ASSERT_EQ(fs_seek(a, FS_SEEK_START, 271 * DATA_BLOCK_SIZE), 0);
+    char output[DATA_BLOCK_SIZE];
+    ASSERT_EQ(fs_read(a, output, std::size(output)), std::size(output));
+    ASSERT_EQ(output[0], 'a' + 271 % 26);
+    fs_close(a);
+
+    // 276 entries past the direct ones take 18 leaves, 2 nodes above them and a root
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), SUCCESS);
+    ASSERT_EQ(report.referenced_dblocks, 1 + 280 + 21);
+    ASSERT_EQ(available_dblocks(&fs), 511 - 280 - 21);
+    free_filesystem(&fs);
+}
+
+// a file kept open while the file system grows can still be written and read through, and
+// the terminal context still points at its working directory
+TEST_F(FSWriteSuite, WriteAcrossResize0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 8, 64);
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    fs_file_t a;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ASSERT_EQ(new_file(&ctx, PATH("./a"), (permission_t)(FS_READ | FS_WRITE)), 0);
+        a = fs_open(&ctx, PATH("./a"));
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    ASSERT_NE(a, nullptr);
+
+    char data[40 * DATA_BLOCK_SIZE];
+    for (size_t i = 0; i < std::size(data); ++i) data[i] = (char)(i * 7 + i / 61);
+    ASSERT_EQ(fs_write(a, data, 10 * DATA_BLOCK_SIZE), 10 * DATA_BLOCK_SIZE);
+
+    // far more than a realloc could grow the arrays by in place
+    inode_t *inode = a->inode;
+    ASSERT_EQ(fs_resize(&fs, 4000, 100000), SUCCESS);
+    ASSERT_EQ(a->inode, inode);
+    ASSERT_EQ(ctx.working_directory, &fs.inodes[0]);
+
+    ASSERT_EQ(fs_write(a, data + 10 * DATA_BLOCK_SIZE, 30 * DATA_BLOCK_SIZE), 30 * DATA_BLOCK_SIZE);
+    ASSERT_EQ(fs_seek(a, FS_SEEK_START, 0), 0);
+    char output[std::size(data)];
+    ASSERT_EQ(fs_read(a, output, std::size(output)), std::size(output));
+    ASSERT_EQ(memcmp(output, data, std::size(data)), 0);
+    fs_close(a);
+
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ASSERT_EQ(new_file(&ctx, PATH("./b"), (permission_t)(FS_READ | FS_WRITE)), 0);
+    }   // end stdout logging
+    check_stdout(OUTPUT "Empty.txt");
+    fs_check_report_t report;
+    ASSERT_EQ(fs_check(&fs, &report), SUCCESS);
+    free_filesystem(&fs);
+}
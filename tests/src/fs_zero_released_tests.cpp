@@ -0,0 +1,113 @@
+#include <vector>
+
+#include "test_util.hpp"
+
+using FSZeroReleasedSuite = fs_internal_test;
+
+static bool dblock_is_zero(const filesystem_t &fs, size_t n)
+{
+    for (size_t i = 0; i < DATA_BLOCK_SIZE; ++i)
+        if (fs.dblocks[n * DATA_BLOCK_SIZE + i] != 0) return false;
+    return true;
+}
+
+static void fill_dblocks(filesystem_t &fs, size_t start, size_t len)
+{
+    memset(&fs.dblocks[start * DATA_BLOCK_SIZE], 0xAB, len * DATA_BLOCK_SIZE);
+}
+
+// test invalid input
+TEST_F(FSZeroReleasedSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    size_t zeroed;
+    auto output_retcode0 = fs_zero_released(NULL, 1, &zeroed);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+}
+
+// a dblock released with lazy zeroing on is zeroed when it is claimed again, and keeps its
+// bytes without it
+TEST_F(FSZeroReleasedSuite, ZeroOnClaim0)
+{
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, 16), SUCCESS);
+    ASSERT_TRUE(dblock_is_zero(fs, 15)) << "New dblocks should read as zeros!";
+
+    dblock_index_t dblock;
+    ASSERT_EQ(claim_available_dblock(&fs, &dblock), SUCCESS);
+    fill_dblocks(fs, dblock, 1);
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[dblock * DATA_BLOCK_SIZE]), SUCCESS);
+    ASSERT_EQ(claim_available_dblock(&fs, &dblock), SUCCESS);
+    ASSERT_FALSE(dblock_is_zero(fs, dblock)) << "Without lazy zeroing the bytes are left as they were!";
+
+    fs.lazy_zero = 1;
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[dblock * DATA_BLOCK_SIZE]), SUCCESS);
+    ASSERT_FALSE(dblock_is_zero(fs, dblock)) << "Releasing should not zero the dblock yet!";
+    ASSERT_EQ(claim_available_dblock(&fs, &dblock), SUCCESS);
+    ASSERT_TRUE(dblock_is_zero(fs, dblock));
+    free_filesystem(&fs);
+}
+
+// every claim function zeroes what it hands out, magazines included
+TEST_F(FSZeroReleasedSuite, ZeroOnClaim1)
+{
+    constexpr size_t dblock_total = 200;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+    fs.lazy_zero = 1;
+    fill_dblocks(fs, 1, dblock_total - 1);
+    ASSERT_EQ(release_dblock_range(&fs, 1, dblock_total - 1), SUCCESS);
+
+    dblock_index_t start;
+    size_t len;
+    ASSERT_EQ(claim_dblock_range(&fs, 70, 0, &start, &len), SUCCESS);
+    for (size_t i = start; i < start + len; ++i) ASSERT_TRUE(dblock_is_zero(fs, i)) << "D-Block " << i << " was not zeroed!";
+
+    std::vector<dblock_index_t> indices(30);
+    ASSERT_EQ(claim_available_dblocks(&fs, indices.size(), indices.data()), SUCCESS);
+    for (auto &&i : indices) ASSERT_TRUE(dblock_is_zero(fs, i)) << "D-Block " << i << " was not zeroed!";
+
+    // the released dblock goes into the magazine and comes straight back out
+    fs.magazine_size = 4;
+    dblock_index_t dblock;
+    ASSERT_EQ(claim_available_dblock(&fs, &dblock), SUCCESS);
+    fill_dblocks(fs, dblock, 1);
+    ASSERT_EQ(release_dblocks(&fs, &dblock, 1), SUCCESS);
+    dblock_index_t again;
+    ASSERT_EQ(claim_available_dblock(&fs, &again), SUCCESS);
+    ASSERT_EQ(again, dblock);
+    ASSERT_TRUE(dblock_is_zero(fs, again));
+    free_filesystem(&fs);
+}
+
+// the background pass zeroes the lowest marked dblocks up to its limit
+TEST_F(FSZeroReleasedSuite, BackgroundPass0)
+{
+    constexpr size_t dblock_total = 300;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+    fs.lazy_zero = 1;
+    dblock_index_t start;
+    size_t len;
+    ASSERT_EQ(claim_dblock_range(&fs, 150, 0, &start, &len), SUCCESS);
+    ASSERT_EQ(start, 1);
+    fill_dblocks(fs, 1, 150);
+    ASSERT_EQ(release_dblock_range(&fs, 1, 150), SUCCESS);
+
+    size_t zeroed = 0;
+    ASSERT_EQ(fs_zero_released(&fs, 100, &zeroed), SUCCESS);
+    ASSERT_EQ(zeroed, 100);
+    for (size_t i = 1; i <= 100; ++i) ASSERT_TRUE(dblock_is_zero(fs, i)) << "D-Block " << i << " was not zeroed!";
+    for (size_t i = 101; i <= 150; ++i) ASSERT_FALSE(dblock_is_zero(fs, i)) << "D-Block " << i << " is past the limit!";
+
+    ASSERT_EQ(fs_zero_released(&fs, 1000, &zeroed), SUCCESS);
+    ASSERT_EQ(zeroed, 50);
+    ASSERT_EQ(fs_zero_released(&fs, 1000, &zeroed), SUCCESS);
+    ASSERT_EQ(zeroed, 0) << "Nothing should be left to zero!";
+    for (size_t i = 1; i <= 150; ++i) ASSERT_TRUE(dblock_is_zero(fs, i));
+    free_filesystem(&fs);
+}
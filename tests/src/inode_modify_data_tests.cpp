@@ -173,4 +173,103 @@ TEST_F(INodeModifyDataSuite, ModifyDirectIndirect1)
     check_fs(OUTPUT "ModifyDirectIndirect1.bin", fs);
 
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// modifying an extent mapped inode overwrites whole extents in place and appends the rest
+TEST_F(INodeModifyDataSuite, ExtentModify0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 128);
+    dblock_index_t start;
+    size_t len;
+    while (claim_dblock_range(&fs, fs.dblock_count, 0, &start, &len) == SUCCESS) {}
+    for (size_t d = 1; d + 2 <= fs.dblock_count; d += 3) release_dblock_range(&fs, d, 2);
+
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = INODE_EXTENT_MAPPED;
+    char expected[12 * DATA_BLOCK_SIZE];
+    for (size_t i = 0; i < std::size(expected); ++i) expected[i] = (char)i;
+    ASSERT_EQ( inode_write_data(&fs, inode, expected, 8 * DATA_BLOCK_SIZE), SUCCESS );
+
+    char patch[6 * DATA_BLOCK_SIZE];
+    for (size_t i = 0; i < std::size(patch); ++i) patch[i] = (char)(0x80 | i);
+    size_t offset = 6 * DATA_BLOCK_SIZE - 5;
+    memcpy(expected + offset, patch, std::size(patch));
+    ASSERT_EQ( inode_modify_data(&fs, inode, offset, patch, std::size(patch)), SUCCESS );
+    EXPECT_EQ( inode->internal.file_size, offset + std::size(patch) );
+    EXPECT_EQ( inode_map_entries(&fs, inode), 7 );
+
+    char output[std::size(expected)];
+    size_t bytes_read = 0;
+    EXPECT_EQ( inode_read_data(&fs, inode, 0, output, std::size(output), &bytes_read), SUCCESS );
+    EXPECT_EQ( bytes_read, offset + std::size(patch) );
+    EXPECT_EQ( memcmp(output, expected, bytes_read), 0 );
+    free_filesystem(&fs);
+}
+
+// an extent mapped inode reserves an extent dblock for every EXTENT_DBLOCK_RECORD_COUNT new
+// data dblocks, and a write that cannot count on them changes nothing
+TEST_F(INodeModifyDataSuite, ExtentInsufficientDataBlock0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 8);
+
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = INODE_EXTENT_MAPPED;
+    char data[7 * DATA_BLOCK_SIZE] = { 0 };
+    ASSERT_EQ( inode_growth_dblocks(&fs, inode, std::size(data)), 8 );
+    ASSERT_EQ( inode_modify_data(&fs, inode, 0, data, std::size(data)), INSUFFICIENT_DBLOCKS );
+    EXPECT_EQ( inode->internal.file_size, 0 );
+    EXPECT_EQ( available_dblocks(&fs), 7 );
+
+    ASSERT_EQ( inode_modify_data(&fs, inode, 0, data, 6 * DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 1 );
+    EXPECT_EQ( inode_map_entries(&fs, inode), 1 );
+    free_filesystem(&fs);
+}
+
+// writes that overwrite, append or both land in the same place however the inode is mapped,
+// including one large enough to be stored around the cache
+TEST_F(INodeModifyDataSuite, RunModify0)
+{
+    const size_t large = (4 << 20) + 3;
+    for (uint32_t map_flags : { 0u, (uint32_t) INODE_TREE_MAPPED, (uint32_t) INODE_EXTENT_MAPPED })
+    {
+        filesystem_t fs;
+        new_filesystem(&fs, 3, 2 * (large / DATA_BLOCK_SIZE));
+        inode_t *inode = &fs.inodes[1];
+        inode->internal.map_flags = map_flags;
+        std::vector<char> expected;
+        std::vector<char> patch(large);
+        for (size_t i = 0; i < patch.size(); ++i) patch[i] = (char)(i * 31 + i / 397);
+
+        // inode 2 takes turns with inode 1 so that the data dblocks of inode 1 come in runs
+        uint64_t rng = 99;
+        for (int i = 0; i < 300; ++i)
+        {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            size_t offset = (rng >> 33) % (expected.size() + 1);
+            if (i % 4 == 0) offset = expected.size();
+            else if (i % 4 == 1) offset -= offset % DATA_BLOCK_SIZE;
+            size_t n = (rng >> 13) % (5 * DATA_BLOCK_SIZE) + 1;
+            const char *data = patch.data() + (rng >> 45) % 1000;
+            ASSERT_EQ( inode_modify_data(&fs, inode, offset, (void *) data, n), SUCCESS );
+            ASSERT_EQ( inode_write_data(&fs, &fs.inodes[2], (void *) data, (rng >> 21) % 3 * DATA_BLOCK_SIZE), SUCCESS );
+            if (offset + n > expected.size()) expected.resize(offset + n);
+            memcpy(expected.data() + offset, data, n);
+        }
+        ASSERT_EQ( inode_modify_data(&fs, inode, 100, patch.data(), patch.size()), SUCCESS );
+        expected.resize(std::max(expected.size(), 100 + patch.size()));
+        memcpy(expected.data() + 100, patch.data(), patch.size());
+        ASSERT_EQ( inode_modify_data(&fs, inode, 7, patch.data() + 1, patch.size() - 1), SUCCESS );
+        memcpy(expected.data() + 7, patch.data() + 1, patch.size() - 1);
+
+        ASSERT_EQ( inode->internal.file_size, expected.size() );
+        std::vector<char> output(expected.size());
+        size_t bytes_read = 0;
+        ASSERT_EQ( inode_read_data(&fs, inode, 0, output.data(), output.size(), &bytes_read), SUCCESS );
+        ASSERT_EQ( bytes_read, expected.size() );
+        EXPECT_EQ( memcmp(output.data(), expected.data(), expected.size()), 0 ) << "Incorrect data with map flags " << map_flags;
+        free_filesystem(&fs);
+    }
+}
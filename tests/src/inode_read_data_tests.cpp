@@ -1,5 +1,10 @@
 #include "test_util.hpp"
 
+extern "C"
+{
+    #include "block_map_cache.h"
+}
+
 using INodeReadDataSuite = fs_internal_test;
 
 constexpr inline std::size_t OVERFLOW = 128;
@@ -97,4 +102,167 @@ TEST_F(INodeReadDataSuite, ReadData2)
     check_fs(INPUT "medium_text.bin", fs); // no changes shouldve been made to the file system
 
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// reads of an extent mapped inode with over 200 extents in about 40 extent dblocks, match the
+// data wherever they start and end
+TEST_F(INodeReadDataSuite, ExtentRead0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 1024);
+    dblock_index_t start;
+    size_t len;
+    while (claim_dblock_range(&fs, fs.dblock_count, 0, &start, &len) == SUCCESS) {}
+    for (size_t d = 1; d + 2 <= fs.dblock_count; d += 3) release_dblock_range(&fs, d, 2);
+
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = INODE_EXTENT_MAPPED;
+    std::vector<char> data(400 * DATA_BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 31 + i / 251);
+    ASSERT_EQ( inode_write_data(&fs, inode, data.data(), data.size()), SUCCESS );
+    // the extent dblocks claimed in between batches split a few of the pairs
+    ASSERT_GE( inode_map_entries(&fs, inode), 200 );
+
+    std::vector<char> output(3 * DATA_BLOCK_SIZE + OVERFLOW);
+    for (size_t offset = 0; offset < data.size() + OVERFLOW; offset += 97)
+    {
+        size_t expected = offset < data.size() ? std::min(output.size(), data.size() - offset) : 0;
+        size_t bytes_read = 0;
+        ASSERT_EQ( inode_read_data(&fs, inode, offset, output.data(), output.size(), &bytes_read), SUCCESS );
+        ASSERT_EQ( bytes_read, expected ) << "Incorrect read length at offset " << offset;
+        ASSERT_EQ( memcmp(output.data(), data.data() + offset, expected), 0 ) << "Incorrect data at offset " << offset;
+    }
+    free_filesystem(&fs);
+}
+
+// with a block map cache, the chain walked while appending answers every later read, and
+// a chain read from the start of an inode the cache does not know is cached on the first miss
+TEST_F(INodeReadDataSuite, MapCache0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 3, 4096);
+    fs.map_cache_budget = 1 << 16;
+    std::vector<char> data(1500 * DATA_BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 29 + i / 509);
+    inode_t *inode = &fs.inodes[1];
+    ASSERT_EQ( inode_write_data(&fs, inode, data.data(), data.size()), SUCCESS );
+    ASSERT_NE( fs.map_cache, nullptr );
+    ASSERT_EQ( fs.map_cache->count, 1 );
+    size_t misses = fs.map_cache->misses;
+
+    std::vector<char> output(2 * DATA_BLOCK_SIZE);
+    uint64_t rng = 12345;
+    for (int i = 0; i < 500; ++i)
+    {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t offset = (rng >> 20) % data.size();
+        size_t expected = std::min(output.size(), data.size() - offset);
+        size_t bytes_read = 0;
+        ASSERT_EQ( inode_read_data(&fs, inode, offset, output.data(), output.size(), &bytes_read), SUCCESS );
+        ASSERT_EQ( bytes_read, expected );
+        ASSERT_EQ( memcmp(output.data(), data.data() + offset, expected), 0 ) << "Incorrect data at offset " << offset;
+    }
+    EXPECT_EQ( fs.map_cache->misses, misses );
+    EXPECT_GT( fs.map_cache->hits, 400 );
+
+    // the chain of inode 2 is only cached once it is read
+    inode_t *other = &fs.inodes[2];
+    ASSERT_EQ( inode_write_data(&fs, other, data.data(), data.size()), SUCCESS );
+    block_map_cache_truncate(fs.map_cache, 2, 0);
+    size_t bytes_read = 0;
+    ASSERT_EQ( inode_read_data(&fs, other, data.size() - 10, output.data(), output.size(), &bytes_read), SUCCESS );
+    EXPECT_EQ( memcmp(output.data(), data.data() + data.size() - 10, 10), 0 );
+    EXPECT_EQ( fs.map_cache->misses, misses + 1 );
+    size_t hits = fs.map_cache->hits;
+    ASSERT_EQ( inode_read_data(&fs, other, data.size() / 2, output.data(), output.size(), &bytes_read), SUCCESS );
+    EXPECT_EQ( memcmp(output.data(), data.data() + data.size() / 2, output.size()), 0 );
+    EXPECT_EQ( fs.map_cache->hits, hits + 1 );
+    free_filesystem(&fs);
+}
+
+// a budget that holds one chain keeps the one read last, and reads stay correct when the
+// cache cannot hold anything
+TEST_F(INodeReadDataSuite, MapCacheBudget0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 3, 4096);
+    std::vector<char> data(1000 * DATA_BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 17 + i / 307);
+    ASSERT_EQ( inode_write_data(&fs, &fs.inodes[1], data.data(), data.size()), SUCCESS );
+    ASSERT_EQ( inode_write_data(&fs, &fs.inodes[2], data.data(), data.size()), SUCCESS );
+
+    fs.map_cache_budget = 1;
+    std::vector<char> output(100);
+    size_t bytes_read = 0;
+    for (size_t offset = 0; offset < data.size(); offset += 4001)
+    {
+        ASSERT_EQ( inode_read_data(&fs, &fs.inodes[1 + offset % 2], offset, output.data(), output.size(), &bytes_read), SUCCESS );
+        ASSERT_EQ( memcmp(output.data(), data.data() + offset, bytes_read), 0 ) << "Incorrect data at offset " << offset;
+    }
+    ASSERT_NE( fs.map_cache, nullptr );
+    EXPECT_EQ( fs.map_cache->count, 0 );
+    EXPECT_EQ( fs.map_cache->bytes, 0 );
+    EXPECT_EQ( fs.map_cache->hits, 0 );
+
+    // room for the chain of one inode, but not of both
+    fs.map_cache_budget = 1 << 16;
+    ASSERT_EQ( inode_read_data(&fs, &fs.inodes[1], data.size() - 1, output.data(), 1, &bytes_read), SUCCESS );
+    fs.map_cache_budget = fs.map_cache->bytes + 64;
+    ASSERT_EQ( inode_read_data(&fs, &fs.inodes[2], data.size() - 1, output.data(), 1, &bytes_read), SUCCESS );
+    EXPECT_EQ( output[0], data.back() );
+    EXPECT_EQ( fs.map_cache->count, 1 );
+    EXPECT_EQ( fs.map_cache->evictions, 1 );
+    EXPECT_LE( fs.map_cache->bytes, fs.map_cache_budget );
+    size_t hits = fs.map_cache->hits;
+    ASSERT_EQ( inode_read_data(&fs, &fs.inodes[2], 500 * DATA_BLOCK_SIZE, output.data(), output.size(), &bytes_read), SUCCESS );
+    EXPECT_EQ( memcmp(output.data(), data.data() + 500 * DATA_BLOCK_SIZE, output.size()), 0 );
+    EXPECT_EQ( fs.map_cache->hits, hits + 1 );
+
+    // taking the budget away drops what is cached on the next walk
+    fs.map_cache_budget = 0;
+    ASSERT_EQ( inode_read_data(&fs, &fs.inodes[2], 600 * DATA_BLOCK_SIZE, output.data(), output.size(), &bytes_read), SUCCESS );
+    EXPECT_EQ( memcmp(output.data(), data.data() + 600 * DATA_BLOCK_SIZE, output.size()), 0 );
+    EXPECT_EQ( fs.map_cache->count, 0 );
+    free_filesystem(&fs);
+}
+
+// reads that span data dblocks next to each other and data dblocks apart return the same
+// data, whether the inode is mapped by a chain or by a tree
+TEST_F(INodeReadDataSuite, RunRead0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 5, 2048);
+    std::vector<char> data(300 * DATA_BLOCK_SIZE + 17);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 13 + i / 211);
+    fs.inodes[3].internal.map_flags = INODE_TREE_MAPPED;
+    fs.inodes[4].internal.map_flags = INODE_TREE_MAPPED;
+
+    // inodes 1 and 3 are written whole, inodes 2 and 4 in turns of 1 to 7 data dblocks and
+    // a few bytes so their data dblocks come in runs of every length
+    ASSERT_EQ( inode_write_data(&fs, &fs.inodes[1], data.data(), data.size()), SUCCESS );
+    ASSERT_EQ( inode_write_data(&fs, &fs.inodes[3], data.data(), data.size()), SUCCESS );
+    for (size_t written = 0, turn = 0; written < data.size(); ++turn)
+    {
+        size_t len = std::min((turn % 7 + 1) * DATA_BLOCK_SIZE + turn % 3, data.size() - written);
+        ASSERT_EQ( inode_write_data(&fs, &fs.inodes[2], data.data() + written, len), SUCCESS );
+        ASSERT_EQ( inode_write_data(&fs, &fs.inodes[4], data.data() + written, len), SUCCESS );
+        written += len;
+    }
+
+    std::vector<char> output(data.size());
+    for (size_t i = 1; i <= 4; ++i)
+    {
+        for (size_t offset = 0; offset < data.size(); offset += 251)
+        {
+            for (size_t n : { (size_t) 1, (size_t) DATA_BLOCK_SIZE, (size_t) 999, data.size() })
+            {
+                size_t expected = std::min(n, data.size() - offset);
+                size_t bytes_read = 0;
+                ASSERT_EQ( inode_read_data(&fs, &fs.inodes[i], offset, output.data(), n, &bytes_read), SUCCESS );
+                ASSERT_EQ( bytes_read, expected );
+                ASSERT_EQ( memcmp(output.data(), data.data() + offset, expected), 0 ) << "Incorrect data in inode " << i << " at offset " << offset;
+            }
+        }
+    }
+    free_filesystem(&fs);
+}
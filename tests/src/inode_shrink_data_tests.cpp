@@ -1,5 +1,10 @@
 #include "test_util.hpp"
 
+extern "C"
+{
+    #include "block_map_cache.h"
+}
+
 using INodeShrinkDataSuite = fs_internal_test;
 
 // test for basic invalid input
@@ -181,4 +186,142 @@ TEST_F(INodeReleaseDataSuite, Release1)
 
     check_fs(OUTPUT "ShrinkComplete1.bin", fs);
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// an extent mapped inode gives back its dblocks a run at a time, and an extent dblock once
+// none of its extents are left
+TEST_F(INodeShrinkDataSuite, ExtentShrink0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 128);
+    dblock_index_t start;
+    size_t len;
+    while (claim_dblock_range(&fs, fs.dblock_count, 0, &start, &len) == SUCCESS) {}
+    for (size_t d = 1; d + 2 <= fs.dblock_count; d += 3) release_dblock_range(&fs, d, 2);
+
+    // ten extents of two dblocks, the last eight in extent dblocks 31 and 32
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = INODE_EXTENT_MAPPED;
+    char data[20 * DATA_BLOCK_SIZE];
+    for (size_t i = 0; i < std::size(data); ++i) data[i] = (char)(i * 13);
+    ASSERT_EQ( inode_write_data(&fs, inode, data, std::size(data)), SUCCESS );
+    ASSERT_EQ( available_dblocks(&fs), 62 );
+
+    // the third extent keeps dblock 7 and extent dblock 31
+    ASSERT_EQ( inode_shrink_data(&fs, inode, 5 * DATA_BLOCK_SIZE - 10), SUCCESS );
+    EXPECT_EQ( inode->internal.file_size, 5 * DATA_BLOCK_SIZE - 10 );
+    EXPECT_EQ( inode_map_entries(&fs, inode), 3 );
+    EXPECT_EQ( available_dblocks(&fs), 62 + 15 + 1 );
+    EXPECT_EQ( inode->internal.indirect_dblock, 31 );
+    EXPECT_EQ( inode_dblock_goal(&fs, inode), 8 );
+    char output[std::size(data)];
+    size_t bytes_read = 0;
+    EXPECT_EQ( inode_read_data(&fs, inode, 0, output, std::size(output), &bytes_read), SUCCESS );
+    EXPECT_EQ( bytes_read, 5 * DATA_BLOCK_SIZE - 10 );
+    EXPECT_EQ( memcmp(output, data, bytes_read), 0 );
+
+    // the first extent ends exactly where the file does
+    ASSERT_EQ( inode_shrink_data(&fs, inode, 2 * DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( inode_map_entries(&fs, inode), 1 );
+    EXPECT_EQ( available_dblocks(&fs), 62 + 15 + 1 + 3 + 1 );
+    EXPECT_EQ( inode->internal.indirect_dblock, 0 );
+
+    // growing again fills the extents back in order
+    ASSERT_EQ( inode_write_data(&fs, inode, data + 2 * DATA_BLOCK_SIZE, std::size(data) - 2 * DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( inode_map_entries(&fs, inode), 10 );
+    EXPECT_EQ( available_dblocks(&fs), 62 );
+    EXPECT_EQ( inode_read_data(&fs, inode, 0, output, std::size(output), &bytes_read), SUCCESS );
+    EXPECT_EQ( memcmp(output, data, std::size(data)), 0 );
+
+    ASSERT_EQ( inode_release_data(&fs, inode), SUCCESS );
+    EXPECT_EQ( inode_map_entries(&fs, inode), 0 );
+    EXPECT_EQ( available_dblocks(&fs), 84 );
+    free_filesystem(&fs);
+}
+
+// shrinking cuts the cached chain back to the index dblocks still in use, so the index
+// dblocks the file grows into afterwards are cached in their place
+TEST_F(INodeShrinkDataSuite, MapCacheShrink0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 2048);
+    fs.map_cache_budget = 1 << 16;
+    std::vector<char> data(900 * DATA_BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 11 + i / 211);
+    std::vector<char> other(data.size());
+    for (size_t i = 0; i < other.size(); ++i) other[i] = (char)(i * 5 + 1);
+
+    inode_t *inode = &fs.inodes[1];
+    ASSERT_EQ( inode_write_data(&fs, inode, data.data(), data.size()), SUCCESS );
+    const dblock_index_t *chain = NULL;
+    ASSERT_EQ( block_map_cache_find(fs.map_cache, 1, &chain), 60 );
+
+    // the dblocks released by the shrink come back in another order
+    ASSERT_EQ( inode_shrink_data(&fs, inode, 100 * DATA_BLOCK_SIZE + 1), SUCCESS );
+    ASSERT_EQ( block_map_cache_find(fs.map_cache, 1, &chain), 7 );
+    ASSERT_EQ( inode_write_data(&fs, inode, other.data() + 100 * DATA_BLOCK_SIZE + 1, other.size() - 100 * DATA_BLOCK_SIZE - 1), SUCCESS );
+    ASSERT_EQ( block_map_cache_find(fs.map_cache, 1, &chain), 60 );
+
+    std::vector<char> output(data.size());
+    size_t bytes_read = 0;
+    size_t misses = fs.map_cache->misses;
+    ASSERT_EQ( inode_read_data(&fs, inode, 0, output.data(), output.size(), &bytes_read), SUCCESS );
+    ASSERT_EQ( bytes_read, data.size() );
+    EXPECT_EQ( memcmp(output.data(), data.data(), 100 * DATA_BLOCK_SIZE + 1), 0 );
+    EXPECT_EQ( memcmp(output.data() + 100 * DATA_BLOCK_SIZE + 1, other.data() + 100 * DATA_BLOCK_SIZE + 1, data.size() - 100 * DATA_BLOCK_SIZE - 1), 0 );
+    for (size_t offset = 0; offset < data.size(); offset += 3001)
+    {
+        ASSERT_EQ( inode_read_data(&fs, inode, offset, output.data(), 1, &bytes_read), SUCCESS );
+        ASSERT_EQ( output[0], offset <= 100 * DATA_BLOCK_SIZE ? data[offset] : other[offset] ) << "Incorrect data at offset " << offset;
+    }
+    EXPECT_EQ( fs.map_cache->misses, misses );
+
+    ASSERT_EQ( inode_release_data(&fs, inode), SUCCESS );
+    EXPECT_EQ( fs.map_cache->count, 0 );
+    EXPECT_EQ( available_dblocks(&fs), 2047 );
+    free_filesystem(&fs);
+}
+
+// shrinking a tree mapped inode releases the nodes past the new end, and the top levels the
+// kept data dblocks no longer need, down to no tree at all
+TEST_F(INodeShrinkDataSuite, TreeShrink0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 1024);
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = INODE_TREE_MAPPED;
+    std::vector<char> data(300 * DATA_BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 3 + i / 97);
+
+    // 296 entries take a tree three levels high: 19 leaves, 2 nodes and a root
+    ASSERT_EQ( inode_write_data(&fs, inode, data.data(), data.size()), SUCCESS );
+    ASSERT_EQ( available_dblocks(&fs), 1023 - 300 - 22 );
+
+    // 96 entries take 6 leaves and a root
+    ASSERT_EQ( inode_shrink_data(&fs, inode, 100 * DATA_BLOCK_SIZE - 5), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 1023 - 100 - 7 );
+    std::vector<char> output(data.size());
+    size_t bytes_read = 0;
+    ASSERT_EQ( inode_read_data(&fs, inode, 0, output.data(), output.size(), &bytes_read), SUCCESS );
+    ASSERT_EQ( bytes_read, 100 * DATA_BLOCK_SIZE - 5 );
+    EXPECT_EQ( memcmp(output.data(), data.data(), bytes_read), 0 );
+
+    // 16 entries fit in a single leaf
+    ASSERT_EQ( inode_shrink_data(&fs, inode, 20 * DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 1023 - 20 - 1 );
+    ASSERT_EQ( inode_read_data(&fs, inode, 0, output.data(), output.size(), &bytes_read), SUCCESS );
+    EXPECT_EQ( memcmp(output.data(), data.data(), bytes_read), 0 );
+
+    ASSERT_EQ( inode_shrink_data(&fs, inode, 3 * DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 1023 - 3 );
+    EXPECT_EQ( inode->internal.indirect_dblock, 0 );
+
+    // the tree grows back from the direct dblocks
+    ASSERT_EQ( inode_write_data(&fs, inode, data.data() + 3 * DATA_BLOCK_SIZE, data.size() - 3 * DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 1023 - 300 - 22 );
+    ASSERT_EQ( inode_read_data(&fs, inode, 0, output.data(), output.size(), &bytes_read), SUCCESS );
+    EXPECT_EQ( memcmp(output.data(), data.data(), data.size()), 0 );
+    ASSERT_EQ( inode_release_data(&fs, inode), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 1023 );
+    free_filesystem(&fs);
+}
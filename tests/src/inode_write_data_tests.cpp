@@ -117,4 +117,326 @@ TEST_F(INodeWriteDataSuite, WriteDirectIndirect)
 
     check_fs(OUTPUT "WriteDirectIndirect.bin", fs);
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// in goal directed mode a file grows into the first fully available byte of the bitmask
+// after its last data block when the data block right after it is taken
+TEST_F(INodeWriteDataSuite, GoalDirectedWrite0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "large.bin", fs);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_GOAL_DIRECTED)), SUCCESS);
+
+    inode_t *hi_file = &fs.inodes[1];
+    char test_message[128];
+    memset(test_message, 0x20, std::size(test_message));
+    EXPECT_EQ( inode_write_data(&fs, hi_file, test_message, std::size(test_message)), SUCCESS );
+
+    // dblocks 46 and 47 are available but share a byte of the bitmask with used dblocks
+    EXPECT_EQ( hi_file->internal.file_size, 65 + std::size(test_message) );
+    EXPECT_EQ( hi_file->internal.direct_data[2], 48 );
+    EXPECT_EQ( hi_file->internal.direct_data[3], 49 );
+
+    char output[std::size(test_message)];
+    size_t bytes_read = 0;
+    EXPECT_EQ( inode_read_data(&fs, hi_file, 65, output, std::size(output), &bytes_read), SUCCESS );
+    EXPECT_EQ( bytes_read, std::size(output) );
+    EXPECT_EQ( memcmp(output, test_message, std::size(output)), 0 );
+    free_filesystem(&fs);
+}
+
+// an empty file places its first data block at its hint and
+// the index data block follows the last direct data block
+TEST_F(INodeWriteDataSuite, GoalDirectedWrite1)
+{
+    filesystem_t fs;
+    load_fs(INPUT "large.bin", fs);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_GOAL_DIRECTED)), SUCCESS);
+
+    inode_t *empty_inode = &fs.inodes[6];
+    EXPECT_EQ( set_dblock_hint(&fs, empty_inode, 50), SUCCESS );
+    EXPECT_EQ( inode_dblock_goal(&fs, empty_inode), 50 );
+    char test_message[5 * 64];
+    for (size_t i = 0; i < std::size(test_message); ++i) test_message[i] = (char)i;
+    EXPECT_EQ( inode_write_data(&fs, empty_inode, test_message, std::size(test_message)), SUCCESS );
+
+    for (size_t i = 0; i < 4; ++i) EXPECT_EQ( empty_inode->internal.direct_data[i], 50 + i );
+    EXPECT_EQ( empty_inode->internal.indirect_dblock, 54 );
+    EXPECT_EQ( inode_dblock_goal(&fs, empty_inode), 56 );
+
+    char output[std::size(test_message)];
+    size_t bytes_read = 0;
+    EXPECT_EQ( inode_read_data(&fs, empty_inode, 0, output, std::size(output), &bytes_read), SUCCESS );
+    EXPECT_EQ( bytes_read, std::size(output) );
+    EXPECT_EQ( memcmp(output, test_message, std::size(output)), 0 );
+    free_filesystem(&fs);
+}
+
+// in buddy mode a large write takes its dblocks out of aligned blocks a batch at a time, so
+// the data dblocks and the index dblock after them form one run
+TEST_F(INodeWriteDataSuite, BuddyWrite0)
+{
+    filesystem_t fs;
+    fs_options_t options = { INODE_FREE_LIST, DBLOCK_BUDDY, FS_GEOMETRY_CLASSIC };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 2, 1024, &options), SUCCESS);
+
+    inode_t *inode = &fs.inodes[1];
+    std::vector<char> data(12 * DATA_BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 7);
+    EXPECT_EQ( inode_write_data(&fs, inode, data.data(), data.size()), SUCCESS );
+
+    for (size_t i = 1; i < 4; ++i) EXPECT_EQ( inode->internal.direct_data[i], inode->internal.direct_data[0] + i );
+    EXPECT_EQ( inode->internal.indirect_dblock, inode->internal.direct_data[0] + 4 );
+    std::vector<char> output(data.size());
+    size_t bytes_read = 0;
+    EXPECT_EQ( inode_read_data(&fs, inode, 0, output.data(), output.size(), &bytes_read), SUCCESS );
+    EXPECT_EQ( bytes_read, data.size() );
+    EXPECT_EQ( memcmp(output.data(), data.data(), data.size()), 0 );
+    free_filesystem(&fs);
+}
+
+// a write can still use every dblock the holder of a reservation does not
+TEST_F(INodeWriteDataSuite, WriteAroundReservation0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    size_t dblocks = available_dblocks(&fs);
+
+    fs_reservation_t reservation;
+    ASSERT_EQ(fs_reserve(&fs, dblocks - 1, 0, &reservation), SUCCESS);
+
+    inode_t *inode = &fs.inodes[0];
+    byte data[2 * DATA_BLOCK_SIZE] = { 0 };
+    size_t size = inode->internal.file_size;
+    size_t fits = (DATA_BLOCK_SIZE - size % DATA_BLOCK_SIZE) % DATA_BLOCK_SIZE + DATA_BLOCK_SIZE;
+    ASSERT_EQ(inode_write_data(&fs, inode, data, fits + 1), INSUFFICIENT_DBLOCKS);
+    ASSERT_EQ(inode->internal.file_size, size);
+    ASSERT_EQ(inode_write_data(&fs, inode, data, fits), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+
+    ASSERT_EQ(fs_commit(&fs, &reservation), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), dblocks - 1);
+    free_filesystem(&fs);
+}
+
+// an extent mapped inode written into an empty file system holds its data in one extent,
+// where the block map lists every data dblock and 20 index dblocks
+TEST_F(INodeWriteDataSuite, ExtentWrite0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 3, 1024);
+
+    std::vector<char> data(300 * DATA_BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 7);
+    inode_t *extent_inode = &fs.inodes[1];
+    extent_inode->internal.map_flags = INODE_EXTENT_MAPPED;
+    EXPECT_EQ( inode_growth_dblocks(&fs, extent_inode, data.size()), 300 + 60 );
+    EXPECT_EQ( inode_write_data(&fs, extent_inode, data.data(), data.size()), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 1023 - 300 );
+    EXPECT_EQ( inode_map_entries(&fs, extent_inode), 1 );
+    EXPECT_EQ( extent_inode->internal.direct_data[0], 1 );
+    EXPECT_EQ( extent_inode->internal.direct_data[1], 300 );
+    EXPECT_EQ( inode_dblock_goal(&fs, extent_inode), 301 );
+
+    inode_t *mapped_inode = &fs.inodes[2];
+    EXPECT_EQ( inode_growth_dblocks(&fs, mapped_inode, data.size()), 300 + 20 );
+    EXPECT_EQ( inode_write_data(&fs, mapped_inode, data.data(), data.size()), SUCCESS );
+    EXPECT_EQ( inode_map_entries(&fs, mapped_inode), 300 );
+
+    std::vector<char> output(data.size());
+    size_t bytes_read = 0;
+    EXPECT_EQ( inode_read_data(&fs, extent_inode, 0, output.data(), output.size(), &bytes_read), SUCCESS );
+    EXPECT_EQ( bytes_read, data.size() );
+    EXPECT_EQ( memcmp(output.data(), data.data(), data.size()), 0 );
+    free_filesystem(&fs);
+}
+
+// with only pairs of dblocks available every pair is an extent of its own. the first two
+// are inline, and an extent dblock is claimed for every EXTENT_DBLOCK_RECORD_COUNT after them
+TEST_F(INodeWriteDataSuite, ExtentWrite1)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 128);
+    dblock_index_t start;
+    size_t len;
+    while (claim_dblock_range(&fs, fs.dblock_count, 0, &start, &len) == SUCCESS) {}
+    for (size_t d = 1; d + 2 <= fs.dblock_count; d += 3) release_dblock_range(&fs, d, 2);
+    ASSERT_EQ( available_dblocks(&fs), 84 );
+
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = INODE_EXTENT_MAPPED;
+    char data[20 * DATA_BLOCK_SIZE - 10];
+    for (size_t i = 0; i < std::size(data); ++i) data[i] = (char)(i * 13);
+    // appends fill up the last data dblock before claiming more
+    EXPECT_EQ( inode_write_data(&fs, inode, data, 100), SUCCESS );
+    EXPECT_EQ( inode_write_data(&fs, inode, data + 100, std::size(data) - 100), SUCCESS );
+
+    // dblocks 1 to 29 hold the data and the extent dblocks come after them
+    EXPECT_EQ( inode_map_entries(&fs, inode), 10 );
+    EXPECT_EQ( available_dblocks(&fs), 84 - 20 - 2 );
+    EXPECT_EQ( inode->internal.direct_data[2], 4 );
+    EXPECT_EQ( inode->internal.direct_data[3], 2 );
+    EXPECT_EQ( inode->internal.indirect_dblock, 31 );
+    EXPECT_EQ( inode_dblock_goal(&fs, inode), 30 );
+
+    char output[std::size(data)];
+    size_t bytes_read = 0;
+    EXPECT_EQ( inode_read_data(&fs, inode, 0, output, std::size(output), &bytes_read), SUCCESS );
+    EXPECT_EQ( bytes_read, std::size(data) );
+    EXPECT_EQ( memcmp(output, data, std::size(data)), 0 );
+    free_filesystem(&fs);
+}
+
+// extent mapped inodes are recorded in the image, while the same byte of an image without
+// the feature is left over padding and ignored
+TEST_F(INodeWriteDataSuite, ExtentSaveLoad0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 4, 64);
+    inode_index_t idx;
+    ASSERT_EQ(claim_available_inode(&fs, &idx), SUCCESS);
+    inode_t *inode = &fs.inodes[idx];
+    inode->internal.map_flags = INODE_EXTENT_MAPPED;
+    char data[5 * DATA_BLOCK_SIZE];
+    for (size_t i = 0; i < std::size(data); ++i) data[i] = (char)(i * 3);
+    ASSERT_EQ(inode_write_data(&fs, inode, data, std::size(data)), SUCCESS);
+
+    FILE *image = tmpfile();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(save_filesystem(image, &fs), SUCCESS);
+    rewind(image);
+    filesystem_t loaded;
+    ASSERT_EQ(load_filesystem(image, &loaded), SUCCESS);
+    ASSERT_EQ(loaded.inodes[idx].internal.map_flags, INODE_EXTENT_MAPPED);
+    ASSERT_EQ(inode_map_entries(&loaded, &loaded.inodes[idx]), 1);
+    char output[std::size(data)];
+    size_t bytes_read = 0;
+    ASSERT_EQ(inode_read_data(&loaded, &loaded.inodes[idx], 0, output, std::size(output), &bytes_read), SUCCESS);
+    ASSERT_EQ(memcmp(output, data, std::size(data)), 0);
+    free_filesystem(&loaded);
+    fclose(image);
+
+    // a released inode does not count
+    ASSERT_EQ(inode_release_data(&fs, inode), SUCCESS);
+    ASSERT_EQ(release_inode(&fs, inode), SUCCESS);
+    image = tmpfile();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(save_filesystem(image, &fs), SUCCESS);
+    free_filesystem(&fs);
+    rewind(image);
+    ASSERT_EQ(load_filesystem(image, &loaded), SUCCESS);
+    ASSERT_EQ(loaded.inodes[idx].internal.map_flags, 0);
+    free_filesystem(&loaded);
+    fclose(image);
+}
+
+// entry `slot` of the index dblock `index_dblock`
+static dblock_index_t tree_entry(filesystem_t *fs, dblock_index_t index_dblock, size_t slot)
+{
+    dblock_index_t entry;
+    memcpy(&entry, &fs->dblocks[index_dblock * DATA_BLOCK_SIZE + slot * sizeof(dblock_index_t)], sizeof(entry));
+    return entry;
+}
+
+// a tree mapped inode lists its data dblocks past the direct ones in a leaf, and the first
+// data dblock past a full tree gives it a new root holding the old one and a new leaf
+TEST_F(INodeWriteDataSuite, TreeWrite0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 64);
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = INODE_TREE_MAPPED;
+    char data[21 * DATA_BLOCK_SIZE];
+    for (size_t i = 0; i < std::size(data); ++i) data[i] = (char)(i * 7 + 1);
+
+    ASSERT_EQ( inode_write_data(&fs, inode, data, 4 * DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( inode->internal.indirect_dblock, 0 );
+    EXPECT_EQ( inode_growth_dblocks(&fs, inode, 20 * DATA_BLOCK_SIZE), 17 );
+    ASSERT_EQ( inode_write_data(&fs, inode, data + 4 * DATA_BLOCK_SIZE, 16 * DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( inode->internal.indirect_dblock, 5 );
+    EXPECT_EQ( available_dblocks(&fs), 63 - 21 );
+
+    // the leaf is full, so the tree grows a level before the next data dblock
+    EXPECT_EQ( inode_growth_dblocks(&fs, inode, 20 * DATA_BLOCK_SIZE + 1), 3 );
+    ASSERT_EQ( inode_write_data(&fs, inode, data + 20 * DATA_BLOCK_SIZE, DATA_BLOCK_SIZE), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 63 - 24 );
+    EXPECT_EQ( inode->internal.indirect_dblock, 22 );
+    EXPECT_EQ( tree_entry(&fs, 22, 0), 5 );
+    EXPECT_EQ( tree_entry(&fs, 22, 1), 23 );
+    EXPECT_EQ( tree_entry(&fs, 23, 0), 24 );
+    EXPECT_EQ( tree_entry(&fs, 5, 15), 21 );
+    EXPECT_EQ( inode_map_entries(&fs, inode), 21 );
+    EXPECT_EQ( inode_dblock_goal(&fs, inode), 25 );
+
+    char output[std::size(data)];
+    size_t bytes_read = 0;
+    ASSERT_EQ( inode_read_data(&fs, inode, 0, output, std::size(output), &bytes_read), SUCCESS );
+    ASSERT_EQ( bytes_read, std::size(data) );
+    EXPECT_EQ( memcmp(output, data, std::size(data)), 0 );
+    free_filesystem(&fs);
+}
+
+// a tree four levels high takes an index dblock per 16 data dblocks and one per 16 index
+// dblocks below it, and gives every one of them back when released
+TEST_F(INodeWriteDataSuite, TreeWrite1)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 6000);
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_GOAL_DIRECTED)), SUCCESS);
+    inode_t *inode = &fs.inodes[1];
+    inode->internal.map_flags = INODE_TREE_MAPPED;
+    std::vector<char> data(5000 * DATA_BLOCK_SIZE);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char)(i * 13 + i / 1031);
+
+    // 4996 entries past the direct ones: 313 leaves, 20 nodes above them, 2 above those and a root
+    EXPECT_EQ( inode_growth_dblocks(&fs, inode, data.size()), 5000 + 313 + 20 + 2 + 1 );
+    ASSERT_EQ( inode_write_data(&fs, inode, data.data(), data.size() / 2), SUCCESS );
+    ASSERT_EQ( inode_write_data(&fs, inode, data.data() + data.size() / 2, data.size() / 2), SUCCESS );
+    EXPECT_EQ( available_dblocks(&fs), 5999 - 5336 );
+
+    std::vector<char> output(3 * DATA_BLOCK_SIZE);
+    for (size_t offset = 0; offset < data.size(); offset += 1237)
+    {
+        size_t expected = std::min(output.size(), data.size() - offset);
+        size_t bytes_read = 0;
+        ASSERT_EQ( inode_read_data(&fs, inode, offset, output.data(), output.size(), &bytes_read), SUCCESS );
+        ASSERT_EQ( bytes_read, expected );
+        ASSERT_EQ( memcmp(output.data(), data.data() + offset, expected), 0 ) << "Incorrect data at offset " << offset;
+    }
+
+    ASSERT_EQ( inode_release_data(&fs, inode), SUCCESS );
+    EXPECT_EQ( inode->internal.indirect_dblock, 0 );
+    EXPECT_EQ( available_dblocks(&fs), 5999 );
+    free_filesystem(&fs);
+}
+
+// tree mapped inodes keep their flag through a save and load, which lists the feature
+TEST_F(INodeWriteDataSuite, TreeSaveLoad0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 4, 128);
+    inode_index_t idx;
+    ASSERT_EQ(claim_available_inode(&fs, &idx), SUCCESS);
+    inode_t *inode = &fs.inodes[idx];
+    inode->internal.map_flags = INODE_TREE_MAPPED;
+    char data[40 * DATA_BLOCK_SIZE];
+    for (size_t i = 0; i < std::size(data); ++i) data[i] = (char)(i * 5);
+    ASSERT_EQ(inode_write_data(&fs, inode, data, std::size(data)), SUCCESS);
+
+    FILE *image = tmpfile();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(save_filesystem(image, &fs), SUCCESS);
+    rewind(image);
+    filesystem_t loaded;
+    ASSERT_EQ(load_filesystem(image, &loaded), SUCCESS);
+    ASSERT_EQ(loaded.inodes[idx].internal.map_flags, INODE_TREE_MAPPED);
+    char output[std::size(data)];
+    size_t bytes_read = 0;
+    ASSERT_EQ(inode_read_data(&loaded, &loaded.inodes[idx], 0, output, std::size(output), &bytes_read), SUCCESS);
+    ASSERT_EQ(memcmp(output, data, std::size(data)), 0);
+    ASSERT_EQ(inode_release_data(&loaded, &loaded.inodes[idx]), SUCCESS);
+    ASSERT_EQ(available_dblocks(&loaded), 127);
+    free_filesystem(&loaded);
+    fclose(image);
+    free_filesystem(&fs);
+}
@@ -208,4 +208,39 @@ TEST_F(NewDirectorySuite, NewDirectory1)
     check_stdout(OUTPUT "Empty.txt");
     check_fs(OUTPUT "NewDirectory1.bin", fs);
     free_filesystem(&fs);
-}
\ No newline at end of file
+}
+
+// with block groups a new directory is spread to an emptier group and the files inside
+// it, along with their data, stay in that group
+TEST_F(NewDirectorySuite, BlockGroups0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 32, 256);
+    ASSERT_EQ(set_block_group_size(&fs, 64), SUCCESS);
+    fs.inode_alloc_mode = INODE_BLOCK_GROUPS;
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_GOAL_DIRECTED)), SUCCESS);
+
+    terminal_context_t ctx { &fs, &fs.inodes[0] };
+    int ret0, ret1;
+    {   // begin stdout logging
+        stdout_logger_lock lk{ this };
+        ret0 = new_directory(&ctx, PATH("./dir"));
+        ret1 = new_file(&ctx, PATH("./dir/file"), FS_READ);
+    }   // end stdout logging
+    ASSERT_EQ(ret0, 0);
+    ASSERT_EQ(ret1, 0);
+    check_stdout(OUTPUT "Empty.txt");
+
+    // group 0 has the root directory and its dblock, so the directory goes to group 1
+    inode_t *dir = &fs.inodes[8];
+    ASSERT_EQ(dir->internal.file_type, DIRECTORY);
+    ASSERT_EQ(dir->internal.direct_data[0], 64);
+
+    inode_t *file = &fs.inodes[9];
+    ASSERT_EQ(file->internal.file_type, DATA_FILE);
+    char data[100] = { 0 };
+    ASSERT_EQ(inode_write_data(&fs, file, data, std::size(data)), SUCCESS);
+    ASSERT_EQ(file->internal.direct_data[0], 65);
+    ASSERT_EQ(file->internal.direct_data[1], 66);
+    free_filesystem(&fs);
+}
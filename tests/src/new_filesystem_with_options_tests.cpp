@@ -0,0 +1,170 @@
+#include "test_util.hpp"
+
+using NewFilesystemWithOptionsSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(NewFilesystemWithOptionsSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    fs_options_t options { INODE_BITMAP, DBLOCK_FIRST_FIT, FS_GEOMETRY_CLASSIC };
+    auto output_retcode0 = new_filesystem_with_options(NULL, 1, 1, &options);
+    auto output_retcode1 = new_filesystem_with_options(&fs, 1, 1, NULL);
+    auto output_retcode2 = new_filesystem_with_options(&fs, 0, 1, &options);
+
+    ASSERT_EQ(expected_retcode, output_retcode0) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode1) << "Return values do not match for options = NULL case!";
+    ASSERT_EQ(expected_retcode, output_retcode2) << "Return values do not match for inode_total = 0 case!";
+}
+
+// the default options save the same image as new_filesystem
+TEST_F(NewFilesystemWithOptionsSuite, SmallFS0)
+{
+    filesystem_t fs;
+    fs_options_t options { INODE_FREE_LIST, DBLOCK_FIRST_FIT, FS_GEOMETRY_CLASSIC };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 8, 8, &options), SUCCESS);
+
+    check_fs(OUTPUT "SmallFS0.bin", fs);
+    free_filesystem(&fs);
+}
+
+// the bitmap allocator is recorded in the image and used again after loading it
+TEST_F(NewFilesystemWithOptionsSuite, BitmapSaveLoad0)
+{
+    filesystem_t fs;
+    fs_options_t options { INODE_BITMAP, DBLOCK_FIRST_FIT, FS_GEOMETRY_CLASSIC };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 8, 8, &options), SUCCESS);
+    ASSERT_EQ(fs.inode_alloc_mode, INODE_BITMAP);
+
+    inode_index_t idx;
+    for (int i = 0; i < 4; ++i) ASSERT_EQ(claim_available_inode(&fs, &idx), SUCCESS);
+    release_inode(&fs, &fs.inodes[2]);
+    release_inode(&fs, &fs.inodes[3]);
+
+    FILE *image = tmpfile();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(save_filesystem(image, &fs), SUCCESS);
+    free_filesystem(&fs);
+
+    rewind(image);
+    filesystem_t loaded;
+    ASSERT_EQ(load_filesystem(image, &loaded), SUCCESS);
+    ASSERT_EQ(loaded.inode_alloc_mode, INODE_BITMAP);
+    ASSERT_EQ(available_inodes(&loaded), 5);
+
+    // the free list has 3 at its head, the bitmap allocator takes the lowest one
+    ASSERT_EQ(loaded.available_inode, 3);
+    ASSERT_EQ(claim_available_inode(&loaded, &idx), SUCCESS);
+    ASSERT_EQ(idx, 2);
+    free_filesystem(&loaded);
+    fclose(image);
+}
+
+// images listing features this code does not know about are refused
+TEST_F(NewFilesystemWithOptionsSuite, UnknownFeature0)
+{
+    filesystem_t fs;
+    fs_options_t options { INODE_BITMAP, DBLOCK_FIRST_FIT, FS_GEOMETRY_CLASSIC };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 8, 8, &options), SUCCESS);
+
+    FILE *image = tmpfile();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(save_filesystem(image, &fs), SUCCESS);
+    free_filesystem(&fs);
+
+    // the feature flags are the last 4 bytes of the image
+    uint32_t features = 0x80000000u;
+    fseek(image, -(long)sizeof(features), SEEK_END);
+    fwrite(&features, sizeof(features), 1, image);
+
+    rewind(image);
+    filesystem_t loaded;
+    ASSERT_EQ(load_filesystem(image, &loaded), INVALID_BINARY_FORMAT);
+    free_filesystem(&loaded);
+    fclose(image);
+}
+
+// the extent tree allocator is recorded in the image and its tree is built again on load
+TEST_F(NewFilesystemWithOptionsSuite, ExtentTreeSaveLoad0)
+{
+    filesystem_t fs;
+    fs_options_t options { INODE_FREE_LIST, DBLOCK_EXTENT_TREE, FS_GEOMETRY_CLASSIC };
+    ASSERT_EQ(new_filesystem_with_options(&fs, 8, 64, &options), SUCCESS);
+    ASSERT_EQ(fs.dblock_alloc_mode, DBLOCK_EXTENT_TREE);
+
+    // leaves the runs [11, 15] and [20, 63]
+    dblock_index_t indices[19];
+    ASSERT_EQ(claim_available_dblocks(&fs, 19, indices), SUCCESS);
+    ASSERT_EQ(release_dblock_range(&fs, 11, 5), SUCCESS);
+
+    FILE *image = tmpfile();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(save_filesystem(image, &fs), SUCCESS);
+    free_filesystem(&fs);
+
+    rewind(image);
+    filesystem_t loaded;
+    ASSERT_EQ(load_filesystem(image, &loaded), SUCCESS);
+    ASSERT_EQ(loaded.dblock_alloc_mode, DBLOCK_EXTENT_TREE);
+    ASSERT_EQ(available_dblocks(&loaded), 49);
+
+    // the hole is the best fit for a short run
+    dblock_index_t start = 0;
+    size_t len = 0;
+    ASSERT_EQ(claim_dblock_range(&loaded, 4, 0, &start, &len), SUCCESS);
+    ASSERT_EQ(start, 11);
+    ASSERT_EQ(len, 4);
+    free_filesystem(&loaded);
+    fclose(image);
+}
+
+// large geometry holds more inodes than 2 byte indices can tell apart, and is recorded in
+// the image header
+TEST_F(NewFilesystemWithOptionsSuite, LargeGeometrySaveLoad0)
+{
+    constexpr size_t inode_total = 70000;
+
+    filesystem_t fs;
+    fs_options_t classic { INODE_FREE_LIST, DBLOCK_FIRST_FIT, FS_GEOMETRY_CLASSIC };
+    fs_options_t large { INODE_FREE_LIST, DBLOCK_FIRST_FIT, FS_GEOMETRY_LARGE };
+    ASSERT_EQ(new_filesystem(&fs, inode_total, 8), INVALID_INPUT);
+    ASSERT_EQ(new_filesystem_with_options(&fs, inode_total, 8, &classic), INVALID_INPUT);
+    ASSERT_EQ(new_filesystem_with_options(&fs, inode_total, 8, &large), SUCCESS);
+    ASSERT_EQ(fs.geometry, FS_GEOMETRY_LARGE);
+
+    // the root directory holds one wider entry for itself
+    ASSERT_EQ(fs.inodes[0].internal.file_size, LARGE_DIRECTORY_ENTRY_SIZE);
+    ASSERT_EQ(directory_entry_inode(&fs, fs.dblocks), 0);
+    ASSERT_STREQ(directory_entry_name(&fs, fs.dblocks), ".");
+
+    // claim past the inodes a classic image can index
+    inode_index_t idx = 0;
+    for (size_t i = 0; i < 66000; ++i) ASSERT_EQ(claim_available_inode(&fs, &idx), SUCCESS);
+    ASSERT_EQ(idx, 66000);
+    ASSERT_EQ(fs.available_inode, 66001);
+
+    FILE *image = tmpfile();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(save_filesystem(image, &fs), SUCCESS);
+    free_filesystem(&fs);
+
+    rewind(image);
+    size_t inode_count = 0;
+    uint32_t available_inode = 0;
+    ASSERT_EQ(fread(&inode_count, sizeof(inode_count), 1, image), 1);
+    ASSERT_EQ(fread(&available_inode, sizeof(available_inode), 1, image), 1);
+    ASSERT_EQ(inode_count, inode_total | FS_LARGE_GEOMETRY_FLAG);
+    ASSERT_EQ(available_inode, 66001);
+
+    rewind(image);
+    filesystem_t loaded;
+    ASSERT_EQ(load_filesystem(image, &loaded), SUCCESS);
+    ASSERT_EQ(loaded.geometry, FS_GEOMETRY_LARGE);
+    ASSERT_EQ(loaded.inode_count, inode_total);
+    ASSERT_EQ(available_inodes(&loaded), inode_total - 66001);
+    ASSERT_EQ(claim_available_inode(&loaded, &idx), SUCCESS);
+    ASSERT_EQ(idx, 66001);
+    free_filesystem(&loaded);
+    fclose(image);
+}
@@ -0,0 +1,62 @@
+#include "test_util.hpp"
+
+using ReleaseDBlockRangeSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(ReleaseDBlockRangeSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    load_fs(INPUT "medium.bin", fs);
+
+    ASSERT_EQ(expected_retcode, release_dblock_range(NULL, 1, 1)) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, release_dblock_range(&fs, 1, 0)) << "Return values do not match for len = 0 case!";
+    ASSERT_EQ(expected_retcode, release_dblock_range(&fs, fs.dblock_count, 1)) << "Return values do not match for start out of range case!";
+    ASSERT_EQ(expected_retcode, release_dblock_range(&fs, 1, fs.dblock_count)) << "Return values do not match for run out of range case!";
+
+    check_fs(INPUT "medium.bin", fs);
+    free_filesystem(&fs);
+}
+
+// releasing a run matches releasing each dblock of it one at a time
+TEST_F(ReleaseDBlockRangeSuite, SimpleReleaseRange0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+
+    for (dblock_index_t idx : { 27, 10, 23, 13, 30, 2 })
+    {
+        ASSERT_EQ(release_dblock_range(&fs, idx, 1), SUCCESS) << "Return value do not match for releasing D-block index " << idx << "!";
+    }
+
+    check_fs(OUTPUT "ComplexReleaseDBlock0.bin", fs);
+    free_filesystem(&fs);
+}
+
+// released runs can be claimed again as a whole
+TEST_F(ReleaseDBlockRangeSuite, ReleaseClaimRange0)
+{
+    constexpr size_t dblock_total = 200;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+
+    dblock_index_t start;
+    size_t len;
+    ASSERT_EQ(claim_dblock_range(&fs, dblock_total, 0, &start, &len), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+
+    ASSERT_EQ(release_dblock_range(&fs, 61, 75), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 75);
+    // releasing part of the run again does not change the count
+    ASSERT_EQ(release_dblock_range(&fs, 100, 10), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 75);
+
+    ASSERT_EQ(claim_dblock_range(&fs, 100, 0, &start, &len), SUCCESS);
+    ASSERT_EQ(start, 61);
+    ASSERT_EQ(len, 75);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+
+    free_filesystem(&fs);
+}
@@ -0,0 +1,58 @@
+#include "test_util.hpp"
+
+using ReleaseDBlocksSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(ReleaseDBlocksSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    load_fs(INPUT "medium.bin", fs);
+
+    dblock_index_t indices[] = { 1, 2, (dblock_index_t)fs.dblock_count };
+    ASSERT_EQ(expected_retcode, release_dblocks(NULL, indices, 1)) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, release_dblocks(&fs, NULL, 1)) << "Return values do not match for indices = NULL case!";
+    ASSERT_EQ(expected_retcode, release_dblocks(&fs, indices, std::size(indices))) << "Return values do not match for index out of range case!";
+
+    // nothing is released when any index is out of range
+    check_fs(INPUT "medium.bin", fs);
+    free_filesystem(&fs);
+}
+
+// one batch matches ComplexReleaseDBlock0 releasing one dblock at a time
+TEST_F(ReleaseDBlocksSuite, ComplexRelease0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+
+    dblock_index_t indices[] = { 27, 10, 23, 13, 30, 2 };
+    ASSERT_EQ(release_dblocks(&fs, indices, std::size(indices)), SUCCESS);
+
+    check_fs(OUTPUT "ComplexReleaseDBlock0.bin", fs);
+    free_filesystem(&fs);
+}
+
+// released dblocks are counted once and can be claimed again
+TEST_F(ReleaseDBlocksSuite, ReleaseClaim0)
+{
+    constexpr size_t dblock_total = 200;
+
+    filesystem_t fs;
+    ASSERT_EQ(new_filesystem(&fs, 4, dblock_total), SUCCESS);
+
+    dblock_index_t claimed[dblock_total - 1];
+    ASSERT_EQ(claim_available_dblocks(&fs, std::size(claimed), claimed), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+
+    dblock_index_t indices[] = { 150, 7, 64, 63, 7, 199 };
+    ASSERT_EQ(release_dblocks(&fs, indices, std::size(indices)), SUCCESS);
+    ASSERT_EQ(available_dblocks(&fs), 5);
+
+    dblock_index_t output[5];
+    ASSERT_EQ(claim_available_dblocks(&fs, std::size(output), output), SUCCESS);
+    dblock_index_t expected[] = { 7, 63, 64, 150, 199 };
+    for (size_t i = 0; i < std::size(expected); ++i) ASSERT_EQ(output[i], expected[i]);
+    ASSERT_EQ(available_dblocks(&fs), 0);
+    free_filesystem(&fs);
+}
@@ -0,0 +1,41 @@
+#include "test_util.hpp"
+
+using ReleaseINodesSuite = fs_internal_test;
+
+// test invalid input
+TEST_F(ReleaseINodesSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    load_fs(INPUT "half_random_inode_fragmented.bin", fs);
+
+    inode_index_t root[] = { 30, 0 };
+    inode_index_t out_of_range[] = { 30, (inode_index_t)fs.inode_count };
+    ASSERT_EQ(expected_retcode, release_inodes(NULL, root, 1)) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, release_inodes(&fs, NULL, 1)) << "Return values do not match for indices = NULL case!";
+    ASSERT_EQ(expected_retcode, release_inodes(&fs, root, std::size(root))) << "Return values do not match for root inode case!";
+    ASSERT_EQ(expected_retcode, release_inodes(&fs, out_of_range, std::size(out_of_range))) << "Return values do not match for index out of range case!";
+
+    // nothing is released when any index is invalid
+    check_fs(INPUT "half_random_inode_fragmented.bin", fs);
+    free_filesystem(&fs);
+}
+
+// one batch matches ComplexReleaseINode0 releasing one inode at a time
+TEST_F(ReleaseINodesSuite, ComplexRelease0)
+{   
+    inode_index_t inodes_to_release_list[] = { 
+        30, 29, 28, 26, 24, 23, 22, 20,
+        19, 16, 14, 13, 10, 9, 8, 7,
+        6, 5, 3, 2, 1
+    };
+
+    filesystem_t fs;
+    load_fs(INPUT "half_random_inode_fragmented.bin", fs);
+
+    ASSERT_EQ(release_inodes(&fs, inodes_to_release_list, std::size(inodes_to_release_list)), SUCCESS);
+
+    check_fs(OUTPUT "ComplexReleaseINode0.bin", fs);
+    free_filesystem(&fs);
+}
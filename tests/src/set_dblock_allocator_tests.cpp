@@ -0,0 +1,145 @@
+#include "test_util.hpp"
+
+using SetDBlockAllocatorSuite = fs_internal_test;
+
+// a first fit policy that counts the dblocks it hands out, to see the claims go through it
+static size_t counted_claims;
+
+static fs_retcode_t counting_claim(filesystem_t *fs, dblock_index_t *index)
+{
+    ++counted_claims;
+    return dblock_allocator_for_mode(DBLOCK_FIRST_FIT)->claim(fs, index);
+}
+
+static void counting_take(filesystem_t *fs, size_t n, dblock_index_t *out)
+{
+    counted_claims += n;
+    dblock_allocator_for_mode(DBLOCK_FIRST_FIT)->take(fs, n, out);
+}
+
+static fs_retcode_t failing_attach(filesystem_t *fs)
+{
+    return SYSTEM_ERROR;
+}
+
+// test invalid input
+TEST_F(SetDBlockAllocatorSuite, InvalidInput)
+{
+    constexpr fs_retcode_t expected_retcode = INVALID_INPUT;
+
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 8);
+    dblock_allocator_t incomplete = *dblock_allocator_for_mode(DBLOCK_FIRST_FIT);
+    incomplete.release_list = NULL;
+
+    ASSERT_EQ(expected_retcode, set_dblock_allocator(NULL, dblock_allocator_for_mode(DBLOCK_FIRST_FIT))) << "Return values do not match for fs = NULL case!";
+    ASSERT_EQ(expected_retcode, set_dblock_allocator(&fs, NULL)) << "Return values do not match for allocator = NULL case!";
+    ASSERT_EQ(expected_retcode, set_dblock_allocator(&fs, &incomplete)) << "Return values do not match for a policy without release_list!";
+    ASSERT_EQ(dblock_allocator_for_mode((dblock_alloc_mode_t) 100), nullptr) << "An unknown mode has no policy!";
+    ASSERT_EQ(fs.allocator, dblock_allocator_for_mode(DBLOCK_FIRST_FIT)) << "A rejected policy must not be used!";
+    free_filesystem(&fs);
+}
+
+// new and loaded file systems use the built in policy of their mode
+TEST_F(SetDBlockAllocatorSuite, BuiltIn0)
+{
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    ASSERT_EQ(fs.allocator, dblock_allocator_for_mode(DBLOCK_FIRST_FIT));
+    free_filesystem(&fs);
+
+    for (dblock_alloc_mode_t mode : { DBLOCK_FIRST_FIT, DBLOCK_NEXT_FIT, DBLOCK_GOAL_DIRECTED, DBLOCK_ATOMIC, DBLOCK_EXTENT_TREE, DBLOCK_BUDDY })
+    {
+        fs_options_t options = { INODE_FREE_LIST, mode, FS_GEOMETRY_CLASSIC };
+        ASSERT_EQ(new_filesystem_with_options(&fs, 2, 128, &options), SUCCESS);
+        ASSERT_EQ(fs.allocator, dblock_allocator_for_mode(mode)) << "Wrong policy for mode " << mode;
+        ASSERT_EQ(fs.allocator->mode, mode);
+
+        // every policy hands out each dblock once
+        dblock_index_t idx;
+        std::vector<bool> seen(128);
+        seen[0] = true;
+        while (claim_available_dblock(&fs, &idx) == SUCCESS)
+        {
+            ASSERT_FALSE(seen[idx]) << "D-Block " << idx << " was claimed twice in mode " << mode;
+            seen[idx] = true;
+        }
+        ASSERT_EQ(available_dblocks(&fs), 0u);
+        free_filesystem(&fs);
+    }
+}
+
+// the claim functions go through a policy that is set, until the mode is assigned again
+TEST_F(SetDBlockAllocatorSuite, CustomPolicy0)
+{
+    dblock_allocator_t counting = *dblock_allocator_for_mode(DBLOCK_FIRST_FIT);
+    counting.name = "counting";
+    counting.claim = counting_claim;
+    counting.take = counting_take;
+
+    filesystem_t fs;
+    load_fs(INPUT "empty_random_inode_fragmented.bin", fs);
+    counted_claims = 0;
+    ASSERT_EQ(set_dblock_allocator(&fs, &counting), SUCCESS);
+    ASSERT_EQ(fs.dblock_alloc_mode, DBLOCK_FIRST_FIT);
+
+    // the policy picks the same dblocks first fit would
+    dblock_index_t idx, batch[3];
+    ASSERT_EQ(claim_available_dblock(&fs, &idx), SUCCESS);
+    ASSERT_EQ(idx, 1u);
+    ASSERT_EQ(claim_available_dblocks(&fs, 3, batch), SUCCESS);
+    ASSERT_EQ(batch[0], 3u);
+    ASSERT_EQ(counted_claims, 4u);
+    // goals go to claim_available_dblock since the policy has no use for them
+    ASSERT_EQ(claim_dblock_near(&fs, 20, &idx), SUCCESS);
+    ASSERT_EQ(counted_claims, 5u);
+
+    // switching to a built in mode replaces the policy
+    ASSERT_EQ(set_dblock_allocator(&fs, dblock_allocator_for_mode(DBLOCK_NEXT_FIT)), SUCCESS);
+    ASSERT_EQ(fs.dblock_alloc_mode, DBLOCK_NEXT_FIT);
+    ASSERT_EQ(claim_available_dblock(&fs, &idx), SUCCESS);
+    ASSERT_EQ(counted_claims, 5u);
+    ASSERT_EQ(fs.allocator, dblock_allocator_for_mode(DBLOCK_NEXT_FIT));
+    free_filesystem(&fs);
+}
+
+// a policy that cannot attach leaves the previous one in place
+TEST_F(SetDBlockAllocatorSuite, AttachFailure0)
+{
+    dblock_allocator_t failing = *dblock_allocator_for_mode(DBLOCK_EXTENT_TREE);
+    failing.attach = failing_attach;
+
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 64);
+    ASSERT_EQ(set_dblock_allocator(&fs, &failing), SYSTEM_ERROR);
+    ASSERT_EQ(fs.allocator, dblock_allocator_for_mode(DBLOCK_FIRST_FIT));
+    ASSERT_EQ(fs.dblock_alloc_mode, DBLOCK_FIRST_FIT);
+    free_filesystem(&fs);
+}
+
+// the counters follow the claims and releases while they are hooked up
+TEST_F(SetDBlockAllocatorSuite, Stats0)
+{
+    filesystem_t fs;
+    new_filesystem(&fs, 2, 1024);
+    dblock_alloc_stats_t stats = {};
+    fs.alloc_stats = &stats;
+
+    dblock_index_t batch[100], start;
+    size_t len;
+    ASSERT_EQ(claim_available_dblocks(&fs, 100, batch), SUCCESS);
+    ASSERT_EQ(claim_dblock_range(&fs, 10, 0, &start, &len), SUCCESS);
+    ASSERT_EQ(release_dblocks(&fs, batch, 50), SUCCESS);
+    ASSERT_EQ(release_dblock(&fs, &fs.dblocks[batch[50] * DATA_BLOCK_SIZE]), SUCCESS);
+    ASSERT_EQ(stats.dblocks_claimed, 100u + len);
+    ASSERT_EQ(stats.dblocks_released, 51u);
+    ASSERT_GT(stats.bitmask_words, 0u);
+
+    // nothing is counted once they are unhooked
+    fs.alloc_stats = NULL;
+    stats = {};
+    ASSERT_EQ(claim_available_dblocks(&fs, 10, batch), SUCCESS);
+    ASSERT_EQ(stats.dblocks_claimed, 0u);
+    ASSERT_EQ(stats.bitmask_words, 0u);
+    free_filesystem(&fs);
+}
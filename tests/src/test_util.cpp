@@ -25,10 +25,13 @@ void compare_fs_files(char *output_buf, size_t output_size, char *expected_buf,
     index += sizeof(size_t);
     ASSERT_EQ(output_inode_count, expected_inode_count) << "Incorrect inode count in filesystem.";
 
-    // compare the next available inode
-    memcpy(&output_available_inode_index, &output_buf[index], sizeof(inode_index_t));
-    memcpy(&expected_available_inode_index, &expected_buf[index], sizeof(inode_index_t));
-    index += sizeof(inode_index_t);
+    // compare the next available inode, which takes 4 bytes in large geometry images
+    size_t available_inode_size = expected_inode_count & FS_LARGE_GEOMETRY_FLAG ? sizeof(uint32_t) : sizeof(uint16_t);
+    expected_inode_count &= ~FS_LARGE_GEOMETRY_FLAG;
+    output_available_inode_index = expected_available_inode_index = 0;
+    memcpy(&output_available_inode_index, &output_buf[index], available_inode_size);
+    memcpy(&expected_available_inode_index, &expected_buf[index], available_inode_size);
+    index += available_inode_size;
     ASSERT_EQ(output_available_inode_index, expected_available_inode_index) << "Incorrect first available inode index.";
 
     // compare the dblock
@@ -67,4 +70,9 @@ void compare_fs_files(char *output_buf, size_t output_size, char *expected_buf,
             ++index;
         }
     }
-}
\ No newline at end of file
+}
+
+bool bit_is_set(const std::vector<uint8_t> &bits, size_t n)
+{
+    return bits[n / 8] & (1 << (7 - n % 8));
+}
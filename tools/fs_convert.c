@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "filesys.h"
+
+/**
+ * converts a saved file system image to another geometry.
+ *
+ * the image is loaded, every directory is rewritten with entries of the new width by
+ * `fs_convert_geometry`, and the result is checked with `fs_check` before it is saved.
+ * the input image is never written to, so a failed conversion leaves it as it was.
+ *
+ * usage: fs_convert input output [classic|large]
+ */
+
+static int parse_geometry(const char *name, fs_geometry_t *geometry)
+{
+    if (strcmp(name, "classic") == 0) *geometry = FS_GEOMETRY_CLASSIC;
+    else if (strcmp(name, "large") == 0) *geometry = FS_GEOMETRY_LARGE;
+    else return 0;
+    return 1;
+}
+
+static const char *geometry_name(fs_geometry_t geometry)
+{
+    return geometry == FS_GEOMETRY_LARGE ? "large" : "classic";
+}
+
+int main(int argc, char **argv)
+{
+    fs_geometry_t geometry = FS_GEOMETRY_LARGE;
+    if (argc < 3 || argc > 4 || (argc == 4 && !parse_geometry(argv[3], &geometry)))
+    {
+        fprintf(stderr, "usage: %s input output [classic|large]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *input = fopen(argv[1], "r");
+    if (!input)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    filesystem_t fs;
+    fs_retcode_t ret = load_filesystem(input, &fs);
+    fclose(input);
+    if (ret != SUCCESS)
+    {
+        fprintf(stderr, "%s: %s\n", argv[1], fs_retcode_string_table[ret]);
+        free_filesystem(&fs);
+        return 1;
+    }
+
+    fs_geometry_t from = fs.geometry;
+    ret = fs_convert_geometry(&fs, geometry);
+    fs_check_report_t report;
+    if (ret == SUCCESS) ret = fs_check(&fs, &report);
+    if (ret != SUCCESS)
+    {
+        fprintf(stderr, "cannot convert %s to %s geometry: %s\n", argv[1], geometry_name(geometry), fs_retcode_string_table[ret]);
+        free_filesystem(&fs);
+        return 1;
+    }
+
+    FILE *output = fopen(argv[2], "w");
+    if (!output)
+    {
+        perror(argv[2]);
+        free_filesystem(&fs);
+        return 1;
+    }
+    ret = save_filesystem(output, &fs);
+    if (fclose(output) != 0 && ret == SUCCESS) ret = SYSTEM_ERROR;
+    if (ret != SUCCESS)
+    {
+        fprintf(stderr, "%s: %s\n", argv[2], fs_retcode_string_table[ret]);
+        free_filesystem(&fs);
+        return 1;
+    }
+
+    printf("%s: %zu inodes, %zu dblocks, %s -> %s geometry, %zu inodes reachable\n", argv[2], fs.inode_count,
+        fs.dblock_count, geometry_name(from), geometry_name(geometry), report.reachable_inodes);
+    free_filesystem(&fs);
+    return 0;
+}